@@ -0,0 +1,368 @@
+///////////////////////////////////////////////////////////////////////////////
+// assetarchive.cpp
+// ============
+// read and build the pak file holding the shaders, textures, models and scene
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "AssetArchive.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// "PAK1" read as a little endian integer
+	const uint32_t ARCHIVE_MAGIC = 0x314B4150;
+	const uint32_t ARCHIVE_VERSION = 1;
+	// every blob and the table of contents start on this boundary
+	const uint64_t BLOB_ALIGNMENT = 64;
+
+	const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+	const uint64_t FNV_PRIME = 1099511628211ULL;
+
+	/***********************************************************
+	 *  IsImageFile()
+	 *
+	 *  Checks whether a file name has one of the image file
+	 *  extensions that are decoded into textures.
+	 ***********************************************************/
+	bool IsImageFile(const std::string& filename)
+	{
+		size_t dot = filename.find_last_of('.');
+		if (dot == std::string::npos)
+		{
+			return(false);
+		}
+
+		std::string extension = filename.substr(dot + 1);
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+		return((extension == "jpg") || (extension == "jpeg") || (extension == "png") ||
+			(extension == "bmp") || (extension == "tga"));
+	}
+
+	/***********************************************************
+	 *  WritePadding()
+	 *
+	 *  Writes zeros up to the next blob boundary.
+	 ***********************************************************/
+	void WritePadding(std::ofstream& file, uint64_t& offset)
+	{
+		static const char zeros[BLOB_ALIGNMENT] = { 0 };
+		uint64_t padding = (BLOB_ALIGNMENT - (offset % BLOB_ALIGNMENT)) % BLOB_ALIGNMENT;
+		file.write(zeros, (std::streamsize)padding);
+		offset += padding;
+	}
+}
+
+/***********************************************************
+ *  AssetArchive()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+AssetArchive::AssetArchive()
+{
+	m_pEntries = NULL;
+	m_numEntries = 0;
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for mapping the archive and checking
+ *  that the header and every table of contents entry lie
+ *  inside the file, so the assets can be used without any
+ *  further checks.
+ ***********************************************************/
+bool AssetArchive::Open(const char* filename)
+{
+	Close();
+
+	if ((m_file.Open(filename) == false) || (m_file.GetSize() < sizeof(ARCHIVE_HEADER)))
+	{
+		std::cout << "Could not open asset archive:" << filename << std::endl;
+		m_file.Close();
+		return(false);
+	}
+
+	const unsigned char* pData = m_file.GetData();
+	uint64_t fileSize = m_file.GetSize();
+
+	ARCHIVE_HEADER header;
+	memcpy(&header, pData, sizeof(header));
+
+	bool bValid = (header.magic == ARCHIVE_MAGIC) &&
+		(header.version == ARCHIVE_VERSION) &&
+		((header.tocOffset % BLOB_ALIGNMENT) == 0) &&
+		(header.tocOffset <= fileSize) &&
+		((uint64_t)header.numEntries <= (fileSize - header.tocOffset) / sizeof(TOC_ENTRY));
+	if (bValid == true)
+	{
+		m_pEntries = (const TOC_ENTRY*)(pData + header.tocOffset);
+		m_numEntries = header.numEntries;
+		for (uint32_t i = 0; (i < m_numEntries) && (bValid == true); i++)
+		{
+			const TOC_ENTRY& entry = m_pEntries[i];
+			bValid = (entry.offset <= header.tocOffset) &&
+				(entry.size <= header.tocOffset - entry.offset) &&
+				((i == 0) || (m_pEntries[i - 1].nameHash < entry.nameHash));
+		}
+	}
+
+	if (bValid == false)
+	{
+		std::cout << "Not a valid asset archive:" << filename << std::endl;
+		Close();
+		return(false);
+	}
+
+	std::cout << "Opened asset archive:" << filename << ", assets:" << m_numEntries
+		<< ", bytes:" << fileSize << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for unmapping the archive.  Asset
+ *  views taken from it are no longer valid.
+ ***********************************************************/
+void AssetArchive::Close()
+{
+	m_file.Close();
+	m_pEntries = NULL;
+	m_numEntries = 0;
+}
+
+/***********************************************************
+ *  FindAsset()
+ *
+ *  This method is used for finding an asset by its name
+ *  with a binary search of the table of contents.
+ ***********************************************************/
+bool AssetArchive::FindAsset(const std::string& name, ASSET_VIEW& asset) const
+{
+	if (NULL == m_pEntries)
+	{
+		return(false);
+	}
+
+	uint64_t nameHash = HashName(name);
+	uint32_t first = 0;
+	uint32_t last = m_numEntries;
+	while (first < last)
+	{
+		uint32_t middle = first + (last - first) / 2;
+		if (m_pEntries[middle].nameHash < nameHash)
+		{
+			first = middle + 1;
+		}
+		else
+		{
+			last = middle;
+		}
+	}
+
+	if ((first == m_numEntries) || (m_pEntries[first].nameHash != nameHash))
+	{
+		return(false);
+	}
+
+	asset.type = (ASSET_TYPE)m_pEntries[first].type;
+	asset.pData = m_file.GetData() + m_pEntries[first].offset;
+	asset.size = (size_t)m_pEntries[first].size;
+	return(true);
+}
+
+/***********************************************************
+ *  GetTexture()
+ *
+ *  This method is used for getting the size and the pixels
+ *  of a texture asset.
+ ***********************************************************/
+bool AssetArchive::GetTexture(const ASSET_VIEW& asset, TEXTURE_HEADER& header, const unsigned char*& pPixels)
+{
+	if ((asset.type != ASSET_TEXTURE) || (asset.size < sizeof(TEXTURE_HEADER)))
+	{
+		return(false);
+	}
+
+	memcpy(&header, asset.pData, sizeof(header));
+	uint64_t numBytes = (uint64_t)header.width * header.height * header.colorChannels;
+	if (numBytes > asset.size - sizeof(TEXTURE_HEADER))
+	{
+		return(false);
+	}
+
+	pPixels = asset.pData + sizeof(TEXTURE_HEADER);
+	return(true);
+}
+
+/***********************************************************
+ *  BuildArchive()
+ *
+ *  This method is used for packing the passed in files into
+ *  a new archive.  Images are decoded and flipped the way
+ *  the textures are loaded, other files are copied as they
+ *  are.  Two names with the same hash fail the build rather
+ *  than hiding one of the assets.
+ ***********************************************************/
+bool AssetArchive::BuildArchive(const char* filename, const std::vector<std::string>& files)
+{
+	std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "Could not create asset archive:" << filename << std::endl;
+		return(false);
+	}
+
+	// the header is written again once the table is known
+	ARCHIVE_HEADER header;
+	memset(&header, 0, sizeof(header));
+	file.write((const char*)&header, sizeof(header));
+	uint64_t offset = sizeof(header);
+
+	std::vector<TOC_ENTRY> entries;
+	std::vector<std::string> names;
+	bool bSuccess = true;
+
+	for (size_t i = 0; (i < files.size()) && (bSuccess == true); i++)
+	{
+		uint64_t nameHash = HashName(files[i]);
+		bool bPacked = false;
+		for (size_t j = 0; j < entries.size(); j++)
+		{
+			if (entries[j].nameHash == nameHash)
+			{
+				bPacked = true;
+				if (names[j] != files[i])
+				{
+					std::cout << "Asset names have the same hash:" << names[j] << ", " << files[i] << std::endl;
+					bSuccess = false;
+				}
+			}
+		}
+		if (bPacked == true)
+		{
+			continue;
+		}
+
+		WritePadding(file, offset);
+
+		TOC_ENTRY entry;
+		memset(&entry, 0, sizeof(entry));
+		entry.nameHash = nameHash;
+		entry.offset = offset;
+
+		if (IsImageFile(files[i]) == true)
+		{
+			int width = 0;
+			int height = 0;
+			int colorChannels = 0;
+			stbi_set_flip_vertically_on_load(true);
+			unsigned char* image = stbi_load(files[i].c_str(), &width, &height, &colorChannels, 0);
+			if ((NULL == image) || ((colorChannels != 3) && (colorChannels != 4)))
+			{
+				std::cout << "Could not pack image:" << files[i] << std::endl;
+				stbi_image_free(image);
+				bSuccess = false;
+				continue;
+			}
+
+			TEXTURE_HEADER textureHeader;
+			textureHeader.width = (uint32_t)width;
+			textureHeader.height = (uint32_t)height;
+			textureHeader.colorChannels = (uint32_t)colorChannels;
+			textureHeader.reserved = 0;
+			uint64_t numBytes = (uint64_t)width * height * colorChannels;
+			file.write((const char*)&textureHeader, sizeof(textureHeader));
+			file.write((const char*)image, (std::streamsize)numBytes);
+			stbi_image_free(image);
+
+			entry.type = ASSET_TEXTURE;
+			entry.size = sizeof(textureHeader) + numBytes;
+		}
+		else
+		{
+			MappedFile source;
+			if (source.Open(files[i].c_str()) == false)
+			{
+				std::cout << "Could not pack file:" << files[i] << std::endl;
+				bSuccess = false;
+				continue;
+			}
+			file.write((const char*)source.GetData(), (std::streamsize)source.GetSize());
+
+			entry.type = ASSET_RAW;
+			entry.size = source.GetSize();
+		}
+
+		offset += entry.size;
+		entries.push_back(entry);
+		names.push_back(files[i]);
+		std::cout << "Packed asset:" << files[i] << ", bytes:" << entry.size << std::endl;
+	}
+
+	if (bSuccess == true)
+	{
+		std::sort(entries.begin(), entries.end(),
+			[](const TOC_ENTRY& a, const TOC_ENTRY& b)
+			{
+				return(a.nameHash < b.nameHash);
+			});
+
+		WritePadding(file, offset);
+		header.magic = ARCHIVE_MAGIC;
+		header.version = ARCHIVE_VERSION;
+		header.numEntries = (uint32_t)entries.size();
+		header.tocOffset = offset;
+		if (entries.empty() == false)
+		{
+			file.write((const char*)entries.data(), (std::streamsize)(entries.size() * sizeof(TOC_ENTRY)));
+		}
+		file.seekp(0);
+		file.write((const char*)&header, sizeof(header));
+		bSuccess = file.good();
+	}
+
+	file.close();
+	if (bSuccess == false)
+	{
+		std::cout << "Could not build asset archive:" << filename << std::endl;
+		std::remove(filename);
+		return(false);
+	}
+
+	std::cout << "Built asset archive:" << filename << ", assets:" << entries.size() << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  HashName()
+ *
+ *  This method is used for hashing an asset name with the
+ *  64-bit FNV-1a hash.  Back slashes are hashed as forward
+ *  slashes, so a path finds the same asset either way.
+ ***********************************************************/
+uint64_t AssetArchive::HashName(const std::string& name)
+{
+	uint64_t hash = FNV_OFFSET_BASIS;
+	for (size_t i = 0; i < name.size(); i++)
+	{
+		unsigned char c = (unsigned char)name[i];
+		if (c == '\\')
+		{
+			c = '/';
+		}
+		hash ^= c;
+		hash *= FNV_PRIME;
+	}
+	return(hash);
+}
@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+// assetarchive.h
+// ============
+// read and build the pak file holding the shaders, textures, models and scene
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  AssetArchive
+ *
+ *  This class contains the code for reading assets out of
+ *  one pak file instead of loose files.  The archive is
+ *  memory mapped once, and every asset is a pointer into the
+ *  mapped pages, so loading the assets needs no file opens,
+ *  no reads and no copies - textures and index data go from
+ *  the mapping straight to OpenGL.
+ *
+ *  The file holds a header, then the blobs, each starting
+ *  on a 64 byte boundary, then the table of contents.  The
+ *  table has one entry per asset, sorted by the 64-bit
+ *  FNV-1a hash of the asset name, so an asset is found with
+ *  a binary search and the names aren't stored at all.
+ *
+ *  Images are decoded when the archive is built and stored
+ *  as flipped rows of pixels after a small header, ready
+ *  for glTexImage2D().  Every other file is stored as is.
+ ***********************************************************/
+class AssetArchive
+{
+public:
+	enum ASSET_TYPE
+	{
+		// the bytes of the file as it was
+		ASSET_RAW = 0,
+		// TEXTURE_HEADER followed by the pixels
+		ASSET_TEXTURE
+	};
+
+	// header of the pixels of an ASSET_TEXTURE
+	struct TEXTURE_HEADER
+	{
+		uint32_t width;
+		uint32_t height;
+		uint32_t colorChannels;
+		uint32_t reserved;
+	};
+
+	// an asset as it lies in the mapped archive
+	struct ASSET_VIEW
+	{
+		ASSET_TYPE type;
+		const unsigned char* pData;
+		size_t size;
+	};
+
+	// constructor
+	AssetArchive();
+
+	// map the archive and check its table of contents,
+	// returns false if it isn't a valid archive
+	bool Open(const char* filename);
+	void Close();
+	bool IsOpen() const { return(m_file.IsOpen()); }
+
+	// find an asset by the name it was packed under
+	bool FindAsset(const std::string& name, ASSET_VIEW& asset) const;
+	// get the header and pixels of an ASSET_TEXTURE
+	static bool GetTexture(const ASSET_VIEW& asset, TEXTURE_HEADER& header, const unsigned char*& pPixels);
+
+	// write an archive holding the passed in files, each packed
+	// under its path, returns false if a file can't be read
+	static bool BuildArchive(const char* filename, const std::vector<std::string>& files);
+
+	// hash of an asset name, with \ and / treated the same
+	static uint64_t HashName(const std::string& name);
+
+private:
+	// archive header at the start of the file
+	struct ARCHIVE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t numEntries;
+		uint32_t reserved;
+		uint64_t tocOffset;
+	};
+
+	// table of contents entry of one asset
+	struct TOC_ENTRY
+	{
+		uint64_t nameHash;
+		uint64_t offset;
+		uint64_t size;
+		uint32_t type;
+		uint32_t reserved;
+	};
+
+	MappedFile m_file;
+	const TOC_ENTRY* m_pEntries;
+	uint32_t m_numEntries;
+};
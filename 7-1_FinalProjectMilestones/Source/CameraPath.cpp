@@ -0,0 +1,164 @@
+///////////////////////////////////////////////////////////////////////////////
+// camerapath.cpp
+// ============
+// scripted camera flight along a spline through timed keyframes
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CameraPath.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <algorithm>
+
+/***********************************************************
+ *  CameraPath()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+CameraPath::CameraPath()
+{
+}
+
+/***********************************************************
+ *  LoadPath()
+ *
+ *  This method is used for reading the keyframes from the
+ *  passed in camera path file.  Blank lines and lines that
+ *  start with '#' are skipped.
+ ***********************************************************/
+bool CameraPath::LoadPath(const char* filename)
+{
+	std::ifstream pathFile(filename);
+	if (!pathFile.is_open())
+	{
+		std::cout << "ERROR: could not open camera path:" << filename << std::endl;
+		return(false);
+	}
+
+	m_keyframes.clear();
+
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(pathFile, line))
+	{
+		lineNumber++;
+		if ((line.empty()) || (line[0] == '#') || (line[0] == '\r'))
+		{
+			continue;
+		}
+
+		CAMERA_KEYFRAME keyframe;
+		std::istringstream lineStream(line);
+		lineStream >> keyframe.time
+			>> keyframe.position.x >> keyframe.position.y >> keyframe.position.z
+			>> keyframe.target.x >> keyframe.target.y >> keyframe.target.z;
+		if (lineStream.fail())
+		{
+			std::cout << "ERROR: bad keyframe on line " << lineNumber << " of " << filename << std::endl;
+			m_keyframes.clear();
+			return(false);
+		}
+		m_keyframes.push_back(keyframe);
+	}
+
+	std::stable_sort(m_keyframes.begin(), m_keyframes.end(),
+		[](const CAMERA_KEYFRAME& a, const CAMERA_KEYFRAME& b) { return(a.time < b.time); });
+
+	if (IsLoaded() == false)
+	{
+		std::cout << "ERROR: camera path needs at least two keyframes:" << filename << std::endl;
+		return(false);
+	}
+
+	std::cout << "INFO: Loaded camera path with " << m_keyframes.size() << " keyframes ("
+		<< GetDuration() << "s) from " << filename << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetDuration()
+ *
+ *  This method is used for getting the time of the last
+ *  keyframe of the path.
+ ***********************************************************/
+double CameraPath::GetDuration() const
+{
+	if (m_keyframes.empty())
+	{
+		return(0.0);
+	}
+	return(m_keyframes.back().time);
+}
+
+/***********************************************************
+ *  Evaluate()
+ *
+ *  This method is used for calculating the camera position
+ *  and view direction at the passed in time.  Both the
+ *  position and the look-at target follow the spline; the
+ *  end keyframes are repeated to close the first and last
+ *  segments.
+ ***********************************************************/
+void CameraPath::Evaluate(double pathTime, glm::vec3& position, glm::vec3& front) const
+{
+	if (IsLoaded() == false)
+	{
+		return;
+	}
+
+	int lastIndex = (int)m_keyframes.size() - 1;
+
+	// find the segment that contains the passed in time
+	int segment = 0;
+	while ((segment < lastIndex - 1) && (pathTime >= m_keyframes[segment + 1].time))
+	{
+		segment++;
+	}
+
+	const CAMERA_KEYFRAME& k0 = m_keyframes[std::max(segment - 1, 0)];
+	const CAMERA_KEYFRAME& k1 = m_keyframes[segment];
+	const CAMERA_KEYFRAME& k2 = m_keyframes[segment + 1];
+	const CAMERA_KEYFRAME& k3 = m_keyframes[std::min(segment + 2, lastIndex)];
+
+	float segmentLength = k2.time - k1.time;
+	float t = 0.0f;
+	if (segmentLength > 0.0f)
+	{
+		t = glm::clamp((float)(pathTime - k1.time) / segmentLength, 0.0f, 1.0f);
+	}
+
+	position = CatmullRom(k0.position, k1.position, k2.position, k3.position, t);
+	glm::vec3 target = CatmullRom(k0.target, k1.target, k2.target, k3.target, t);
+
+	glm::vec3 direction = target - position;
+	if (glm::length(direction) > 0.0001f)
+	{
+		front = glm::normalize(direction);
+	}
+}
+
+/***********************************************************
+ *  CatmullRom()
+ *
+ *  This method is used for evaluating the uniform Catmull-Rom
+ *  spline segment between p1 and p2 at t in [0, 1].
+ ***********************************************************/
+glm::vec3 CameraPath::CatmullRom(
+	const glm::vec3& p0,
+	const glm::vec3& p1,
+	const glm::vec3& p2,
+	const glm::vec3& p3,
+	float t)
+{
+	float t2 = t * t;
+	float t3 = t2 * t;
+
+	return(0.5f * ((2.0f * p1) +
+		(p2 - p0) * t +
+		(2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+		(3.0f * p1 - p0 - 3.0f * p2 + p3) * t3));
+}
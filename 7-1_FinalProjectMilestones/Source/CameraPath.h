@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////////////
+// camerapath.h
+// ============
+// scripted camera flight along a spline through timed keyframes
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  CameraPath
+ *
+ *  This class contains the code for loading camera keyframes
+ *  from a text file and evaluating a Catmull-Rom spline
+ *  through them, so the camera can be driven along exactly
+ *  the same path on every run.
+ *
+ *  Each non-comment line of the file holds one keyframe:
+ *      time  posX posY posZ  targetX targetY targetZ
+ ***********************************************************/
+class CameraPath
+{
+public:
+	// constructor
+	CameraPath();
+
+	struct CAMERA_KEYFRAME
+	{
+		float time;
+		glm::vec3 position;
+		glm::vec3 target;
+	};
+
+	// load the keyframes from a camera path file
+	bool LoadPath(const char* filename);
+
+	// get the camera position and view direction at the passed in time
+	void Evaluate(double pathTime, glm::vec3& position, glm::vec3& front) const;
+
+	// get the time of the last keyframe
+	double GetDuration() const;
+	bool IsLoaded() const { return(m_keyframes.size() >= 2); }
+
+private:
+	// keyframes ordered by time
+	std::vector<CAMERA_KEYFRAME> m_keyframes;
+
+	// evaluate the Catmull-Rom segment between p1 and p2
+	static glm::vec3 CatmullRom(
+		const glm::vec3& p0,
+		const glm::vec3& p1,
+		const glm::vec3& p2,
+		const glm::vec3& p3,
+		float t);
+};
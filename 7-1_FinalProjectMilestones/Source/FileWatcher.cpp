@@ -0,0 +1,245 @@
+///////////////////////////////////////////////////////////////////////////////
+// filewatcher.cpp
+// ============
+// report changes to watched files - inotify on Linux, polling elsewhere
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FileWatcher.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// declaration of the global variables and defines
+namespace
+{
+	// shortest time between two polling passes
+	const std::chrono::milliseconds POLL_INTERVAL(500);
+}
+
+/***********************************************************
+ *  FileWatcher()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FileWatcher::FileWatcher()
+{
+	m_notifyHandle = -1;
+#if defined(__linux__)
+	m_notifyHandle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+	m_lastPollTime = std::chrono::steady_clock::now();
+}
+
+/***********************************************************
+ *  ~FileWatcher()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FileWatcher::~FileWatcher()
+{
+#if defined(__linux__)
+	if (m_notifyHandle >= 0)
+	{
+		// closing the instance removes all of its watches
+		close(m_notifyHandle);
+	}
+#endif
+}
+
+/***********************************************************
+ *  WatchFile()
+ *
+ *  This method is used for adding a file to the watched set.
+ ***********************************************************/
+bool FileWatcher::WatchFile(const std::string& filePath)
+{
+	for (size_t i = 0; i < m_watchedFiles.size(); i++)
+	{
+		if (m_watchedFiles[i].path == filePath)
+		{
+			return(true);
+		}
+	}
+
+	WATCHED_FILE watchedFile;
+	watchedFile.path = filePath;
+	size_t separator = filePath.find_last_of("/\\");
+	if (separator == std::string::npos)
+	{
+		watchedFile.directory = ".";
+		watchedFile.fileName = filePath;
+	}
+	else
+	{
+		watchedFile.directory = filePath.substr(0, separator);
+		watchedFile.fileName = filePath.substr(separator + 1);
+	}
+	watchedFile.watchHandle = -1;
+	watchedFile.modifiedTime = 0;
+	watchedFile.fileSize = 0;
+
+	if (GetFileTime(filePath, watchedFile.modifiedTime, watchedFile.fileSize) == false)
+	{
+		return(false);
+	}
+
+#if defined(__linux__)
+	if (m_notifyHandle >= 0)
+	{
+		// watching a directory twice returns the same handle
+		watchedFile.watchHandle = inotify_add_watch(
+			m_notifyHandle,
+			watchedFile.directory.c_str(),
+			IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (watchedFile.watchHandle < 0)
+		{
+			return(false);
+		}
+	}
+#endif
+
+	m_watchedFiles.push_back(watchedFile);
+	return(true);
+}
+
+/***********************************************************
+ *  PollChanges()
+ *
+ *  This method is used for getting the watched files that
+ *  were saved since the last call.  It never blocks.
+ ***********************************************************/
+void FileWatcher::PollChanges(std::vector<std::string>& changedFiles)
+{
+	changedFiles.clear();
+
+	if (m_notifyHandle >= 0)
+	{
+		PollNotify(changedFiles);
+	}
+	else
+	{
+		PollFileTimes(changedFiles);
+	}
+}
+
+/***********************************************************
+ *  PollNotify()
+ *
+ *  This method is used for reading the queued inotify events
+ *  and matching them against the watched files.
+ ***********************************************************/
+void FileWatcher::PollNotify(std::vector<std::string>& changedFiles)
+{
+#if defined(__linux__)
+	// aligned for the event structures read into it
+	alignas(struct inotify_event) char buffer[4096];
+
+	while (true)
+	{
+		ssize_t length = read(m_notifyHandle, buffer, sizeof(buffer));
+		if (length <= 0)
+		{
+			// no more events queued
+			return;
+		}
+
+		for (char* pEvent = buffer; pEvent < buffer + length; )
+		{
+			const struct inotify_event* event = (const struct inotify_event*)pEvent;
+			if (event->len > 0)
+			{
+				for (size_t i = 0; i < m_watchedFiles.size(); i++)
+				{
+					if ((m_watchedFiles[i].watchHandle == event->wd) &&
+						(m_watchedFiles[i].fileName == event->name))
+					{
+						AddUnique(changedFiles, m_watchedFiles[i].path);
+					}
+				}
+			}
+			pEvent += sizeof(struct inotify_event) + event->len;
+		}
+	}
+#else
+	(void)changedFiles;
+#endif
+}
+
+/***********************************************************
+ *  PollFileTimes()
+ *
+ *  This method is used for comparing the modification time
+ *  and size of every watched file against the last ones seen.
+ *  A file that is missing, such as in the middle of a save,
+ *  is checked again on the next pass.
+ ***********************************************************/
+void FileWatcher::PollFileTimes(std::vector<std::string>& changedFiles)
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (now - m_lastPollTime < POLL_INTERVAL)
+	{
+		return;
+	}
+	m_lastPollTime = now;
+
+	for (size_t i = 0; i < m_watchedFiles.size(); i++)
+	{
+		WATCHED_FILE& watchedFile = m_watchedFiles[i];
+
+		time_t modifiedTime = 0;
+		long long fileSize = 0;
+		if (GetFileTime(watchedFile.path, modifiedTime, fileSize) == false)
+		{
+			continue;
+		}
+		if ((modifiedTime != watchedFile.modifiedTime) || (fileSize != watchedFile.fileSize))
+		{
+			watchedFile.modifiedTime = modifiedTime;
+			watchedFile.fileSize = fileSize;
+			AddUnique(changedFiles, watchedFile.path);
+		}
+	}
+}
+
+/***********************************************************
+ *  GetFileTime()
+ *
+ *  This method is used for getting the modification time and
+ *  size of a file.
+ ***********************************************************/
+bool FileWatcher::GetFileTime(const std::string& filePath, time_t& modifiedTime, long long& fileSize)
+{
+	struct stat fileInfo;
+	if (stat(filePath.c_str(), &fileInfo) != 0)
+	{
+		return(false);
+	}
+
+	modifiedTime = fileInfo.st_mtime;
+	fileSize = (long long)fileInfo.st_size;
+	return(true);
+}
+
+/***********************************************************
+ *  AddUnique()
+ *
+ *  This method is used for adding a path to the list if it
+ *  is not already in it - one save can raise several events.
+ ***********************************************************/
+void FileWatcher::AddUnique(std::vector<std::string>& paths, const std::string& path)
+{
+	for (size_t i = 0; i < paths.size(); i++)
+	{
+		if (paths[i] == path)
+		{
+			return;
+		}
+	}
+	paths.push_back(path);
+}
@@ -0,0 +1,69 @@
+///////////////////////////////////////////////////////////////////////////////
+// filewatcher.h
+// ============
+// report changes to watched files - inotify on Linux, polling elsewhere
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <ctime>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  FileWatcher
+ *
+ *  This class contains the code for noticing when any of a
+ *  set of files has been saved.  On Linux the directories of
+ *  the files are watched with inotify, so checking for
+ *  changes is one non-blocking read.  Elsewhere the file
+ *  times are compared, at most a few times per second.
+ *
+ *  Editors often save by writing a new file and renaming it
+ *  over the old one, so the watch is on the directory and
+ *  the file name is matched, which covers both ways of
+ *  saving.
+ ***********************************************************/
+class FileWatcher
+{
+public:
+	// constructor
+	FileWatcher();
+	// destructor
+	~FileWatcher();
+
+	// start watching a file, returns false if it can't be watched
+	bool WatchFile(const std::string& filePath);
+	// get the watched files saved since the last call, each
+	// path as it was passed to WatchFile()
+	void PollChanges(std::vector<std::string>& changedFiles);
+
+	// true when the changes come from inotify, not polling
+	bool IsUsingNotify() const { return(m_notifyHandle >= 0); }
+
+private:
+	struct WATCHED_FILE
+	{
+		std::string path;
+		std::string directory;
+		std::string fileName;
+		// inotify watch of the directory
+		int watchHandle;
+		// last seen modification time and size, for polling
+		time_t modifiedTime;
+		long long fileSize;
+	};
+
+	std::vector<WATCHED_FILE> m_watchedFiles;
+	// inotify instance, negative when polling
+	int m_notifyHandle;
+	// time of the last polling pass
+	std::chrono::steady_clock::time_point m_lastPollTime;
+
+	void PollNotify(std::vector<std::string>& changedFiles);
+	void PollFileTimes(std::vector<std::string>& changedFiles);
+	static bool GetFileTime(const std::string& filePath, time_t& modifiedTime, long long& fileSize);
+	static void AddUnique(std::vector<std::string>& paths, const std::string& path);
+};
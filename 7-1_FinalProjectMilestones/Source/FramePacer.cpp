@@ -0,0 +1,418 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepacer.cpp
+// ============
+// pace the frames - swap interval, frame limit, frames in flight and latency
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FramePacer.h"
+
+#include "GLFW/glfw3.h"     // GLFW library
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+// declaration of the global variables and defines
+namespace
+{
+	// longest wait for a frame in flight, in nanoseconds, after
+	// which the frame is given up on rather than hanging
+	const GLuint64 FRAME_WAIT_TIMEOUT = 1000000000;
+	// seconds between matching the GPU clock up with the CPU's
+	const double CALIBRATION_SECONDS = 1.0;
+	// the limiter spins for at least this long before a
+	// deadline, and at most for the longest oversleep below
+	const double MIN_SLEEP_MARGIN = 0.001;
+	const double MAX_SLEEP_MARGIN = 0.02;
+	// share of the margin kept every frame, so one late wake
+	// up doesn't keep the limiter spinning for good
+	const double SLEEP_MARGIN_DECAY = 0.995;
+}
+
+const int FramePacer::MAX_FRAMES_IN_FLIGHT;
+const int FramePacer::NUM_FRAME_RECORDS;
+
+/***********************************************************
+ *  FramePacer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FramePacer::FramePacer()
+{
+	m_pRenderStats = NULL;
+	m_swapMode = SWAP_DEFAULT;
+	m_frameLimit = 0.0f;
+	m_maxFramesInFlight = 0;
+	for (int i = 0; i < NUM_FRAME_RECORDS; i++)
+	{
+		m_frameRecords[i].queryID = 0;
+		m_frameRecords[i].fence = NULL;
+		m_frameRecords[i].beginTime = 0.0;
+		m_frameRecords[i].inputTime = -1.0;
+	}
+	m_oldestRecord = 0;
+	m_numPendingRecords = 0;
+	m_bCreated = false;
+	m_frameBeginTime = 0.0;
+	m_frameInputTime = -1.0;
+	m_clockOffset = 0.0;
+	m_lastCalibrationTime = 0.0;
+	m_lastDeadline = 0.0;
+	m_sleepMargin = MIN_SLEEP_MARGIN;
+}
+
+/***********************************************************
+ *  ~FramePacer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FramePacer::~FramePacer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for setting the swap interval of the
+ *  context current on this thread, and making the timestamp
+ *  queries of the frame records.  Adaptive vsync falls back
+ *  to vsync when the driver doesn't have it.
+ ***********************************************************/
+bool FramePacer::Create(RenderStats* pRenderStats)
+{
+	Destroy();
+
+	m_pRenderStats = pRenderStats;
+
+	if (m_swapMode == SWAP_OFF)
+	{
+		glfwSwapInterval(0);
+		std::cout << "Frame pacing: vsync off" << std::endl;
+	}
+	else if (m_swapMode == SWAP_VSYNC)
+	{
+		glfwSwapInterval(1);
+		std::cout << "Frame pacing: vsync on" << std::endl;
+	}
+	else if (m_swapMode == SWAP_ADAPTIVE)
+	{
+		if ((glfwExtensionSupported("WGL_EXT_swap_control_tear") == GLFW_TRUE) ||
+			(glfwExtensionSupported("GLX_EXT_swap_control_tear") == GLFW_TRUE))
+		{
+			// a negative interval swaps late frames right away
+			glfwSwapInterval(-1);
+			std::cout << "Frame pacing: adaptive vsync" << std::endl;
+		}
+		else
+		{
+			glfwSwapInterval(1);
+			std::cout << "Frame pacing: adaptive vsync is not supported, vsync on" << std::endl;
+		}
+	}
+
+	if (m_frameLimit > 0.0f)
+	{
+		std::cout << "Frame pacing: limited to " << m_frameLimit << " fps" << std::endl;
+	}
+	if (m_maxFramesInFlight > 0)
+	{
+		std::cout << "Frame pacing: " << m_maxFramesInFlight << " frames in flight" << std::endl;
+	}
+
+	for (int i = 0; i < NUM_FRAME_RECORDS; i++)
+	{
+		glGenQueries(1, &m_frameRecords[i].queryID);
+	}
+	m_oldestRecord = 0;
+	m_numPendingRecords = 0;
+	m_lastDeadline = 0.0;
+	m_bCreated = true;
+
+	CalibrateClock();
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the queries and the
+ *  fences of the frames still in flight.
+ ***********************************************************/
+void FramePacer::Destroy()
+{
+	for (int i = 0; i < NUM_FRAME_RECORDS; i++)
+	{
+		if (NULL != m_frameRecords[i].fence)
+		{
+			glDeleteSync(m_frameRecords[i].fence);
+			m_frameRecords[i].fence = NULL;
+		}
+		if (0 != m_frameRecords[i].queryID)
+		{
+			glDeleteQueries(1, &m_frameRecords[i].queryID);
+			m_frameRecords[i].queryID = 0;
+		}
+	}
+	m_numPendingRecords = 0;
+	m_bCreated = false;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for reading every frame the GPU has
+ *  finished, and waiting for the oldest frames until fewer
+ *  than the allowed frames are in flight.  With a limit of
+ *  one frame the CPU only starts a frame once the GPU has
+ *  finished the one before.  The passed in time, of the
+ *  oldest input event the frame shows, is negative when
+ *  there was no input since the frame before.
+ ***********************************************************/
+void FramePacer::BeginFrame(double inputTime)
+{
+	if (m_bCreated == false)
+	{
+		return;
+	}
+
+	m_frameBeginTime = glfwGetTime();
+	m_frameInputTime = inputTime;
+	if (m_frameBeginTime - m_lastCalibrationTime >= CALIBRATION_SECONDS)
+	{
+		CalibrateClock();
+	}
+
+	int maxPending = NUM_FRAME_RECORDS - 1;
+	if (m_maxFramesInFlight > 0)
+	{
+		maxPending = m_maxFramesInFlight - 1;
+	}
+
+	// the GPU finishes the frames in order, so the reading
+	// stops at the first frame it is still working on
+	double waitStartTime = m_frameBeginTime;
+	bool bWaited = false;
+	while (m_numPendingRecords > 0)
+	{
+		bool bWait = (m_numPendingRecords > maxPending);
+		if ((bWait == true) && (bWaited == false))
+		{
+			if (ReadOldestFrame(false) == true)
+			{
+				continue;
+			}
+			bWaited = true;
+		}
+		if (ReadOldestFrame(bWait) == false)
+		{
+			break;
+		}
+	}
+
+	if (bWaited == true)
+	{
+		// the frame starts once the GPU has caught up
+		m_frameBeginTime = glfwGetTime();
+		if (NULL != m_pRenderStats)
+		{
+			m_pRenderStats->CountFenceWait((float)((m_frameBeginTime - waitStartTime) * 1000.0));
+		}
+	}
+	if (NULL != m_pRenderStats)
+	{
+		m_pRenderStats->CountFramesInFlight((uint32_t)m_numPendingRecords);
+	}
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for adding a timestamp query and a
+ *  fence after the swap of the frame, and then waiting for
+ *  the frame limit.
+ ***********************************************************/
+void FramePacer::EndFrame()
+{
+	if (m_bCreated == false)
+	{
+		return;
+	}
+
+	// a frame given up on in BeginFrame() is dropped, so the
+	// ring never runs out of records
+	if (m_numPendingRecords == NUM_FRAME_RECORDS)
+	{
+		FRAME_RECORD& oldest = m_frameRecords[m_oldestRecord];
+		glDeleteSync(oldest.fence);
+		oldest.fence = NULL;
+		m_oldestRecord = (m_oldestRecord + 1) % NUM_FRAME_RECORDS;
+		m_numPendingRecords--;
+	}
+
+	FRAME_RECORD& record = m_frameRecords[(m_oldestRecord + m_numPendingRecords) % NUM_FRAME_RECORDS];
+	glQueryCounter(record.queryID, GL_TIMESTAMP);
+	record.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	record.beginTime = m_frameBeginTime;
+	record.inputTime = m_frameInputTime;
+	m_numPendingRecords++;
+
+	WaitForFrameLimit();
+}
+
+/***********************************************************
+ *  ReadOldestFrame()
+ *
+ *  This method is used for reading the time the GPU finished
+ *  the oldest frame in flight, if its fence is signaled, and
+ *  counting its latency.  When asked to wait, the commands
+ *  are flushed and the fence is waited on for up to a second.
+ *  Returns false if the frame isn't finished.
+ ***********************************************************/
+bool FramePacer::ReadOldestFrame(bool bWait)
+{
+	FRAME_RECORD& record = m_frameRecords[m_oldestRecord];
+
+	GLenum result = GL_TIMEOUT_EXPIRED;
+	if (bWait == true)
+	{
+		result = glClientWaitSync(record.fence, GL_SYNC_FLUSH_COMMANDS_BIT, FRAME_WAIT_TIMEOUT);
+	}
+	else
+	{
+		result = glClientWaitSync(record.fence, 0, 0);
+	}
+	if (result == GL_TIMEOUT_EXPIRED)
+	{
+		return(false);
+	}
+
+	// the timestamp comes before the fence, so it is done too
+	if (result != GL_WAIT_FAILED)
+	{
+		GLuint64 gpuTime = 0;
+		glGetQueryObjectui64v(record.queryID, GL_QUERY_RESULT, &gpuTime);
+		double doneTime = m_clockOffset + (double)gpuTime * 1.0e-9;
+
+		float frameMilliseconds = (float)(std::max(doneTime - record.beginTime, 0.0) * 1000.0);
+		float inputMilliseconds = -1.0f;
+		if (record.inputTime >= 0.0)
+		{
+			inputMilliseconds = (float)(std::max(doneTime - record.inputTime, 0.0) * 1000.0);
+		}
+		if (NULL != m_pRenderStats)
+		{
+			m_pRenderStats->CountFrameLatency(frameMilliseconds, inputMilliseconds);
+		}
+	}
+
+	glDeleteSync(record.fence);
+	record.fence = NULL;
+	m_oldestRecord = (m_oldestRecord + 1) % NUM_FRAME_RECORDS;
+	m_numPendingRecords--;
+	return(true);
+}
+
+/***********************************************************
+ *  CalibrateClock()
+ *
+ *  This method is used for reading the GPU clock and the CPU
+ *  clock together, for moving the GPU timestamps onto the
+ *  CPU clock.  It is done again every second, as the two
+ *  clocks drift apart.
+ ***********************************************************/
+void FramePacer::CalibrateClock()
+{
+	GLint64 gpuTime = 0;
+	glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+	double cpuTime = glfwGetTime();
+
+	m_clockOffset = cpuTime - (double)gpuTime * 1.0e-9;
+	m_lastCalibrationTime = cpuTime;
+}
+
+/***********************************************************
+ *  WaitForFrameLimit()
+ *
+ *  This method is used for waiting until the next frame is
+ *  due at the frame limit.  The deadlines follow on from
+ *  each other, so the frames keep an even rate, but after a
+ *  frame that ran past its deadline they start over rather
+ *  than running frames back to back to catch up.
+ *
+ *  A sleep can wake up late, by a lot on some systems, so
+ *  the wait only sleeps while the deadline is further off
+ *  than the longest oversleep seen, and spins the rest.
+ ***********************************************************/
+void FramePacer::WaitForFrameLimit()
+{
+	if (m_frameLimit <= 0.0f)
+	{
+		return;
+	}
+
+	double deadline = m_lastDeadline + 1.0 / m_frameLimit;
+	double currentTime = glfwGetTime();
+	if (currentTime >= deadline)
+	{
+		m_lastDeadline = currentTime;
+		return;
+	}
+
+	double waitStartTime = currentTime;
+	m_sleepMargin = std::max(m_sleepMargin * SLEEP_MARGIN_DECAY, MIN_SLEEP_MARGIN);
+	while (deadline - currentTime > m_sleepMargin)
+	{
+		double sleepSeconds = deadline - currentTime - m_sleepMargin;
+		std::this_thread::sleep_for(std::chrono::microseconds((long long)(sleepSeconds * 1.0e6)));
+
+		double wakeTime = glfwGetTime();
+		double oversleep = (wakeTime - currentTime) - sleepSeconds;
+		if (oversleep > m_sleepMargin)
+		{
+			m_sleepMargin = std::min(oversleep, MAX_SLEEP_MARGIN);
+		}
+		currentTime = wakeTime;
+	}
+	while (currentTime < deadline)
+	{
+		std::this_thread::yield();
+		currentTime = glfwGetTime();
+	}
+
+	m_lastDeadline = deadline;
+	if (NULL != m_pRenderStats)
+	{
+		m_pRenderStats->CountPacingWait((float)((currentTime - waitStartTime) * 1000.0));
+	}
+}
+
+/***********************************************************
+ *  ParseSwapMode()
+ *
+ *  This method is used for getting the swap mode named by
+ *  the option value - off, on or adaptive.
+ ***********************************************************/
+bool FramePacer::ParseSwapMode(const char* name, SWAP_MODE& mode)
+{
+	if (strcmp(name, "off") == 0)
+	{
+		mode = SWAP_OFF;
+	}
+	else if (strcmp(name, "on") == 0)
+	{
+		mode = SWAP_VSYNC;
+	}
+	else if (strcmp(name, "adaptive") == 0)
+	{
+		mode = SWAP_ADAPTIVE;
+	}
+	else
+	{
+		return(false);
+	}
+	return(true);
+}
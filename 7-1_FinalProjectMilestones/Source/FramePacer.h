@@ -0,0 +1,136 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepacer.h
+// ============
+// pace the frames - swap interval, frame limit, frames in flight and latency
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "RenderStats.h"
+
+#include <GL/glew.h>        // GLEW library
+
+/***********************************************************
+ *  FramePacer
+ *
+ *  This class contains the code for choosing when frames
+ *  are started and swapped, to trade the latency from the
+ *  input to the screen against the frame rate.
+ *
+ *  The swap interval is set once, when the pacer is made -
+ *  off, vsync, or adaptive vsync, which swaps late frames
+ *  without waiting and tears instead of halving the rate.
+ *  The frame limit paces the frames to a fixed rate after
+ *  the swap, before the input is polled, so the frame that
+ *  follows shows input that is as new as possible.  It
+ *  sleeps until the deadline is closer than the longest
+ *  oversleep seen, and spins the rest of the way.
+ *
+ *  Every frame ends with a timestamp query and a fence after
+ *  the swap.  The fences limit the frames the CPU can queue
+ *  ahead of the GPU, which a driver will otherwise let run a
+ *  few frames ahead, each adding a frame of latency.  The
+ *  timestamps give the time the GPU finished each frame, on
+ *  the clock of the CPU, measured from the start of the
+ *  frame and from the oldest input event the frame showed.
+ *  The time to light up the pixels after that isn't known
+ *  to OpenGL.
+ ***********************************************************/
+class FramePacer
+{
+public:
+	// how the swap waits for the display refresh
+	enum SWAP_MODE
+	{
+		// leave the interval the driver starts with
+		SWAP_DEFAULT = 0,
+		SWAP_OFF,
+		SWAP_VSYNC,
+		SWAP_ADAPTIVE
+	};
+
+	// most frames in flight that can be asked for
+	static const int MAX_FRAMES_IN_FLIGHT = 4;
+
+	// constructor
+	FramePacer();
+	// destructor
+	~FramePacer();
+
+	// set the swap mode, used by the next call to Create()
+	void SetSwapMode(SWAP_MODE mode) { m_swapMode = mode; }
+	// frames per second the frames are limited to, zero to not limit them
+	void SetFrameLimit(float framesPerSecond) { m_frameLimit = framesPerSecond; }
+	// frames queued on the GPU the CPU can start a frame with,
+	// zero leaves it to the driver
+	void SetMaxFramesInFlight(int numFrames) { m_maxFramesInFlight = numFrames; }
+
+	// set the swap interval of the current context and make the
+	// queries, with the render stats the pacing is counted in
+	bool Create(RenderStats* pRenderStats);
+	// free the OpenGL objects
+	void Destroy();
+
+	// read the frames the GPU has finished and wait for the
+	// frames in flight to drop below the limit, the passed in
+	// time is of the oldest input the frame shows, or negative
+	void BeginFrame(double inputTime);
+	// set the time of the oldest input the frame in progress
+	// shows, when it is only known after BeginFrame()
+	void SetInputTime(double inputTime) { m_frameInputTime = inputTime; }
+	// mark the end of the frame, called after the swap, and
+	// wait for the frame limit
+	void EndFrame();
+
+	// get the swap mode of the passed in option value
+	static bool ParseSwapMode(const char* name, SWAP_MODE& mode);
+
+private:
+	// a swapped frame the GPU may not have finished yet
+	struct FRAME_RECORD
+	{
+		GLuint queryID;
+		GLsync fence;
+		// CPU times the frame was started at, and of its input
+		double beginTime;
+		double inputTime;
+	};
+
+	// more than the frames a driver queues on its own, for
+	// when the frames in flight are left to it
+	static const int NUM_FRAME_RECORDS = 8;
+
+	RenderStats* m_pRenderStats;
+	SWAP_MODE m_swapMode;
+	float m_frameLimit;
+	int m_maxFramesInFlight;
+
+	// swapped frames the GPU hasn't been seen to finish, from
+	// the oldest record
+	FRAME_RECORD m_frameRecords[NUM_FRAME_RECORDS];
+	int m_oldestRecord;
+	int m_numPendingRecords;
+	bool m_bCreated;
+
+	// frame in progress
+	double m_frameBeginTime;
+	double m_frameInputTime;
+
+	// seconds to add to a GPU timestamp for the CPU time
+	double m_clockOffset;
+	double m_lastCalibrationTime;
+
+	// deadline of the last limited frame, and how close to a
+	// deadline the limiter stops sleeping and spins
+	double m_lastDeadline;
+	double m_sleepMargin;
+
+	// read the oldest frame record once its fence is signaled,
+	// waiting for it when asked to
+	bool ReadOldestFrame(bool bWait);
+	// match the GPU timestamps up with the CPU clock
+	void CalibrateClock();
+	// sleep and spin until the next frame is due
+	void WaitForFrameLimit();
+};
@@ -0,0 +1,270 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameringbuffer.cpp
+// ============
+// persistently mapped buffer split into per-frame parts guarded by fences
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameRingBuffer.h"
+
+#include <algorithm>
+#include <chrono>
+
+// declaration of the global variables and defines
+namespace
+{
+	// the parts start on this many bytes, the largest buffer
+	// offset alignment OpenGL implementations ask for
+	const size_t FRAME_ALIGNMENT = 256;
+	// nanoseconds to wait for a fence before flushing again
+	const GLuint64 FENCE_TIMEOUT = 1000000000;
+}
+
+const int FrameRingBuffer::DEFAULT_FRAMES;
+const int FrameRingBuffer::MAX_FRAMES;
+
+/***********************************************************
+ *  FrameRingBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameRingBuffer::FrameRingBuffer(GLenum target)
+{
+	m_target = target;
+	m_bufferID = 0;
+	m_frameSize = 0;
+	m_numFrames = DEFAULT_FRAMES;
+	m_frameIndex = m_numFrames - 1;
+	m_pMapped = NULL;
+	m_bPersistent = false;
+	for (int i = 0; i < MAX_FRAMES; i++)
+	{
+		m_frameFences[i] = NULL;
+	}
+}
+
+/***********************************************************
+ *  ~FrameRingBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameRingBuffer::~FrameRingBuffer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  SetNumFrames()
+ *
+ *  This method is used for setting how many frames can be
+ *  in flight, from one, where every frame waits for the GPU
+ *  to finish the one before, up to MAX_FRAMES.  The buffer
+ *  is freed, and made with the new number of parts when the
+ *  next frame begins.
+ ***********************************************************/
+void FrameRingBuffer::SetNumFrames(int numFrames)
+{
+	if (numFrames < 1)
+	{
+		numFrames = 1;
+	}
+	if (numFrames > MAX_FRAMES)
+	{
+		numFrames = MAX_FRAMES;
+	}
+	if (numFrames == m_numFrames)
+	{
+		return;
+	}
+
+	Destroy();
+	m_numFrames = numFrames;
+	m_frameIndex = m_numFrames - 1;
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the buffer object with
+ *  one part of at least the passed in size for every frame
+ *  in flight, and mapping it when buffer storage is there.
+ *  BeginFrame() creates the buffer when it was not created.
+ ***********************************************************/
+bool FrameRingBuffer::Create(size_t bytesPerFrame)
+{
+	Destroy();
+
+	m_frameSize = ((bytesPerFrame + FRAME_ALIGNMENT - 1) / FRAME_ALIGNMENT) * FRAME_ALIGNMENT;
+	if (m_frameSize == 0)
+	{
+		m_frameSize = FRAME_ALIGNMENT;
+	}
+	m_frameIndex = m_numFrames - 1;
+	m_bPersistent = (GLEW_ARB_buffer_storage == GL_TRUE);
+
+	size_t bufferSize = m_frameSize * m_numFrames;
+	glGenBuffers(1, &m_bufferID);
+	glBindBuffer(m_target, m_bufferID);
+
+	if (m_bPersistent == true)
+	{
+		// coherent, so the writes need no flushing
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(m_target, bufferSize, NULL, flags);
+		m_pMapped = (unsigned char*)glMapBufferRange(m_target, 0, bufferSize, flags);
+		if (NULL == m_pMapped)
+		{
+			glBindBuffer(m_target, 0);
+			Destroy();
+			return(false);
+		}
+	}
+	else
+	{
+		glBufferData(m_target, bufferSize, NULL, GL_STREAM_DRAW);
+	}
+
+	glBindBuffer(m_target, 0);
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the buffer object once
+ *  the GPU is done with every part of it.
+ ***********************************************************/
+void FrameRingBuffer::Destroy()
+{
+	for (int i = 0; i < MAX_FRAMES; i++)
+	{
+		WaitForFrame(i);
+	}
+
+	if (0 != m_bufferID)
+	{
+		if (NULL != m_pMapped)
+		{
+			glBindBuffer(m_target, m_bufferID);
+			glUnmapBuffer(m_target);
+			glBindBuffer(m_target, 0);
+			m_pMapped = NULL;
+		}
+		glDeleteBuffers(1, &m_bufferID);
+		m_bufferID = 0;
+	}
+	m_frameSize = 0;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for moving on to the part of the next
+ *  frame and getting a pointer for writing into it.  The
+ *  fence of the frame that last used the part is usually
+ *  long passed, so this only blocks when the CPU runs more
+ *  than the number of frames - 1 ahead of the GPU.
+ ***********************************************************/
+void* FrameRingBuffer::BeginFrame(size_t bytesPerFrame, float& waitMilliseconds)
+{
+	waitMilliseconds = 0.0f;
+
+	if ((0 == m_bufferID) || (bytesPerFrame > m_frameSize))
+	{
+		// grow by at least half, so a slowly growing scene
+		// does not recreate the buffer every frame
+		size_t newSize = bytesPerFrame;
+		if (newSize < m_frameSize + m_frameSize / 2)
+		{
+			newSize = m_frameSize + m_frameSize / 2;
+		}
+		if (Create(newSize) == false)
+		{
+			return(NULL);
+		}
+	}
+
+	m_frameIndex = (m_frameIndex + 1) % m_numFrames;
+	waitMilliseconds = WaitForFrame(m_frameIndex);
+
+	if (m_bPersistent == true)
+	{
+		return(m_pMapped + GetFrameOffset());
+	}
+
+	// the fence already keeps the GPU off this part
+	glBindBuffer(m_target, m_bufferID);
+	void* pData = glMapBufferRange(
+		m_target,
+		GetFrameOffset(),
+		m_frameSize,
+		GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	glBindBuffer(m_target, 0);
+	return(pData);
+}
+
+/***********************************************************
+ *  EndWrites()
+ *
+ *  This method is used for ending the writes of the frame,
+ *  before the draws that read the data are issued.
+ ***********************************************************/
+void FrameRingBuffer::EndWrites()
+{
+	if ((m_bPersistent == false) && (0 != m_bufferID))
+	{
+		glBindBuffer(m_target, m_bufferID);
+		glUnmapBuffer(m_target);
+		glBindBuffer(m_target, 0);
+	}
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for placing a fence after the draws
+ *  of the frame, which marks when the GPU is done reading
+ *  the part of the frame.
+ ***********************************************************/
+void FrameRingBuffer::EndFrame()
+{
+	if (0 != m_bufferID)
+	{
+		m_frameFences[m_frameIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+}
+
+/***********************************************************
+ *  WaitForFrame()
+ *
+ *  This method is used for waiting until the GPU has passed
+ *  the fence of the part.  Returns the milliseconds the CPU
+ *  was blocked on the GPU, zero if the fence had passed.
+ ***********************************************************/
+float FrameRingBuffer::WaitForFrame(int frameIndex)
+{
+	GLsync fence = m_frameFences[frameIndex];
+	if (NULL == fence)
+	{
+		return(0.0f);
+	}
+	m_frameFences[frameIndex] = NULL;
+
+	float waitMilliseconds = 0.0f;
+	GLenum result = glClientWaitSync(fence, 0, 0);
+	if (result == GL_TIMEOUT_EXPIRED)
+	{
+		std::chrono::steady_clock::time_point waitStart = std::chrono::steady_clock::now();
+		while (result == GL_TIMEOUT_EXPIRED)
+		{
+			// flush so the fence is sure to be reached
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+		}
+		std::chrono::duration<float, std::milli> waited = std::chrono::steady_clock::now() - waitStart;
+		// a wait too short for the clock still counts as one
+		waitMilliseconds = std::max(waited.count(), 0.001f);
+	}
+	glDeleteSync(fence);
+
+	return(waitMilliseconds);
+}
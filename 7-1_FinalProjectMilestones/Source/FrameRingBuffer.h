@@ -0,0 +1,92 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameringbuffer.h
+// ============
+// persistently mapped buffer split into per-frame parts guarded by fences
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+#include <cstddef>
+
+/***********************************************************
+ *  FrameRingBuffer
+ *
+ *  This class contains the code for a buffer object that the
+ *  CPU writes the per-frame data of the scene into directly.
+ *  The buffer is split into one part per frame in flight and
+ *  used round robin.  A fence is placed after the draws of
+ *  each frame, and a part is only written again once the GPU
+ *  has passed the fence of the frame that last used it, so
+ *  the CPU never overwrites data the GPU still reads and the
+ *  driver never has to copy or stall on the buffer.  The
+ *  number of parts is the depth of the pipeline - how many
+ *  frames the CPU can write ahead while the GPU draws.
+ *
+ *  With buffer storage (OpenGL 4.4) the buffer is mapped
+ *  once, persistent and coherent, for its whole lifetime.
+ *  Without it each part is mapped unsynchronized for the
+ *  frame, which keeps the same fencing.
+ ***********************************************************/
+class FrameRingBuffer
+{
+public:
+	// constructor, for a buffer bound to the passed in target
+	FrameRingBuffer(GLenum target);
+	// destructor
+	~FrameRingBuffer();
+
+	// number of frames that can be in flight at once, by
+	// default and at most
+	static const int DEFAULT_FRAMES = 3;
+	static const int MAX_FRAMES = 4;
+
+	// set the number of frames in flight, which frees the
+	// buffer once the GPU is done with it, to be created again
+	// with the new number of parts by the next BeginFrame()
+	void SetNumFrames(int numFrames);
+	int GetNumFrames() const { return(m_numFrames); }
+
+	// create the buffer with room for the passed in number of
+	// bytes per frame
+	bool Create(size_t bytesPerFrame);
+	// wait for the GPU to finish with the buffer and free it
+	void Destroy();
+
+	// wait until the part of the next frame is free and get a
+	// pointer for writing up to bytesPerFrame bytes into it.
+	// The buffer grows first if it is too small.  Sets
+	// waitMilliseconds to how long the CPU was blocked on the
+	// GPU for the part, zero when it was free.
+	void* BeginFrame(size_t bytesPerFrame, float& waitMilliseconds);
+	// make the written data visible to the following draws
+	void EndWrites();
+	// place the fence after the draws of the frame
+	void EndFrame();
+
+	GLuint GetBufferID() const { return(m_bufferID); }
+	// offset of the part of the current frame in the buffer
+	size_t GetFrameOffset() const { return(m_frameIndex * m_frameSize); }
+	size_t GetFrameSize() const { return(m_frameSize); }
+	bool IsPersistent() const { return(m_bPersistent); }
+
+private:
+	GLenum m_target;
+	GLuint m_bufferID;
+	// bytes in the part of each frame, and the number of parts
+	size_t m_frameSize;
+	int m_numFrames;
+	// part of the frame being written
+	int m_frameIndex;
+	// mapping of the whole buffer, when persistent
+	unsigned char* m_pMapped;
+	bool m_bPersistent;
+	// fence after the last draws of each part, or NULL
+	GLsync m_frameFences[MAX_FRAMES];
+
+	// wait for the fence of the part and delete it, returning
+	// the milliseconds the CPU was blocked
+	float WaitForFrame(int frameIndex);
+};
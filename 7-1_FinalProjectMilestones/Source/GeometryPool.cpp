@@ -0,0 +1,552 @@
+///////////////////////////////////////////////////////////////////////////////
+// geometrypool.cpp
+// ============
+// shared vertex and index buffers that the meshes are sub-allocated from
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GeometryPool.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <cmath>
+#include <cstddef>
+
+// declaration of the global variables and defines
+namespace
+{
+	// smallest allocation of the buffers, in entries
+	const size_t MIN_VERTEX_CAPACITY = 16384;
+	const size_t MIN_INDEX_CAPACITY = 65536;
+
+	/***********************************************************
+	 *  EncodeOctahedral()
+	 *
+	 *  This function is used to map a unit vector onto the
+	 *  octahedron |x| + |y| + |z| = 1 and unfold the lower half
+	 *  over the upper, giving two coordinates from -1 to 1.
+	 *  DecodeOctahedralNormal() in the vertex shader is the
+	 *  reverse.
+	 ***********************************************************/
+	glm::vec2 EncodeOctahedral(const glm::vec3& normal)
+	{
+		float sum = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+		if (sum <= 0.0f)
+		{
+			return(glm::vec2(0.0f, 0.0f));
+		}
+
+		glm::vec2 result(normal.x / sum, normal.y / sum);
+		if (normal.z < 0.0f)
+		{
+			float signX = (result.x >= 0.0f) ? 1.0f : -1.0f;
+			float signY = (result.y >= 0.0f) ? 1.0f : -1.0f;
+			result = glm::vec2(
+				(1.0f - fabsf(result.y)) * signX,
+				(1.0f - fabsf(result.x)) * signY);
+		}
+		return(result);
+	}
+}
+
+/***********************************************************
+ *  GeometryPool()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GeometryPool::GeometryPool()
+{
+	m_vertexFormat = VERTEX_FORMAT_FLOAT;
+	m_vertexArrayID = 0;
+	m_vertexBufferID = 0;
+	m_indexBufferID = 0;
+	m_vertexCapacity = 0;
+	m_indexCapacity = 0;
+	m_numVertices = 0;
+	m_numIndices = 0;
+	m_bKeepMeshData = false;
+}
+
+/***********************************************************
+ *  ~GeometryPool()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GeometryPool::~GeometryPool()
+{
+	Clear();
+}
+
+/***********************************************************
+ *  AddMesh()
+ *
+ *  This method is used for copying the vertices and indices
+ *  of the mesh data into the pool.
+ ***********************************************************/
+int GeometryPool::AddMesh(const MESH_DATA& mesh)
+{
+	return(AddMesh(
+		mesh.vertices.data(),
+		mesh.vertices.size(),
+		mesh.indices.data(),
+		mesh.indices.size(),
+		mesh.lineIndices.data(),
+		mesh.lineIndices.size()));
+}
+
+/***********************************************************
+ *  AddMesh()
+ *
+ *  This method is used for copying the vertices and indices
+ *  of a mesh into the next free ranges of the pool buffers.
+ *  The triangle and line indices of the mesh are stored one
+ *  after the other.  In the float format the arrays are
+ *  handed to OpenGL as they are, so a mesh in a mapped file
+ *  goes from the page cache to the buffer with no copy of
+ *  our own in between.
+ ***********************************************************/
+int GeometryPool::AddMesh(
+	const VERTEX* pVertices,
+	size_t numVertices,
+	const uint32_t* pIndices,
+	size_t numIndices,
+	const uint32_t* pLineIndices,
+	size_t numLineIndices)
+{
+	if (numVertices == 0)
+	{
+		return(-1);
+	}
+
+	Reserve(m_numVertices + numVertices, m_numIndices + numIndices + numLineIndices);
+
+	MESH_RANGE range;
+	range.baseVertex = (GLint)m_numVertices;
+	range.numVertices = (GLuint)numVertices;
+	range.firstIndex = (GLuint)m_numIndices;
+	range.numIndices = (GLsizei)numIndices;
+	range.firstLineIndex = range.firstIndex + (GLuint)numIndices;
+	range.numLineIndices = (GLsizei)numLineIndices;
+	range.positionOffset = glm::vec3(0.0f);
+	range.positionScale = glm::vec3(1.0f);
+
+	// the copy targets leave the vertex array state alone
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_vertexBufferID);
+	if (m_vertexFormat == VERTEX_FORMAT_PACKED)
+	{
+		std::vector<PACKED_VERTEX> packedVertices;
+		PackVertices(pVertices, numVertices, packedVertices, range);
+		glBufferSubData(
+			GL_COPY_WRITE_BUFFER,
+			m_numVertices * sizeof(PACKED_VERTEX),
+			packedVertices.size() * sizeof(PACKED_VERTEX),
+			packedVertices.data());
+	}
+	else
+	{
+		glBufferSubData(
+			GL_COPY_WRITE_BUFFER,
+			m_numVertices * sizeof(VERTEX),
+			numVertices * sizeof(VERTEX),
+			pVertices);
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_indexBufferID);
+	if (numIndices > 0)
+	{
+		glBufferSubData(
+			GL_COPY_WRITE_BUFFER,
+			range.firstIndex * sizeof(uint32_t),
+			numIndices * sizeof(uint32_t),
+			pIndices);
+	}
+	if (numLineIndices > 0)
+	{
+		glBufferSubData(
+			GL_COPY_WRITE_BUFFER,
+			range.firstLineIndex * sizeof(uint32_t),
+			numLineIndices * sizeof(uint32_t),
+			pLineIndices);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	m_numVertices += numVertices;
+	m_numIndices += numIndices + numLineIndices;
+	m_meshRanges.push_back(range);
+
+	m_meshData.resize(m_meshRanges.size());
+	if (m_bKeepMeshData == true)
+	{
+		MESH_DATA& meshData = m_meshData.back();
+		meshData.vertices.assign(pVertices, pVertices + numVertices);
+		meshData.indices.assign(pIndices, pIndices + numIndices);
+		meshData.lineIndices.assign(pLineIndices, pLineIndices + numLineIndices);
+	}
+
+	return((int)m_meshRanges.size() - 1);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for freeing the pool buffers and
+ *  forgetting every mesh.
+ ***********************************************************/
+void GeometryPool::Clear()
+{
+	if (0 != m_vertexArrayID)
+	{
+		glDeleteVertexArrays(1, &m_vertexArrayID);
+		m_vertexArrayID = 0;
+	}
+	if (0 != m_vertexBufferID)
+	{
+		glDeleteBuffers(1, &m_vertexBufferID);
+		m_vertexBufferID = 0;
+	}
+	if (0 != m_indexBufferID)
+	{
+		glDeleteBuffers(1, &m_indexBufferID);
+		m_indexBufferID = 0;
+	}
+	m_vertexCapacity = 0;
+	m_indexCapacity = 0;
+	m_numVertices = 0;
+	m_numIndices = 0;
+	m_meshRanges.clear();
+	m_meshData.clear();
+}
+
+/***********************************************************
+ *  SetVertexFormat()
+ *
+ *  This method is used for choosing how the vertices are
+ *  stored.  The meshes already in the pool are in the old
+ *  format, so changing it frees the pool.
+ ***********************************************************/
+void GeometryPool::SetVertexFormat(VERTEX_FORMAT format)
+{
+	if (format != m_vertexFormat)
+	{
+		Clear();
+		m_vertexFormat = format;
+	}
+}
+
+/***********************************************************
+ *  GetVertexSize()
+ *
+ *  This method is used for getting the bytes of one stored
+ *  vertex in the current format.
+ ***********************************************************/
+size_t GeometryPool::GetVertexSize() const
+{
+	if (m_vertexFormat == VERTEX_FORMAT_PACKED)
+	{
+		return(sizeof(PACKED_VERTEX));
+	}
+	return(sizeof(VERTEX));
+}
+
+/***********************************************************
+ *  GetPositionDecode()
+ *
+ *  This method is used for getting the transform that maps
+ *  the stored positions of a mesh back into model space.
+ *  Applied ahead of the model matrix, it lets the packed
+ *  positions be drawn with no extra work in the shader.
+ ***********************************************************/
+glm::mat4 GeometryPool::GetPositionDecode(int mesh) const
+{
+	const MESH_RANGE& range = m_meshRanges[mesh];
+
+	glm::mat4 decode(1.0f);
+	decode[0][0] = range.positionScale.x;
+	decode[1][1] = range.positionScale.y;
+	decode[2][2] = range.positionScale.z;
+	decode[3] = glm::vec4(range.positionOffset, 1.0f);
+	return(decode);
+}
+
+/***********************************************************
+ *  GetMeshData()
+ *
+ *  This method is used for getting the copy of the vertices
+ *  and indices of a mesh, kept when it was added.
+ ***********************************************************/
+const GeometryPool::MESH_DATA* GeometryPool::GetMeshData(int mesh) const
+{
+	if ((mesh < 0) || ((size_t)mesh >= m_meshData.size()) || (m_meshData[mesh].vertices.empty() == true))
+	{
+		return(NULL);
+	}
+	return(&m_meshData[mesh]);
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for binding the vertex array of the
+ *  pool.  It only needs to be done once before any number
+ *  of mesh draws.
+ ***********************************************************/
+void GeometryPool::Bind() const
+{
+	glBindVertexArray(m_vertexArrayID);
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for drawing the triangles of a mesh.
+ ***********************************************************/
+void GeometryPool::DrawMesh(int mesh) const
+{
+	const MESH_RANGE& range = m_meshRanges[mesh];
+	glDrawElementsBaseVertex(
+		GL_TRIANGLES,
+		range.numIndices,
+		GL_UNSIGNED_INT,
+		(const void*)(range.firstIndex * sizeof(uint32_t)),
+		range.baseVertex);
+}
+
+/***********************************************************
+ *  DrawMeshRanges()
+ *
+ *  This method is used for drawing runs of the triangles of
+ *  one mesh, such as the meshlets that survived culling.  A
+ *  single run is drawn the same way as a whole mesh.
+ ***********************************************************/
+void GeometryPool::DrawMeshRanges(int mesh, const INDEX_RANGE* pRanges, size_t numRanges)
+{
+	if (numRanges == 0)
+	{
+		return;
+	}
+
+	const MESH_RANGE& range = m_meshRanges[mesh];
+	if (numRanges == 1)
+	{
+		glDrawElementsBaseVertex(
+			GL_TRIANGLES,
+			pRanges[0].numIndices,
+			GL_UNSIGNED_INT,
+			(const void*)((range.firstIndex + pRanges[0].firstIndex) * sizeof(uint32_t)),
+			range.baseVertex);
+		return;
+	}
+
+	m_drawCounts.resize(numRanges);
+	m_drawOffsets.resize(numRanges);
+	m_drawBaseVertices.assign(numRanges, range.baseVertex);
+	for (size_t i = 0; i < numRanges; i++)
+	{
+		m_drawCounts[i] = pRanges[i].numIndices;
+		m_drawOffsets[i] = (const void*)((range.firstIndex + pRanges[i].firstIndex) * sizeof(uint32_t));
+	}
+
+	glMultiDrawElementsBaseVertex(
+		GL_TRIANGLES,
+		m_drawCounts.data(),
+		GL_UNSIGNED_INT,
+		m_drawOffsets.data(),
+		(GLsizei)numRanges,
+		m_drawBaseVertices.data());
+}
+
+/***********************************************************
+ *  DrawMeshLines()
+ *
+ *  This method is used for drawing the wireframe lines of a
+ *  mesh.
+ ***********************************************************/
+void GeometryPool::DrawMeshLines(int mesh) const
+{
+	const MESH_RANGE& range = m_meshRanges[mesh];
+	glDrawElementsBaseVertex(
+		GL_LINES,
+		range.numLineIndices,
+		GL_UNSIGNED_INT,
+		(const void*)(range.firstLineIndex * sizeof(uint32_t)),
+		range.baseVertex);
+}
+
+/***********************************************************
+ *  Reserve()
+ *
+ *  This method is used for making sure the pool buffers can
+ *  hold the passed in numbers of vertices and indices.  A
+ *  buffer that is too small is at least doubled, so adding
+ *  many meshes one by one reallocates only a few times.
+ ***********************************************************/
+void GeometryPool::Reserve(size_t numVertices, size_t numIndices)
+{
+	if (0 == m_vertexArrayID)
+	{
+		glGenVertexArrays(1, &m_vertexArrayID);
+	}
+
+	bool bResized = false;
+	if ((0 == m_vertexBufferID) || (numVertices > m_vertexCapacity))
+	{
+		size_t capacity = m_vertexCapacity * 2;
+		if (capacity < MIN_VERTEX_CAPACITY)
+			capacity = MIN_VERTEX_CAPACITY;
+		if (capacity < numVertices)
+			capacity = numVertices;
+
+		m_vertexBufferID = ResizeBuffer(
+			m_vertexBufferID,
+			m_numVertices * GetVertexSize(),
+			capacity * GetVertexSize());
+		m_vertexCapacity = capacity;
+		bResized = true;
+	}
+	if ((0 == m_indexBufferID) || (numIndices > m_indexCapacity))
+	{
+		size_t capacity = m_indexCapacity * 2;
+		if (capacity < MIN_INDEX_CAPACITY)
+			capacity = MIN_INDEX_CAPACITY;
+		if (capacity < numIndices)
+			capacity = numIndices;
+
+		m_indexBufferID = ResizeBuffer(
+			m_indexBufferID,
+			m_numIndices * sizeof(uint32_t),
+			capacity * sizeof(uint32_t));
+		m_indexCapacity = capacity;
+		bResized = true;
+	}
+
+	if (bResized == true)
+	{
+		SetupVertexArray();
+	}
+}
+
+/***********************************************************
+ *  ResizeBuffer()
+ *
+ *  This method is used for creating a buffer of the new size
+ *  and copying the used part of the old buffer into it on
+ *  the GPU.  The old buffer is deleted.
+ ***********************************************************/
+GLuint GeometryPool::ResizeBuffer(GLuint bufferID, size_t usedBytes, size_t newBytes)
+{
+	GLuint newBufferID = 0;
+	glGenBuffers(1, &newBufferID);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, newBufferID);
+	glBufferData(GL_COPY_WRITE_BUFFER, newBytes, NULL, GL_STATIC_DRAW);
+
+	if (0 != bufferID)
+	{
+		if (usedBytes > 0)
+		{
+			glBindBuffer(GL_COPY_READ_BUFFER, bufferID);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, usedBytes);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		}
+		glDeleteBuffers(1, &bufferID);
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	return(newBufferID);
+}
+
+/***********************************************************
+ *  SetupVertexArray()
+ *
+ *  This method is used for describing the shared vertex
+ *  format to the vertex array and attaching the pool
+ *  buffers to it.  The attribute locations match the ones
+ *  in the vertex shader.
+ ***********************************************************/
+void GeometryPool::SetupVertexArray()
+{
+	glBindVertexArray(m_vertexArrayID);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBufferID);
+
+	if (m_vertexFormat == VERTEX_FORMAT_PACKED)
+	{
+		// the normalized values are turned into floats when read,
+		// the normal only has its two octahedral coordinates
+		GLsizei stride = sizeof(PACKED_VERTEX);
+		glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (const void*)offsetof(PACKED_VERTEX, position));
+		glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (const void*)offsetof(PACKED_VERTEX, normal));
+		glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (const void*)offsetof(PACKED_VERTEX, textureCoordinate));
+	}
+	else
+	{
+		GLsizei stride = sizeof(VERTEX);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (const void*)offsetof(VERTEX, position));
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (const void*)offsetof(VERTEX, normal));
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (const void*)offsetof(VERTEX, textureCoordinate));
+	}
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+
+	// the index buffer binding is part of the vertex array
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferID);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  PackVertices()
+ *
+ *  This method is used for converting the vertices of a mesh
+ *  into the packed format.  The positions are quantized to
+ *  65536 steps across the bounds of the mesh on each axis,
+ *  and the offset and scale that undo it are stored in the
+ *  mesh range.  An axis the mesh is flat along keeps a scale
+ *  of zero.
+ ***********************************************************/
+void GeometryPool::PackVertices(
+	const VERTEX* pVertices,
+	size_t numVertices,
+	std::vector<PACKED_VERTEX>& packedVertices,
+	MESH_RANGE& range)
+{
+	glm::vec3 boundsMin = pVertices[0].position;
+	glm::vec3 boundsMax = pVertices[0].position;
+	for (size_t i = 1; i < numVertices; i++)
+	{
+		boundsMin = glm::min(boundsMin, pVertices[i].position);
+		boundsMax = glm::max(boundsMax, pVertices[i].position);
+	}
+	range.positionOffset = boundsMin;
+	range.positionScale = boundsMax - boundsMin;
+
+	glm::vec3 toUnit(0.0f);
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (range.positionScale[axis] > 0.0f)
+		{
+			toUnit[axis] = 1.0f / range.positionScale[axis];
+		}
+	}
+
+	packedVertices.resize(numVertices);
+	for (size_t i = 0; i < numVertices; i++)
+	{
+		const VERTEX& vertex = pVertices[i];
+		PACKED_VERTEX& packed = packedVertices[i];
+
+		glm::vec3 unit = (vertex.position - boundsMin) * toUnit;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			packed.position[axis] = glm::packUnorm1x16(unit[axis]);
+		}
+		packed.padding = 0;
+
+		uint32_t normal = glm::packSnorm2x16(EncodeOctahedral(vertex.normal));
+		packed.normal[0] = (int16_t)(normal & 0xFFFF);
+		packed.normal[1] = (int16_t)(normal >> 16);
+
+		packed.textureCoordinate[0] = glm::packHalf1x16(vertex.textureCoordinate.x);
+		packed.textureCoordinate[1] = glm::packHalf1x16(vertex.textureCoordinate.y);
+	}
+}
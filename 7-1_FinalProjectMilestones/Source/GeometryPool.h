@@ -0,0 +1,187 @@
+///////////////////////////////////////////////////////////////////////////////
+// geometrypool.h
+// ============
+// shared vertex and index buffers that the meshes are sub-allocated from
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  GeometryPool
+ *
+ *  This class contains the code for keeping the vertices and
+ *  indices of every mesh in one vertex buffer and one index
+ *  buffer, described by one vertex array object.  Each mesh
+ *  is given its own range of both buffers, so once the
+ *  vertex array is bound, meshes differ only in the base
+ *  vertex and first index passed to the draw command and
+ *  any number of them are drawn with no further binds.
+ *
+ *  Ranges are handed out in order from the front of the
+ *  buffers.  When a mesh does not fit, the buffers are
+ *  reallocated larger and the existing data is copied over
+ *  on the GPU, so the ranges already handed out stay valid.
+ *
+ *  The vertices are stored either as floats, 32 bytes each,
+ *  or packed into 16 bytes: positions as 16-bit unsigned
+ *  normalized values across the bounds of their mesh,
+ *  normals as two 16-bit signed normalized octahedral
+ *  coordinates and texture coordinates as half floats.  The
+ *  vertex shader turns the octahedral normals back into
+ *  vectors, and the decode transform of the mesh maps the
+ *  packed positions back into model space.
+ ***********************************************************/
+class GeometryPool
+{
+public:
+	// constructor
+	GeometryPool();
+	// destructor
+	~GeometryPool();
+
+	// how the vertices are stored in the vertex buffer
+	enum VERTEX_FORMAT
+	{
+		VERTEX_FORMAT_FLOAT = 0,
+		VERTEX_FORMAT_PACKED
+	};
+
+	// vertex of the mesh data passed in, and the stored vertex
+	// of the float format
+	struct VERTEX
+	{
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 textureCoordinate;
+	};
+
+	// stored vertex of the packed format
+	struct PACKED_VERTEX
+	{
+		// unsigned normalized, 0 to 1 across the mesh bounds
+		uint16_t position[3];
+		uint16_t padding;
+		// signed normalized octahedral coordinates
+		int16_t normal[2];
+		// half floats, so repeating textures keep working
+		uint16_t textureCoordinate[2];
+	};
+
+	// mesh data to add to the pool, with indices relative to
+	// the first vertex of the mesh
+	struct MESH_DATA
+	{
+		std::vector<VERTEX> vertices;
+		// triangle list
+		std::vector<uint32_t> indices;
+		// line list of the edges drawn for the wireframe
+		std::vector<uint32_t> lineIndices;
+	};
+
+	// ranges of the pool buffers holding one mesh
+	struct MESH_RANGE
+	{
+		GLint baseVertex;
+		GLuint numVertices;
+		GLuint firstIndex;
+		GLsizei numIndices;
+		GLuint firstLineIndex;
+		GLsizei numLineIndices;
+		// packed positions times the scale plus the offset give
+		// the model space positions
+		glm::vec3 positionOffset;
+		glm::vec3 positionScale;
+	};
+
+	// run of the triangle indices of one mesh, relative to the
+	// first index of the mesh
+	struct INDEX_RANGE
+	{
+		GLuint firstIndex;
+		GLsizei numIndices;
+	};
+
+	// choose the vertex format, which frees the pool if it had
+	// meshes stored in another format
+	void SetVertexFormat(VERTEX_FORMAT format);
+	VERTEX_FORMAT GetVertexFormat() const { return(m_vertexFormat); }
+	// bytes of one stored vertex
+	size_t GetVertexSize() const;
+	// keep a copy of the vertices and indices of the meshes
+	// added from now on, for work that needs them on the CPU
+	void SetKeepMeshData(bool bKeepMeshData) { m_bKeepMeshData = bKeepMeshData; }
+
+	// copy a mesh into the pool, returns its mesh ID or -1
+	int AddMesh(const MESH_DATA& mesh);
+	// same as above from arrays anywhere in memory, such as a
+	// mapped file, so they can be uploaded with no extra copy
+	int AddMesh(
+		const VERTEX* pVertices,
+		size_t numVertices,
+		const uint32_t* pIndices,
+		size_t numIndices,
+		const uint32_t* pLineIndices,
+		size_t numLineIndices);
+	// free the buffers and every mesh
+	void Clear();
+
+	// bind the vertex array of the pool for the following draws
+	void Bind() const;
+	// draw the triangles or wireframe lines of one mesh, with
+	// the vertex array of the pool bound
+	void DrawMesh(int mesh) const;
+	void DrawMeshLines(int mesh) const;
+	// draw some runs of the triangles of one mesh with a single
+	// multi draw
+	void DrawMeshRanges(int mesh, const INDEX_RANGE* pRanges, size_t numRanges);
+
+	// transform from the stored positions of a mesh to model
+	// space, identity for the float format
+	glm::mat4 GetPositionDecode(int mesh) const;
+	// copy of the data of a mesh, NULL unless it was kept
+	const MESH_DATA* GetMeshData(int mesh) const;
+
+	const MESH_RANGE& GetMeshRange(int mesh) const { return(m_meshRanges[mesh]); }
+	size_t GetMeshCount() const { return(m_meshRanges.size()); }
+	GLuint GetVertexBufferID() const { return(m_vertexBufferID); }
+	GLuint GetIndexBufferID() const { return(m_indexBufferID); }
+
+private:
+	VERTEX_FORMAT m_vertexFormat;
+	GLuint m_vertexArrayID;
+	GLuint m_vertexBufferID;
+	GLuint m_indexBufferID;
+	// allocated and used entries of the buffers
+	size_t m_vertexCapacity;
+	size_t m_indexCapacity;
+	size_t m_numVertices;
+	size_t m_numIndices;
+	std::vector<MESH_RANGE> m_meshRanges;
+	// copies of the mesh data, empty for meshes not kept
+	bool m_bKeepMeshData;
+	std::vector<MESH_DATA> m_meshData;
+	// draw arrays of DrawMeshRanges(), kept between draws
+	std::vector<GLsizei> m_drawCounts;
+	std::vector<const void*> m_drawOffsets;
+	std::vector<GLint> m_drawBaseVertices;
+
+	// grow the buffers to hold at least the passed in counts
+	void Reserve(size_t numVertices, size_t numIndices);
+	// move the contents of a buffer into a larger new one
+	static GLuint ResizeBuffer(GLuint bufferID, size_t usedBytes, size_t newBytes);
+	// point the vertex array at the current buffers
+	void SetupVertexArray();
+	// pack the vertices of a mesh and set its decode values
+	static void PackVertices(
+		const VERTEX* pVertices,
+		size_t numVertices,
+		std::vector<PACKED_VERTEX>& packedVertices,
+		MESH_RANGE& range);
+};
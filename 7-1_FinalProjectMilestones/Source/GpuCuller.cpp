@@ -0,0 +1,498 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuculler.cpp
+// ============
+// frustum culling and draw command compaction in a compute shader
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GpuCuller.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// GLSL files of the culling shader and of the vertex shader
+	// the culled objects are drawn with
+	const char* CULLING_COMPUTE_SHADER_FILE = "shaders/cullingComputeShader.glsl";
+	const char* GPU_VERTEX_SHADER_FILE = "shaders/gpuVertexShader.glsl";
+	const char* g_NumObjectsName = "numObjects";
+
+	// shader storage binding points, as declared in the shaders
+	const GLuint RECORD_BUFFER_BINDING = 0;
+	const GLuint OBJECT_BUFFER_BINDING = 1;
+	const GLuint COMMAND_BUFFER_BINDING = 2;
+	const GLuint COUNT_BUFFER_BINDING = 3;
+
+	// objects tested by one work group of the culling shader
+	const uint32_t CULL_GROUP_SIZE = 64;
+}
+
+const uint32_t GpuCuller::NO_BUCKET;
+
+/***********************************************************
+ *  GpuCuller()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GpuCuller::GpuCuller()
+{
+	m_pCullShader = NULL;
+	m_pRenderStats = NULL;
+	m_recordBufferID = 0;
+	m_objectBufferID = 0;
+	m_commandBufferID = 0;
+	m_countBufferID = 0;
+	m_pUploadBuffer = new FrameRingBuffer(GL_COPY_READ_BUFFER);
+	m_numObjects = 0;
+	m_objectBlockSize = 0;
+}
+
+/***********************************************************
+ *  ~GpuCuller()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GpuCuller::~GpuCuller()
+{
+	Destroy();
+	delete m_pUploadBuffer;
+	m_pUploadBuffer = NULL;
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking whether the context can
+ *  run the culling shader and draw its commands.  The base
+ *  instance in the vertex shader and the draw counts read
+ *  from a buffer both came in with OpenGL 4.6.
+ ***********************************************************/
+bool GpuCuller::IsSupported()
+{
+	return(GLEW_VERSION_4_6 == GL_TRUE);
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for loading the culling compute
+ *  shader.  The buffers are created by SetObjects().
+ ***********************************************************/
+bool GpuCuller::Create(const ShaderManager* pSceneShaders)
+{
+	Destroy();
+
+	m_pRenderStats = pSceneShaders->GetRenderStats();
+	m_pCullShader = new ShaderManager();
+	m_pCullShader->SetRenderStats(m_pRenderStats);
+	m_pCullShader->SetAssetArchive(pSceneShaders->GetAssetArchive());
+	m_pCullShader->SetProgramCacheDirectory(pSceneShaders->GetProgramCacheDirectory());
+	if (0 == m_pCullShader->LoadComputeShader(CULLING_COMPUTE_SHADER_FILE))
+	{
+		Destroy();
+		return(false);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the buffers and the
+ *  compute shader.
+ ***********************************************************/
+void GpuCuller::Destroy()
+{
+	DestroyBuffers();
+	m_pUploadBuffer->Destroy();
+	if (NULL != m_pCullShader)
+	{
+		delete m_pCullShader;
+		m_pCullShader = NULL;
+	}
+	m_pRenderStats = NULL;
+}
+
+/***********************************************************
+ *  DestroyBuffers()
+ *
+ *  This method is used for freeing the shader storage
+ *  buffers and forgetting the objects.
+ ***********************************************************/
+void GpuCuller::DestroyBuffers()
+{
+	GLuint* bufferIDs[4] = { &m_recordBufferID, &m_objectBufferID, &m_commandBufferID, &m_countBufferID };
+	for (int i = 0; i < 4; i++)
+	{
+		if (0 != *bufferIDs[i])
+		{
+			glDeleteBuffers(1, bufferIDs[i]);
+			*bufferIDs[i] = 0;
+		}
+	}
+
+	m_numObjects = 0;
+	m_objectBlocks.clear();
+	m_changedObjects.clear();
+	m_bucketFirst.clear();
+	m_bucketCapacity.clear();
+}
+
+/***********************************************************
+ *  CreateBuffer()
+ *
+ *  This method is used for creating a buffer object holding
+ *  the passed in bytes, or uninitialized ones for NULL.  An
+ *  empty buffer is given one word, so it can still be bound.
+ ***********************************************************/
+GLuint GpuCuller::CreateBuffer(GLenum target, size_t size, const void* pData, GLenum usage)
+{
+	if (size == 0)
+	{
+		size = sizeof(GLuint);
+		pData = NULL;
+	}
+
+	GLuint bufferID = 0;
+	glGenBuffers(1, &bufferID);
+	glBindBuffer(target, bufferID);
+	glBufferData(target, size, pData, usage);
+	glBindBuffer(target, 0);
+	return(bufferID);
+}
+
+/***********************************************************
+ *  SetObjects()
+ *
+ *  This method is used for replacing every object.  Each
+ *  bucket is given room for a command from every record
+ *  that uses it, laid out one bucket after another, and the
+ *  first command of its bucket is filled into each record.
+ ***********************************************************/
+void GpuCuller::SetObjects(
+	const void* pObjectBlocks,
+	size_t objectBlockSize,
+	std::vector<DRAW_RECORD>& records,
+	uint32_t numBuckets)
+{
+	DestroyBuffers();
+
+	m_numObjects = (uint32_t)records.size();
+	m_objectBlockSize = objectBlockSize;
+
+	m_bucketCapacity.assign(numBuckets, 0);
+	for (size_t i = 0; i < records.size(); i++)
+	{
+		m_bucketCapacity[records[i].triangles[2]]++;
+		if (records[i].lines[2] != NO_BUCKET)
+		{
+			m_bucketCapacity[records[i].lines[2]]++;
+		}
+	}
+	m_bucketFirst.assign(numBuckets, 0);
+	uint32_t numCommands = 0;
+	for (uint32_t bucket = 0; bucket < numBuckets; bucket++)
+	{
+		m_bucketFirst[bucket] = numCommands;
+		numCommands += m_bucketCapacity[bucket];
+	}
+	for (size_t i = 0; i < records.size(); i++)
+	{
+		records[i].triangles[3] = m_bucketFirst[records[i].triangles[2]];
+		if (records[i].lines[2] != NO_BUCKET)
+		{
+			records[i].lines[3] = m_bucketFirst[records[i].lines[2]];
+		}
+	}
+
+	size_t objectBytes = m_numObjects * objectBlockSize;
+	const unsigned char* pBlocks = (const unsigned char*)pObjectBlocks;
+	m_objectBlocks.assign(pBlocks, pBlocks + objectBytes);
+
+	m_recordBufferID = CreateBuffer(
+		GL_SHADER_STORAGE_BUFFER,
+		records.size() * sizeof(DRAW_RECORD),
+		records.data(),
+		GL_STATIC_DRAW);
+	m_objectBufferID = CreateBuffer(
+		GL_SHADER_STORAGE_BUFFER,
+		objectBytes,
+		m_objectBlocks.data(),
+		GL_DYNAMIC_DRAW);
+	// written and read on the GPU only
+	m_commandBufferID = CreateBuffer(
+		GL_SHADER_STORAGE_BUFFER,
+		numCommands * sizeof(DRAW_COMMAND),
+		NULL,
+		GL_DYNAMIC_COPY);
+	m_countBufferID = CreateBuffer(
+		GL_SHADER_STORAGE_BUFFER,
+		numBuckets * sizeof(GLuint),
+		NULL,
+		GL_DYNAMIC_COPY);
+
+	if (NULL != m_pRenderStats)
+	{
+		m_pRenderStats->CountUpload(records.size() * sizeof(DRAW_RECORD) + objectBytes);
+	}
+}
+
+/***********************************************************
+ *  UpdateObject()
+ *
+ *  This method is used for changing the object block of one
+ *  object.  The block is copied and sent with the next cull.
+ ***********************************************************/
+void GpuCuller::UpdateObject(uint32_t index, const void* pObjectBlock)
+{
+	if (index >= m_numObjects)
+	{
+		return;
+	}
+
+	memcpy(&m_objectBlocks[index * m_objectBlockSize], pObjectBlock, m_objectBlockSize);
+	m_changedObjects.push_back(index);
+}
+
+/***********************************************************
+ *  SendChangedObjects()
+ *
+ *  This method is used for sending the object blocks that
+ *  changed since the last cull.  They are written one after
+ *  the other into the frame's part of the upload buffer, and
+ *  copied into the object buffer on the GPU, in order with
+ *  the draws of the frames before, rather than updated from
+ *  the CPU, which could wait for those draws.  Neighboring
+ *  objects are copied together, so a moved group costs one
+ *  copy.
+ ***********************************************************/
+void GpuCuller::SendChangedObjects()
+{
+	if (m_changedObjects.empty())
+	{
+		return;
+	}
+
+	std::sort(m_changedObjects.begin(), m_changedObjects.end());
+	m_changedObjects.erase(
+		std::unique(m_changedObjects.begin(), m_changedObjects.end()),
+		m_changedObjects.end());
+
+	float waitMilliseconds = 0.0f;
+	unsigned char* pFrameData = (unsigned char*)m_pUploadBuffer->BeginFrame(
+		m_changedObjects.size() * m_objectBlockSize,
+		waitMilliseconds);
+	if (NULL == pFrameData)
+	{
+		return;
+	}
+	if ((NULL != m_pRenderStats) && (waitMilliseconds > 0.0f))
+	{
+		m_pRenderStats->CountFenceWait(waitMilliseconds);
+	}
+
+	// the copies are made from where each run was written
+	struct COPY_RUN
+	{
+		size_t sourceOffset;
+		size_t targetOffset;
+		size_t size;
+	};
+	std::vector<COPY_RUN> runs;
+	size_t writeOffset = 0;
+	size_t runStart = 0;
+	for (size_t i = 1; i <= m_changedObjects.size(); i++)
+	{
+		if ((i < m_changedObjects.size()) && (m_changedObjects[i] == m_changedObjects[i - 1] + 1))
+		{
+			continue;
+		}
+
+		COPY_RUN run;
+		run.sourceOffset = writeOffset;
+		run.targetOffset = m_changedObjects[runStart] * m_objectBlockSize;
+		run.size = (i - runStart) * m_objectBlockSize;
+		memcpy(pFrameData + writeOffset, &m_objectBlocks[run.targetOffset], run.size);
+		runs.push_back(run);
+
+		writeOffset += run.size;
+		runStart = i;
+	}
+	m_pUploadBuffer->EndWrites();
+
+	size_t frameOffset = m_pUploadBuffer->GetFrameOffset();
+	glBindBuffer(GL_COPY_READ_BUFFER, m_pUploadBuffer->GetBufferID());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_objectBufferID);
+	for (size_t i = 0; i < runs.size(); i++)
+	{
+		glCopyBufferSubData(
+			GL_COPY_READ_BUFFER,
+			GL_COPY_WRITE_BUFFER,
+			frameOffset + runs[i].sourceOffset,
+			runs[i].targetOffset,
+			runs[i].size);
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	// the part is free again once the GPU is past the copies
+	m_pUploadBuffer->EndFrame();
+	if (NULL != m_pRenderStats)
+	{
+		m_pRenderStats->CountUpload(writeOffset);
+	}
+
+	m_changedObjects.clear();
+}
+
+/***********************************************************
+ *  Cull()
+ *
+ *  This method is used for writing the draw commands of the
+ *  frame.  The bucket counts are cleared, one thread of the
+ *  culling shader tests each object, and a barrier makes the
+ *  commands and counts visible to the indirect draws.
+ ***********************************************************/
+void GpuCuller::Cull(const glm::vec4 frustumPlanes[6])
+{
+	if (m_numObjects == 0)
+	{
+		return;
+	}
+
+	SendChangedObjects();
+
+	GLuint zero = 0;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_countBufferID);
+	glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	m_pCullShader->use();
+	for (int i = 0; i < 6; i++)
+	{
+		std::ostringstream name;
+		name << "frustumPlanes[" << i << "]";
+		m_pCullShader->setVec4Value(name.str(), frustumPlanes[i]);
+	}
+	m_pCullShader->setIntValue(g_NumObjectsName, (int)m_numObjects);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, RECORD_BUFFER_BINDING, m_recordBufferID);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_BUFFER_BINDING, m_objectBufferID);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMAND_BUFFER_BINDING, m_commandBufferID);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COUNT_BUFFER_BINDING, m_countBufferID);
+	if (NULL != m_pRenderStats)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			m_pRenderStats->CountBufferBind();
+		}
+	}
+
+	glDispatchCompute((m_numObjects + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+/***********************************************************
+ *  BindBuffers()
+ *
+ *  This method is used for binding the command and count
+ *  buffers for the indirect draws, and the object buffer
+ *  for the vertex shader.
+ ***********************************************************/
+void GpuCuller::BindBuffers()
+{
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBufferID);
+	glBindBuffer(GL_PARAMETER_BUFFER, m_countBufferID);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_BUFFER_BINDING, m_objectBufferID);
+	if (NULL != m_pRenderStats)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			m_pRenderStats->CountBufferBind();
+		}
+	}
+}
+
+/***********************************************************
+ *  GetBucketCapacity()
+ *
+ *  This method is used for getting the most commands the
+ *  bucket can hold, which is the number of objects using it.
+ ***********************************************************/
+uint32_t GpuCuller::GetBucketCapacity(uint32_t bucket) const
+{
+	if (bucket >= m_bucketCapacity.size())
+	{
+		return(0);
+	}
+	return(m_bucketCapacity[bucket]);
+}
+
+/***********************************************************
+ *  DrawBucket()
+ *
+ *  This method is used for drawing the commands the culling
+ *  shader wrote into a bucket, with the buffers bound.  The
+ *  GPU reads the number of commands from the count buffer.
+ ***********************************************************/
+void GpuCuller::DrawBucket(uint32_t bucket, GLenum mode)
+{
+	uint32_t capacity = GetBucketCapacity(bucket);
+	if (capacity == 0)
+	{
+		return;
+	}
+
+	glMultiDrawElementsIndirectCount(
+		mode,
+		GL_UNSIGNED_INT,
+		(const void*)(m_bucketFirst[bucket] * sizeof(DRAW_COMMAND)),
+		(GLintptr)(bucket * sizeof(GLuint)),
+		(GLsizei)capacity,
+		0);
+	if (NULL != m_pRenderStats)
+	{
+		m_pRenderStats->CountMultiDraw();
+	}
+}
+
+/***********************************************************
+ *  BeginLoadShaders()
+ *
+ *  This method is used for starting to build the culling
+ *  compute shader program, so it compiles while the other
+ *  programs of startup do.  Create() finishes it.
+ ***********************************************************/
+void GpuCuller::BeginLoadShaders(ShaderManager* pSceneShaders)
+{
+	pSceneShaders->BeginLoadComputeShader(CULLING_COMPUTE_SHADER_FILE);
+}
+
+/***********************************************************
+ *  GetShaderFiles()
+ *
+ *  This method is used for getting the GLSL files of the
+ *  culling shader and the vertex shader, for packing them
+ *  in the asset archive.
+ ***********************************************************/
+void GpuCuller::GetShaderFiles(std::vector<std::string>& files)
+{
+	files.push_back(CULLING_COMPUTE_SHADER_FILE);
+	files.push_back(GPU_VERTEX_SHADER_FILE);
+}
+
+/***********************************************************
+ *  GetVertexShaderFile()
+ *
+ *  This method is used for getting the vertex shader the
+ *  scene is drawn with when it is culled on the GPU.  It
+ *  reads the object blocks from the object buffer.
+ ***********************************************************/
+const char* GpuCuller::GetVertexShaderFile()
+{
+	return(GPU_VERTEX_SHADER_FILE);
+}
@@ -0,0 +1,155 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuculler.h
+// ============
+// frustum culling and draw command compaction in a compute shader
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "FrameRingBuffer.h"
+#include "RenderStats.h"
+
+#include <GL/glew.h>        // GLEW library
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  GpuCuller
+ *
+ *  This class contains the code for culling the scene
+ *  objects on the GPU.  Every object has an object block,
+ *  with its model matrix and appearance, and a draw record,
+ *  with its mesh ranges and the box around its mesh, kept in
+ *  shader storage buffers.  The buffers are filled when the
+ *  scene is built, and after that only the object blocks of
+ *  objects that moved are sent, so the CPU work of a frame
+ *  does not grow with the size of the scene.  They are
+ *  written into the frame's part of an upload ring buffer
+ *  and copied across on the GPU, so the CPU never waits for
+ *  the draws of the frames before to finish reading them.
+ *
+ *  Every frame a compute shader tests each object's world
+ *  box against the frustum and appends an indirect draw
+ *  command for each visible one to its bucket, counting the
+ *  commands with an atomic add.  The buckets are drawn with
+ *  glMultiDrawElementsIndirectCount(), which reads the counts
+ *  from the GPU, so nothing is read back.  Each command puts
+ *  the object index in its base instance, where the vertex
+ *  shader finds the object block.
+ *
+ *  The caller decides the buckets - one per run of draws that
+ *  needs its own state, such as a texture or lines.
+ ***********************************************************/
+class GpuCuller
+{
+public:
+	// indirect draw command as the multi draw reads it
+	struct DRAW_COMMAND
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// per-object culling values in the std430 layout of the
+	// DrawRecord struct of the culling shader
+	struct DRAW_RECORD
+	{
+		// box around the stored positions of the mesh
+		glm::vec4 boundsMin;
+		glm::vec4 boundsMax;
+		// index count, first index, bucket, and first command of
+		// the bucket - filled in by SetObjects()
+		uint32_t triangles[4];
+		// the same for the lines, NO_BUCKET when there are none
+		uint32_t lines[4];
+		// base vertex of the mesh, the rest is padding
+		int32_t baseVertex[4];
+	};
+
+	static const uint32_t NO_BUCKET = 0xFFFFFFFF;
+
+	// constructor
+	GpuCuller();
+	// destructor
+	~GpuCuller();
+
+	// check whether the context has compute shaders, draw
+	// parameters and indirect draw counts
+	static bool IsSupported();
+
+	// load the culling compute shader, the same way as the
+	// scene shaders are loaded
+	bool Create(const ShaderManager* pSceneShaders);
+	// free the buffers and the compute shader
+	void Destroy();
+	// set how many frames of uploads can be in flight
+	void SetPipelineDepth(int numFrames) { m_pUploadBuffer->SetNumFrames(numFrames); }
+
+	// replace every object with the passed in object blocks,
+	// each objectBlockSize bytes, and draw records
+	void SetObjects(
+		const void* pObjectBlocks,
+		size_t objectBlockSize,
+		std::vector<DRAW_RECORD>& records,
+		uint32_t numBuckets);
+	// change the object block of one object, sent with the
+	// next cull
+	void UpdateObject(uint32_t index, const void* pObjectBlock);
+
+	// send the changed object blocks and write the draw
+	// commands of the objects inside the frustum planes, this
+	// leaves the compute shader program in use
+	void Cull(const glm::vec4 frustumPlanes[6]);
+
+	// bind the buffers read by the draws of the buckets
+	void BindBuffers();
+	// most commands a bucket can hold, zero for an unused one
+	uint32_t GetBucketCapacity(uint32_t bucket) const;
+	// draw the commands written into one bucket
+	void DrawBucket(uint32_t bucket, GLenum mode);
+
+	// get the GLSL files of the culling and drawing shaders
+	static void GetShaderFiles(std::vector<std::string>& files);
+	// start building the culling shader program ahead of
+	// Create(), with the other programs of startup
+	static void BeginLoadShaders(ShaderManager* pSceneShaders);
+	// get the vertex shader that reads the object buffer
+	static const char* GetVertexShaderFile();
+
+private:
+	// culling compute shader program
+	ShaderManager* m_pCullShader;
+	RenderStats* m_pRenderStats;
+	// shader storage buffers
+	GLuint m_recordBufferID;
+	GLuint m_objectBufferID;
+	GLuint m_commandBufferID;
+	GLuint m_countBufferID;
+	// per-frame parts the changed object blocks are sent from
+	FrameRingBuffer* m_pUploadBuffer;
+
+	uint32_t m_numObjects;
+	size_t m_objectBlockSize;
+	// copy of the object blocks, sent from for the changes
+	std::vector<unsigned char> m_objectBlocks;
+	// objects whose block changed since the last cull
+	std::vector<uint32_t> m_changedObjects;
+	// first command and most commands of each bucket
+	std::vector<uint32_t> m_bucketFirst;
+	std::vector<uint32_t> m_bucketCapacity;
+
+	// create a buffer holding the passed in bytes
+	static GLuint CreateBuffer(GLenum target, size_t size, const void* pData, GLenum usage);
+	// free the shader storage buffers
+	void DestroyBuffers();
+	// send the changed object blocks, merged into runs
+	void SendChangedObjects();
+};
@@ -0,0 +1,307 @@
+///////////////////////////////////////////////////////////////////////////////
+// inputrecorder.cpp
+// ============
+// record timestamped GLFW input events to a binary log and replay them
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "InputRecorder.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+
+#include "GLFW/glfw3.h"     // GLFW library
+
+// declaration of global variables
+namespace
+{
+	// identifies the input log file format
+	const char g_LogMagic[4] = { 'I', 'N', 'R', 'C' };
+	const uint32_t g_LogVersion = 1;
+
+	// header written at the start of the input log file
+	struct INPUT_LOG_HEADER
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t eventSize;
+		uint32_t eventCount;
+	};
+}
+
+/***********************************************************
+ *  InputRecorder()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+InputRecorder::InputRecorder()
+{
+	m_recordStartTime = 0.0;
+	m_bRecording = false;
+	m_replayIndex = 0;
+	m_replayKeys.assign(GLFW_KEY_LAST + 1, 0);
+	m_replayEndTime = 0.0f;
+	m_bReplaying = false;
+}
+
+/***********************************************************
+ *  ~InputRecorder()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+InputRecorder::~InputRecorder()
+{
+	m_events.clear();
+}
+
+/***********************************************************
+ *  StartRecording()
+ *
+ *  This method is used for starting a new recording.  The
+ *  events are kept in memory and written out in one go when
+ *  the recording is stopped, so recording adds no file I/O
+ *  to the frames being measured.
+ ***********************************************************/
+bool InputRecorder::StartRecording(const char* filename, double currentTime)
+{
+	if (m_bReplaying == true)
+	{
+		std::cout << "ERROR: cannot record input while replaying" << std::endl;
+		return(false);
+	}
+
+	m_recordFilename = filename;
+	m_recordStartTime = currentTime;
+	m_events.clear();
+	m_events.reserve(16384);
+	m_bRecording = true;
+
+	std::cout << "INFO: Recording input to " << filename << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  StopRecording()
+ *
+ *  This method is used for closing the recording with an
+ *  end event and writing the events into the log file.
+ ***********************************************************/
+bool InputRecorder::StopRecording(double currentTime)
+{
+	if (m_bRecording == false)
+	{
+		return(false);
+	}
+
+	AddEvent(currentTime, EVENT_END, 0, 0, 0.0f, 0.0f);
+	m_bRecording = false;
+
+	std::ofstream logFile(m_recordFilename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!logFile.is_open())
+	{
+		std::cout << "ERROR: could not write input log:" << m_recordFilename << std::endl;
+		return(false);
+	}
+
+	INPUT_LOG_HEADER header;
+	memcpy(header.magic, g_LogMagic, sizeof(header.magic));
+	header.version = g_LogVersion;
+	header.eventSize = sizeof(INPUT_EVENT);
+	header.eventCount = (uint32_t)m_events.size();
+
+	logFile.write((const char*)&header, sizeof(header));
+	logFile.write((const char*)m_events.data(), m_events.size() * sizeof(INPUT_EVENT));
+
+	std::cout << "INFO: Wrote " << m_events.size() << " input events ("
+		<< m_events.back().time << "s) to " << m_recordFilename << std::endl;
+
+	return(logFile.good());
+}
+
+/***********************************************************
+ *  Record*()
+ *
+ *  These methods are used for adding live input events to
+ *  the recording, when a recording is in progress.
+ ***********************************************************/
+void InputRecorder::RecordMouseMove(double currentTime, double xMousePos, double yMousePos)
+{
+	AddEvent(currentTime, EVENT_MOUSE_MOVE, 0, 0, (float)xMousePos, (float)yMousePos);
+}
+
+void InputRecorder::RecordMouseScroll(double currentTime, double xOffset, double yOffset)
+{
+	AddEvent(currentTime, EVENT_MOUSE_SCROLL, 0, 0, (float)xOffset, (float)yOffset);
+}
+
+void InputRecorder::RecordKey(double currentTime, int key, int action)
+{
+	// key repeats do not change the held key state
+	if ((key < 0) || (key > GLFW_KEY_LAST) || (action == GLFW_REPEAT))
+	{
+		return;
+	}
+	AddEvent(currentTime, EVENT_KEY, (uint8_t)action, (uint16_t)key, 0.0f, 0.0f);
+}
+
+/***********************************************************
+ *  AddEvent()
+ *
+ *  This method is used for timestamping an event relative to
+ *  the start of the recording and adding it to the events.
+ ***********************************************************/
+void InputRecorder::AddEvent(double currentTime, uint8_t type, uint8_t action, uint16_t key, float x, float y)
+{
+	if (m_bRecording == false)
+	{
+		return;
+	}
+
+	INPUT_EVENT event;
+	event.time = (float)(currentTime - m_recordStartTime);
+	event.type = type;
+	event.action = action;
+	event.key = key;
+	event.x = x;
+	event.y = y;
+	m_events.push_back(event);
+}
+
+/***********************************************************
+ *  LoadReplay()
+ *
+ *  This method is used for reading a recorded input log
+ *  file and preparing it for replay from the beginning.
+ *  The header is checked against the size of the file, and
+ *  every event against the types, actions and keys that
+ *  are recorded, so a damaged log fails to load.
+ ***********************************************************/
+bool InputRecorder::LoadReplay(const char* filename)
+{
+	std::ifstream logFile(filename, std::ios::in | std::ios::binary | std::ios::ate);
+	if (!logFile.is_open())
+	{
+		std::cout << "ERROR: could not open input log:" << filename << std::endl;
+		return(false);
+	}
+	std::streamoff fileSize = logFile.tellg();
+	logFile.seekg(0, std::ios::beg);
+
+	INPUT_LOG_HEADER header;
+	logFile.read((char*)&header, sizeof(header));
+	if ((!logFile.good()) ||
+		(memcmp(header.magic, g_LogMagic, sizeof(header.magic)) != 0) ||
+		(header.version != g_LogVersion) ||
+		(header.eventSize != sizeof(INPUT_EVENT)))
+	{
+		std::cout << "ERROR: not a valid input log:" << filename << std::endl;
+		return(false);
+	}
+
+	if ((fileSize < (std::streamoff)sizeof(header)) ||
+		((uint64_t)header.eventCount > (uint64_t)(fileSize - sizeof(header)) / sizeof(INPUT_EVENT)))
+	{
+		std::cout << "ERROR: input log is truncated:" << filename << std::endl;
+		return(false);
+	}
+
+	m_events.resize(header.eventCount);
+	logFile.read((char*)m_events.data(), m_events.size() * sizeof(INPUT_EVENT));
+	if (!logFile.good())
+	{
+		std::cout << "ERROR: input log is truncated:" << filename << std::endl;
+		m_events.clear();
+		return(false);
+	}
+
+	for (size_t i = 0; i < m_events.size(); i++)
+	{
+		const INPUT_EVENT& event = m_events[i];
+		bool bValid = (event.type >= EVENT_MOUSE_MOVE) && (event.type <= EVENT_END);
+		if (event.type == EVENT_KEY)
+		{
+			bValid = (event.key <= GLFW_KEY_LAST) &&
+				((event.action == GLFW_PRESS) || (event.action == GLFW_RELEASE));
+		}
+		if (bValid == false)
+		{
+			std::cout << "ERROR: input log has an invalid event " << i << ":" << filename << std::endl;
+			m_events.clear();
+			return(false);
+		}
+	}
+
+	// the end event marks the length of the recording
+	m_replayEndTime = 0.0f;
+	if (m_events.size() > 0)
+	{
+		m_replayEndTime = m_events.back().time;
+	}
+
+	m_replayIndex = 0;
+	m_replayKeys.assign(GLFW_KEY_LAST + 1, 0);
+	m_bReplaying = true;
+
+	std::cout << "INFO: Replaying " << m_events.size() << " input events ("
+		<< m_replayEndTime << "s) from " << filename << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  ReplayEvents()
+ *
+ *  This method is used for collecting every event that is
+ *  due by the passed in replay time.  Key events update the
+ *  replayed key states, mouse events are handed back so the
+ *  caller can apply them in order.
+ ***********************************************************/
+void InputRecorder::ReplayEvents(double replayTime, std::vector<INPUT_EVENT>& dueEvents)
+{
+	dueEvents.clear();
+
+	while ((m_replayIndex < m_events.size()) &&
+		(m_events[m_replayIndex].time <= replayTime))
+	{
+		const INPUT_EVENT& event = m_events[m_replayIndex];
+		if (event.type == EVENT_KEY)
+		{
+			m_replayKeys[event.key] = (event.action == GLFW_PRESS) ? 1 : 0;
+		}
+		else if (event.type != EVENT_END)
+		{
+			dueEvents.push_back(event);
+		}
+		m_replayIndex++;
+	}
+}
+
+/***********************************************************
+ *  IsKeyDown()
+ *
+ *  This method is used for checking whether the passed in
+ *  key is held down at the current point of the replay.
+ ***********************************************************/
+bool InputRecorder::IsKeyDown(int key) const
+{
+	if ((key < 0) || (key > GLFW_KEY_LAST))
+	{
+		return(false);
+	}
+	return(m_replayKeys[key] != 0);
+}
+
+/***********************************************************
+ *  IsReplayFinished()
+ *
+ *  This method is used for checking whether the replay time
+ *  has passed the end of the recording.
+ ***********************************************************/
+bool InputRecorder::IsReplayFinished(double replayTime) const
+{
+	return((m_bReplaying == true) &&
+		(m_replayIndex >= m_events.size()) &&
+		(replayTime >= m_replayEndTime));
+}
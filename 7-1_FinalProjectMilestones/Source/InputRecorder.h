@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////////////
+// inputrecorder.h
+// ============
+// record timestamped GLFW input events to a binary log and replay them
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  InputRecorder
+ *
+ *  This class contains the code for recording the mouse and
+ *  keyboard events of a session into a compact binary log,
+ *  and for replaying that log on a fixed timestep so that
+ *  every replay produces the same sequence of views.
+ ***********************************************************/
+class InputRecorder
+{
+public:
+	// constructor
+	InputRecorder();
+	// destructor
+	~InputRecorder();
+
+	enum INPUT_EVENT_TYPE
+	{
+		EVENT_MOUSE_MOVE = 1,
+		EVENT_MOUSE_SCROLL = 2,
+		EVENT_KEY = 3,
+		EVENT_END = 4
+	};
+
+	// one recorded input event - 16 bytes in the log file
+	struct INPUT_EVENT
+	{
+		// seconds since the recording was started
+		float time;
+		uint8_t type;
+		// GLFW_PRESS or GLFW_RELEASE for key events
+		uint8_t action;
+		// GLFW key code for key events
+		uint16_t key;
+		// cursor position or scroll offsets
+		float x;
+		float y;
+	};
+
+	// start recording events into the passed in log file
+	bool StartRecording(const char* filename, double currentTime);
+	// stop recording and write the log file
+	bool StopRecording(double currentTime);
+
+	// add a live event to the recording
+	void RecordMouseMove(double currentTime, double xMousePos, double yMousePos);
+	void RecordMouseScroll(double currentTime, double xOffset, double yOffset);
+	void RecordKey(double currentTime, int key, int action);
+
+	// load a previously recorded log file for replay
+	bool LoadReplay(const char* filename);
+	// get the events due by the passed in replay time and
+	// apply the key events to the replayed key states
+	void ReplayEvents(double replayTime, std::vector<INPUT_EVENT>& dueEvents);
+	// check whether a key is held down in the replayed input
+	bool IsKeyDown(int key) const;
+	// check whether the replay has run past its end event
+	bool IsReplayFinished(double replayTime) const;
+
+	bool IsRecording() const { return(m_bRecording); }
+	bool IsReplaying() const { return(m_bReplaying); }
+
+private:
+	// events of the recording or of the loaded replay
+	std::vector<INPUT_EVENT> m_events;
+	// log file written when the recording is stopped
+	std::string m_recordFilename;
+	double m_recordStartTime;
+	bool m_bRecording;
+
+	// index of the next event to replay
+	size_t m_replayIndex;
+	// key states driven by the replayed key events
+	std::vector<uint8_t> m_replayKeys;
+	// time of the end event of the replay
+	float m_replayEndTime;
+	bool m_bReplaying;
+
+	// add an event to the recording
+	void AddEvent(double currentTime, uint8_t type, uint8_t action, uint16_t key, float x, float y);
+};
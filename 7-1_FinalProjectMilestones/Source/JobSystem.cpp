@@ -0,0 +1,229 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.cpp
+// ============
+// work-stealing task scheduler for running per-frame CPU work on all cores
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "JobSystem.h"
+
+/***********************************************************
+ *  JobSystem()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+JobSystem::JobSystem(unsigned int numWorkers)
+{
+	if (numWorkers == 0)
+	{
+		unsigned int numCores = std::thread::hardware_concurrency();
+		numWorkers = (numCores > 1) ? (numCores - 1) : 0;
+	}
+
+	m_queuedJobs = 0;
+	m_bRunning = true;
+
+	// one deque for the calling thread plus one per worker
+	for (unsigned int i = 0; i <= numWorkers; i++)
+	{
+		m_queues.push_back(std::unique_ptr<JOB_QUEUE>(new JOB_QUEUE()));
+	}
+	for (unsigned int i = 1; i <= numWorkers; i++)
+	{
+		m_workers.push_back(std::thread(&JobSystem::WorkerMain, this, i));
+	}
+}
+
+/***********************************************************
+ *  ~JobSystem()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> sleepGuard(m_sleepLock);
+		m_bRunning = false;
+	}
+	m_wakeCondition.notify_all();
+
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+}
+
+/***********************************************************
+ *  ParallelFor()
+ *
+ *  This method is used for running the passed in function
+ *  over the range [0, count) split into chunks of grainSize.
+ *  The chunks are dealt round-robin onto every deque so each
+ *  worker starts with local work; any imbalance is evened
+ *  out by stealing.  Returns once every chunk has finished.
+ ***********************************************************/
+void JobSystem::ParallelFor(size_t count, size_t grainSize, const RANGE_FUNCTION& function)
+{
+	if (count == 0)
+	{
+		return;
+	}
+	if (grainSize == 0)
+	{
+		grainSize = 1;
+	}
+
+	// small ranges are not worth waking the workers for
+	if ((count <= grainSize) || (m_workers.empty()))
+	{
+		function(0, count);
+		return;
+	}
+
+	size_t numChunks = (count + grainSize - 1) / grainSize;
+	std::atomic<size_t> remaining(numChunks);
+
+	// count the jobs before they can be taken so the queued
+	// count never drops below zero
+	m_queuedJobs += numChunks;
+
+	for (size_t chunk = 0; chunk < numChunks; chunk++)
+	{
+		JOB job;
+		job.pFunction = &function;
+		job.begin = chunk * grainSize;
+		job.end = (job.begin + grainSize < count) ? (job.begin + grainSize) : count;
+		job.pRemaining = &remaining;
+
+		JOB_QUEUE& queue = *m_queues[chunk % m_queues.size()];
+		std::lock_guard<std::mutex> queueGuard(queue.lock);
+		queue.jobs.push_back(job);
+	}
+
+	// taking the sleep lock orders the wake up after any
+	// worker that is just about to wait
+	{
+		std::lock_guard<std::mutex> sleepGuard(m_sleepLock);
+	}
+	m_wakeCondition.notify_all();
+
+	// the calling thread works too until every chunk is done
+	while (remaining.load(std::memory_order_acquire) > 0)
+	{
+		JOB job;
+		if (FindJob(0, job) == true)
+		{
+			RunJob(job);
+		}
+		else
+		{
+			// the last chunks are running on the workers
+			std::this_thread::yield();
+		}
+	}
+}
+
+/***********************************************************
+ *  WorkerMain()
+ *
+ *  This method is the loop run by each worker thread.  The
+ *  worker runs jobs while any can be found and sleeps when
+ *  no jobs are queued anywhere.
+ ***********************************************************/
+void JobSystem::WorkerMain(unsigned int queueIndex)
+{
+	while (true)
+	{
+		JOB job;
+		if (FindJob(queueIndex, job) == true)
+		{
+			RunJob(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> sleepGuard(m_sleepLock);
+		m_wakeCondition.wait(sleepGuard, [this]()
+			{
+				return((m_queuedJobs.load() > 0) || (m_bRunning == false));
+			});
+		if (m_bRunning == false)
+		{
+			return;
+		}
+	}
+}
+
+/***********************************************************
+ *  FindJob()
+ *
+ *  This method is used for finding the next job for the
+ *  thread - from its own deque first, then by stealing.
+ ***********************************************************/
+bool JobSystem::FindJob(unsigned int queueIndex, JOB& job)
+{
+	if ((PopJob(queueIndex, job) == true) || (StealJob(queueIndex, job) == true))
+	{
+		m_queuedJobs.fetch_sub(1);
+		return(true);
+	}
+	return(false);
+}
+
+/***********************************************************
+ *  PopJob()
+ *
+ *  This method is used for taking the newest job from the
+ *  back of the thread's own deque.
+ ***********************************************************/
+bool JobSystem::PopJob(unsigned int queueIndex, JOB& job)
+{
+	JOB_QUEUE& queue = *m_queues[queueIndex];
+	std::lock_guard<std::mutex> queueGuard(queue.lock);
+	if (queue.jobs.empty())
+	{
+		return(false);
+	}
+
+	job = queue.jobs.back();
+	queue.jobs.pop_back();
+	return(true);
+}
+
+/***********************************************************
+ *  StealJob()
+ *
+ *  This method is used for taking the oldest job from the
+ *  front of another thread's deque, visiting the other
+ *  deques starting next to the thief so that thieves spread
+ *  out over different victims.
+ ***********************************************************/
+bool JobSystem::StealJob(unsigned int thiefIndex, JOB& job)
+{
+	size_t numQueues = m_queues.size();
+	for (size_t offset = 1; offset < numQueues; offset++)
+	{
+		JOB_QUEUE& queue = *m_queues[(thiefIndex + offset) % numQueues];
+
+		// skip victims that are busy rather than wait on them
+		std::unique_lock<std::mutex> queueGuard(queue.lock, std::try_to_lock);
+		if ((queueGuard.owns_lock()) && (!queue.jobs.empty()))
+		{
+			job = queue.jobs.front();
+			queue.jobs.pop_front();
+			return(true);
+		}
+	}
+	return(false);
+}
+
+/***********************************************************
+ *  RunJob()
+ *
+ *  This method is used for running the job's sub-range and
+ *  counting its chunk as finished.
+ ***********************************************************/
+void JobSystem::RunJob(JOB& job)
+{
+	(*job.pFunction)(job.begin, job.end);
+	job.pRemaining->fetch_sub(1, std::memory_order_acq_rel);
+}
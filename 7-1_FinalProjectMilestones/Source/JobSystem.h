@@ -0,0 +1,88 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.h
+// ============
+// work-stealing task scheduler for running per-frame CPU work on all cores
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  JobSystem
+ *
+ *  This class contains a pool of worker threads, each with
+ *  its own job deque.  A thread pops jobs from the back of
+ *  its own deque (newest first, still warm in its cache) and
+ *  when that runs dry it steals from the front of the other
+ *  deques (oldest first, the largest untouched ranges).
+ *
+ *  ParallelFor() splits an index range into jobs, spreads
+ *  them over the deques and lets the calling thread work on
+ *  them too until the whole range is done.  It is meant to
+ *  be called from one thread at a time - the render thread.
+ ***********************************************************/
+class JobSystem
+{
+public:
+	// function run on one [begin, end) sub-range of the work
+	typedef std::function<void(size_t begin, size_t end)> RANGE_FUNCTION;
+
+	// constructor - zero workers means one per extra core
+	JobSystem(unsigned int numWorkers = 0);
+	// destructor
+	~JobSystem();
+
+	// run the function over [0, count) in chunks of grainSize
+	void ParallelFor(size_t count, size_t grainSize, const RANGE_FUNCTION& function);
+
+	// number of threads working on jobs, including the caller
+	unsigned int GetThreadCount() const { return((unsigned int)m_queues.size()); }
+
+private:
+	// one chunk of a parallel for
+	struct JOB
+	{
+		const RANGE_FUNCTION* pFunction;
+		size_t begin;
+		size_t end;
+		// chunks of the parallel for still to finish
+		std::atomic<size_t>* pRemaining;
+	};
+
+	// job deque owned by one thread - index 0 is the caller
+	struct JOB_QUEUE
+	{
+		std::mutex lock;
+		std::deque<JOB> jobs;
+	};
+
+	std::vector<std::unique_ptr<JOB_QUEUE>> m_queues;
+	std::vector<std::thread> m_workers;
+
+	// jobs queued and not taken yet, used for sleeping
+	std::atomic<size_t> m_queuedJobs;
+	std::atomic<bool> m_bRunning;
+	std::mutex m_sleepLock;
+	std::condition_variable m_wakeCondition;
+
+	// the loop run by each worker thread
+	void WorkerMain(unsigned int queueIndex);
+	// take the next job from the thread's own deque
+	bool PopJob(unsigned int queueIndex, JOB& job);
+	// take a job from the front of another thread's deque
+	bool StealJob(unsigned int thiefIndex, JOB& job);
+	// find a job for the thread, its own first
+	bool FindJob(unsigned int queueIndex, JOB& job);
+	// run the job and mark its chunk as done
+	static void RunJob(JOB& job);
+};
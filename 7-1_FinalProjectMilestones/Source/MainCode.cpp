@@ -9,6 +9,9 @@
 
 #include <iostream>         // error handling and output
 #include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // strcmp
+#include <atomic>
+#include <thread>
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -22,6 +25,16 @@
 #include "ViewManager.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "RenderStats.h"
+#include "TripleBuffer.h"
+#include "TransformBatch.h"
+#include "MeshletCuller.h"
+#include "FileWatcher.h"
+#include "AssetArchive.h"
+#include "ResolutionScaler.h"
+#include "FramePacer.h"
+#include "FrameRingBuffer.h"
+#include "RenderGraph.h"
 
 // Namespace for declaring global variables
 namespace
@@ -29,6 +42,10 @@ namespace
 	// Macro for window title
 	const char* const WINDOW_TITLE = "7-1 FinalProject and Milestones"; 
 
+	// GLSL source files of the shader program
+	const char* const VERTEX_SHADER_FILE = "shaders/vertexShader.glsl";
+	const char* const FRAGMENT_SHADER_FILE = "shaders/fragmentShader.glsl";
+
 	// Main GLFW window
 	GLFWwindow* g_Window = nullptr;
 
@@ -38,12 +55,127 @@ namespace
 	ShaderManager* g_ShaderManager = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+	// render stats object for counting the work done every frame
+	RenderStats* g_RenderStats = nullptr;
+	// file watcher object for reloading edited shader, texture
+	// and scene files while the application runs
+	FileWatcher* g_FileWatcher = nullptr;
+	// asset archive the shaders and scene are loaded from, when
+	// one was passed in on the command line
+	AssetArchive* g_AssetArchive = nullptr;
+	// resolution scaler object for drawing the scene offscreen
+	// at a scale that holds the target GPU frame time
+	ResolutionScaler* g_ResolutionScaler = nullptr;
+	// frame pacer object for the swap interval, the frame limit,
+	// the frames in flight and the latency measurements
+	FramePacer* g_FramePacer = nullptr;
+	// render graph object for ordering the passes of a frame and
+	// placing the textures they draw into
+	RenderGraph* g_RenderGraph = nullptr;
+
+	// options passed in on the command line
+	struct APP_OPTIONS
+	{
+		// input log file to record the session into
+		const char* recordFile = nullptr;
+		// input log file to drive the camera from
+		const char* replayFile = nullptr;
+		// camera path file to fly the camera along
+		const char* cameraPathFile = nullptr;
+		// timestep in seconds used for replays and camera paths
+		float fixedTimeStep = 1.0f / 60.0f;
+		// camera updates per second on the main thread while the
+		// scene renders on its own thread, zero renders in-line
+		float updateRate = 0.0f;
+		// number of transforms to benchmark, zero runs the scene
+		size_t benchmarkTransforms = 0;
+		// sphere slices of the meshlet benchmark, zero runs the scene
+		int benchmarkMeshletSlices = 0;
+		// store the shape mesh vertices packed into 16 bytes
+		bool bPackedVertices = false;
+		// asset archive to load the assets from
+		const char* archiveFile = nullptr;
+		// asset archive to build from the loose files, then exit
+		const char* buildArchiveFile = nullptr;
+		// always compile the shaders, skipping the binary cache
+		bool bNoShaderCache = false;
+		// skip the objects hidden behind the large objects
+		bool bOcclusionCulling = false;
+		// cull the objects and write their draws on the GPU
+		bool bGpuCulling = false;
+		// cull the meshlets of the large models
+		bool bMeshletCulling = false;
+		// merge the objects that don't move into static batches
+		bool bStaticBatching = false;
+		// only draw a frame when something changed
+		bool bOnDemandRendering = false;
+		// keep an image of the objects that don't move while the
+		// camera is still
+		bool bStaticLayerCache = false;
+		// GPU frame time in milliseconds the render resolution is
+		// scaled for, zero draws at the window resolution
+		float dynamicResolutionTarget = 0.0f;
+		// sharpening of the upscaled image, from 0 to 1
+		float upscaleSharpness = 0.0f;
+		// how the swap waits for the display refresh
+		FramePacer::SWAP_MODE swapMode = FramePacer::SWAP_DEFAULT;
+		// frames per second to limit the frames to, zero for none
+		float frameLimit = 0.0f;
+		// frames queued on the GPU the CPU can start a frame with,
+		// zero leaves it to the driver
+		int maxFramesInFlight = 0;
+		// frames of per-frame buffers the CPU writes ahead into
+		int pipelineDepth = FrameRingBuffer::DEFAULT_FRAMES;
+	};
+	APP_OPTIONS g_Options;
+
+	// one camera update handed from the update thread to the
+	// render thread - the renderer blends the two states
+	struct VIEW_TICK
+	{
+		ViewManager::CAMERA_STATE previous;
+		ViewManager::CAMERA_STATE current;
+		// time the current state was produced at
+		double tickTime;
+		float tickDuration;
+		// time of the oldest input the update moved the camera
+		// with, negative if there was none
+		double inputTime;
+	};
+	TripleBuffer<VIEW_TICK> g_ViewTicks;
+
+	// cleared by the update thread to stop the render thread
+	std::atomic<bool> g_bRenderThreadRunning(false);
+
+	// most camera updates run back to back after a stall
+	const int MAX_CATCH_UP_TICKS = 5;
+
+	// longest sleep between checks for changes when rendering on
+	// demand, which is how soon a saved file is noticed
+	const double ON_DEMAND_WAIT_SECONDS = 0.25;
+	// frames drawn after the last change, so the occlusion depth
+	// and the frame timers read back a few frames late catch up
+	const int ON_DEMAND_SETTLE_FRAMES = 3;
+	// refresh rate used for counting the skipped frames when the
+	// monitor doesn't report one
+	const int DEFAULT_REFRESH_RATE = 60;
+	// set by the window callbacks when the window has to be drawn
+	bool g_bWindowDirty = false;
 }
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
 bool InitializeGLFW();
 bool InitializeGLEW();
+bool ParseCommandLine(int argc, char* argv[]);
+bool BuildAssetArchive(const char* filename);
+void RenderThreadMain();
+void RunThreadedUpdate();
+void RunOnDemandRendering();
+void RenderFrame();
+void Window_Refresh_Callback(GLFWwindow* window);
+void WatchSourceFiles();
+bool ProcessFileChanges();
 
 
 /***********************************************************
@@ -54,14 +186,59 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	// if the command line options are not valid, then terminate the application
+	if (ParseCommandLine(argc, argv) == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// the transform benchmark needs no window
+	if (g_Options.benchmarkTransforms > 0)
+	{
+		TransformBatch::RunBenchmark(g_Options.benchmarkTransforms);
+		return(EXIT_SUCCESS);
+	}
+
+	// so does the meshlet benchmark
+	if (g_Options.benchmarkMeshletSlices > 0)
+	{
+		MeshletCuller::RunBenchmark(g_Options.benchmarkMeshletSlices);
+		return(EXIT_SUCCESS);
+	}
+
+	// packing the assets needs no window either
+	if (NULL != g_Options.buildArchiveFile)
+	{
+		return((BuildAssetArchive(g_Options.buildArchiveFile) == true) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	// map the asset archive before anything is loaded from it
+	if (NULL != g_Options.archiveFile)
+	{
+		g_AssetArchive = new AssetArchive();
+		if (g_AssetArchive->Open(g_Options.archiveFile) == false)
+		{
+			return(EXIT_FAILURE);
+		}
+	}
+
 	// if GLFW fails initialization, then terminate the application
 	if (InitializeGLFW() == false)
 	{
 		return(EXIT_FAILURE);
 	}
 
+	// create the render stats object shared by the managers
+	g_RenderStats = new RenderStats();
+
 	// try to create a new shader manager object
 	g_ShaderManager = new ShaderManager();
+	g_ShaderManager->SetRenderStats(g_RenderStats);
+	g_ShaderManager->SetAssetArchive(g_AssetArchive);
+	if (g_Options.bNoShaderCache == true)
+	{
+		g_ShaderManager->SetProgramCacheDirectory("");
+	}
 	// try to create a new view manager object
 	g_ViewManager = new ViewManager(
 		g_ShaderManager);
@@ -75,42 +252,159 @@ int main(int argc, char* argv[])
 		return(EXIT_FAILURE);
 	}
 
+	// try to create a new scene manager object and prepare the 3D scene
+	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager->SetPackedVertices(g_Options.bPackedVertices);
+	g_SceneManager->SetAssetArchive(g_AssetArchive);
+	g_SceneManager->SetOcclusionCulling(g_Options.bOcclusionCulling);
+	g_SceneManager->SetGpuCulling(g_Options.bGpuCulling);
+	g_SceneManager->SetMeshletCulling(g_Options.bMeshletCulling);
+	g_SceneManager->SetStaticBatching(g_Options.bStaticBatching);
+	g_SceneManager->SetStaticLayerCache(g_Options.bStaticLayerCache);
+	g_SceneManager->SetPipelineDepth(g_Options.pipelineDepth);
+
+	// start building every shader program used at startup before
+	// waiting on any, so the driver compiles them side by side
+	g_ShaderManager->BeginLoadShaders(VERTEX_SHADER_FILE, FRAGMENT_SHADER_FILE);
+	g_SceneManager->BeginLoadShaders(FRAGMENT_SHADER_FILE);
+	if (g_Options.dynamicResolutionTarget > 0.0f)
+	{
+		ResolutionScaler::BeginLoadShaders(g_ShaderManager);
+	}
+
 	// load the shader code from the external GLSL files
 	g_ShaderManager->LoadShaders(
-		"shaders/vertexShader.glsl",
-		"shaders/fragmentShader.glsl");
+		VERTEX_SHADER_FILE,
+		FRAGMENT_SHADER_FILE);
 	g_ShaderManager->use();
 
-	// try to create a new scene manager object and prepare the 3D scene
-	g_SceneManager = new SceneManager(g_ShaderManager);
 	g_SceneManager->PrepareScene();
 
+	// draw the scene offscreen and scale it up to the window
+	if (g_Options.dynamicResolutionTarget > 0.0f)
+	{
+		int windowWidth = 0;
+		int windowHeight = 0;
+		glfwGetFramebufferSize(g_Window, &windowWidth, &windowHeight);
+
+		g_ResolutionScaler = new ResolutionScaler();
+		g_ResolutionScaler->SetTargetFrameTime(g_Options.dynamicResolutionTarget);
+		g_ResolutionScaler->SetSharpness(g_Options.upscaleSharpness);
+		if (g_ResolutionScaler->Create(g_ShaderManager, windowWidth, windowHeight) == false)
+		{
+			delete g_ResolutionScaler;
+			g_ResolutionScaler = NULL;
+		}
+		g_ShaderManager->use();
+	}
+
+	// free the programs begun for a feature that turned itself off
+	ShaderManager::DiscardPendingBuilds();
+
+	// set the swap interval and start measuring the latency
+	g_FramePacer = new FramePacer();
+	g_FramePacer->SetSwapMode(g_Options.swapMode);
+	g_FramePacer->SetFrameLimit(g_Options.frameLimit);
+	g_FramePacer->SetMaxFramesInFlight(g_Options.maxFramesInFlight);
+	g_FramePacer->Create(g_RenderStats);
+
+	// schedule the passes of every frame
+	g_RenderGraph = new RenderGraph();
+	g_RenderGraph->SetRenderStats(g_RenderStats);
+
+	// watch the files the shaders and the scene were loaded from,
+	// the assets of an archive only change when it is rebuilt
+	if (NULL == g_AssetArchive)
+	{
+		WatchSourceFiles();
+	}
+
+	// set up the input recording or the scripted camera
+	g_ViewManager->SetFixedTimeStep(g_Options.fixedTimeStep);
+	if ((NULL != g_Options.replayFile) &&
+		(g_ViewManager->StartInputReplay(g_Options.replayFile) == false))
+	{
+		return(EXIT_FAILURE);
+	}
+	if ((NULL != g_Options.cameraPathFile) &&
+		(g_ViewManager->StartCameraPath(g_Options.cameraPathFile) == false))
+	{
+		return(EXIT_FAILURE);
+	}
+	if (NULL != g_Options.recordFile)
+	{
+		g_ViewManager->StartInputRecording(g_Options.recordFile);
+	}
+
+	// when requested, update the camera on this thread at a
+	// fixed rate while the scene renders on its own thread
+	if (g_Options.updateRate > 0.0f)
+	{
+		RunThreadedUpdate();
+	}
+	// or sleep until an event, and only draw when it changes
+	// something on the screen
+	else if (g_Options.bOnDemandRendering == true)
+	{
+		RunOnDemandRendering();
+	}
+
 	// loop will keep running until the application is closed 
 	// or until an error has occurred
 	while (!glfwWindowShouldClose(g_Window))
 	{
-		// Enable z-depth
-		glEnable(GL_DEPTH_TEST);
+		// start counting the work done for this frame
+		g_RenderStats->BeginFrame();
 
-		// Clear the frame and z buffers
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		// wait for the GPU to catch up to the frames in flight
+		g_FramePacer->BeginFrame(ViewManager::TakeInputTime());
+
+		// reload any shader, texture or scene file that was saved
+		ProcessFileChanges();
 
 		// convert from 3D object space to 2D view
 		g_ViewManager->PrepareSceneView();
 
-		// refresh the 3D scene
-		g_SceneManager->RenderScene();
-
+		// draw the passes of the frame
+		RenderFrame();
 
 		// Flips the the back buffer with the front buffer every frame.
 		glfwSwapBuffers(g_Window);
 
+		// mark the end of the frame and wait for the frame limit
+		g_FramePacer->EndFrame();
+
+		// close the frame counters and print them periodically
+		g_RenderStats->EndFrame(glfwGetTime());
+
 		// query the latest GLFW events
 		glfwPollEvents();
 	}
 
+	// write out the input log if a recording was made
+	g_ViewManager->StopInputRecording();
+
 	// clear the allocated manager objects from memory
+	if (NULL != g_FileWatcher)
+	{
+		delete g_FileWatcher;
+		g_FileWatcher = NULL;
+	}
+	if (NULL != g_RenderGraph)
+	{
+		delete g_RenderGraph;
+		g_RenderGraph = NULL;
+	}
+	if (NULL != g_FramePacer)
+	{
+		delete g_FramePacer;
+		g_FramePacer = NULL;
+	}
+	if (NULL != g_ResolutionScaler)
+	{
+		delete g_ResolutionScaler;
+		g_ResolutionScaler = NULL;
+	}
 	if (NULL != g_SceneManager)
 	{
 		delete g_SceneManager;
@@ -126,11 +420,668 @@ int main(int argc, char* argv[])
 		delete g_ShaderManager;
 		g_ShaderManager = NULL;
 	}
+	if (NULL != g_RenderStats)
+	{
+		delete g_RenderStats;
+		g_RenderStats = NULL;
+	}
+	if (NULL != g_AssetArchive)
+	{
+		delete g_AssetArchive;
+		g_AssetArchive = NULL;
+	}
 
 	// Terminates the program successfully
 	exit(EXIT_SUCCESS); 
 }
 
+/***********************************************************
+ *	ParseCommandLine()
+ *
+ *  This function is used to read the options passed in on
+ *  the command line:
+ *    --record <file>       record the input into a log file
+ *    --replay <file>       drive the camera from a log file
+ *    --camera-path <file>  fly the camera along a spline path
+ *    --timestep <seconds>  fixed timestep for replays and paths
+ *    --update-rate <hz>    update the camera at a fixed rate on
+ *                          the main thread and render on a
+ *                          separate thread
+ *    --bench-transforms <count>  time the model matrix
+ *                          kernels and exit
+ *    --packed-vertices     store the shape mesh vertices
+ *                          packed into 16 bytes
+ *    --pak <file>          load the shaders, textures, models
+ *                          and scene from an asset archive
+ *    --build-pak <file>    pack the loose asset files into an
+ *                          asset archive and exit
+ *    --no-shader-cache     compile the shaders every run
+ *    --occlusion-culling   skip drawing the objects hidden
+ *                          behind the large objects
+ *    --gpu-culling         cull the objects in a compute
+ *                          shader and draw them indirectly
+ *    --meshlet-culling     skip the meshlets of the large
+ *                          models outside the view or facing
+ *                          away
+ *    --bench-meshlets <slices>  time the meshlet culling of
+ *                          a sphere and exit
+ *    --static-batching     draw the objects that don't move
+ *                          as a few merged batches
+ *    --dynamic-resolution <ms>  scale the resolution the scene
+ *                          is drawn at to hold the GPU frame
+ *                          time in milliseconds
+ *    --upscale-sharpen <0-1>  sharpen the upscaled image
+ *    --on-demand           only draw a frame when the camera,
+ *                          a watched file or the window changes
+ *    --static-layer-cache  reuse an image of the objects that
+ *                          don't move while the camera is still
+ *    --vsync <off|on|adaptive>  how the swap waits for the
+ *                          display refresh
+ *    --frame-limit <fps>   limit the frame rate, sleeping and
+ *                          spinning to the deadline
+ *    --max-frames-in-flight <count>  most frames the CPU can
+ *                          queue ahead of the GPU
+ *    --pipeline-depth <frames>  frames of per-frame buffers,
+ *                          written by the CPU while the GPU
+ *                          draws the frames before
+ ***********************************************************/
+bool ParseCommandLine(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; i++)
+	{
+		bool bHasValue = (i + 1 < argc);
+
+		if ((strcmp(argv[i], "--record") == 0) && bHasValue)
+		{
+			g_Options.recordFile = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--replay") == 0) && bHasValue)
+		{
+			g_Options.replayFile = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--camera-path") == 0) && bHasValue)
+		{
+			g_Options.cameraPathFile = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--timestep") == 0) && bHasValue)
+		{
+			g_Options.fixedTimeStep = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--update-rate") == 0) && bHasValue)
+		{
+			g_Options.updateRate = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--bench-transforms") == 0) && bHasValue)
+		{
+			g_Options.benchmarkTransforms = (size_t)strtoul(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--packed-vertices") == 0)
+		{
+			g_Options.bPackedVertices = true;
+		}
+		else if ((strcmp(argv[i], "--pak") == 0) && bHasValue)
+		{
+			g_Options.archiveFile = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--build-pak") == 0) && bHasValue)
+		{
+			g_Options.buildArchiveFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--no-shader-cache") == 0)
+		{
+			g_Options.bNoShaderCache = true;
+		}
+		else if (strcmp(argv[i], "--occlusion-culling") == 0)
+		{
+			g_Options.bOcclusionCulling = true;
+		}
+		else if (strcmp(argv[i], "--gpu-culling") == 0)
+		{
+			g_Options.bGpuCulling = true;
+		}
+		else if (strcmp(argv[i], "--meshlet-culling") == 0)
+		{
+			g_Options.bMeshletCulling = true;
+		}
+		else if (strcmp(argv[i], "--static-batching") == 0)
+		{
+			g_Options.bStaticBatching = true;
+		}
+		else if ((strcmp(argv[i], "--dynamic-resolution") == 0) && bHasValue)
+		{
+			g_Options.dynamicResolutionTarget = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--upscale-sharpen") == 0) && bHasValue)
+		{
+			g_Options.upscaleSharpness = (float)atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--on-demand") == 0)
+		{
+			g_Options.bOnDemandRendering = true;
+		}
+		else if (strcmp(argv[i], "--static-layer-cache") == 0)
+		{
+			g_Options.bStaticLayerCache = true;
+		}
+		else if ((strcmp(argv[i], "--vsync") == 0) && bHasValue)
+		{
+			if (FramePacer::ParseSwapMode(argv[++i], g_Options.swapMode) == false)
+			{
+				std::cerr << "Option --vsync must be off, on or adaptive" << std::endl;
+				return(false);
+			}
+		}
+		else if ((strcmp(argv[i], "--frame-limit") == 0) && bHasValue)
+		{
+			g_Options.frameLimit = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--max-frames-in-flight") == 0) && bHasValue)
+		{
+			g_Options.maxFramesInFlight = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--pipeline-depth") == 0) && bHasValue)
+		{
+			g_Options.pipelineDepth = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--bench-meshlets") == 0) && bHasValue)
+		{
+			g_Options.benchmarkMeshletSlices = atoi(argv[++i]);
+		}
+		else
+		{
+			std::cerr << "Unknown or incomplete option: " << argv[i] << std::endl;
+			return(false);
+		}
+	}
+
+	if ((NULL != g_Options.replayFile) && (NULL != g_Options.cameraPathFile))
+	{
+		std::cerr << "Options --replay and --camera-path cannot be combined" << std::endl;
+		return(false);
+	}
+	if ((NULL != g_Options.recordFile) && (NULL != g_Options.replayFile))
+	{
+		std::cerr << "Options --record and --replay cannot be combined" << std::endl;
+		return(false);
+	}
+	if (g_Options.updateRate < 0.0f)
+	{
+		std::cerr << "Option --update-rate cannot be negative" << std::endl;
+		return(false);
+	}
+	if ((g_Options.updateRate > 0.0f) && (g_Options.bOnDemandRendering == true))
+	{
+		std::cerr << "Options --update-rate and --on-demand cannot be combined" << std::endl;
+		return(false);
+	}
+	if (g_Options.fixedTimeStep <= 0.0f)
+	{
+		std::cerr << "Option --timestep must be greater than zero" << std::endl;
+		return(false);
+	}
+	if (g_Options.dynamicResolutionTarget < 0.0f)
+	{
+		std::cerr << "Option --dynamic-resolution cannot be negative" << std::endl;
+		return(false);
+	}
+	if ((g_Options.upscaleSharpness < 0.0f) || (g_Options.upscaleSharpness > 1.0f))
+	{
+		std::cerr << "Option --upscale-sharpen must be between 0 and 1" << std::endl;
+		return(false);
+	}
+	if (g_Options.frameLimit < 0.0f)
+	{
+		std::cerr << "Option --frame-limit cannot be negative" << std::endl;
+		return(false);
+	}
+	if ((g_Options.maxFramesInFlight < 0) ||
+		(g_Options.maxFramesInFlight > FramePacer::MAX_FRAMES_IN_FLIGHT))
+	{
+		std::cerr << "Option --max-frames-in-flight must be between 0 and "
+			<< FramePacer::MAX_FRAMES_IN_FLIGHT << std::endl;
+		return(false);
+	}
+	if ((g_Options.pipelineDepth < 1) ||
+		(g_Options.pipelineDepth > FrameRingBuffer::MAX_FRAMES))
+	{
+		std::cerr << "Option --pipeline-depth must be between 1 and "
+			<< FrameRingBuffer::MAX_FRAMES << std::endl;
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *	BuildAssetArchive()
+ *
+ *  This function is used to pack the shader sources and
+ *  every file the scene is loaded from into one asset
+ *  archive, for loading with the --pak option.
+ ***********************************************************/
+bool BuildAssetArchive(const char* filename)
+{
+	std::vector<std::string> files;
+	files.push_back(VERTEX_SHADER_FILE);
+	files.push_back(FRAGMENT_SHADER_FILE);
+	ResolutionScaler::GetShaderFiles(files);
+	if (SceneManager::GetAssetFiles(files) == false)
+	{
+		return(false);
+	}
+
+	return(AssetArchive::BuildArchive(filename, files));
+}
+
+/***********************************************************
+ *	RunThreadedUpdate()
+ *
+ *  This function is used to run the camera updates at a fixed
+ *  rate on the main thread, which also has to poll the GLFW
+ *  events, while a separate render thread draws the frames.
+ *  Each update is published through a lock-free triple buffer
+ *  so a slow frame never delays input sampling, and the
+ *  renderer never waits for an update.
+ ***********************************************************/
+void RunThreadedUpdate()
+{
+	float tickDuration = 1.0f / g_Options.updateRate;
+
+	// publish the starting camera before the renderer starts
+	ViewManager::CAMERA_STATE lastState = g_ViewManager->GetCameraState();
+	VIEW_TICK& firstTick = g_ViewTicks.GetWriteBuffer();
+	firstTick.previous = lastState;
+	firstTick.current = lastState;
+	firstTick.tickTime = glfwGetTime();
+	firstTick.tickDuration = tickDuration;
+	firstTick.inputTime = -1.0;
+	g_ViewTicks.Publish();
+
+	// hand the OpenGL context over to the render thread
+	glfwMakeContextCurrent(NULL);
+	g_bRenderThreadRunning = true;
+	std::thread renderThread(RenderThreadMain);
+
+	double nextTickTime = glfwGetTime() + tickDuration;
+	while (!glfwWindowShouldClose(g_Window))
+	{
+		// sleep until the next update is due or an event arrives,
+		// the mouse callbacks run from inside this call
+		double currentTime = glfwGetTime();
+		if (currentTime < nextTickTime)
+		{
+			glfwWaitEventsTimeout(nextTickTime - currentTime);
+			continue;
+		}
+		glfwPollEvents();
+
+		// every update of the burst carries the input, as the
+		// renderer may only see the last one
+		double inputTime = ViewManager::TakeInputTime();
+		int numTicks = 0;
+		while ((currentTime >= nextTickTime) && (numTicks < MAX_CATCH_UP_TICKS))
+		{
+			g_ViewManager->UpdateCamera(tickDuration);
+
+			VIEW_TICK& tick = g_ViewTicks.GetWriteBuffer();
+			tick.previous = lastState;
+			tick.current = g_ViewManager->GetCameraState();
+			tick.tickTime = nextTickTime;
+			tick.tickDuration = tickDuration;
+			tick.inputTime = inputTime;
+			g_ViewTicks.Publish();
+
+			lastState = tick.current;
+			nextTickTime += tickDuration;
+			numTicks++;
+		}
+
+		// after a long stall start the tick clock over rather
+		// than running a burst of catch up updates
+		if (currentTime >= nextTickTime)
+		{
+			nextTickTime = currentTime + tickDuration;
+		}
+	}
+
+	// stop the render thread and take the context back for cleanup
+	g_bRenderThreadRunning = false;
+	renderThread.join();
+	glfwMakeContextCurrent(g_Window);
+}
+
+/***********************************************************
+ *	RenderThreadMain()
+ *
+ *  This function is used to render frames on the render
+ *  thread from the latest published camera update, blending
+ *  between the last two updates by how far the frame time
+ *  is past the latest one.
+ ***********************************************************/
+void RenderThreadMain()
+{
+	glfwMakeContextCurrent(g_Window);
+
+	// input already counted for a frame, as several frames can
+	// be drawn from one update
+	double drawnInputTime = -1.0;
+
+	while (g_bRenderThreadRunning)
+	{
+		// start counting the work done for this frame
+		g_RenderStats->BeginFrame();
+
+		// wait for the GPU to catch up to the frames in flight,
+		// the input is only known once the update is read
+		g_FramePacer->BeginFrame(-1.0);
+
+		// reload any shader, texture or scene file that was saved
+		ProcessFileChanges();
+
+		// blend the latest camera update for the frame time
+		const VIEW_TICK& tick = g_ViewTicks.Read();
+		if (tick.inputTime != drawnInputTime)
+		{
+			g_FramePacer->SetInputTime(tick.inputTime);
+			drawnInputTime = tick.inputTime;
+		}
+		float alpha = (float)((glfwGetTime() - tick.tickTime) / tick.tickDuration);
+		alpha = glm::clamp(alpha, 0.0f, 1.0f);
+
+		// convert from 3D object space to 2D view
+		g_ViewManager->PrepareSceneView(
+			ViewManager::InterpolateCameraState(tick.previous, tick.current, alpha));
+
+		// draw the passes of the frame
+		RenderFrame();
+
+		// Flips the the back buffer with the front buffer every frame.
+		glfwSwapBuffers(g_Window);
+
+		// mark the end of the frame and wait for the frame limit
+		g_FramePacer->EndFrame();
+
+		// close the frame counters and print them periodically
+		g_RenderStats->EndFrame(glfwGetTime());
+	}
+
+	glfwMakeContextCurrent(NULL);
+}
+
+/***********************************************************
+ *	RunOnDemandRendering()
+ *
+ *  This function is used to render frames only when there is
+ *  something new to show - the camera moved, from the input
+ *  or a scripted camera, a watched file was saved, or the
+ *  window has to be drawn again.  In between it sleeps in
+ *  glfwWaitEventsTimeout(), waking for the next event or the
+ *  timeout, and counts the refresh intervals of the monitor
+ *  that passed while asleep as skipped frames.  After a change
+ *  a few more frames are drawn, for the values read back from
+ *  the GPU a few frames late to catch up.
+ ***********************************************************/
+void RunOnDemandRendering()
+{
+	glfwSetWindowRefreshCallback(g_Window, &Window_Refresh_Callback);
+
+	ViewManager::CAMERA_STATE drawnState = g_ViewManager->GetCameraState();
+	int framesToDraw = ON_DEMAND_SETTLE_FRAMES;
+	double lastUpdateTime = glfwGetTime();
+
+	// a windowed window has no monitor of its own, so the
+	// primary monitor is taken as the one it is shown on
+	GLFWmonitor* pMonitor = glfwGetWindowMonitor(g_Window);
+	if (NULL == pMonitor)
+	{
+		pMonitor = glfwGetPrimaryMonitor();
+	}
+	const GLFWvidmode* pVideoMode = (NULL != pMonitor) ? glfwGetVideoMode(pMonitor) : NULL;
+	int refreshRate = DEFAULT_REFRESH_RATE;
+	if ((NULL != pVideoMode) && (pVideoMode->refreshRate > 0))
+	{
+		refreshRate = pVideoMode->refreshRate;
+	}
+	// refresh intervals spent asleep, with the part of an
+	// interval carried over to the next wait
+	double skippedIntervals = 0.0;
+
+	while (!glfwWindowShouldClose(g_Window))
+	{
+		// move the camera for the time since the last pass, held
+		// keys keep moving it without any new events
+		double currentTime = glfwGetTime();
+		g_ViewManager->UpdateCamera((float)(currentTime - lastUpdateTime));
+		lastUpdateTime = currentTime;
+		ViewManager::CAMERA_STATE cameraState = g_ViewManager->GetCameraState();
+		// input that changed nothing is not waiting on a frame
+		double inputTime = ViewManager::TakeInputTime();
+
+		// reload any shader, texture or scene file that was saved
+		bool bChanged = ProcessFileChanges();
+		if ((cameraState.position != drawnState.position) ||
+			(cameraState.front != drawnState.front) ||
+			(cameraState.up != drawnState.up) ||
+			(cameraState.zoom != drawnState.zoom))
+		{
+			bChanged = true;
+		}
+		if (g_bWindowDirty == true)
+		{
+			bChanged = true;
+			g_bWindowDirty = false;
+		}
+		if (bChanged == true)
+		{
+			framesToDraw = ON_DEMAND_SETTLE_FRAMES;
+		}
+
+		if (framesToDraw == 0)
+		{
+			double waitStartTime = glfwGetTime();
+			glfwWaitEventsTimeout(ON_DEMAND_WAIT_SECONDS);
+			// a key pressed during the wait has only just been
+			// held, so the camera doesn't move for the time asleep
+			lastUpdateTime = glfwGetTime();
+
+			skippedIntervals += (lastUpdateTime - waitStartTime) * refreshRate;
+			uint32_t numSkipped = (uint32_t)skippedIntervals;
+			skippedIntervals -= numSkipped;
+			g_RenderStats->CountSkippedFrames(numSkipped);
+			continue;
+		}
+		framesToDraw--;
+
+		// start counting the work done for this frame
+		g_RenderStats->BeginFrame();
+
+		// wait for the GPU to catch up to the frames in flight
+		g_FramePacer->BeginFrame(inputTime);
+
+		// convert from 3D object space to 2D view
+		g_ViewManager->PrepareSceneView(cameraState);
+		drawnState = cameraState;
+
+		// draw the passes of the frame
+		RenderFrame();
+
+		// Flips the the back buffer with the front buffer every frame.
+		glfwSwapBuffers(g_Window);
+
+		// mark the end of the frame and wait for the frame limit
+		g_FramePacer->EndFrame();
+
+		// close the frame counters and print them periodically
+		g_RenderStats->EndFrame(glfwGetTime());
+
+		// query the latest GLFW events
+		glfwPollEvents();
+	}
+}
+
+/***********************************************************
+ *	RenderFrame()
+ *
+ *  This function is used to draw the frame from the view set
+ *  up by PrepareSceneView(), as the passes of the render
+ *  graph.  The scene draws into the window, or with dynamic
+ *  resolution into a texture the upscale pass scales up to
+ *  the window.  The passes are added the same way every
+ *  frame, so the graph is only compiled once.
+ ***********************************************************/
+void RenderFrame()
+{
+	g_RenderGraph->BeginGraph();
+
+	// the scene clears what it draws into, as the textures of
+	// the graph start out undefined
+	auto drawScene = []()
+	{
+		// Enable z-depth
+		glEnable(GL_DEPTH_TEST);
+
+		// Clear the frame and z buffers
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		// refresh the 3D scene
+		g_SceneManager->SetViewProjection(
+			g_ViewManager->GetViewMatrix(),
+			g_ViewManager->GetProjectionMatrix());
+		g_SceneManager->RenderScene();
+	};
+
+	if (NULL == g_ResolutionScaler)
+	{
+		int scenePass = g_RenderGraph->AddPass("scene", drawScene);
+		g_RenderGraph->WriteTexture(scenePass, RenderGraph::BACKBUFFER);
+	}
+	else
+	{
+		// pick this frame's scale, the offscreen target is the
+		// size of the window at every scale
+		g_ResolutionScaler->BeginFrame();
+
+		RenderGraph::TEXTURE_DESC colorDesc;
+		colorDesc.width = g_ResolutionScaler->GetWindowWidth();
+		colorDesc.height = g_ResolutionScaler->GetWindowHeight();
+		colorDesc.format = GL_RGBA8;
+		RenderGraph::TEXTURE_DESC depthDesc = colorDesc;
+		depthDesc.format = GL_DEPTH_COMPONENT24;
+		int sceneColor = g_RenderGraph->CreateTexture("sceneColor", colorDesc);
+		int sceneDepth = g_RenderGraph->CreateTexture("sceneDepth", depthDesc);
+
+		int scenePass = g_RenderGraph->AddPass("scene", [drawScene]()
+		{
+			// draw into the corner at this frame's scale
+			g_ResolutionScaler->SetSceneViewport();
+			drawScene();
+		});
+		g_RenderGraph->WriteTexture(scenePass, sceneColor);
+		g_RenderGraph->WriteTexture(scenePass, sceneDepth);
+
+		int upscalePass = g_RenderGraph->AddPass("upscale", [sceneColor]()
+		{
+			// scale the frame up to the window
+			g_ResolutionScaler->Upscale(g_RenderGraph->GetTextureID(sceneColor));
+			// the scene shader program draws the next frame
+			g_ShaderManager->use();
+		});
+		g_RenderGraph->ReadTexture(upscalePass, sceneColor);
+		g_RenderGraph->WriteTexture(upscalePass, RenderGraph::BACKBUFFER);
+	}
+
+	if (g_RenderGraph->Compile() == true)
+	{
+		g_RenderGraph->Execute();
+	}
+
+	if (NULL != g_ResolutionScaler)
+	{
+		g_ResolutionScaler->EndFrame();
+	}
+}
+
+/***********************************************************
+ *	Window_Refresh_Callback()
+ *
+ *  This function is automatically called from GLFW whenever
+ *  the contents of the window have to be drawn again, such
+ *  as after it was uncovered or resized.
+ ***********************************************************/
+void Window_Refresh_Callback(GLFWwindow* window)
+{
+	g_bWindowDirty = true;
+}
+
+/***********************************************************
+ *	WatchSourceFiles()
+ *
+ *  This function is used to start watching the shader source
+ *  files and the texture images and scene file of the scene,
+ *  so they can be edited while the application runs.
+ ***********************************************************/
+void WatchSourceFiles()
+{
+	std::vector<std::string> files;
+	g_SceneManager->GetSourceFiles(files);
+	files.push_back(g_ShaderManager->GetVertexShaderPath());
+	files.push_back(g_ShaderManager->GetFragmentShaderPath());
+
+	g_FileWatcher = new FileWatcher();
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		if (g_FileWatcher->WatchFile(files[i]) == false)
+		{
+			std::cout << "Could not watch file:" << files[i] << std::endl;
+		}
+	}
+}
+
+/***********************************************************
+ *	ProcessFileChanges()
+ *
+ *  This function is used to reload the watched files that
+ *  were saved since the last frame.  It runs on the thread
+ *  that owns the OpenGL context, between frames.  Returns
+ *  true if any file was saved.
+ ***********************************************************/
+bool ProcessFileChanges()
+{
+	if (NULL == g_FileWatcher)
+	{
+		return(false);
+	}
+
+	std::vector<std::string> changedFiles;
+	g_FileWatcher->PollChanges(changedFiles);
+
+	bool bReloadShaders = false;
+	for (size_t i = 0; i < changedFiles.size(); i++)
+	{
+		std::cout << "File changed:" << changedFiles[i] << std::endl;
+		if (g_ShaderManager->IsShaderFile(changedFiles[i]) == true)
+		{
+			// both stages are linked together, so one reload
+			// covers saving both files
+			bReloadShaders = true;
+		}
+		else
+		{
+			g_SceneManager->ReloadSourceFile(changedFiles[i]);
+		}
+	}
+
+	if ((bReloadShaders == true) && (0 != g_ShaderManager->ReloadShaders()))
+	{
+		// a new program starts with default uniform values
+		g_ShaderManager->use();
+		g_SceneManager->SetupSceneLights();
+	}
+
+	return(changedFiles.empty() == false);
+}
+
 /***********************************************************
  *	InitializeGLFW()
  * 
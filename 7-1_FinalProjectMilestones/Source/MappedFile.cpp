@@ -0,0 +1,158 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.cpp
+// ============
+// read-only memory mapping of a whole file
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/***********************************************************
+ *  MappedFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MappedFile::MappedFile()
+{
+	m_pData = NULL;
+	m_size = 0;
+#if defined(_WIN32)
+	m_fileHandle = INVALID_HANDLE_VALUE;
+	m_mappingHandle = NULL;
+#endif
+}
+
+/***********************************************************
+ *  ~MappedFile()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for mapping the whole file into
+ *  memory.  An empty file opens with no data, as there is
+ *  nothing to map.
+ ***********************************************************/
+bool MappedFile::Open(const char* filename)
+{
+	Close();
+
+#if defined(_WIN32)
+	m_fileHandle = CreateFileA(
+		filename,
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		NULL,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+		NULL);
+	if (m_fileHandle == INVALID_HANDLE_VALUE)
+	{
+		return(false);
+	}
+
+	LARGE_INTEGER fileSize;
+	if (GetFileSizeEx(m_fileHandle, &fileSize) == FALSE)
+	{
+		Close();
+		return(false);
+	}
+	if (fileSize.QuadPart == 0)
+	{
+		Close();
+		return(true);
+	}
+	m_size = (size_t)fileSize.QuadPart;
+
+	m_mappingHandle = CreateFileMappingA(m_fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (NULL != m_mappingHandle)
+	{
+		m_pData = (const unsigned char*)MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	}
+#else
+	int fileHandle = open(filename, O_RDONLY);
+	if (fileHandle < 0)
+	{
+		return(false);
+	}
+
+	struct stat fileInfo;
+	if (fstat(fileHandle, &fileInfo) != 0)
+	{
+		close(fileHandle);
+		return(false);
+	}
+	if (fileInfo.st_size == 0)
+	{
+		close(fileHandle);
+		return(true);
+	}
+	m_size = (size_t)fileInfo.st_size;
+
+	void* pMapped = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fileHandle, 0);
+	// the mapping keeps the file contents reachable on its own
+	close(fileHandle);
+	if (pMapped != MAP_FAILED)
+	{
+		m_pData = (const unsigned char*)pMapped;
+		// the files are mostly read front to back once
+		madvise(pMapped, m_size, MADV_SEQUENTIAL);
+	}
+#endif
+
+	if (NULL == m_pData)
+	{
+		Close();
+		return(false);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for unmapping the file.
+ ***********************************************************/
+void MappedFile::Close()
+{
+#if defined(_WIN32)
+	if (NULL != m_pData)
+	{
+		UnmapViewOfFile(m_pData);
+	}
+	if (NULL != m_mappingHandle)
+	{
+		CloseHandle(m_mappingHandle);
+		m_mappingHandle = NULL;
+	}
+	if (m_fileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_fileHandle);
+		m_fileHandle = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (NULL != m_pData)
+	{
+		munmap((void*)m_pData, m_size);
+	}
+#endif
+	m_pData = NULL;
+	m_size = 0;
+}
@@ -0,0 +1,49 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.h
+// ============
+// read-only memory mapping of a whole file
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+
+/***********************************************************
+ *  MappedFile
+ *
+ *  This class contains the code for mapping a file into
+ *  memory read-only, with mmap() or a Windows file mapping.
+ *  The contents are read straight from the page cache, with
+ *  no read calls and no copy into a buffer of our own, and
+ *  pages are only loaded as they are touched.
+ ***********************************************************/
+class MappedFile
+{
+public:
+	// constructor
+	MappedFile();
+	// destructor
+	~MappedFile();
+
+	// map the whole file, returns false if it can't be opened
+	bool Open(const char* filename);
+	// unmap the file
+	void Close();
+
+	bool IsOpen() const { return(NULL != m_pData); }
+	const unsigned char* GetData() const { return(m_pData); }
+	size_t GetSize() const { return(m_size); }
+
+private:
+	const unsigned char* m_pData;
+	size_t m_size;
+#if defined(_WIN32)
+	void* m_fileHandle;
+	void* m_mappingHandle;
+#endif
+
+	// a mapping can't be shared by two owners
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+};
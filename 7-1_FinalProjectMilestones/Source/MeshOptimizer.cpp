@@ -0,0 +1,420 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshoptimizer.cpp
+// ============
+// reorder mesh triangles and vertices for the GPU vertex cache and overdraw
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+// declaration of the global variables and defines
+namespace
+{
+	// size of the LRU cache the triangle order is scored with
+	const int SCORING_CACHE_SIZE = 32;
+	// size of the FIFO cache the cost is measured with
+	const int SIMULATED_CACHE_SIZE = 16;
+
+	// vertex scoring constants from Forsyth's paper
+	const float CACHE_DECAY_POWER = 1.5f;
+	const float LAST_TRIANGLE_SCORE = 0.75f;
+	const float VALENCE_BOOST_SCALE = 2.0f;
+	const float VALENCE_BOOST_POWER = 0.5f;
+
+	/***********************************************************
+	 *  ScoreVertex()
+	 *
+	 *  This function is used to score a vertex from its place
+	 *  in the cache, -1 when not cached, and the number of its
+	 *  triangles not yet added.  Vertices just used and
+	 *  vertices with few triangles left score highest, so the
+	 *  triangles that finish off a vertex are added first.
+	 ***********************************************************/
+	float ScoreVertex(int cachePosition, uint32_t numRemaining)
+	{
+		if (0 == numRemaining)
+		{
+			return(-1.0f);
+		}
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			if (cachePosition < 3)
+			{
+				// used by the last triangle, which keeps a fixed
+				// score so strips are not favored too strongly
+				score = LAST_TRIANGLE_SCORE;
+			}
+			else
+			{
+				float scale = 1.0f / (SCORING_CACHE_SIZE - 3);
+				score = powf(1.0f - (cachePosition - 3) * scale, CACHE_DECAY_POWER);
+			}
+		}
+
+		score += VALENCE_BOOST_SCALE * powf((float)numRemaining, -VALENCE_BOOST_POWER);
+		return(score);
+	}
+}
+
+/***********************************************************
+ *  OptimizeMesh()
+ *
+ *  This method is used for running the vertex cache,
+ *  overdraw and vertex fetch steps on a mesh, and measuring
+ *  its vertex cache cost before and after.
+ ***********************************************************/
+void MeshOptimizer::OptimizeMesh(
+	GeometryPool::MESH_DATA& mesh,
+	CACHE_STATS& before,
+	CACHE_STATS& after)
+{
+	before = AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+
+	OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+	OptimizeOverdraw(mesh.indices, mesh.vertices);
+	OptimizeVertexFetch(mesh);
+
+	after = AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+}
+
+/***********************************************************
+ *  OptimizeVertexCache()
+ *
+ *  This method is used for reordering the triangles with
+ *  Forsyth's algorithm.  Every vertex is scored, a triangle
+ *  scores the sum of its vertices, and the best triangle is
+ *  added next.  Only the triangles of the cached vertices can
+ *  change score, so after the first pick the next one is
+ *  searched for among them, and only when none are left is
+ *  the next triangle not yet added taken in input order.
+ ***********************************************************/
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, size_t numVertices)
+{
+	size_t numTriangles = indices.size() / 3;
+	if (numTriangles == 0)
+	{
+		return;
+	}
+
+	// triangles of each vertex, as offsets into one list
+	std::vector<uint32_t> triangleCounts(numVertices, 0);
+	for (size_t i = 0; i < numTriangles * 3; i++)
+	{
+		triangleCounts[indices[i]]++;
+	}
+	std::vector<uint32_t> triangleOffsets(numVertices + 1, 0);
+	for (size_t v = 0; v < numVertices; v++)
+	{
+		triangleOffsets[v + 1] = triangleOffsets[v] + triangleCounts[v];
+	}
+	std::vector<uint32_t> vertexTriangles(numTriangles * 3);
+	std::vector<uint32_t> numRemaining(numVertices, 0);
+	for (size_t t = 0; t < numTriangles; t++)
+	{
+		for (int corner = 0; corner < 3; corner++)
+		{
+			uint32_t v = indices[t * 3 + corner];
+			vertexTriangles[triangleOffsets[v] + numRemaining[v]] = (uint32_t)t;
+			numRemaining[v]++;
+		}
+	}
+
+	std::vector<int> cachePositions(numVertices, -1);
+	std::vector<float> vertexScores(numVertices);
+	for (size_t v = 0; v < numVertices; v++)
+	{
+		vertexScores[v] = ScoreVertex(-1, numRemaining[v]);
+	}
+	std::vector<float> triangleScores(numTriangles);
+	std::vector<bool> triangleAdded(numTriangles, false);
+	for (size_t t = 0; t < numTriangles; t++)
+	{
+		triangleScores[t] =
+			vertexScores[indices[t * 3]] +
+			vertexScores[indices[t * 3 + 1]] +
+			vertexScores[indices[t * 3 + 2]];
+	}
+
+	// the first triangle is the best scoring one overall
+	size_t bestTriangle = 0;
+	for (size_t t = 1; t < numTriangles; t++)
+	{
+		if (triangleScores[t] > triangleScores[bestTriangle])
+		{
+			bestTriangle = t;
+		}
+	}
+
+	std::vector<uint32_t> newIndices;
+	newIndices.reserve(numTriangles * 3);
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> newCache;
+	cache.reserve(SCORING_CACHE_SIZE + 3);
+	newCache.reserve(SCORING_CACHE_SIZE + 3);
+	size_t nextInputTriangle = 0;
+
+	for (size_t added = 0; added < numTriangles; added++)
+	{
+		if (bestTriangle >= numTriangles)
+		{
+			// nothing cached has triangles left, so continue with
+			// the next triangle in input order
+			while (triangleAdded[nextInputTriangle] == true)
+			{
+				nextInputTriangle++;
+			}
+			bestTriangle = nextInputTriangle;
+		}
+
+		// add the triangle and take it off its vertices' lists
+		triangleAdded[bestTriangle] = true;
+		const uint32_t* triangle = &indices[bestTriangle * 3];
+		for (int corner = 0; corner < 3; corner++)
+		{
+			uint32_t v = triangle[corner];
+			newIndices.push_back(v);
+
+			uint32_t* pBegin = &vertexTriangles[triangleOffsets[v]];
+			uint32_t* pEnd = pBegin + numRemaining[v];
+			uint32_t* pFound = std::find(pBegin, pEnd, (uint32_t)bestTriangle);
+			*pFound = *(pEnd - 1);
+			numRemaining[v]--;
+		}
+
+		// move the vertices of the triangle to the front of the
+		// cache, and let the oldest entries fall off the end
+		newCache.clear();
+		newCache.push_back(triangle[0]);
+		newCache.push_back(triangle[1]);
+		newCache.push_back(triangle[2]);
+		for (size_t i = 0; i < cache.size(); i++)
+		{
+			uint32_t v = cache[i];
+			if ((v != triangle[0]) && (v != triangle[1]) && (v != triangle[2]))
+			{
+				newCache.push_back(v);
+			}
+		}
+		for (size_t i = 0; i < newCache.size(); i++)
+		{
+			uint32_t v = newCache[i];
+			cachePositions[v] = (i < (size_t)SCORING_CACHE_SIZE) ? (int)i : -1;
+			vertexScores[v] = ScoreVertex(cachePositions[v], numRemaining[v]);
+		}
+		if (newCache.size() > (size_t)SCORING_CACHE_SIZE)
+		{
+			newCache.resize(SCORING_CACHE_SIZE);
+		}
+		cache.swap(newCache);
+
+		// rescore the triangles of the cached vertices and pick
+		// the best of them
+		bestTriangle = numTriangles;
+		float bestScore = -1.0f;
+		for (size_t i = 0; i < cache.size(); i++)
+		{
+			uint32_t v = cache[i];
+			for (uint32_t j = 0; j < numRemaining[v]; j++)
+			{
+				uint32_t t = vertexTriangles[triangleOffsets[v] + j];
+				float score =
+					vertexScores[indices[t * 3]] +
+					vertexScores[indices[t * 3 + 1]] +
+					vertexScores[indices[t * 3 + 2]];
+				triangleScores[t] = score;
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = t;
+				}
+			}
+		}
+	}
+
+	// keep anything past the last whole triangle
+	newIndices.insert(newIndices.end(), indices.begin() + numTriangles * 3, indices.end());
+	indices.swap(newIndices);
+}
+
+/***********************************************************
+ *  OptimizeOverdraw()
+ *
+ *  This method is used for reordering whole clusters of the
+ *  cache ordered triangles.  A cluster ends where a triangle
+ *  misses the simulated cache on all three vertices, as the
+ *  cache starts over there anyway and moving the clusters
+ *  around costs almost no vertex reuse.  The clusters are
+ *  then sorted by how far their area weighted normal faces
+ *  away from the center of the mesh.  Seen from outside, the
+ *  outward facing surfaces are in front, so drawing them
+ *  first lets the depth test reject more of the rest.
+ ***********************************************************/
+void MeshOptimizer::OptimizeOverdraw(
+	std::vector<uint32_t>& indices,
+	const std::vector<GeometryPool::VERTEX>& vertices)
+{
+	size_t numTriangles = indices.size() / 3;
+	if (numTriangles < 2)
+	{
+		return;
+	}
+
+	// find where the clusters start
+	std::vector<size_t> clusterStarts;
+	std::vector<uint32_t> cacheTimes(vertices.size(), 0);
+	uint32_t time = SIMULATED_CACHE_SIZE + 1;
+	for (size_t t = 0; t < numTriangles; t++)
+	{
+		int numMisses = 0;
+		for (int corner = 0; corner < 3; corner++)
+		{
+			uint32_t v = indices[t * 3 + corner];
+			if (time - cacheTimes[v] > (uint32_t)SIMULATED_CACHE_SIZE)
+			{
+				cacheTimes[v] = time++;
+				numMisses++;
+			}
+		}
+		if ((t == 0) || (numMisses == 3))
+		{
+			clusterStarts.push_back(t);
+		}
+	}
+	if (clusterStarts.size() < 2)
+	{
+		return;
+	}
+
+	glm::vec3 meshCenter(0.0f);
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		meshCenter += vertices[i].position;
+	}
+	meshCenter = meshCenter / (float)vertices.size();
+
+	// sort key of each cluster, the outward facing ones first
+	std::vector<std::pair<float, size_t> > clusterOrder;
+	for (size_t c = 0; c < clusterStarts.size(); c++)
+	{
+		size_t begin = clusterStarts[c];
+		size_t end = (c + 1 < clusterStarts.size()) ? clusterStarts[c + 1] : numTriangles;
+
+		glm::vec3 center(0.0f);
+		glm::vec3 normal(0.0f);
+		float totalArea = 0.0f;
+		for (size_t t = begin; t < end; t++)
+		{
+			const glm::vec3& p0 = vertices[indices[t * 3]].position;
+			const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position;
+			const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position;
+
+			// the cross product length is twice the area
+			glm::vec3 areaNormal = glm::cross(p1 - p0, p2 - p0);
+			float area = glm::length(areaNormal);
+			center += (p0 + p1 + p2) * (area / 3.0f);
+			normal += areaNormal;
+			totalArea += area;
+		}
+
+		float outward = 0.0f;
+		if (totalArea > 0.0f)
+		{
+			center = center / totalArea;
+			outward = glm::dot(center - meshCenter, normal / totalArea);
+		}
+		clusterOrder.push_back(std::make_pair(-outward, c));
+	}
+	std::stable_sort(clusterOrder.begin(), clusterOrder.end());
+
+	std::vector<uint32_t> newIndices;
+	newIndices.reserve(indices.size());
+	for (size_t i = 0; i < clusterOrder.size(); i++)
+	{
+		size_t c = clusterOrder[i].second;
+		size_t begin = clusterStarts[c];
+		size_t end = (c + 1 < clusterStarts.size()) ? clusterStarts[c + 1] : numTriangles;
+		newIndices.insert(newIndices.end(), indices.begin() + begin * 3, indices.begin() + end * 3);
+	}
+	newIndices.insert(newIndices.end(), indices.begin() + numTriangles * 3, indices.end());
+	indices.swap(newIndices);
+}
+
+/***********************************************************
+ *  OptimizeVertexFetch()
+ *
+ *  This method is used for renumbering the vertices in the
+ *  order the triangles, and then the lines, first use them.
+ *  Vertices used by neither are dropped.
+ ***********************************************************/
+void MeshOptimizer::OptimizeVertexFetch(GeometryPool::MESH_DATA& mesh)
+{
+	const uint32_t UNUSED = 0xFFFFFFFF;
+	std::vector<uint32_t> remap(mesh.vertices.size(), UNUSED);
+	std::vector<GeometryPool::VERTEX> newVertices;
+	newVertices.reserve(mesh.vertices.size());
+
+	std::vector<uint32_t>* indexLists[2] = { &mesh.indices, &mesh.lineIndices };
+	for (int list = 0; list < 2; list++)
+	{
+		std::vector<uint32_t>& indices = *indexLists[list];
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			uint32_t v = indices[i];
+			if (remap[v] == UNUSED)
+			{
+				remap[v] = (uint32_t)newVertices.size();
+				newVertices.push_back(mesh.vertices[v]);
+			}
+			indices[i] = remap[v];
+		}
+	}
+
+	mesh.vertices.swap(newVertices);
+}
+
+/***********************************************************
+ *  AnalyzeVertexCache()
+ *
+ *  This method is used for counting the vertices a FIFO
+ *  post-transform cache would have to transform to draw the
+ *  triangles in order.
+ ***********************************************************/
+MeshOptimizer::CACHE_STATS MeshOptimizer::AnalyzeVertexCache(
+	const std::vector<uint32_t>& indices,
+	size_t numVertices)
+{
+	CACHE_STATS stats;
+	stats.numTransformed = 0;
+	stats.acmr = 0.0f;
+	stats.atvr = 0.0f;
+
+	// a vertex is cached while fewer than the cache size of
+	// vertices were transformed after it
+	std::vector<uint32_t> cacheTimes(numVertices, 0);
+	uint32_t time = SIMULATED_CACHE_SIZE + 1;
+	size_t numTriangles = indices.size() / 3;
+	for (size_t i = 0; i < numTriangles * 3; i++)
+	{
+		uint32_t v = indices[i];
+		if (time - cacheTimes[v] > (uint32_t)SIMULATED_CACHE_SIZE)
+		{
+			cacheTimes[v] = time++;
+			stats.numTransformed++;
+		}
+	}
+
+	if (numTriangles > 0)
+	{
+		stats.acmr = (float)stats.numTransformed / numTriangles;
+	}
+	if (numVertices > 0)
+	{
+		stats.atvr = (float)stats.numTransformed / numVertices;
+	}
+	return(stats);
+}
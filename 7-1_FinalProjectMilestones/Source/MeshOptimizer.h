@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshoptimizer.h
+// ============
+// reorder mesh triangles and vertices for the GPU vertex cache and overdraw
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GeometryPool.h"
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  MeshOptimizer
+ *
+ *  This class contains the code for reordering the triangles
+ *  and vertices of a mesh before it is added to the geometry
+ *  pool, without changing what is drawn:
+ *
+ *  1. Vertex cache - the triangles are ordered with Tom
+ *     Forsyth's linear-speed algorithm, so that the vertices
+ *     a triangle uses were transformed for a recent triangle
+ *     and are still in the post-transform cache.
+ *  2. Overdraw - the cache ordered triangles are split into
+ *     clusters where the cache starts over, and the clusters
+ *     facing out from the center of the mesh are drawn first,
+ *     so they hide the ones behind them from the depth test.
+ *  3. Vertex fetch - the vertices are renumbered in the order
+ *     the triangles first use them, so the vertex shader
+ *     reads the vertex buffer front to back.
+ *
+ *  The cost is measured with a FIFO cache simulation as the
+ *  ACMR, vertices transformed per triangle, and the ATVR,
+ *  vertices transformed per vertex of the mesh.  The ACMR is
+ *  3.0 when no vertex is reused and nears 0.5 for a large
+ *  regular grid, the ATVR is 1.0 when every vertex is only
+ *  transformed once.
+ ***********************************************************/
+class MeshOptimizer
+{
+public:
+	// cost of drawing a mesh in the simulated vertex cache
+	struct CACHE_STATS
+	{
+		uint32_t numTransformed;
+		// average cache miss ratio, transformed per triangle
+		float acmr;
+		// average transform to vertex ratio
+		float atvr;
+	};
+
+	// run all three steps on a mesh, filling in the cache
+	// stats from before and after
+	static void OptimizeMesh(
+		GeometryPool::MESH_DATA& mesh,
+		CACHE_STATS& before,
+		CACHE_STATS& after);
+
+	// order the triangles for the vertex cache
+	static void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t numVertices);
+	// order the clusters of cache ordered triangles so the
+	// outward facing ones are drawn first
+	static void OptimizeOverdraw(
+		std::vector<uint32_t>& indices,
+		const std::vector<GeometryPool::VERTEX>& vertices);
+	// renumber the vertices in the order they are first used
+	static void OptimizeVertexFetch(GeometryPool::MESH_DATA& mesh);
+
+	// simulate the triangles going through a FIFO vertex cache
+	static CACHE_STATS AnalyzeVertexCache(
+		const std::vector<uint32_t>& indices,
+		size_t numVertices);
+};
@@ -0,0 +1,594 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshletculler.cpp
+// ============
+// split large meshes into meshlets and cull them against the view with SIMD
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshletCuller.h"
+#include "MeshOptimizer.h"
+#include "ShapeMeshes.h"
+
+#include <glm/gtx/transform.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include <emmintrin.h>
+
+// declaration of the global variables and defines
+namespace
+{
+	// cutoff of a meshlet that is never back facing
+	const float NO_CONE_CUTOFF = 2.0f;
+	// cones wider than this from their axis are not worth a
+	// test, as the camera is almost never inside them
+	const float MIN_CONE_DOT = 0.1f;
+
+	// camera views timed by the benchmark, and the times each
+	// test is run, best one counts
+	const int BENCHMARK_VIEWS = 64;
+	const int BENCHMARK_RUNS = 5;
+
+	// frustum planes and camera position of one object, in the
+	// model space of its mesh
+	struct CULL_SPACE
+	{
+		glm::vec4 planes[6];
+		glm::vec3 camera;
+	};
+
+	/***********************************************************
+	 *  PrepareCullSpace()
+	 *
+	 *  This function is used to bring the view into the model
+	 *  space of an object.  The planes taken from the model view
+	 *  projection are the world planes seen from model space,
+	 *  and normalizing them there makes the plane distance of a
+	 *  sphere center comparable to its radius, however the
+	 *  model is scaled.
+	 ***********************************************************/
+	void PrepareCullSpace(
+		const glm::mat4& model,
+		const glm::mat4& viewProjection,
+		const glm::vec3& cameraPosition,
+		CULL_SPACE& space)
+	{
+		glm::mat4 modelViewProjection = viewProjection * model;
+		const glm::mat4& m = modelViewProjection;
+		glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+		glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+		glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+		glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+		space.planes[0] = row3 + row0;	// left
+		space.planes[1] = row3 - row0;	// right
+		space.planes[2] = row3 + row1;	// bottom
+		space.planes[3] = row3 - row1;	// top
+		space.planes[4] = row3 + row2;	// near
+		space.planes[5] = row3 - row2;	// far
+
+		for (int i = 0; i < 6; i++)
+		{
+			float length = glm::length(glm::vec3(space.planes[i]));
+			if (length > 0.0f)
+			{
+				space.planes[i] = space.planes[i] * (1.0f / length);
+			}
+		}
+
+		space.camera = glm::vec3(glm::inverse(model) * glm::vec4(cameraPosition, 1.0f));
+	}
+
+	/***********************************************************
+	 *  AppendRange()
+	 *
+	 *  This function is used to add the index range of a kept
+	 *  meshlet, merged into the last range when it follows on.
+	 ***********************************************************/
+	void AppendRange(std::vector<GeometryPool::INDEX_RANGE>& ranges, const GeometryPool::INDEX_RANGE& range)
+	{
+		if ((ranges.empty() == false) &&
+			(ranges.back().firstIndex + (GLuint)ranges.back().numIndices == range.firstIndex))
+		{
+			ranges.back().numIndices += range.numIndices;
+			return;
+		}
+		ranges.push_back(range);
+	}
+
+	/***********************************************************
+	 *  CullScalar()
+	 *
+	 *  This function is used to test the meshlets one at a time,
+	 *  the reference for the SSE2 kernel.
+	 ***********************************************************/
+	uint32_t CullScalar(
+		const MeshletCuller::MESHLET_SET& meshlets,
+		const CULL_SPACE& space,
+		bool bBackfaceCulling,
+		std::vector<GeometryPool::INDEX_RANGE>& ranges)
+	{
+		uint32_t numKept = 0;
+		size_t numMeshlets = meshlets.ranges.size();
+
+		for (size_t i = 0; i < numMeshlets; i++)
+		{
+			glm::vec3 center(meshlets.centerX[i], meshlets.centerY[i], meshlets.centerZ[i]);
+
+			bool bVisible = true;
+			for (int plane = 0; (plane < 6) && (bVisible == true); plane++)
+			{
+				float distance = glm::dot(glm::vec3(space.planes[plane]), center) + space.planes[plane].w;
+				bVisible = (distance + meshlets.radius[i] >= 0.0f);
+			}
+
+			if ((bVisible == true) && (bBackfaceCulling == true))
+			{
+				glm::vec3 toApex = glm::vec3(meshlets.apexX[i], meshlets.apexY[i], meshlets.apexZ[i]) - space.camera;
+				glm::vec3 axis(meshlets.axisX[i], meshlets.axisY[i], meshlets.axisZ[i]);
+				bVisible = (glm::dot(toApex, axis) <= meshlets.cutoff[i] * glm::length(toApex));
+			}
+
+			if (bVisible == true)
+			{
+				AppendRange(ranges, meshlets.ranges[i]);
+				numKept++;
+			}
+		}
+
+		return(numKept);
+	}
+
+	/***********************************************************
+	 *  CullSSE2()
+	 *
+	 *  This function is used to test 4 meshlets at once, one
+	 *  meshlet per lane, with no branches until the lanes that
+	 *  passed are gathered into ranges.
+	 ***********************************************************/
+	uint32_t CullSSE2(
+		const MeshletCuller::MESHLET_SET& meshlets,
+		const CULL_SPACE& space,
+		bool bBackfaceCulling,
+		std::vector<GeometryPool::INDEX_RANGE>& ranges)
+	{
+		uint32_t numKept = 0;
+		size_t numMeshlets = meshlets.ranges.size();
+
+		__m128 planeX[6];
+		__m128 planeY[6];
+		__m128 planeZ[6];
+		__m128 planeW[6];
+		for (int plane = 0; plane < 6; plane++)
+		{
+			planeX[plane] = _mm_set1_ps(space.planes[plane].x);
+			planeY[plane] = _mm_set1_ps(space.planes[plane].y);
+			planeZ[plane] = _mm_set1_ps(space.planes[plane].z);
+			planeW[plane] = _mm_set1_ps(space.planes[plane].w);
+		}
+		__m128 cameraX = _mm_set1_ps(space.camera.x);
+		__m128 cameraY = _mm_set1_ps(space.camera.y);
+		__m128 cameraZ = _mm_set1_ps(space.camera.z);
+		__m128 zero = _mm_setzero_ps();
+
+		for (size_t i = 0; i < numMeshlets; i += 4)
+		{
+			__m128 centerX = _mm_loadu_ps(&meshlets.centerX[i]);
+			__m128 centerY = _mm_loadu_ps(&meshlets.centerY[i]);
+			__m128 centerZ = _mm_loadu_ps(&meshlets.centerZ[i]);
+			__m128 radius = _mm_loadu_ps(&meshlets.radius[i]);
+
+			// sphere against the frustum planes
+			__m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (int plane = 0; plane < 6; plane++)
+			{
+				__m128 distance = _mm_add_ps(
+					_mm_add_ps(
+						_mm_add_ps(_mm_mul_ps(planeX[plane], centerX), _mm_mul_ps(planeY[plane], centerY)),
+						_mm_mul_ps(planeZ[plane], centerZ)),
+					planeW[plane]);
+				visible = _mm_and_ps(visible, _mm_cmpge_ps(_mm_add_ps(distance, radius), zero));
+			}
+
+			// camera inside the cone behind the apex
+			if (bBackfaceCulling == true)
+			{
+				__m128 toApexX = _mm_sub_ps(_mm_loadu_ps(&meshlets.apexX[i]), cameraX);
+				__m128 toApexY = _mm_sub_ps(_mm_loadu_ps(&meshlets.apexY[i]), cameraY);
+				__m128 toApexZ = _mm_sub_ps(_mm_loadu_ps(&meshlets.apexZ[i]), cameraZ);
+				__m128 axisDot = _mm_add_ps(
+					_mm_add_ps(
+						_mm_mul_ps(toApexX, _mm_loadu_ps(&meshlets.axisX[i])),
+						_mm_mul_ps(toApexY, _mm_loadu_ps(&meshlets.axisY[i]))),
+					_mm_mul_ps(toApexZ, _mm_loadu_ps(&meshlets.axisZ[i])));
+				__m128 length = _mm_sqrt_ps(_mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(toApexX, toApexX), _mm_mul_ps(toApexY, toApexY)),
+					_mm_mul_ps(toApexZ, toApexZ)));
+				__m128 limit = _mm_mul_ps(_mm_loadu_ps(&meshlets.cutoff[i]), length);
+				visible = _mm_and_ps(visible, _mm_cmple_ps(axisDot, limit));
+			}
+
+			int mask = _mm_movemask_ps(visible);
+			for (int lane = 0; (mask != 0) && (lane < 4); lane++)
+			{
+				if (((mask & (1 << lane)) != 0) && (i + lane < numMeshlets))
+				{
+					AppendRange(ranges, meshlets.ranges[i + lane]);
+					numKept++;
+				}
+			}
+		}
+
+		return(numKept);
+	}
+
+	/***********************************************************
+	 *  AddMeshletBounds()
+	 *
+	 *  This function is used to calculate the bounding sphere
+	 *  and normal cone of one meshlet.  The sphere is centered
+	 *  on the box around the vertices.  The cone axis is the
+	 *  average of the triangle normals, its cutoff the sine of
+	 *  the widest angle between a normal and the axis, and its
+	 *  apex is moved back along the axis until every triangle
+	 *  plane passes in front of it.
+	 ***********************************************************/
+	void AddMeshletBounds(
+		const GeometryPool::VERTEX* pVertices,
+		const uint32_t* pIndices,
+		const GeometryPool::INDEX_RANGE& range,
+		MeshletCuller::MESHLET_SET& meshlets)
+	{
+		const uint32_t* pMeshletIndices = pIndices + range.firstIndex;
+		size_t numTriangles = (size_t)range.numIndices / 3;
+
+		glm::vec3 boundsMin = pVertices[pMeshletIndices[0]].position;
+		glm::vec3 boundsMax = boundsMin;
+		for (GLsizei i = 1; i < range.numIndices; i++)
+		{
+			boundsMin = glm::min(boundsMin, pVertices[pMeshletIndices[i]].position);
+			boundsMax = glm::max(boundsMax, pVertices[pMeshletIndices[i]].position);
+		}
+		glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+		float radius = 0.0f;
+		for (GLsizei i = 0; i < range.numIndices; i++)
+		{
+			radius = glm::max(radius, glm::distance(center, pVertices[pMeshletIndices[i]].position));
+		}
+
+		// unit normals of the triangles, zero for a degenerate one
+		std::vector<glm::vec3> normals(numTriangles);
+		glm::vec3 normalSum(0.0f);
+		for (size_t t = 0; t < numTriangles; t++)
+		{
+			const glm::vec3& p0 = pVertices[pMeshletIndices[t * 3 + 0]].position;
+			const glm::vec3& p1 = pVertices[pMeshletIndices[t * 3 + 1]].position;
+			const glm::vec3& p2 = pVertices[pMeshletIndices[t * 3 + 2]].position;
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			float length = glm::length(normal);
+			normals[t] = (length > 0.0f) ? (normal / length) : glm::vec3(0.0f);
+			normalSum += normals[t];
+		}
+
+		glm::vec3 axis(0.0f);
+		glm::vec3 apex = center;
+		float cutoff = NO_CONE_CUTOFF;
+		float sumLength = glm::length(normalSum);
+		if (sumLength > 0.0f)
+		{
+			axis = normalSum / sumLength;
+
+			float minDot = 1.0f;
+			for (size_t t = 0; t < numTriangles; t++)
+			{
+				if (normals[t] != glm::vec3(0.0f))
+				{
+					minDot = glm::min(minDot, glm::dot(normals[t], axis));
+				}
+			}
+
+			if (minDot > MIN_CONE_DOT)
+			{
+				float maxOffset = 0.0f;
+				for (size_t t = 0; t < numTriangles; t++)
+				{
+					if (normals[t] != glm::vec3(0.0f))
+					{
+						const glm::vec3& p0 = pVertices[pMeshletIndices[t * 3]].position;
+						float offset = glm::dot(center - p0, normals[t]) / glm::dot(axis, normals[t]);
+						maxOffset = glm::max(maxOffset, offset);
+					}
+				}
+				apex = center - axis * maxOffset;
+				cutoff = sqrtf(1.0f - minDot * minDot);
+			}
+		}
+
+		meshlets.ranges.push_back(range);
+		meshlets.centerX.push_back(center.x);
+		meshlets.centerY.push_back(center.y);
+		meshlets.centerZ.push_back(center.z);
+		meshlets.radius.push_back(radius);
+		meshlets.apexX.push_back(apex.x);
+		meshlets.apexY.push_back(apex.y);
+		meshlets.apexZ.push_back(apex.z);
+		meshlets.axisX.push_back(axis.x);
+		meshlets.axisY.push_back(axis.y);
+		meshlets.axisZ.push_back(axis.z);
+		meshlets.cutoff.push_back(cutoff);
+	}
+
+	/***********************************************************
+	 *  PadMeshlets()
+	 *
+	 *  This function is used to grow the culling value arrays
+	 *  to a multiple of 4, so the last SSE2 load stays inside
+	 *  them.  The padding lanes are never gathered.
+	 ***********************************************************/
+	void PadMeshlets(MeshletCuller::MESHLET_SET& meshlets)
+	{
+		size_t paddedCount = (meshlets.ranges.size() + 3) & ~(size_t)3;
+		meshlets.centerX.resize(paddedCount, 0.0f);
+		meshlets.centerY.resize(paddedCount, 0.0f);
+		meshlets.centerZ.resize(paddedCount, 0.0f);
+		meshlets.radius.resize(paddedCount, 0.0f);
+		meshlets.apexX.resize(paddedCount, 0.0f);
+		meshlets.apexY.resize(paddedCount, 0.0f);
+		meshlets.apexZ.resize(paddedCount, 0.0f);
+		meshlets.axisX.resize(paddedCount, 0.0f);
+		meshlets.axisY.resize(paddedCount, 0.0f);
+		meshlets.axisZ.resize(paddedCount, 0.0f);
+		meshlets.cutoff.resize(paddedCount, NO_CONE_CUTOFF);
+	}
+}
+
+/***********************************************************
+ *  BuildMeshlets()
+ *
+ *  This method is used for splitting the triangles of a mesh
+ *  into meshlets.  The triangles are taken in order, and a
+ *  new meshlet is started whenever the next triangle would
+ *  take the current one past its vertex or triangle limit.
+ ***********************************************************/
+void MeshletCuller::BuildMeshlets(
+	const GeometryPool::VERTEX* pVertices,
+	size_t numVertices,
+	const uint32_t* pIndices,
+	size_t numIndices,
+	MESHLET_SET& meshlets)
+{
+	meshlets = MESHLET_SET();
+	size_t numTriangles = numIndices / 3;
+	if (numTriangles == 0)
+	{
+		return;
+	}
+
+	// meshlet each vertex was last counted in, plus one
+	std::vector<uint32_t> vertexMeshlets(numVertices, 0);
+	uint32_t meshletNumber = 1;
+	uint32_t numMeshletVertices = 0;
+	uint32_t numMeshletTriangles = 0;
+	size_t firstTriangle = 0;
+
+	for (size_t t = 0; t < numTriangles; t++)
+	{
+		const uint32_t* pTriangle = pIndices + t * 3;
+
+		uint32_t numNewVertices = 0;
+		for (int corner = 0; corner < 3; corner++)
+		{
+			bool bRepeated = ((corner > 0) && (pTriangle[corner] == pTriangle[0])) ||
+				((corner > 1) && (pTriangle[corner] == pTriangle[1]));
+			if ((vertexMeshlets[pTriangle[corner]] != meshletNumber) && (bRepeated == false))
+			{
+				numNewVertices++;
+			}
+		}
+
+		if ((numMeshletVertices + numNewVertices > MAX_MESHLET_VERTICES) ||
+			(numMeshletTriangles == MAX_MESHLET_TRIANGLES))
+		{
+			GeometryPool::INDEX_RANGE range;
+			range.firstIndex = (GLuint)(firstTriangle * 3);
+			range.numIndices = (GLsizei)((t - firstTriangle) * 3);
+			AddMeshletBounds(pVertices, pIndices, range, meshlets);
+
+			meshletNumber++;
+			numMeshletVertices = 0;
+			numMeshletTriangles = 0;
+			firstTriangle = t;
+			numNewVertices = 0;
+			for (int corner = 0; corner < 3; corner++)
+			{
+				bool bRepeated = ((corner > 0) && (pTriangle[corner] == pTriangle[0])) ||
+					((corner > 1) && (pTriangle[corner] == pTriangle[1]));
+				if (bRepeated == false)
+				{
+					numNewVertices++;
+				}
+			}
+		}
+
+		for (int corner = 0; corner < 3; corner++)
+		{
+			vertexMeshlets[pTriangle[corner]] = meshletNumber;
+		}
+		numMeshletVertices += numNewVertices;
+		numMeshletTriangles++;
+	}
+
+	GeometryPool::INDEX_RANGE range;
+	range.firstIndex = (GLuint)(firstTriangle * 3);
+	range.numIndices = (GLsizei)((numTriangles - firstTriangle) * 3);
+	AddMeshletBounds(pVertices, pIndices, range, meshlets);
+
+	PadMeshlets(meshlets);
+}
+
+/***********************************************************
+ *  CullMeshlets()
+ *
+ *  This method is used for finding the meshlets of an object
+ *  that can be seen, with the SSE2 kernel.
+ ***********************************************************/
+uint32_t MeshletCuller::CullMeshlets(
+	const MESHLET_SET& meshlets,
+	const glm::mat4& model,
+	const glm::mat4& viewProjection,
+	const glm::vec3& cameraPosition,
+	bool bBackfaceCulling,
+	std::vector<GeometryPool::INDEX_RANGE>& ranges)
+{
+	return(CullMeshlets(meshlets, model, viewProjection, cameraPosition, bBackfaceCulling, ranges, KERNEL_SSE2));
+}
+
+/***********************************************************
+ *  CullMeshlets()
+ *
+ *  This method is used for finding the meshlets of an object
+ *  that can be seen, with the passed in kernel.
+ ***********************************************************/
+uint32_t MeshletCuller::CullMeshlets(
+	const MESHLET_SET& meshlets,
+	const glm::mat4& model,
+	const glm::mat4& viewProjection,
+	const glm::vec3& cameraPosition,
+	bool bBackfaceCulling,
+	std::vector<GeometryPool::INDEX_RANGE>& ranges,
+	KERNEL_TYPE kernel)
+{
+	ranges.clear();
+	if (meshlets.ranges.empty() == true)
+	{
+		return(0);
+	}
+
+	CULL_SPACE space;
+	PrepareCullSpace(model, viewProjection, cameraPosition, space);
+
+	if (kernel == KERNEL_SCALAR)
+	{
+		return(CullScalar(meshlets, space, bBackfaceCulling, ranges));
+	}
+	return(CullSSE2(meshlets, space, bBackfaceCulling, ranges));
+}
+
+/***********************************************************
+ *  RunBenchmark()
+ *
+ *  This method is used for timing the meshlet culling of a
+ *  sphere tessellated with the passed in number of slices,
+ *  and half as many stacks, seen from random views close
+ *  enough that part of it is off screen.  Each test prints
+ *  its time over all the views and the share of triangles
+ *  it keeps, next to drawing the whole sphere every view.
+ ***********************************************************/
+void MeshletCuller::RunBenchmark(int numSlices)
+{
+	if (numSlices < 4)
+	{
+		return;
+	}
+
+	// the same preparation as the meshes of the scene
+	GeometryPool::MESH_DATA sphere;
+	ShapeMeshes::GenerateSphere(sphere, numSlices, numSlices / 2);
+	MeshOptimizer::CACHE_STATS before;
+	MeshOptimizer::CACHE_STATS after;
+	MeshOptimizer::OptimizeMesh(sphere, before, after);
+
+	MESHLET_SET meshlets;
+	auto startTime = std::chrono::high_resolution_clock::now();
+	BuildMeshlets(
+		sphere.vertices.data(), sphere.vertices.size(),
+		sphere.indices.data(), sphere.indices.size(),
+		meshlets);
+	std::chrono::duration<double, std::milli> buildTime = std::chrono::high_resolution_clock::now() - startTime;
+
+	size_t numTriangles = sphere.indices.size() / 3;
+	std::cout << "Meshlet benchmark, sphere of " << numTriangles << " triangles, "
+		<< meshlets.ranges.size() << " meshlets built in " << buildTime.count() << " ms, "
+		<< BENCHMARK_VIEWS << " views, best of " << BENCHMARK_RUNS << " runs" << std::endl;
+
+	// random cameras 1.5 to 4 radii from the center, looking
+	// near the sphere rather than straight at it
+	srand(330);
+	std::vector<glm::mat4> viewProjections(BENCHMARK_VIEWS);
+	std::vector<glm::vec3> cameraPositions(BENCHMARK_VIEWS);
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+	for (int view = 0; view < BENCHMARK_VIEWS; view++)
+	{
+		float r[6];
+		for (int j = 0; j < 6; j++)
+		{
+			r[j] = (float)rand() / (float)RAND_MAX;
+		}
+		glm::vec3 direction = glm::normalize(glm::vec3(r[0] - 0.5f, r[1] - 0.5f, r[2] - 0.5f) + glm::vec3(0.0f, 0.0f, 0.01f));
+		cameraPositions[view] = direction * (1.5f + r[3] * 2.5f);
+		glm::vec3 target(r[4] * 1.6f - 0.8f, r[5] * 1.6f - 0.8f, 0.0f);
+		viewProjections[view] = projection * glm::lookAt(cameraPositions[view], target, glm::vec3(0.0f, 1.0f, 0.0f));
+	}
+
+	glm::mat4 model(1.0f);
+	std::vector<GeometryPool::INDEX_RANGE> ranges;
+	std::vector<GeometryPool::INDEX_RANGE> referenceRanges;
+
+	const char* testNames[2] = { "frustum:         ", "frustum + cones: " };
+	for (int test = 0; test < 2; test++)
+	{
+		bool bBackfaceCulling = (test == 1);
+
+		for (int kernel = KERNEL_SCALAR; kernel <= KERNEL_SSE2; kernel++)
+		{
+			double bestTime = 0.0;
+			uint64_t keptIndices = 0;
+			bool bMatches = true;
+			for (int run = 0; run < BENCHMARK_RUNS; run++)
+			{
+				keptIndices = 0;
+				auto runStart = std::chrono::high_resolution_clock::now();
+				for (int view = 0; view < BENCHMARK_VIEWS; view++)
+				{
+					CullMeshlets(meshlets, model, viewProjections[view], cameraPositions[view],
+						bBackfaceCulling, ranges, (KERNEL_TYPE)kernel);
+					for (size_t i = 0; i < ranges.size(); i++)
+					{
+						keptIndices += (uint64_t)ranges[i].numIndices;
+					}
+				}
+				std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - runStart;
+				if ((run == 0) || (elapsed.count() < bestTime))
+				{
+					bestTime = elapsed.count();
+				}
+			}
+
+			// the SIMD kernel has to keep the same triangles
+			if (kernel != KERNEL_SCALAR)
+			{
+				for (int view = 0; (view < BENCHMARK_VIEWS) && (bMatches == true); view++)
+				{
+					CullMeshlets(meshlets, model, viewProjections[view], cameraPositions[view],
+						bBackfaceCulling, referenceRanges, KERNEL_SCALAR);
+					CullMeshlets(meshlets, model, viewProjections[view], cameraPositions[view],
+						bBackfaceCulling, ranges, (KERNEL_TYPE)kernel);
+					bMatches = (ranges.size() == referenceRanges.size());
+					for (size_t i = 0; (i < ranges.size()) && (bMatches == true); i++)
+					{
+						bMatches = (ranges[i].firstIndex == referenceRanges[i].firstIndex) &&
+							(ranges[i].numIndices == referenceRanges[i].numIndices);
+					}
+				}
+			}
+
+			double keptShare = (double)keptIndices / ((double)sphere.indices.size() * BENCHMARK_VIEWS);
+			std::cout << "  " << testNames[test] << ((kernel == KERNEL_SCALAR) ? "scalar " : "SSE2   ")
+				<< bestTime << " ms, " << (keptShare * 100.0) << "% of triangles drawn"
+				<< ((bMatches == true) ? "" : ", DIFFERS FROM SCALAR") << std::endl;
+		}
+	}
+}
@@ -0,0 +1,114 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshletculler.h
+// ============
+// split large meshes into meshlets and cull them against the view with SIMD
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GeometryPool.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  MeshletCuller
+ *
+ *  This class contains the code for splitting the triangles
+ *  of a large mesh into meshlets, and for finding which of
+ *  them can be seen before the mesh is drawn.
+ *
+ *  A meshlet is a run of the mesh's own triangle order that
+ *  uses at most 64 vertices and 124 triangles, so the index
+ *  buffer is left as it is and the meshlets that survive are
+ *  drawn as runs of it.  Neighbouring runs are merged, and
+ *  the rest go into one multi draw.  The order of a vertex
+ *  cache optimized mesh keeps each meshlet in one small
+ *  patch of the surface.
+ *
+ *  Each meshlet has a bounding sphere and a normal cone - an
+ *  apex, an axis and the cutoff every triangle normal lies
+ *  within.  A meshlet is culled when its sphere is outside a
+ *  frustum plane, or when the camera is inside the cone
+ *  behind the apex, where every triangle faces away.  The
+ *  test runs in model space, so the meshlet values are never
+ *  transformed, and for 4 meshlets at a time with SSE2.
+ *
+ *  The back facing test is only right for closed meshes with
+ *  counterclockwise triangles seen from outside, as the scene
+ *  draws both sides of every triangle.
+ ***********************************************************/
+class MeshletCuller
+{
+public:
+	enum KERNEL_TYPE
+	{
+		KERNEL_SCALAR = 0,
+		KERNEL_SSE2
+	};
+
+	// most vertices and triangles of one meshlet
+	static const uint32_t MAX_MESHLET_VERTICES = 64;
+	static const uint32_t MAX_MESHLET_TRIANGLES = 124;
+	// meshes with fewer triangles are only culled whole
+	static const size_t MIN_MESH_TRIANGLES = 4096;
+
+	// meshlets of one mesh, with each culling value in its own
+	// array, padded to a multiple of 4 meshlets for the SSE2
+	// loads.  A cutoff above 1 never culls the meshlet.
+	struct MESHLET_SET
+	{
+		std::vector<GeometryPool::INDEX_RANGE> ranges;
+		// bounding sphere
+		std::vector<float> centerX;
+		std::vector<float> centerY;
+		std::vector<float> centerZ;
+		std::vector<float> radius;
+		// normal cone
+		std::vector<float> apexX;
+		std::vector<float> apexY;
+		std::vector<float> apexZ;
+		std::vector<float> axisX;
+		std::vector<float> axisY;
+		std::vector<float> axisZ;
+		std::vector<float> cutoff;
+	};
+
+	// split the triangles of a mesh into meshlets and calculate
+	// their bounds, the indices are relative to pVertices
+	static void BuildMeshlets(
+		const GeometryPool::VERTEX* pVertices,
+		size_t numVertices,
+		const uint32_t* pIndices,
+		size_t numIndices,
+		MESHLET_SET& meshlets);
+
+	// find the meshlets of an object that can be seen and put
+	// their merged index ranges into ranges, returns the number
+	// of meshlets kept.  The camera position is in world space.
+	static uint32_t CullMeshlets(
+		const MESHLET_SET& meshlets,
+		const glm::mat4& model,
+		const glm::mat4& viewProjection,
+		const glm::vec3& cameraPosition,
+		bool bBackfaceCulling,
+		std::vector<GeometryPool::INDEX_RANGE>& ranges);
+	// same as above with a specific kernel, for testing
+	static uint32_t CullMeshlets(
+		const MESHLET_SET& meshlets,
+		const glm::mat4& model,
+		const glm::mat4& viewProjection,
+		const glm::vec3& cameraPosition,
+		bool bBackfaceCulling,
+		std::vector<GeometryPool::INDEX_RANGE>& ranges,
+		KERNEL_TYPE kernel);
+
+	// time building and culling the meshlets of a sphere with
+	// the passed in number of slices, and print the triangles
+	// each test keeps to the console
+	static void RunBenchmark(int numSlices);
+};
@@ -0,0 +1,1581 @@
+///////////////////////////////////////////////////////////////////////////////
+// modelimporter.cpp
+// ============
+// import OBJ and glTF models from memory mapped files into the geometry pool
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ModelImporter.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	typedef GeometryPool::VERTEX VERTEX;
+	typedef GeometryPool::MESH_DATA MESH_DATA;
+
+	// bytes of OBJ text parsed by one job
+	const size_t OBJ_CHUNK_SIZE = 1 << 20;
+	// vertices converted by one job
+	const size_t VERTICES_PER_JOB = 16384;
+	// index of an attribute a corner does not have
+	const uint32_t NO_INDEX = 0xFFFFFFFF;
+
+	// GLB header and chunk tags
+	const uint32_t GLB_MAGIC = 0x46546C67;
+	const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+	const uint32_t GLB_CHUNK_BIN = 0x004E4942;
+
+	// glTF accessor component types and primitive mode
+	const int GLTF_BYTE = 5120;
+	const int GLTF_UNSIGNED_BYTE = 5121;
+	const int GLTF_SHORT = 5122;
+	const int GLTF_UNSIGNED_SHORT = 5123;
+	const int GLTF_UNSIGNED_INT = 5125;
+	const int GLTF_FLOAT = 5126;
+	const int GLTF_TRIANGLES = 4;
+
+	// largest number taken as an index or a size, the largest
+	// whole number a double holds exactly that fits a size_t
+	const double MAX_JSON_INDEX = (sizeof(size_t) < 8) ? 4294967295.0 : 9007199254740992.0;
+
+	/***********************************************************
+	 *  JSON_VALUE
+	 *
+	 *  One value of a JSON document.  Arrays and objects hold
+	 *  their members in items, objects their names in keys.
+	 ***********************************************************/
+	struct JSON_VALUE
+	{
+		enum JSON_TYPE
+		{
+			JSON_NULL = 0,
+			JSON_BOOL,
+			JSON_NUMBER,
+			JSON_STRING,
+			JSON_ARRAY,
+			JSON_OBJECT
+		};
+
+		JSON_TYPE type;
+		bool boolean;
+		double number;
+		std::string text;
+		std::vector<JSON_VALUE> items;
+		std::vector<std::string> keys;
+
+		JSON_VALUE() : type(JSON_NULL), boolean(false), number(0.0) {}
+
+		// member of an object by name, or NULL
+		const JSON_VALUE* Find(const char* key) const
+		{
+			for (size_t i = 0; i < keys.size(); i++)
+			{
+				if (keys[i] == key)
+				{
+					return(&items[i]);
+				}
+			}
+			return(NULL);
+		}
+
+		// item of an array, or NULL
+		const JSON_VALUE* At(size_t index) const
+		{
+			if ((type == JSON_ARRAY) && (index < items.size()))
+			{
+				return(&items[index]);
+			}
+			return(NULL);
+		}
+
+		// the value as an index or a size, false unless it is a
+		// whole number from zero up that fits a size_t
+		bool AsIndex(size_t& index) const
+		{
+			if ((type != JSON_NUMBER) || (number < 0.0) ||
+				(number > MAX_JSON_INDEX) || (number != floor(number)))
+			{
+				return(false);
+			}
+			index = (size_t)number;
+			return(true);
+		}
+
+		// index member of an object, false when it is missing or
+		// not a valid index
+		bool GetIndex(const char* key, size_t& index) const
+		{
+			const JSON_VALUE* pValue = Find(key);
+			return((NULL != pValue) && (pValue->AsIndex(index) == true));
+		}
+
+		// index member of an object, or the default when it is
+		// missing, false when it is not a valid index
+		bool GetIndex(const char* key, size_t& index, size_t defaultValue) const
+		{
+			const JSON_VALUE* pValue = Find(key);
+			if (NULL == pValue)
+			{
+				index = defaultValue;
+				return(true);
+			}
+			return(pValue->AsIndex(index));
+		}
+
+		// check whether an object is a triangle primitive, the
+		// mode defaults to triangles
+		bool IsTrianglePrimitive() const
+		{
+			size_t mode = 0;
+			return((GetIndex("mode", mode, GLTF_TRIANGLES) == true) && (mode == (size_t)GLTF_TRIANGLES));
+		}
+	};
+
+	/***********************************************************
+	 *  JsonReader
+	 *
+	 *  Recursive descent reader for the JSON of a glTF file.
+	 ***********************************************************/
+	class JsonReader
+	{
+	public:
+		JsonReader(const char* pText, size_t size) : m_pText(pText), m_pEnd(pText + size) {}
+
+		bool Read(JSON_VALUE& value)
+		{
+			if (ReadValue(value, 0) == false)
+			{
+				return(false);
+			}
+			SkipSpace();
+			return(m_pText == m_pEnd);
+		}
+
+	private:
+		const char* m_pText;
+		const char* m_pEnd;
+
+		void SkipSpace()
+		{
+			while ((m_pText < m_pEnd) &&
+				((*m_pText == ' ') || (*m_pText == '\t') || (*m_pText == '\r') || (*m_pText == '\n')))
+			{
+				m_pText++;
+			}
+		}
+
+		bool Expect(const char* word)
+		{
+			size_t length = strlen(word);
+			if (((size_t)(m_pEnd - m_pText) < length) || (strncmp(m_pText, word, length) != 0))
+			{
+				return(false);
+			}
+			m_pText += length;
+			return(true);
+		}
+
+		bool ReadString(std::string& text)
+		{
+			if ((m_pText >= m_pEnd) || (*m_pText != '"'))
+			{
+				return(false);
+			}
+			m_pText++;
+
+			text.clear();
+			while (m_pText < m_pEnd)
+			{
+				char c = *m_pText++;
+				if (c == '"')
+				{
+					return(true);
+				}
+				if (c == '\\')
+				{
+					if (m_pText >= m_pEnd)
+					{
+						return(false);
+					}
+					char escaped = *m_pText++;
+					switch (escaped)
+					{
+					case 'n': text += '\n'; break;
+					case 't': text += '\t'; break;
+					case 'r': text += '\r'; break;
+					case 'b': text += '\b'; break;
+					case 'f': text += '\f'; break;
+					case 'u':
+						// names and URIs in glTF files are plain ASCII,
+						// anything else is kept as a placeholder
+						if (m_pEnd - m_pText < 4)
+						{
+							return(false);
+						}
+						m_pText += 4;
+						text += '?';
+						break;
+					default: text += escaped; break;
+					}
+				}
+				else
+				{
+					text += c;
+				}
+			}
+			return(false);
+		}
+
+		bool ReadValue(JSON_VALUE& value, int depth)
+		{
+			// glTF documents are shallow, this only stops a
+			// broken file from exhausting the stack
+			if (depth > 64)
+			{
+				return(false);
+			}
+
+			SkipSpace();
+			if (m_pText >= m_pEnd)
+			{
+				return(false);
+			}
+
+			char c = *m_pText;
+			if (c == '{')
+			{
+				value.type = JSON_VALUE::JSON_OBJECT;
+				m_pText++;
+				SkipSpace();
+				if ((m_pText < m_pEnd) && (*m_pText == '}'))
+				{
+					m_pText++;
+					return(true);
+				}
+				while (true)
+				{
+					SkipSpace();
+					value.keys.push_back(std::string());
+					if (ReadString(value.keys.back()) == false)
+					{
+						return(false);
+					}
+					SkipSpace();
+					if ((m_pText >= m_pEnd) || (*m_pText++ != ':'))
+					{
+						return(false);
+					}
+					value.items.push_back(JSON_VALUE());
+					if (ReadValue(value.items.back(), depth + 1) == false)
+					{
+						return(false);
+					}
+					SkipSpace();
+					if (m_pText >= m_pEnd)
+					{
+						return(false);
+					}
+					c = *m_pText++;
+					if (c == '}')
+					{
+						return(true);
+					}
+					if (c != ',')
+					{
+						return(false);
+					}
+				}
+			}
+			if (c == '[')
+			{
+				value.type = JSON_VALUE::JSON_ARRAY;
+				m_pText++;
+				SkipSpace();
+				if ((m_pText < m_pEnd) && (*m_pText == ']'))
+				{
+					m_pText++;
+					return(true);
+				}
+				while (true)
+				{
+					value.items.push_back(JSON_VALUE());
+					if (ReadValue(value.items.back(), depth + 1) == false)
+					{
+						return(false);
+					}
+					SkipSpace();
+					if (m_pText >= m_pEnd)
+					{
+						return(false);
+					}
+					c = *m_pText++;
+					if (c == ']')
+					{
+						return(true);
+					}
+					if (c != ',')
+					{
+						return(false);
+					}
+				}
+			}
+			if (c == '"')
+			{
+				value.type = JSON_VALUE::JSON_STRING;
+				return(ReadString(value.text));
+			}
+			if (c == 't')
+			{
+				value.type = JSON_VALUE::JSON_BOOL;
+				value.boolean = true;
+				return(Expect("true"));
+			}
+			if (c == 'f')
+			{
+				value.type = JSON_VALUE::JSON_BOOL;
+				return(Expect("false"));
+			}
+			if (c == 'n')
+			{
+				return(Expect("null"));
+			}
+
+			// the number text ends at the next delimiter, copied
+			// out as the mapped text has no terminator
+			const char* pStart = m_pText;
+			while ((m_pText < m_pEnd) && (strchr(",]} \t\r\n", *m_pText) == NULL))
+			{
+				m_pText++;
+			}
+			std::string number(pStart, m_pText);
+			char* pNumberEnd = NULL;
+			value.type = JSON_VALUE::JSON_NUMBER;
+			value.number = strtod(number.c_str(), &pNumberEnd);
+			return((number.empty() == false) && (*pNumberEnd == '\0'));
+		}
+	};
+
+	/***********************************************************
+	 *  ParseFloat()
+	 *
+	 *  This function is used to read a decimal number at the
+	 *  text position and move past it.  It does much less than
+	 *  strtof() - no locale, hex or infinities - which is what
+	 *  makes parsing a large OBJ file fast.
+	 ***********************************************************/
+	bool ParseFloat(const char*& pText, const char* pEnd, float& value)
+	{
+		const char* p = pText;
+		bool bNegative = false;
+		if ((p < pEnd) && ((*p == '-') || (*p == '+')))
+		{
+			bNegative = (*p == '-');
+			p++;
+		}
+
+		double result = 0.0;
+		bool bDigits = false;
+		while ((p < pEnd) && (*p >= '0') && (*p <= '9'))
+		{
+			result = result * 10.0 + (*p++ - '0');
+			bDigits = true;
+		}
+		if ((p < pEnd) && (*p == '.'))
+		{
+			p++;
+			double scale = 0.1;
+			while ((p < pEnd) && (*p >= '0') && (*p <= '9'))
+			{
+				result += (*p++ - '0') * scale;
+				scale *= 0.1;
+				bDigits = true;
+			}
+		}
+		if (bDigits == false)
+		{
+			return(false);
+		}
+		if ((p < pEnd) && ((*p == 'e') || (*p == 'E')))
+		{
+			p++;
+			bool bNegativeExponent = false;
+			if ((p < pEnd) && ((*p == '-') || (*p == '+')))
+			{
+				bNegativeExponent = (*p == '-');
+				p++;
+			}
+			int exponent = 0;
+			while ((p < pEnd) && (*p >= '0') && (*p <= '9'))
+			{
+				exponent = exponent * 10 + (*p++ - '0');
+			}
+			result *= pow(10.0, bNegativeExponent ? -exponent : exponent);
+		}
+
+		value = (float)(bNegative ? -result : result);
+		pText = p;
+		return(true);
+	}
+
+	/***********************************************************
+	 *  ParseIndex()
+	 *
+	 *  This function is used to read a 1-based OBJ index, which
+	 *  is negative when counted back from the last element, and
+	 *  turn it into a 0-based index.
+	 ***********************************************************/
+	bool ParseIndex(const char*& pText, const char* pEnd, uint32_t count, uint32_t& index)
+	{
+		const char* p = pText;
+		bool bNegative = false;
+		if ((p < pEnd) && (*p == '-'))
+		{
+			bNegative = true;
+			p++;
+		}
+
+		int64_t value = 0;
+		if ((p >= pEnd) || (*p < '0') || (*p > '9'))
+		{
+			return(false);
+		}
+		while ((p < pEnd) && (*p >= '0') && (*p <= '9'))
+		{
+			value = value * 10 + (*p++ - '0');
+		}
+
+		int64_t result = bNegative ? ((int64_t)count - value) : (value - 1);
+		if ((result < 0) || (result >= (int64_t)count))
+		{
+			return(false);
+		}
+		index = (uint32_t)result;
+		pText = p;
+		return(true);
+	}
+
+	// attribute indices of one corner of an OBJ face
+	struct OBJ_CORNER
+	{
+		uint32_t position;
+		uint32_t textureCoordinate;
+		uint32_t normal;
+	};
+
+	// one part of an OBJ file parsed by one job
+	struct OBJ_CHUNK
+	{
+		const char* pBegin;
+		const char* pEnd;
+		// elements in the chunk, then before it in the file
+		uint32_t numPositions;
+		uint32_t numTextureCoordinates;
+		uint32_t numNormals;
+		uint32_t firstPosition;
+		uint32_t firstTextureCoordinate;
+		uint32_t firstNormal;
+		// three corners per triangle
+		std::vector<OBJ_CORNER> corners;
+		bool bError;
+	};
+
+	/***********************************************************
+	 *  ParseObjChunk()
+	 *
+	 *  This function is used to parse the lines of one OBJ
+	 *  chunk.  The attribute arrays are already sized for the
+	 *  whole file, and the first element of each before this
+	 *  chunk is known, so the values are written to their final
+	 *  place and relative indices can be resolved here.
+	 ***********************************************************/
+	void ParseObjChunk(
+		OBJ_CHUNK& chunk,
+		std::vector<glm::vec3>& positions,
+		std::vector<glm::vec2>& textureCoordinates,
+		std::vector<glm::vec3>& normals)
+	{
+		uint32_t numPositions = chunk.firstPosition;
+		uint32_t numTextureCoordinates = chunk.firstTextureCoordinate;
+		uint32_t numNormals = chunk.firstNormal;
+		std::vector<OBJ_CORNER> faceCorners;
+
+		const char* p = chunk.pBegin;
+		while ((p < chunk.pEnd) && (chunk.bError == false))
+		{
+			const char* pLineEnd = (const char*)memchr(p, '\n', chunk.pEnd - p);
+			if (NULL == pLineEnd)
+			{
+				pLineEnd = chunk.pEnd;
+			}
+
+			while ((p < pLineEnd) && ((*p == ' ') || (*p == '\t')))
+			{
+				p++;
+			}
+
+			if ((pLineEnd - p > 2) && (p[0] == 'v') && ((p[1] == ' ') || (p[1] == 't') || (p[1] == 'n')))
+			{
+				char kind = p[1];
+				p += (kind == ' ') ? 1 : 2;
+
+				int numValues = (kind == 't') ? 2 : 3;
+				float values[3] = { 0.0f, 0.0f, 0.0f };
+				for (int i = 0; i < numValues; i++)
+				{
+					while ((p < pLineEnd) && ((*p == ' ') || (*p == '\t')))
+					{
+						p++;
+					}
+					if (ParseFloat(p, pLineEnd, values[i]) == false)
+					{
+						// a texture coordinate may leave out v
+						if ((kind != 't') || (i == 0))
+						{
+							chunk.bError = true;
+						}
+						break;
+					}
+				}
+
+				if (kind == ' ')
+					positions[numPositions++] = glm::vec3(values[0], values[1], values[2]);
+				else if (kind == 't')
+					textureCoordinates[numTextureCoordinates++] = glm::vec2(values[0], values[1]);
+				else
+					normals[numNormals++] = glm::vec3(values[0], values[1], values[2]);
+			}
+			else if ((pLineEnd - p > 1) && (p[0] == 'f') && ((p[1] == ' ') || (p[1] == '\t')))
+			{
+				p++;
+				faceCorners.clear();
+				while (chunk.bError == false)
+				{
+					while ((p < pLineEnd) && ((*p == ' ') || (*p == '\t') || (*p == '\r')))
+					{
+						p++;
+					}
+					if (p >= pLineEnd)
+					{
+						break;
+					}
+
+					// p, p/t, p//n or p/t/n
+					OBJ_CORNER corner = { NO_INDEX, NO_INDEX, NO_INDEX };
+					bool bValid = ParseIndex(p, pLineEnd, numPositions, corner.position);
+					if ((bValid == true) && (p < pLineEnd) && (*p == '/'))
+					{
+						p++;
+						if ((p < pLineEnd) && (*p != '/'))
+						{
+							bValid = ParseIndex(p, pLineEnd, numTextureCoordinates, corner.textureCoordinate);
+						}
+						if ((bValid == true) && (p < pLineEnd) && (*p == '/'))
+						{
+							p++;
+							bValid = ParseIndex(p, pLineEnd, numNormals, corner.normal);
+						}
+					}
+					if (bValid == false)
+					{
+						chunk.bError = true;
+						break;
+					}
+					faceCorners.push_back(corner);
+				}
+
+				// split the polygon into a fan of triangles
+				for (size_t i = 2; i < faceCorners.size(); i++)
+				{
+					chunk.corners.push_back(faceCorners[0]);
+					chunk.corners.push_back(faceCorners[i - 1]);
+					chunk.corners.push_back(faceCorners[i]);
+				}
+			}
+
+			p = pLineEnd + 1;
+		}
+	}
+
+	/***********************************************************
+	 *  CountObjChunk()
+	 *
+	 *  This function is used to count the attribute lines of
+	 *  one OBJ chunk, looking only at the start of each line.
+	 ***********************************************************/
+	void CountObjChunk(OBJ_CHUNK& chunk)
+	{
+		const char* p = chunk.pBegin;
+		while (p < chunk.pEnd)
+		{
+			while ((p < chunk.pEnd) && ((*p == ' ') || (*p == '\t')))
+			{
+				p++;
+			}
+			if ((chunk.pEnd - p > 2) && (p[0] == 'v'))
+			{
+				if (p[1] == ' ')
+					chunk.numPositions++;
+				else if (p[1] == 't')
+					chunk.numTextureCoordinates++;
+				else if (p[1] == 'n')
+					chunk.numNormals++;
+			}
+
+			const char* pLineEnd = (const char*)memchr(p, '\n', chunk.pEnd - p);
+			if (NULL == pLineEnd)
+			{
+				break;
+			}
+			p = pLineEnd + 1;
+		}
+	}
+
+	// a glTF accessor resolved to memory
+	struct ACCESSOR_VIEW
+	{
+		const unsigned char* pData;
+		size_t count;
+		size_t stride;
+		int componentType;
+		int numComponents;
+		bool bNormalized;
+	};
+
+	/***********************************************************
+	 *  GetComponentSize()
+	 *
+	 *  This function is used to get the bytes of one component
+	 *  of a glTF component type, 0 for an unknown type.
+	 ***********************************************************/
+	size_t GetComponentSize(int componentType)
+	{
+		switch (componentType)
+		{
+		case GLTF_BYTE:
+		case GLTF_UNSIGNED_BYTE:
+			return(1);
+		case GLTF_SHORT:
+		case GLTF_UNSIGNED_SHORT:
+			return(2);
+		case GLTF_UNSIGNED_INT:
+		case GLTF_FLOAT:
+			return(4);
+		default:
+			break;
+		}
+		return(0);
+	}
+
+	/***********************************************************
+	 *  ReadComponent()
+	 *
+	 *  This function is used to read one component of an
+	 *  accessor element as a float, applying the normalization
+	 *  of the integer types.
+	 ***********************************************************/
+	float ReadComponent(const ACCESSOR_VIEW& view, size_t element, int component)
+	{
+		const unsigned char* p = view.pData + element * view.stride +
+			component * GetComponentSize(view.componentType);
+
+		switch (view.componentType)
+		{
+		case GLTF_FLOAT:
+		{
+			float value;
+			memcpy(&value, p, sizeof(value));
+			return(value);
+		}
+		case GLTF_UNSIGNED_BYTE:
+			return(view.bNormalized ? (*p / 255.0f) : (float)*p);
+		case GLTF_BYTE:
+			return(view.bNormalized ? std::max(*(const int8_t*)p / 127.0f, -1.0f) : (float)*(const int8_t*)p);
+		case GLTF_UNSIGNED_SHORT:
+		{
+			uint16_t value;
+			memcpy(&value, p, sizeof(value));
+			return(view.bNormalized ? (value / 65535.0f) : (float)value);
+		}
+		case GLTF_SHORT:
+		{
+			int16_t value;
+			memcpy(&value, p, sizeof(value));
+			return(view.bNormalized ? std::max(value / 32767.0f, -1.0f) : (float)value);
+		}
+		default:
+			break;
+		}
+		return(0.0f);
+	}
+
+	/***********************************************************
+	 *  ReadIndex()
+	 *
+	 *  This function is used to read one element of an index
+	 *  accessor.  Returns false if it is past the passed in
+	 *  number of vertices.
+	 ***********************************************************/
+	bool ReadIndex(const ACCESSOR_VIEW& view, size_t element, size_t numVertices, uint32_t& index)
+	{
+		const unsigned char* p = view.pData + element * view.stride;
+		if (view.componentType == GLTF_UNSIGNED_BYTE)
+		{
+			index = *p;
+		}
+		else if (view.componentType == GLTF_UNSIGNED_SHORT)
+		{
+			uint16_t value;
+			memcpy(&value, p, sizeof(value));
+			index = value;
+		}
+		else
+		{
+			memcpy(&index, p, sizeof(index));
+		}
+		return(index < numVertices);
+	}
+
+	// one triangle primitive of the glTF scene to import
+	struct GLTF_PRIMITIVE
+	{
+		const JSON_VALUE* pPrimitive;
+		glm::mat4 transform;
+		bool bIdentity;
+	};
+
+	/***********************************************************
+	 *  GetNodeMatrix()
+	 *
+	 *  This function is used to get the local transform of a
+	 *  glTF node, from its matrix or its translation, rotation
+	 *  quaternion and scale.
+	 ***********************************************************/
+	glm::mat4 GetNodeMatrix(const JSON_VALUE& node, bool& bIdentity)
+	{
+		glm::mat4 matrix(1.0f);
+		bIdentity = true;
+
+		const JSON_VALUE* pMatrix = node.Find("matrix");
+		if ((NULL != pMatrix) && (pMatrix->items.size() == 16))
+		{
+			for (int i = 0; i < 16; i++)
+			{
+				// stored column by column, like glm
+				matrix[i / 4][i % 4] = (float)pMatrix->items[i].number;
+				if (pMatrix->items[i].number != ((i % 5 == 0) ? 1.0 : 0.0))
+				{
+					bIdentity = false;
+				}
+			}
+			return(matrix);
+		}
+
+		float translation[3] = { 0.0f, 0.0f, 0.0f };
+		float rotation[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		float scale[3] = { 1.0f, 1.0f, 1.0f };
+		const char* names[3] = { "translation", "rotation", "scale" };
+		float* values[3] = { translation, rotation, scale };
+		size_t sizes[3] = { 3, 4, 3 };
+		for (int part = 0; part < 3; part++)
+		{
+			const JSON_VALUE* pValues = node.Find(names[part]);
+			if ((NULL != pValues) && (pValues->items.size() == sizes[part]))
+			{
+				for (size_t i = 0; i < sizes[part]; i++)
+				{
+					values[part][i] = (float)pValues->items[i].number;
+				}
+				bIdentity = false;
+			}
+		}
+		if (bIdentity == true)
+		{
+			return(matrix);
+		}
+
+		// rotation matrix of the unit quaternion x, y, z, w
+		float x = rotation[0];
+		float y = rotation[1];
+		float z = rotation[2];
+		float w = rotation[3];
+		matrix[0] = glm::vec4(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w), 0.0f) * scale[0];
+		matrix[1] = glm::vec4(2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w), 0.0f) * scale[1];
+		matrix[2] = glm::vec4(2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y), 0.0f) * scale[2];
+		matrix[3] = glm::vec4(translation[0], translation[1], translation[2], 1.0f);
+		return(matrix);
+	}
+
+	/***********************************************************
+	 *  GatherNodePrimitives()
+	 *
+	 *  This function is used to walk a glTF node and its
+	 *  children, collecting the triangle primitives of their
+	 *  meshes with the world transform of the node.
+	 ***********************************************************/
+	void GatherNodePrimitives(
+		const JSON_VALUE& document,
+		size_t nodeIndex,
+		const glm::mat4& parentTransform,
+		bool bParentIdentity,
+		int depth,
+		std::vector<GLTF_PRIMITIVE>& primitives)
+	{
+		const JSON_VALUE* pNodes = document.Find("nodes");
+		const JSON_VALUE* pNode = (NULL != pNodes) ? pNodes->At(nodeIndex) : NULL;
+		if ((NULL == pNode) || (depth > 64))
+		{
+			return;
+		}
+
+		bool bIdentity = true;
+		glm::mat4 transform = parentTransform * GetNodeMatrix(*pNode, bIdentity);
+		bIdentity = (bIdentity == true) && (bParentIdentity == true);
+
+		const JSON_VALUE* pMeshes = document.Find("meshes");
+		size_t meshIndex = 0;
+		const JSON_VALUE* pMesh = ((NULL != pMeshes) && (pNode->GetIndex("mesh", meshIndex) == true)) ?
+			pMeshes->At(meshIndex) : NULL;
+		const JSON_VALUE* pPrimitives = (NULL != pMesh) ? pMesh->Find("primitives") : NULL;
+		if (NULL != pPrimitives)
+		{
+			for (size_t i = 0; i < pPrimitives->items.size(); i++)
+			{
+				if (pPrimitives->items[i].IsTrianglePrimitive() == true)
+				{
+					GLTF_PRIMITIVE primitive;
+					primitive.pPrimitive = &pPrimitives->items[i];
+					primitive.transform = transform;
+					primitive.bIdentity = bIdentity;
+					primitives.push_back(primitive);
+				}
+			}
+		}
+
+		const JSON_VALUE* pChildren = pNode->Find("children");
+		if (NULL != pChildren)
+		{
+			for (size_t i = 0; i < pChildren->items.size(); i++)
+			{
+				size_t childIndex = 0;
+				if (pChildren->items[i].AsIndex(childIndex) == true)
+				{
+					GatherNodePrimitives(document, childIndex, transform, bIdentity, depth + 1, primitives);
+				}
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  GetDirectory()
+	 *
+	 *  This function is used to get the directory part of a
+	 *  file path, with its trailing separator.
+	 ***********************************************************/
+	std::string GetDirectory(const std::string& filePath)
+	{
+		size_t separator = filePath.find_last_of("/\\");
+		if (separator == std::string::npos)
+		{
+			return(std::string());
+		}
+		return(filePath.substr(0, separator + 1));
+	}
+}
+
+/***********************************************************
+ *  ModelImporter()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ModelImporter::ModelImporter(JobSystem* pJobSystem)
+{
+	m_pJobSystem = pJobSystem;
+	m_bBuildMeshlets = false;
+}
+
+/***********************************************************
+ *  IsModelFile()
+ *
+ *  This method is used for checking whether a file name ends
+ *  in one of the model file extensions.
+ ***********************************************************/
+bool ModelImporter::IsModelFile(const std::string& filename)
+{
+	size_t dot = filename.find_last_of('.');
+	if (dot == std::string::npos)
+	{
+		return(false);
+	}
+
+	std::string extension = filename.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+	return((extension == "obj") || (extension == "gltf") || (extension == "glb"));
+}
+
+/***********************************************************
+ *  ImportFile()
+ *
+ *  This method is used for mapping a model file, parsing it
+ *  by its extension and adding its triangles to the geometry
+ *  pool as one mesh.
+ ***********************************************************/
+bool ModelImporter::ImportFile(const char* filename, GeometryPool* pGeometryPool, IMPORT_RESULT& result)
+{
+	MappedFile file;
+	if ((file.Open(filename) == false) || (file.IsOpen() == false))
+	{
+		std::cout << "Could not open model file:" << filename << std::endl;
+		result.mesh = -1;
+		return(false);
+	}
+
+	return(ImportData(filename, file.GetData(), file.GetSize(), pGeometryPool, result));
+}
+
+/***********************************************************
+ *  ImportData()
+ *
+ *  This method is used for parsing the contents of a model
+ *  file where they lie in memory, by the extension of the
+ *  file name, and adding its triangles to the geometry pool
+ *  as one mesh.
+ ***********************************************************/
+bool ModelImporter::ImportData(
+	const char* filename,
+	const unsigned char* pData,
+	size_t size,
+	GeometryPool* pGeometryPool,
+	IMPORT_RESULT& result)
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	result.mesh = -1;
+	result.boundsMin = glm::vec3(0.0f);
+	result.boundsMax = glm::vec3(0.0f);
+	result.numVertices = 0;
+	result.numTriangles = 0;
+	result.milliseconds = 0.0;
+	result.meshlets = MeshletCuller::MESHLET_SET();
+
+	std::string name(filename);
+	std::string extension = name.substr(name.find_last_of('.') + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+	bool bSuccess = false;
+	if (extension == "obj")
+	{
+		MESH_DATA mesh;
+		bSuccess = ParseOBJ((const char*)pData, size, mesh);
+		if ((bSuccess == true) && (mesh.indices.empty() == false))
+		{
+			result.boundsMin = mesh.vertices[0].position;
+			result.boundsMax = mesh.vertices[0].position;
+			for (size_t i = 1; i < mesh.vertices.size(); i++)
+			{
+				result.boundsMin = glm::min(result.boundsMin, mesh.vertices[i].position);
+				result.boundsMax = glm::max(result.boundsMax, mesh.vertices[i].position);
+			}
+			result.numVertices = mesh.vertices.size();
+			result.numTriangles = mesh.indices.size() / 3;
+			BuildMeshlets(mesh.vertices, mesh.indices.data(), mesh.indices.size(), result);
+			result.mesh = pGeometryPool->AddMesh(mesh);
+		}
+	}
+	else if ((extension == "gltf") || (extension == "glb"))
+	{
+		bSuccess = ImportGLTF(filename, pData, size, pGeometryPool, result);
+	}
+
+	if ((bSuccess == false) || (result.mesh < 0))
+	{
+		std::cout << "Could not import model file:" << filename << std::endl;
+		return(false);
+	}
+
+	result.milliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - startTime).count();
+	std::cout << "Imported model:" << filename << ", vertices:" << result.numVertices
+		<< ", triangles:" << result.numTriangles << ", meshlets:" << result.meshlets.ranges.size()
+		<< ", time:" << result.milliseconds << "ms" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  ParseOBJ()
+ *
+ *  This method is used for parsing the positions, texture
+ *  coordinates, normals and faces of an OBJ file on all
+ *  cores, and building the vertices and triangles from them.
+ *  Other statements, such as groups and materials, are
+ *  skipped.
+ ***********************************************************/
+bool ModelImporter::ParseOBJ(const char* pText, size_t size, MESH_DATA& mesh)
+{
+	// split the text into chunks that end at a line end
+	std::vector<OBJ_CHUNK> chunks;
+	const char* pEnd = pText + size;
+	const char* pBegin = pText;
+	while (pBegin < pEnd)
+	{
+		const char* pChunkEnd = pEnd;
+		if ((size_t)(pEnd - pBegin) > OBJ_CHUNK_SIZE)
+		{
+			pChunkEnd = (const char*)memchr(pBegin + OBJ_CHUNK_SIZE, '\n', pEnd - pBegin - OBJ_CHUNK_SIZE);
+			pChunkEnd = (NULL == pChunkEnd) ? pEnd : pChunkEnd + 1;
+		}
+
+		OBJ_CHUNK chunk;
+		chunk.pBegin = pBegin;
+		chunk.pEnd = pChunkEnd;
+		chunk.numPositions = 0;
+		chunk.numTextureCoordinates = 0;
+		chunk.numNormals = 0;
+		chunk.firstPosition = 0;
+		chunk.firstTextureCoordinate = 0;
+		chunk.firstNormal = 0;
+		chunk.bError = false;
+		chunks.push_back(chunk);
+		pBegin = pChunkEnd;
+	}
+
+	// count, then parse every chunk into its place
+	m_pJobSystem->ParallelFor(chunks.size(), 1,
+		[&chunks](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				CountObjChunk(chunks[i]);
+			}
+		});
+
+	uint32_t numPositions = 0;
+	uint32_t numTextureCoordinates = 0;
+	uint32_t numNormals = 0;
+	for (size_t i = 0; i < chunks.size(); i++)
+	{
+		chunks[i].firstPosition = numPositions;
+		chunks[i].firstTextureCoordinate = numTextureCoordinates;
+		chunks[i].firstNormal = numNormals;
+		numPositions += chunks[i].numPositions;
+		numTextureCoordinates += chunks[i].numTextureCoordinates;
+		numNormals += chunks[i].numNormals;
+	}
+
+	std::vector<glm::vec3> positions(numPositions);
+	std::vector<glm::vec2> textureCoordinates(numTextureCoordinates);
+	std::vector<glm::vec3> normals(numNormals);
+	m_pJobSystem->ParallelFor(chunks.size(), 1,
+		[&chunks, &positions, &textureCoordinates, &normals](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				ParseObjChunk(chunks[i], positions, textureCoordinates, normals);
+			}
+		});
+
+	size_t numCorners = 0;
+	for (size_t i = 0; i < chunks.size(); i++)
+	{
+		if (chunks[i].bError == true)
+		{
+			return(false);
+		}
+		numCorners += chunks[i].corners.size();
+	}
+	if (numCorners == 0)
+	{
+		return(false);
+	}
+
+	// make each distinct combination of attribute indices one
+	// vertex.  The vertices of each position are chained, and
+	// as a position is rarely used with more than a few
+	// combinations the chains are short
+	mesh.indices.resize(numCorners);
+	std::vector<OBJ_CORNER> vertexCorners;
+	std::vector<uint32_t> nextVertices;
+	std::vector<uint32_t> firstVertices(numPositions, NO_INDEX);
+	vertexCorners.reserve(numPositions);
+	nextVertices.reserve(numPositions);
+	size_t cornerIndex = 0;
+	for (size_t c = 0; c < chunks.size(); c++)
+	{
+		const std::vector<OBJ_CORNER>& corners = chunks[c].corners;
+		for (size_t i = 0; i < corners.size(); i++)
+		{
+			const OBJ_CORNER& corner = corners[i];
+			uint32_t v = firstVertices[corner.position];
+			while ((v != NO_INDEX) &&
+				((vertexCorners[v].textureCoordinate != corner.textureCoordinate) ||
+				(vertexCorners[v].normal != corner.normal)))
+			{
+				v = nextVertices[v];
+			}
+			if (v == NO_INDEX)
+			{
+				v = (uint32_t)vertexCorners.size();
+				vertexCorners.push_back(corner);
+				nextVertices.push_back(firstVertices[corner.position]);
+				firstVertices[corner.position] = v;
+			}
+			mesh.indices[cornerIndex++] = v;
+		}
+		std::vector<OBJ_CORNER>().swap(chunks[c].corners);
+	}
+
+	// build the vertices on all cores
+	bool bHasNormals = (numNormals > 0);
+	mesh.vertices.resize(vertexCorners.size());
+	m_pJobSystem->ParallelFor(vertexCorners.size(), VERTICES_PER_JOB,
+		[&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				const OBJ_CORNER& corner = vertexCorners[i];
+				VERTEX& vertex = mesh.vertices[i];
+				vertex.position = positions[corner.position];
+				vertex.textureCoordinate = (corner.textureCoordinate != NO_INDEX) ?
+					textureCoordinates[corner.textureCoordinate] : glm::vec2(0.0f, 0.0f);
+				vertex.normal = (corner.normal != NO_INDEX) ?
+					normals[corner.normal] : glm::vec3(0.0f, 0.0f, 0.0f);
+			}
+		});
+
+	if (bHasNormals == false)
+	{
+		GenerateNormals(mesh, 0);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  ImportGLTF()
+ *
+ *  This method is used for reading a glTF or GLB file.  The
+ *  triangle primitives of the default scene are merged into
+ *  one mesh in model space, with their texture coordinates
+ *  flipped to the OpenGL origin at the bottom left.
+ ***********************************************************/
+bool ModelImporter::ImportGLTF(
+	const char* filename,
+	const unsigned char* pData,
+	size_t size,
+	GeometryPool* pGeometryPool,
+	IMPORT_RESULT& result)
+{
+	// a GLB file holds the JSON and the binary buffer as chunks
+	const char* pJson = (const char*)pData;
+	size_t jsonSize = size;
+	const unsigned char* pBinaryChunk = NULL;
+	size_t binaryChunkSize = 0;
+
+	uint32_t header[3] = { 0, 0, 0 };
+	if (size >= sizeof(header))
+	{
+		memcpy(header, pData, sizeof(header));
+	}
+	if (header[0] == GLB_MAGIC)
+	{
+		size_t offset = sizeof(header);
+		pJson = NULL;
+		while (offset + 8 <= size)
+		{
+			uint32_t chunkHeader[2];
+			memcpy(chunkHeader, pData + offset, sizeof(chunkHeader));
+			offset += 8;
+			if (chunkHeader[0] > size - offset)
+			{
+				return(false);
+			}
+			if ((chunkHeader[1] == GLB_CHUNK_JSON) && (NULL == pJson))
+			{
+				pJson = (const char*)(pData + offset);
+				jsonSize = chunkHeader[0];
+			}
+			else if ((chunkHeader[1] == GLB_CHUNK_BIN) && (NULL == pBinaryChunk))
+			{
+				pBinaryChunk = pData + offset;
+				binaryChunkSize = chunkHeader[0];
+			}
+			// chunks are padded to 4 bytes
+			offset += (chunkHeader[0] + 3) & ~3u;
+		}
+		if (NULL == pJson)
+		{
+			return(false);
+		}
+	}
+
+	JSON_VALUE document;
+	JsonReader reader(pJson, jsonSize);
+	if ((reader.Read(document) == false) || (document.type != JSON_VALUE::JSON_OBJECT))
+	{
+		std::cout << "Model file has invalid JSON:" << filename << std::endl;
+		return(false);
+	}
+
+	// map the buffers - the GLB chunk, or the files they name
+	const JSON_VALUE* pBuffers = document.Find("buffers");
+	size_t numBuffers = (NULL != pBuffers) ? pBuffers->items.size() : 0;
+	std::vector<const unsigned char*> bufferData(numBuffers, NULL);
+	std::vector<size_t> bufferSizes(numBuffers, 0);
+	std::vector<MappedFile*> bufferFiles;
+	bool bBuffersValid = true;
+	for (size_t i = 0; (i < numBuffers) && (bBuffersValid == true); i++)
+	{
+		const JSON_VALUE* pUri = pBuffers->items[i].Find("uri");
+		if (NULL == pUri)
+		{
+			bufferData[i] = pBinaryChunk;
+			bufferSizes[i] = binaryChunkSize;
+		}
+		else if (pUri->text.compare(0, 5, "data:") == 0)
+		{
+			std::cout << "Embedded base64 buffers are not supported, use .glb or a .bin file:" << filename << std::endl;
+			bBuffersValid = false;
+		}
+		else
+		{
+			MappedFile* pFile = new MappedFile();
+			bufferFiles.push_back(pFile);
+			std::string bufferPath = GetDirectory(filename) + pUri->text;
+			if (pFile->Open(bufferPath.c_str()) == false)
+			{
+				std::cout << "Could not open model buffer:" << bufferPath << std::endl;
+				bBuffersValid = false;
+			}
+			bufferData[i] = pFile->GetData();
+			bufferSizes[i] = pFile->GetSize();
+		}
+
+		size_t declaredSize = 0;
+		if ((bBuffersValid == true) &&
+			((pBuffers->items[i].GetIndex("byteLength", declaredSize, 0) == false) ||
+			(NULL == bufferData[i]) || (bufferSizes[i] < declaredSize)))
+		{
+			bBuffersValid = false;
+		}
+	}
+
+	// resolve the accessor named by a member of the passed in
+	// object to memory, checking it fits its buffer
+	const JSON_VALUE* pAccessors = document.Find("accessors");
+	const JSON_VALUE* pBufferViews = document.Find("bufferViews");
+	auto getAccessor = [&](const JSON_VALUE& object, const char* key, ACCESSOR_VIEW& view) -> bool
+	{
+		size_t accessorIndex = 0;
+		const JSON_VALUE* pAccessor = ((NULL != pAccessors) && (object.GetIndex(key, accessorIndex) == true)) ?
+			pAccessors->At(accessorIndex) : NULL;
+		if (NULL == pAccessor)
+		{
+			return(false);
+		}
+		size_t bufferViewIndex = 0;
+		const JSON_VALUE* pBufferView = ((NULL != pBufferViews) && (pAccessor->GetIndex("bufferView", bufferViewIndex) == true)) ?
+			pBufferViews->At(bufferViewIndex) : NULL;
+		if (NULL == pBufferView)
+		{
+			return(false);
+		}
+		size_t buffer = 0;
+		if ((pBufferView->GetIndex("buffer", buffer) == false) || (buffer >= numBuffers))
+		{
+			return(false);
+		}
+
+		static const char* const typeNames[] = { "SCALAR", "VEC2", "VEC3", "VEC4" };
+		const JSON_VALUE* pType = pAccessor->Find("type");
+		view.numComponents = 0;
+		for (int i = 0; (i < 4) && (NULL != pType); i++)
+		{
+			if (pType->text == typeNames[i])
+			{
+				view.numComponents = i + 1;
+			}
+		}
+		size_t componentType = 0;
+		size_t viewOffset = 0;
+		size_t viewLength = 0;
+		size_t accessorOffset = 0;
+		if ((pAccessor->GetIndex("componentType", componentType) == false) ||
+			(pAccessor->GetIndex("count", view.count) == false) ||
+			(pAccessor->GetIndex("byteOffset", accessorOffset, 0) == false) ||
+			(pBufferView->GetIndex("byteStride", view.stride, 0) == false) ||
+			(pBufferView->GetIndex("byteOffset", viewOffset, 0) == false) ||
+			(pBufferView->GetIndex("byteLength", viewLength) == false) ||
+			(componentType > (size_t)GLTF_FLOAT))
+		{
+			return(false);
+		}
+		view.componentType = (int)componentType;
+		const JSON_VALUE* pNormalized = pAccessor->Find("normalized");
+		view.bNormalized = (NULL != pNormalized) && (pNormalized->boolean == true);
+
+		size_t elementSize = GetComponentSize(view.componentType) * view.numComponents;
+		if (view.stride == 0)
+		{
+			view.stride = elementSize;
+		}
+
+		// every size is checked against the room left before it,
+		// so none of the sums can wrap
+		if ((elementSize == 0) || (view.count == 0) ||
+			(viewLength > bufferSizes[buffer]) || (viewOffset > bufferSizes[buffer] - viewLength) ||
+			(accessorOffset > viewLength) || (elementSize > viewLength - accessorOffset) ||
+			(view.count - 1 > (viewLength - accessorOffset - elementSize) / view.stride))
+		{
+			return(false);
+		}
+		view.pData = bufferData[buffer] + viewOffset + accessorOffset;
+		return(true);
+	};
+
+	// gather the primitives of the default scene, or of every
+	// mesh when the file has no scenes
+	std::vector<GLTF_PRIMITIVE> primitives;
+	const JSON_VALUE* pScenes = document.Find("scenes");
+	size_t sceneIndex = 0;
+	const JSON_VALUE* pScene = ((NULL != pScenes) && (document.GetIndex("scene", sceneIndex, 0) == true)) ?
+		pScenes->At(sceneIndex) : NULL;
+	const JSON_VALUE* pSceneNodes = (NULL != pScene) ? pScene->Find("nodes") : NULL;
+	if (NULL != pSceneNodes)
+	{
+		for (size_t i = 0; i < pSceneNodes->items.size(); i++)
+		{
+			size_t nodeIndex = 0;
+			if (pSceneNodes->items[i].AsIndex(nodeIndex) == true)
+			{
+				GatherNodePrimitives(document, nodeIndex, glm::mat4(1.0f), true, 0, primitives);
+			}
+		}
+	}
+	else if (NULL != document.Find("meshes"))
+	{
+		const JSON_VALUE* pMeshes = document.Find("meshes");
+		for (size_t m = 0; m < pMeshes->items.size(); m++)
+		{
+			const JSON_VALUE* pPrimitives = pMeshes->items[m].Find("primitives");
+			for (size_t i = 0; (NULL != pPrimitives) && (i < pPrimitives->items.size()); i++)
+			{
+				if (pPrimitives->items[i].IsTrianglePrimitive() == true)
+				{
+					GLTF_PRIMITIVE primitive;
+					primitive.pPrimitive = &pPrimitives->items[i];
+					primitive.transform = glm::mat4(1.0f);
+					primitive.bIdentity = true;
+					primitives.push_back(primitive);
+				}
+			}
+		}
+	}
+
+	MESH_DATA mesh;
+	// indices to upload straight from the mapped buffer
+	const uint32_t* pMappedIndices = NULL;
+	size_t numMappedIndices = 0;
+	bool bValid = (bBuffersValid == true) && (primitives.empty() == false);
+
+	for (size_t p = 0; (p < primitives.size()) && (bValid == true); p++)
+	{
+		const GLTF_PRIMITIVE& primitive = primitives[p];
+		const JSON_VALUE* pAttributes = primitive.pPrimitive->Find("attributes");
+		if (NULL == pAttributes)
+		{
+			bValid = false;
+			break;
+		}
+
+		ACCESSOR_VIEW positions;
+		ACCESSOR_VIEW normals;
+		ACCESSOR_VIEW textureCoordinates;
+		ACCESSOR_VIEW indices;
+		if ((getAccessor(*pAttributes, "POSITION", positions) == false) ||
+			(positions.numComponents != 3) ||
+			(positions.count > NO_INDEX - mesh.vertices.size()))
+		{
+			bValid = false;
+			break;
+		}
+		bool bHasNormals = (getAccessor(*pAttributes, "NORMAL", normals) == true) &&
+			(normals.numComponents == 3) && (normals.count == positions.count);
+		bool bHasTextureCoordinates = (getAccessor(*pAttributes, "TEXCOORD_0", textureCoordinates) == true) &&
+			(textureCoordinates.numComponents == 2) && (textureCoordinates.count == positions.count);
+		bool bHasIndices = (getAccessor(*primitive.pPrimitive, "indices", indices) == true) &&
+			(indices.numComponents == 1);
+
+		// convert the vertices into the pool layout on all cores
+		uint32_t firstVertex = (uint32_t)mesh.vertices.size();
+		mesh.vertices.resize(firstVertex + positions.count);
+		glm::mat4 transform = primitive.transform;
+		glm::mat3 normalTransform = glm::transpose(glm::inverse(glm::mat3(transform)));
+		bool bIdentity = primitive.bIdentity;
+		m_pJobSystem->ParallelFor(positions.count, VERTICES_PER_JOB,
+			[&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					VERTEX& vertex = mesh.vertices[firstVertex + i];
+					vertex.position = glm::vec3(
+						ReadComponent(positions, i, 0),
+						ReadComponent(positions, i, 1),
+						ReadComponent(positions, i, 2));
+					vertex.normal = glm::vec3(0.0f, 0.0f, 0.0f);
+					if (bHasNormals == true)
+					{
+						vertex.normal = glm::vec3(
+							ReadComponent(normals, i, 0),
+							ReadComponent(normals, i, 1),
+							ReadComponent(normals, i, 2));
+					}
+					vertex.textureCoordinate = glm::vec2(0.0f, 0.0f);
+					if (bHasTextureCoordinates == true)
+					{
+						vertex.textureCoordinate = glm::vec2(
+							ReadComponent(textureCoordinates, i, 0),
+							1.0f - ReadComponent(textureCoordinates, i, 1));
+					}
+					if (bIdentity == false)
+					{
+						vertex.position = glm::vec3(transform * glm::vec4(vertex.position, 1.0f));
+						vertex.normal = glm::normalize(normalTransform * vertex.normal);
+					}
+				}
+			});
+		if ((bHasIndices == true) && (primitives.size() == 1) &&
+			(indices.componentType == GLTF_UNSIGNED_INT) && (indices.stride == sizeof(uint32_t)) &&
+			(((uintptr_t)indices.pData & 3) == 0) && (bHasNormals == true))
+		{
+			// the indices are already in the layout of the pool
+			pMappedIndices = (const uint32_t*)indices.pData;
+			numMappedIndices = indices.count;
+			for (size_t i = 0; (i < numMappedIndices) && (bValid == true); i++)
+			{
+				bValid = (pMappedIndices[i] < positions.count);
+			}
+		}
+		else if (bHasIndices == true)
+		{
+			size_t firstIndex = mesh.indices.size();
+			mesh.indices.resize(firstIndex + indices.count);
+			for (size_t i = 0; (i < indices.count) && (bValid == true); i++)
+			{
+				uint32_t index = 0;
+				bValid = ReadIndex(indices, i, positions.count, index);
+				mesh.indices[firstIndex + i] = firstVertex + index;
+			}
+		}
+		else
+		{
+			for (size_t i = 0; i < positions.count; i++)
+			{
+				mesh.indices.push_back(firstVertex + (uint32_t)i);
+			}
+		}
+		// the indices are checked before anything goes by them
+		if (bValid == false)
+		{
+			std::cout << "Model indices are past the end of the vertices:" << filename << std::endl;
+			break;
+		}
+		if (bHasNormals == false)
+		{
+			GenerateNormals(mesh, firstVertex);
+		}
+	}
+
+	size_t numIndices = (NULL != pMappedIndices) ? numMappedIndices : mesh.indices.size();
+	if ((bValid == true) && (numIndices >= 3))
+	{
+		const uint32_t* pIndices = (NULL != pMappedIndices) ? pMappedIndices : mesh.indices.data();
+		result.boundsMin = mesh.vertices[0].position;
+		result.boundsMax = mesh.vertices[0].position;
+		for (size_t i = 1; i < mesh.vertices.size(); i++)
+		{
+			result.boundsMin = glm::min(result.boundsMin, mesh.vertices[i].position);
+			result.boundsMax = glm::max(result.boundsMax, mesh.vertices[i].position);
+		}
+		result.numVertices = mesh.vertices.size();
+		result.numTriangles = numIndices / 3;
+		BuildMeshlets(mesh.vertices, pIndices, numIndices - (numIndices % 3), result);
+		result.mesh = pGeometryPool->AddMesh(
+			mesh.vertices.data(), mesh.vertices.size(),
+			pIndices, numIndices - (numIndices % 3),
+			NULL, 0);
+	}
+
+	for (size_t i = 0; i < bufferFiles.size(); i++)
+	{
+		delete bufferFiles[i];
+	}
+	return(result.mesh >= 0);
+}
+
+/***********************************************************
+ *  GenerateNormals()
+ *
+ *  This method is used for setting the normal of every
+ *  vertex from the first vertex on to the average of the
+ *  normals of the triangles using it, weighted by their
+ *  area, for meshes read without normals.  The vertices
+ *  before it belong to parts of the mesh that had normals.
+ ***********************************************************/
+void ModelImporter::GenerateNormals(MESH_DATA& mesh, size_t firstVertex)
+{
+	std::vector<glm::vec3> sums(mesh.vertices.size(), glm::vec3(0.0f));
+	for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+	{
+		uint32_t a = mesh.indices[i];
+		uint32_t b = mesh.indices[i + 1];
+		uint32_t c = mesh.indices[i + 2];
+		if ((a < firstVertex) || (b < firstVertex) || (c < firstVertex))
+		{
+			continue;
+		}
+
+		// the cross product length is twice the area
+		glm::vec3 areaNormal = glm::cross(
+			mesh.vertices[b].position - mesh.vertices[a].position,
+			mesh.vertices[c].position - mesh.vertices[a].position);
+		sums[a] += areaNormal;
+		sums[b] += areaNormal;
+		sums[c] += areaNormal;
+	}
+
+	for (size_t i = firstVertex; i < mesh.vertices.size(); i++)
+	{
+		float length = glm::length(sums[i]);
+		if (length > 0.0f)
+		{
+			mesh.vertices[i].normal = sums[i] / length;
+		}
+	}
+}
+
+/***********************************************************
+ *  BuildMeshlets()
+ *
+ *  This method is used for splitting a mesh into meshlets
+ *  before it is added to the geometry pool, when meshlets
+ *  were asked for and the mesh is large enough to gain from
+ *  culling them.
+ ***********************************************************/
+void ModelImporter::BuildMeshlets(
+	const std::vector<GeometryPool::VERTEX>& vertices,
+	const uint32_t* pIndices,
+	size_t numIndices,
+	IMPORT_RESULT& result) const
+{
+	if ((m_bBuildMeshlets == false) || (numIndices / 3 < MeshletCuller::MIN_MESH_TRIANGLES))
+	{
+		return;
+	}
+
+	MeshletCuller::BuildMeshlets(vertices.data(), vertices.size(), pIndices, numIndices, result.meshlets);
+}
@@ -0,0 +1,113 @@
+///////////////////////////////////////////////////////////////////////////////
+// modelimporter.h
+// ============
+// import OBJ and glTF models from memory mapped files into the geometry pool
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GeometryPool.h"
+#include "JobSystem.h"
+#include "MeshletCuller.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  ModelImporter
+ *
+ *  This class contains the code for reading the triangles of
+ *  a model file into the geometry pool, as one mesh.  The
+ *  file is memory mapped and parsed where it lies:
+ *
+ *  OBJ - the file is split into chunks at line ends.  One
+ *  pass on all cores counts the v, vt and vn lines of each
+ *  chunk, so a second pass on all cores can parse every chunk
+ *  straight into its place in the attribute arrays and turn
+ *  relative indices into absolute ones.  The corners are then
+ *  made into vertices, one per distinct combination of
+ *  attribute indices.  Smooth normals are generated when the
+ *  file has none.
+ *
+ *  glTF and GLB - the JSON is read into a small tree and the
+ *  triangle primitives of the default scene are gathered with
+ *  their node transforms.  The accessors are read from the
+ *  binary chunk or the mapped .bin files.  Vertices have to
+ *  be converted into the pool layout, but for a single
+ *  untransformed primitive with 32-bit indices the indices
+ *  are uploaded from the mapped file with no copy.
+ *
+ *  Meshes of at least MeshletCuller::MIN_MESH_TRIANGLES can
+ *  also be split into meshlets as they are imported, while
+ *  their triangles are still in memory.
+ ***********************************************************/
+class ModelImporter
+{
+public:
+	// constructor, the job system spreads the parsing over
+	// all cores
+	ModelImporter(JobSystem* pJobSystem);
+
+	struct IMPORT_RESULT
+	{
+		// mesh ID in the geometry pool
+		int mesh;
+		// model space box around the mesh
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		size_t numVertices;
+		size_t numTriangles;
+		// time spent reading, parsing and uploading
+		double milliseconds;
+		// meshlets of a large mesh, empty when none were built
+		MeshletCuller::MESHLET_SET meshlets;
+	};
+
+	// split the large meshes into meshlets as they are imported
+	void SetBuildMeshlets(bool bBuildMeshlets) { m_bBuildMeshlets = bBuildMeshlets; }
+
+	// import an .obj, .gltf or .glb file into the geometry pool,
+	// returns false with a message printed if it can't be read
+	bool ImportFile(const char* filename, GeometryPool* pGeometryPool, IMPORT_RESULT& result);
+	// import the contents of a model file already in memory,
+	// the file name gives the format and the directory of any
+	// .bin files of a .gltf
+	bool ImportData(
+		const char* filename,
+		const unsigned char* pData,
+		size_t size,
+		GeometryPool* pGeometryPool,
+		IMPORT_RESULT& result);
+
+	// check whether the file name has a model file extension
+	static bool IsModelFile(const std::string& filename);
+
+private:
+	JobSystem* m_pJobSystem;
+	bool m_bBuildMeshlets;
+
+	// parse the text of an OBJ file into mesh data
+	bool ParseOBJ(const char* pText, size_t size, GeometryPool::MESH_DATA& mesh);
+	// read a glTF or GLB file and add its mesh to the pool
+	bool ImportGLTF(
+		const char* filename,
+		const unsigned char* pData,
+		size_t size,
+		GeometryPool* pGeometryPool,
+		IMPORT_RESULT& result);
+
+	// give the vertices from the first one on the average of
+	// the normals of the triangles around them
+	void GenerateNormals(GeometryPool::MESH_DATA& mesh, size_t firstVertex);
+	// split a mesh into meshlets when it is large enough and
+	// they were asked for
+	void BuildMeshlets(
+		const std::vector<GeometryPool::VERTEX>& vertices,
+		const uint32_t* pIndices,
+		size_t numIndices,
+		IMPORT_RESULT& result) const;
+};
@@ -0,0 +1,432 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionculler.cpp
+// ============
+// hierarchical depth occlusion test of object bounds against the large occluders
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// GLSL files of the depth only shader program
+	const char* OCCLUDER_VERTEX_SHADER_FILE = "shaders/occluderVertexShader.glsl";
+	const char* OCCLUDER_FRAGMENT_SHADER_FILE = "shaders/occluderFragmentShader.glsl";
+	const char* g_ModelViewProjectionName = "modelViewProjection";
+
+	// size of the occlusion buffer, small enough for the copy
+	// and the pyramid to cost next to nothing
+	const int OCCLUSION_WIDTH = 256;
+	const int OCCLUSION_HEIGHT = 128;
+
+	// a box with a corner this close to the eye, or behind it,
+	// is never reported as hidden
+	const float MIN_CLIP_W = 0.0001f;
+}
+
+const int OcclusionCuller::NUM_READBACKS;
+
+/***********************************************************
+ *  OcclusionCuller()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+OcclusionCuller::OcclusionCuller()
+{
+	m_pDepthShader = NULL;
+	m_framebufferID = 0;
+	m_depthBufferID = 0;
+	m_readbackIndex = 0;
+	for (int i = 0; i < NUM_READBACKS; i++)
+	{
+		m_readbacks[i].bufferID = 0;
+		m_readbacks[i].fence = NULL;
+		m_readbacks[i].viewProjection = glm::mat4(1.0f);
+	}
+	for (int i = 0; i < 4; i++)
+	{
+		m_savedViewport[i] = 0;
+	}
+	m_savedFramebuffer = 0;
+	m_depthViewProjection = glm::mat4(1.0f);
+	m_bHasDepth = false;
+}
+
+/***********************************************************
+ *  ~OcclusionCuller()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+OcclusionCuller::~OcclusionCuller()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the occlusion buffer,
+ *  the pixel buffers its depth is copied into, and the depth
+ *  only shader program.  Returns false, with everything
+ *  freed again, if any of them can't be created.
+ ***********************************************************/
+bool OcclusionCuller::Create(const ShaderManager* pSceneShaders)
+{
+	Destroy();
+
+	m_pDepthShader = new ShaderManager();
+	m_pDepthShader->SetRenderStats(pSceneShaders->GetRenderStats());
+	m_pDepthShader->SetAssetArchive(pSceneShaders->GetAssetArchive());
+	m_pDepthShader->SetProgramCacheDirectory(pSceneShaders->GetProgramCacheDirectory());
+	if (0 == m_pDepthShader->LoadShaders(OCCLUDER_VERTEX_SHADER_FILE, OCCLUDER_FRAGMENT_SHADER_FILE))
+	{
+		std::cout << "Occlusion culling is off, the occluder shaders did not load" << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	// depth only, so there is no color buffer to draw or read
+	glGenRenderbuffers(1, &m_depthBufferID);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBufferID);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32F, OCCLUSION_WIDTH, OCCLUSION_HEIGHT);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_framebufferID);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthBufferID);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Occlusion culling is off, the occlusion buffer is not complete:" << status << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	size_t bufferSize = OCCLUSION_WIDTH * OCCLUSION_HEIGHT * sizeof(float);
+	for (int i = 0; i < NUM_READBACKS; i++)
+	{
+		glGenBuffers(1, &m_readbacks[i].bufferID);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, m_readbacks[i].bufferID);
+		glBufferData(GL_PIXEL_PACK_BUFFER, bufferSize, NULL, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	// every level halves the one below, rounding up, down to 1 x 1
+	int width = OCCLUSION_WIDTH;
+	int height = OCCLUSION_HEIGHT;
+	while (true)
+	{
+		m_levelSizes.push_back(glm::ivec2(width, height));
+		m_depthLevels.push_back(std::vector<float>((size_t)width * height, 1.0f));
+		if ((width == 1) && (height == 1))
+		{
+			break;
+		}
+		width = (width + 1) / 2;
+		height = (height + 1) / 2;
+	}
+
+	std::cout << "Occlusion culling on, buffer:" << OCCLUSION_WIDTH << "x" << OCCLUSION_HEIGHT
+		<< ", pyramid levels:" << m_depthLevels.size() << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the OpenGL objects.  The
+ *  pixel buffers can be deleted with copies still pending,
+ *  OpenGL keeps them until the copies are done.
+ ***********************************************************/
+void OcclusionCuller::Destroy()
+{
+	for (int i = 0; i < NUM_READBACKS; i++)
+	{
+		if (NULL != m_readbacks[i].fence)
+		{
+			glDeleteSync(m_readbacks[i].fence);
+			m_readbacks[i].fence = NULL;
+		}
+		if (0 != m_readbacks[i].bufferID)
+		{
+			glDeleteBuffers(1, &m_readbacks[i].bufferID);
+			m_readbacks[i].bufferID = 0;
+		}
+	}
+	if (0 != m_framebufferID)
+	{
+		glDeleteFramebuffers(1, &m_framebufferID);
+		m_framebufferID = 0;
+	}
+	if (0 != m_depthBufferID)
+	{
+		glDeleteRenderbuffers(1, &m_depthBufferID);
+		m_depthBufferID = 0;
+	}
+	if (NULL != m_pDepthShader)
+	{
+		delete m_pDepthShader;
+		m_pDepthShader = NULL;
+	}
+
+	m_depthLevels.clear();
+	m_levelSizes.clear();
+	m_readbackIndex = 0;
+	m_bHasDepth = false;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for taking the newest depth copy the
+ *  GPU has finished, if there is one, and building the depth
+ *  pyramid from it.  The fences are only polled, never waited
+ *  on - without a finished copy the last pyramid is kept.
+ ***********************************************************/
+void OcclusionCuller::BeginFrame()
+{
+	if (m_depthLevels.empty())
+	{
+		return;
+	}
+
+	// the copies finish in the order they were made, so go from
+	// the oldest and stop at the first one still pending
+	int newest = -1;
+	for (int i = 0; i < NUM_READBACKS; i++)
+	{
+		int index = (m_readbackIndex + i) % NUM_READBACKS;
+		if (NULL == m_readbacks[index].fence)
+		{
+			continue;
+		}
+
+		GLenum result = glClientWaitSync(m_readbacks[index].fence, 0, 0);
+		if ((result != GL_ALREADY_SIGNALED) && (result != GL_CONDITION_SATISFIED))
+		{
+			break;
+		}
+		glDeleteSync(m_readbacks[index].fence);
+		m_readbacks[index].fence = NULL;
+		newest = index;
+	}
+	if (newest < 0)
+	{
+		return;
+	}
+
+	std::vector<float>& depth = m_depthLevels[0];
+	size_t bufferSize = depth.size() * sizeof(float);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_readbacks[newest].bufferID);
+	const void* pDepth = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bufferSize, GL_MAP_READ_BIT);
+	if (NULL != pDepth)
+	{
+		memcpy(depth.data(), pDepth, bufferSize);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+		BuildDepthPyramid();
+		m_depthViewProjection = m_readbacks[newest].viewProjection;
+		m_bHasDepth = true;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+/***********************************************************
+ *  BuildDepthPyramid()
+ *
+ *  This method is used for filling each level of the depth
+ *  pyramid with the farthest depth of the two by two texels
+ *  under it.  A level with an odd size repeats its last row
+ *  or column, so no texel is left out.
+ ***********************************************************/
+void OcclusionCuller::BuildDepthPyramid()
+{
+	for (size_t level = 1; level < m_depthLevels.size(); level++)
+	{
+		const std::vector<float>& source = m_depthLevels[level - 1];
+		std::vector<float>& target = m_depthLevels[level];
+		glm::ivec2 sourceSize = m_levelSizes[level - 1];
+		glm::ivec2 targetSize = m_levelSizes[level];
+
+		for (int y = 0; y < targetSize.y; y++)
+		{
+			int y0 = y * 2;
+			int y1 = std::min(y0 + 1, sourceSize.y - 1);
+			for (int x = 0; x < targetSize.x; x++)
+			{
+				int x0 = x * 2;
+				int x1 = std::min(x0 + 1, sourceSize.x - 1);
+				float farthest = std::max(
+					std::max(source[y0 * sourceSize.x + x0], source[y0 * sourceSize.x + x1]),
+					std::max(source[y1 * sourceSize.x + x0], source[y1 * sourceSize.x + x1]));
+				target[y * targetSize.x + x] = farthest;
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  BeginOccluderPass()
+ *
+ *  This method is used for switching the drawing over to the
+ *  occlusion buffer and the depth only shader program.
+ ***********************************************************/
+void OcclusionCuller::BeginOccluderPass(const glm::mat4& viewProjection)
+{
+	m_readbacks[m_readbackIndex].viewProjection = viewProjection;
+
+	glGetIntegerv(GL_VIEWPORT, m_savedViewport);
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &m_savedFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glViewport(0, 0, OCCLUSION_WIDTH, OCCLUSION_HEIGHT);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	m_pDepthShader->use();
+}
+
+/***********************************************************
+ *  SetOccluderTransform()
+ *
+ *  This method is used for setting the transform of the
+ *  next occluder drawn.
+ ***********************************************************/
+void OcclusionCuller::SetOccluderTransform(const glm::mat4& modelViewProjection)
+{
+	m_pDepthShader->setMat4Value(g_ModelViewProjectionName, modelViewProjection);
+}
+
+/***********************************************************
+ *  EndOccluderPass()
+ *
+ *  This method is used for starting the copy of the depth
+ *  into this frame's pixel buffer, fencing it, and switching
+ *  the drawing back to the framebuffer of the frame, which
+ *  is offscreen with dynamic resolution.  The copy runs on
+ *  the GPU after the occluders, so nothing waits here.
+ ***********************************************************/
+void OcclusionCuller::EndOccluderPass()
+{
+	DEPTH_READBACK& readback = m_readbacks[m_readbackIndex];
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.bufferID);
+	glReadPixels(0, 0, OCCLUSION_WIDTH, OCCLUSION_HEIGHT, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	// a copy never read is replaced by the newer one
+	if (NULL != readback.fence)
+	{
+		glDeleteSync(readback.fence);
+	}
+	readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_readbackIndex = (m_readbackIndex + 1) % NUM_READBACKS;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)m_savedFramebuffer);
+	glViewport(m_savedViewport[0], m_savedViewport[1], m_savedViewport[2], m_savedViewport[3]);
+}
+
+/***********************************************************
+ *  IsBoxOccluded()
+ *
+ *  This method is used for checking whether the world space
+ *  box lies wholly behind the occluders.  The box is projected
+ *  with the view projection of the depth pyramid, and the
+ *  rectangle it covers, grown by a texel for the low
+ *  resolution of the buffer, is read at the pyramid level
+ *  where it spans at most 3 x 3 texels.  When in doubt the
+ *  box is reported as not hidden.
+ ***********************************************************/
+bool OcclusionCuller::IsBoxOccluded(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const
+{
+	if (m_bHasDepth == false)
+	{
+		return(false);
+	}
+
+	glm::vec2 screenMin(1.0f);
+	glm::vec2 screenMax(-1.0f);
+	float nearestDepth = 1.0f;
+	for (int i = 0; i < 8; i++)
+	{
+		glm::vec4 corner(
+			((i & 1) != 0) ? boundsMax.x : boundsMin.x,
+			((i & 2) != 0) ? boundsMax.y : boundsMin.y,
+			((i & 4) != 0) ? boundsMax.z : boundsMin.z,
+			1.0f);
+		glm::vec4 clip = m_depthViewProjection * corner;
+		if (clip.w <= MIN_CLIP_W)
+		{
+			return(false);
+		}
+
+		glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		screenMin = glm::min(screenMin, glm::vec2(ndc));
+		screenMax = glm::max(screenMax, glm::vec2(ndc));
+		nearestDepth = std::min(nearestDepth, ndc.z * 0.5f + 0.5f);
+	}
+
+	if ((screenMax.x < -1.0f) || (screenMin.x > 1.0f) ||
+		(screenMax.y < -1.0f) || (screenMin.y > 1.0f))
+	{
+		return(false);
+	}
+
+	// texel rectangle in the full size level
+	glm::ivec2 size = m_levelSizes[0];
+	int x0 = std::max((int)std::floor((screenMin.x * 0.5f + 0.5f) * size.x) - 1, 0);
+	int y0 = std::max((int)std::floor((screenMin.y * 0.5f + 0.5f) * size.y) - 1, 0);
+	int x1 = std::min((int)std::floor((screenMax.x * 0.5f + 0.5f) * size.x) + 1, size.x - 1);
+	int y1 = std::min((int)std::floor((screenMax.y * 0.5f + 0.5f) * size.y) + 1, size.y - 1);
+
+	size_t level = 0;
+	while ((level + 1 < m_depthLevels.size()) &&
+		(((x1 >> level) - (x0 >> level) > 2) || ((y1 >> level) - (y0 >> level) > 2)))
+	{
+		level++;
+	}
+
+	const std::vector<float>& depth = m_depthLevels[level];
+	int levelWidth = m_levelSizes[level].x;
+	float farthestDepth = 0.0f;
+	for (int y = (y0 >> level); y <= (y1 >> level); y++)
+	{
+		for (int x = (x0 >> level); x <= (x1 >> level); x++)
+		{
+			farthestDepth = std::max(farthestDepth, depth[y * levelWidth + x]);
+		}
+	}
+
+	return(nearestDepth > farthestDepth);
+}
+
+/***********************************************************
+ *  BeginLoadShaders()
+ *
+ *  This method is used for starting to build the depth only
+ *  shader program, so it compiles while the other programs
+ *  of startup do.  Create() finishes it.
+ ***********************************************************/
+void OcclusionCuller::BeginLoadShaders(ShaderManager* pSceneShaders)
+{
+	pSceneShaders->BeginLoadShaders(OCCLUDER_VERTEX_SHADER_FILE, OCCLUDER_FRAGMENT_SHADER_FILE);
+}
+
+/***********************************************************
+ *  GetShaderFiles()
+ *
+ *  This method is used for getting the GLSL files of the
+ *  depth only shader program, for packing them in the asset
+ *  archive.
+ ***********************************************************/
+void OcclusionCuller::GetShaderFiles(std::vector<std::string>& files)
+{
+	files.push_back(OCCLUDER_VERTEX_SHADER_FILE);
+	files.push_back(OCCLUDER_FRAGMENT_SHADER_FILE);
+}
@@ -0,0 +1,112 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionculler.h
+// ============
+// hierarchical depth occlusion test of object bounds against the large occluders
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+
+#include <GL/glew.h>        // GLEW library
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  OcclusionCuller
+ *
+ *  This class contains the code for finding the scene
+ *  objects hidden behind the large objects of the scene,
+ *  such as the walls, the floor and the couch.
+ *
+ *  Every frame the occluders are drawn depth only into a
+ *  small occlusion buffer, and its depth is copied into a
+ *  pixel buffer with a fence behind it.  The copy is read a
+ *  frame or two later, once its fence has passed, so the
+ *  CPU never waits for the GPU.  A hierarchical depth (Hi-Z)
+ *  pyramid is built from it, each level holding the farthest
+ *  depth of four texels of the level below.
+ *
+ *  An object is tested by projecting its bounding box with
+ *  the view projection the depth was drawn with, and reading
+ *  the pyramid level where the box covers at most 3 x 3
+ *  texels.  When the nearest point of the box is behind the
+ *  farthest occluder depth over the whole box, it can't be
+ *  seen.  The depth is a few frames old, so an object that
+ *  comes out from behind an occluder can show up a frame
+ *  late, which is hard to notice at interactive frame rates.
+ ***********************************************************/
+class OcclusionCuller
+{
+public:
+	// constructor
+	OcclusionCuller();
+	// destructor
+	~OcclusionCuller();
+
+	// create the occlusion buffer, the pixel buffers and the
+	// depth only shader program, loaded the same way as the
+	// scene shaders
+	bool Create(const ShaderManager* pSceneShaders);
+	// free the OpenGL objects
+	void Destroy();
+
+	// read the newest finished depth copy into the pyramid,
+	// called at the start of the frame
+	void BeginFrame();
+
+	// draw the occluders into the occlusion buffer - each
+	// occluder sets its transform, then draws its mesh
+	void BeginOccluderPass(const glm::mat4& viewProjection);
+	void SetOccluderTransform(const glm::mat4& modelViewProjection);
+	// start copying the depth and put the view back
+	void EndOccluderPass();
+
+	// check whether the world space box is hidden, safe to
+	// call from any thread between the frame stages
+	bool IsBoxOccluded(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const;
+
+	// get the GLSL files of the depth only shader program
+	static void GetShaderFiles(std::vector<std::string>& files);
+	// start building the depth only shader program ahead of
+	// Create(), with the other programs of startup
+	static void BeginLoadShaders(ShaderManager* pSceneShaders);
+
+private:
+	// a copy of the occlusion buffer depth on its way to the CPU
+	struct DEPTH_READBACK
+	{
+		GLuint bufferID;
+		GLsync fence;
+		// view projection the depth was drawn with
+		glm::mat4 viewProjection;
+	};
+
+	static const int NUM_READBACKS = 3;
+
+	// depth only shader program of the occluders
+	ShaderManager* m_pDepthShader;
+	// occlusion buffer
+	GLuint m_framebufferID;
+	GLuint m_depthBufferID;
+	DEPTH_READBACK m_readbacks[NUM_READBACKS];
+	// readback the next occluder pass is copied into
+	int m_readbackIndex;
+	// viewport and framebuffer of the frame, put back after
+	// the occluder pass
+	GLint m_savedViewport[4];
+	GLint m_savedFramebuffer;
+
+	// depth pyramid, level 0 is the size of the occlusion buffer
+	std::vector<std::vector<float> > m_depthLevels;
+	std::vector<glm::ivec2> m_levelSizes;
+	// view projection the pyramid depth was drawn with
+	glm::mat4 m_depthViewProjection;
+	bool m_bHasDepth;
+
+	// build the upper pyramid levels from level 0
+	void BuildDepthPyramid();
+};
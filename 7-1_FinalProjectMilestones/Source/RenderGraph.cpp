@@ -0,0 +1,891 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendergraph.cpp
+// ============
+// schedule the passes of a frame from the textures they read and write
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderGraph.h"
+
+#include <iostream>
+#include <sstream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// most color textures one pass can write
+	const int MAX_COLOR_ATTACHMENTS = 4;
+}
+
+const int RenderGraph::BACKBUFFER;
+const int RenderGraph::NUM_PASS_TIMERS;
+
+/***********************************************************
+ *  RenderGraph()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderGraph::RenderGraph()
+{
+	m_pRenderStats = NULL;
+	m_bCompiled = false;
+	for (int i = 0; i < NUM_PASS_TIMERS; i++)
+	{
+		m_passTimers[i].bPending = false;
+	}
+	m_passTimerIndex = 0;
+	BeginGraph();
+}
+
+/***********************************************************
+ *  ~RenderGraph()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RenderGraph::~RenderGraph()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the framebuffers, the
+ *  textures of the pool and the timestamp queries.
+ ***********************************************************/
+void RenderGraph::Destroy()
+{
+	DestroyFramebuffers();
+	for (size_t i = 0; i < m_physicalTextures.size(); i++)
+	{
+		glDeleteTextures(1, &m_physicalTextures[i].textureID);
+	}
+	m_physicalTextures.clear();
+
+	for (int i = 0; i < NUM_PASS_TIMERS; i++)
+	{
+		if (m_passTimers[i].queryIDs.empty() == false)
+		{
+			glDeleteQueries((GLsizei)m_passTimers[i].queryIDs.size(), m_passTimers[i].queryIDs.data());
+			m_passTimers[i].queryIDs.clear();
+		}
+		m_passTimers[i].bPending = false;
+	}
+
+	m_compiledSignature.clear();
+	m_bCompiled = false;
+}
+
+/***********************************************************
+ *  BeginGraph()
+ *
+ *  This method is used for forgetting the passes and the
+ *  textures of the last frame, before the passes of the new
+ *  frame are added.  The compiled graph is kept, for a frame
+ *  added the same way.
+ ***********************************************************/
+void RenderGraph::BeginGraph()
+{
+	m_passes.clear();
+	m_textures.clear();
+	m_passOrder.clear();
+
+	GRAPH_TEXTURE backbuffer;
+	backbuffer.name = "backbuffer";
+	backbuffer.desc.width = 0;
+	backbuffer.desc.height = 0;
+	backbuffer.desc.format = GL_NONE;
+	backbuffer.physicalIndex = -1;
+	backbuffer.firstUse = -1;
+	backbuffer.lastUse = -1;
+	m_textures.push_back(backbuffer);
+}
+
+/***********************************************************
+ *  CreateTexture()
+ *
+ *  This method is used for declaring a transient texture,
+ *  which gets an OpenGL texture when the graph is compiled.
+ ***********************************************************/
+int RenderGraph::CreateTexture(const char* name, const TEXTURE_DESC& desc)
+{
+	GRAPH_TEXTURE texture;
+	texture.name = name;
+	texture.desc = desc;
+	texture.physicalIndex = -1;
+	texture.firstUse = -1;
+	texture.lastUse = -1;
+	m_textures.push_back(texture);
+
+	return((int)m_textures.size() - 1);
+}
+
+/***********************************************************
+ *  AddPass()
+ *
+ *  This method is used for adding a pass, which runs the
+ *  passed in function when the graph is executed.
+ ***********************************************************/
+int RenderGraph::AddPass(const char* name, std::function<void()> execute)
+{
+	GRAPH_PASS pass;
+	pass.name = name;
+	pass.execute = execute;
+	pass.bSideEffects = false;
+	pass.framebufferID = 0;
+	pass.width = 0;
+	pass.height = 0;
+	m_passes.push_back(pass);
+
+	return((int)m_passes.size() - 1);
+}
+
+/***********************************************************
+ *  ReadTexture()
+ *
+ *  This method is used for declaring that a pass samples a
+ *  texture, so it runs after the passes that write it.
+ ***********************************************************/
+void RenderGraph::ReadTexture(int pass, int texture)
+{
+	m_passes[pass].reads.push_back(texture);
+}
+
+/***********************************************************
+ *  WriteTexture()
+ *
+ *  This method is used for declaring that a pass draws into
+ *  a texture.  A pass draws into the window, or into up to
+ *  four color textures and one depth texture of one size.
+ ***********************************************************/
+void RenderGraph::WriteTexture(int pass, int texture)
+{
+	m_passes[pass].writes.push_back(texture);
+}
+
+/***********************************************************
+ *  SetSideEffects()
+ *
+ *  This method is used for keeping a pass that does work
+ *  outside the graph, such as a read back to the CPU, when
+ *  no pass reads what it writes.
+ ***********************************************************/
+void RenderGraph::SetSideEffects(int pass)
+{
+	m_passes[pass].bSideEffects = true;
+}
+
+/***********************************************************
+ *  GetTextureID()
+ *
+ *  This method is used for getting the OpenGL texture a
+ *  texture was placed in, zero for the window and for a
+ *  texture no pass that runs uses.
+ ***********************************************************/
+GLuint RenderGraph::GetTextureID(int texture) const
+{
+	int physicalIndex = m_textures[texture].physicalIndex;
+	if (physicalIndex < 0)
+	{
+		return(0);
+	}
+	return(m_physicalTextures[physicalIndex].textureID);
+}
+
+/***********************************************************
+ *  Compile()
+ *
+ *  This method is used for ordering the passes, dropping
+ *  the ones nothing reads from, and placing the textures
+ *  and making the framebuffers of the ones that run.  When
+ *  the passes and textures were added the same way as the
+ *  last compiled frame, its results are used as they are.
+ ***********************************************************/
+bool RenderGraph::Compile()
+{
+	std::string signature = GetSignature();
+	if ((m_bCompiled == true) && (signature == m_compiledSignature))
+	{
+		m_passOrder = m_compiledOrder;
+		for (size_t i = 0; i < m_textures.size(); i++)
+		{
+			m_textures[i].physicalIndex = m_compiledPhysical[i];
+		}
+		for (size_t i = 0; i < m_passOrder.size(); i++)
+		{
+			GRAPH_PASS& pass = m_passes[m_passOrder[i]];
+			pass.framebufferID = m_compiledFramebuffers[i];
+			for (size_t j = 0; j < pass.writes.size(); j++)
+			{
+				if (pass.writes[j] != BACKBUFFER)
+				{
+					pass.width = m_textures[pass.writes[j]].desc.width;
+					pass.height = m_textures[pass.writes[j]].desc.height;
+				}
+			}
+		}
+		return(true);
+	}
+
+	DestroyFramebuffers();
+	m_bCompiled = false;
+
+	if (SortPasses(m_passOrder) == false)
+	{
+		std::cout << "Render graph has a cycle, the passes run in the order they were added" << std::endl;
+		m_passOrder.clear();
+		for (size_t i = 0; i < m_passes.size(); i++)
+		{
+			m_passOrder.push_back((int)i);
+		}
+	}
+	CullPasses(m_passOrder);
+	PlaceTextures();
+	if (CreateFramebuffers() == false)
+	{
+		DestroyFramebuffers();
+		return(false);
+	}
+
+	m_compiledSignature = signature;
+	m_compiledOrder = m_passOrder;
+	m_compiledPhysical.clear();
+	for (size_t i = 0; i < m_textures.size(); i++)
+	{
+		m_compiledPhysical.push_back(m_textures[i].physicalIndex);
+	}
+	m_bCompiled = true;
+
+	std::cout << "Render graph compiled:";
+	for (size_t i = 0; i < m_passOrder.size(); i++)
+	{
+		std::cout << " " << m_passes[m_passOrder[i]].name;
+	}
+	std::cout << ", " << (m_passes.size() - m_passOrder.size()) << " passes culled, "
+		<< m_physicalTextures.size() << " textures for "
+		<< (m_textures.size() - 1) << " transient" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  Execute()
+ *
+ *  This method is used for running the passes in order.
+ *  Each pass has its framebuffer bound and the viewport set
+ *  to the size of the textures it writes, or to the viewport
+ *  of the window for the passes that draw into the window,
+ *  and a timestamp is written before it.
+ ***********************************************************/
+void RenderGraph::Execute()
+{
+	if (m_bCompiled == false)
+	{
+		return;
+	}
+
+	ReadPassTimers();
+	CountTextureMemory();
+
+	GLint windowViewport[4];
+	glGetIntegerv(GL_VIEWPORT, windowViewport);
+
+	// with every timer still in flight this frame goes unmeasured
+	PASS_TIMER& timer = m_passTimers[m_passTimerIndex];
+	bool bTiming = (timer.bPending == false);
+	if (bTiming == true)
+	{
+		size_t numQueries = m_passOrder.size() + 1;
+		if (timer.queryIDs.size() < numQueries)
+		{
+			size_t first = timer.queryIDs.size();
+			timer.queryIDs.resize(numQueries);
+			glGenQueries((GLsizei)(numQueries - first), &timer.queryIDs[first]);
+		}
+		timer.passNames.clear();
+	}
+
+	for (size_t i = 0; i < m_passOrder.size(); i++)
+	{
+		GRAPH_PASS& pass = m_passes[m_passOrder[i]];
+		if (bTiming == true)
+		{
+			glQueryCounter(timer.queryIDs[i], GL_TIMESTAMP);
+			timer.passNames.push_back(pass.name);
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, pass.framebufferID);
+		if (0 == pass.framebufferID)
+		{
+			glViewport(windowViewport[0], windowViewport[1], windowViewport[2], windowViewport[3]);
+		}
+		else
+		{
+			glViewport(0, 0, pass.width, pass.height);
+		}
+		pass.execute();
+	}
+
+	if (bTiming == true)
+	{
+		glQueryCounter(timer.queryIDs[m_passOrder.size()], GL_TIMESTAMP);
+		timer.bPending = true;
+		m_passTimerIndex = (m_passTimerIndex + 1) % NUM_PASS_TIMERS;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(windowViewport[0], windowViewport[1], windowViewport[2], windowViewport[3]);
+}
+
+/***********************************************************
+ *  GetSignature()
+ *
+ *  This method is used for describing the passes and the
+ *  textures added this frame - everything the compiled graph
+ *  depends on, which is everything but the pass functions.
+ ***********************************************************/
+std::string RenderGraph::GetSignature() const
+{
+	std::ostringstream signature;
+	for (size_t i = 0; i < m_textures.size(); i++)
+	{
+		signature << "t" << m_textures[i].desc.width << "x" << m_textures[i].desc.height
+			<< ":" << m_textures[i].desc.format << ";";
+	}
+	for (size_t i = 0; i < m_passes.size(); i++)
+	{
+		signature << "p" << m_passes[i].name << (m_passes[i].bSideEffects ? "!" : "") << "r";
+		for (size_t j = 0; j < m_passes[i].reads.size(); j++)
+		{
+			signature << m_passes[i].reads[j] << ",";
+		}
+		signature << "w";
+		for (size_t j = 0; j < m_passes[i].writes.size(); j++)
+		{
+			signature << m_passes[i].writes[j] << ",";
+		}
+		signature << ";";
+	}
+	return(signature.str());
+}
+
+/***********************************************************
+ *  SortPasses()
+ *
+ *  This method is used for ordering the passes so a pass
+ *  that reads a texture runs after the passes added before
+ *  it that write it, and before the ones added after it
+ *  that write it.  A texture read before any pass that
+ *  writes it was added is read after all of them.  Of the
+ *  passes that are free to run, the first added runs first,
+ *  so passes added in order keep it.  Returns false if the
+ *  passes depend on each other in a cycle.
+ ***********************************************************/
+bool RenderGraph::SortPasses(std::vector<int>& order) const
+{
+	size_t numPasses = m_passes.size();
+	std::vector<std::vector<int> > edges(numPasses);
+	std::vector<int> inDegree(numPasses, 0);
+
+	for (size_t texture = 0; texture < m_textures.size(); texture++)
+	{
+		std::vector<int> writers;
+		std::vector<int> readers;
+		for (size_t i = 0; i < numPasses; i++)
+		{
+			const GRAPH_PASS& pass = m_passes[i];
+			for (size_t j = 0; j < pass.writes.size(); j++)
+			{
+				if (pass.writes[j] == (int)texture)
+				{
+					writers.push_back((int)i);
+					break;
+				}
+			}
+			for (size_t j = 0; j < pass.reads.size(); j++)
+			{
+				if (pass.reads[j] == (int)texture)
+				{
+					readers.push_back((int)i);
+					break;
+				}
+			}
+		}
+
+		// the writes land in the order they were added
+		for (size_t i = 1; i < writers.size(); i++)
+		{
+			edges[writers[i - 1]].push_back(writers[i]);
+			inDegree[writers[i]]++;
+		}
+
+		for (size_t i = 0; i < readers.size(); i++)
+		{
+			int reader = readers[i];
+			bool bWrittenBefore = false;
+			for (size_t j = 0; j < writers.size(); j++)
+			{
+				if (writers[j] < reader)
+				{
+					bWrittenBefore = true;
+				}
+			}
+			for (size_t j = 0; j < writers.size(); j++)
+			{
+				int writer = writers[j];
+				if (writer == reader)
+				{
+					continue;
+				}
+				if ((writer < reader) || (bWrittenBefore == false))
+				{
+					edges[writer].push_back(reader);
+					inDegree[reader]++;
+				}
+				else
+				{
+					edges[reader].push_back(writer);
+					inDegree[writer]++;
+				}
+			}
+		}
+	}
+
+	order.clear();
+	std::vector<bool> bDone(numPasses, false);
+	while (order.size() < numPasses)
+	{
+		int next = -1;
+		for (size_t i = 0; i < numPasses; i++)
+		{
+			if ((bDone[i] == false) && (inDegree[i] == 0))
+			{
+				next = (int)i;
+				break;
+			}
+		}
+		if (next < 0)
+		{
+			return(false);
+		}
+
+		bDone[next] = true;
+		order.push_back(next);
+		for (size_t i = 0; i < edges[next].size(); i++)
+		{
+			inDegree[edges[next][i]]--;
+		}
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  CullPasses()
+ *
+ *  This method is used for dropping the passes whose output
+ *  is never used.  Going from the last pass to the first, a
+ *  pass is kept if it draws into the window, has side
+ *  effects, or writes a texture a kept pass after it reads.
+ ***********************************************************/
+void RenderGraph::CullPasses(std::vector<int>& order) const
+{
+	std::vector<bool> bNeeded(m_textures.size(), false);
+	std::vector<int> kept;
+
+	for (size_t i = order.size(); i > 0; i--)
+	{
+		const GRAPH_PASS& pass = m_passes[order[i - 1]];
+		bool bKeep = pass.bSideEffects;
+		for (size_t j = 0; j < pass.writes.size(); j++)
+		{
+			if ((pass.writes[j] == BACKBUFFER) || (bNeeded[pass.writes[j]] == true))
+			{
+				bKeep = true;
+			}
+		}
+		if (bKeep == false)
+		{
+			continue;
+		}
+
+		// what is read has to be written by the passes before,
+		// and a texture written again isn't needed before that
+		for (size_t j = 0; j < pass.writes.size(); j++)
+		{
+			bNeeded[pass.writes[j]] = false;
+		}
+		for (size_t j = 0; j < pass.reads.size(); j++)
+		{
+			bNeeded[pass.reads[j]] = true;
+		}
+		kept.push_back(order[i - 1]);
+	}
+
+	order.assign(kept.rbegin(), kept.rend());
+}
+
+/***********************************************************
+ *  PlaceTextures()
+ *
+ *  This method is used for giving every transient texture a
+ *  texture of the pool.  The textures are placed in the order
+ *  the passes that first use them run, each in a texture of
+ *  the same size and format whose last user has already run,
+ *  or in a new one when there is none.  The textures of the
+ *  pool nothing was placed in are freed, so the pool only
+ *  holds what the frame needs at once.
+ ***********************************************************/
+void RenderGraph::PlaceTextures()
+{
+	for (size_t i = 0; i < m_textures.size(); i++)
+	{
+		m_textures[i].physicalIndex = -1;
+		m_textures[i].firstUse = -1;
+		m_textures[i].lastUse = -1;
+	}
+	for (size_t i = 0; i < m_passOrder.size(); i++)
+	{
+		const GRAPH_PASS& pass = m_passes[m_passOrder[i]];
+		for (int list = 0; list < 2; list++)
+		{
+			const std::vector<int>& textures = (list == 0) ? pass.reads : pass.writes;
+			for (size_t j = 0; j < textures.size(); j++)
+			{
+				GRAPH_TEXTURE& texture = m_textures[textures[j]];
+				if (texture.firstUse < 0)
+				{
+					texture.firstUse = (int)i;
+				}
+				texture.lastUse = (int)i;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < m_physicalTextures.size(); i++)
+	{
+		m_physicalTextures[i].lastUse = -1;
+	}
+	std::vector<bool> bUsed(m_physicalTextures.size(), false);
+
+	for (size_t position = 0; position < m_passOrder.size(); position++)
+	{
+		for (size_t i = 1; i < m_textures.size(); i++)
+		{
+			GRAPH_TEXTURE& texture = m_textures[i];
+			if (texture.firstUse != (int)position)
+			{
+				continue;
+			}
+
+			int physicalIndex = -1;
+			for (size_t j = 0; j < m_physicalTextures.size(); j++)
+			{
+				const PHYSICAL_TEXTURE& physical = m_physicalTextures[j];
+				if ((physical.lastUse < (int)position) &&
+					(physical.desc.width == texture.desc.width) &&
+					(physical.desc.height == texture.desc.height) &&
+					(physical.desc.format == texture.desc.format))
+				{
+					physicalIndex = (int)j;
+					break;
+				}
+			}
+			if (physicalIndex < 0)
+			{
+				PHYSICAL_TEXTURE physical;
+				physical.desc = texture.desc;
+				physical.textureID = CreatePhysicalTexture(texture.desc);
+				physical.lastUse = -1;
+				m_physicalTextures.push_back(physical);
+				bUsed.push_back(false);
+				physicalIndex = (int)m_physicalTextures.size() - 1;
+			}
+
+			m_physicalTextures[physicalIndex].lastUse = texture.lastUse;
+			bUsed[physicalIndex] = true;
+			texture.physicalIndex = physicalIndex;
+		}
+	}
+
+	// free the textures of the pool no texture was placed in
+	std::vector<int> newIndex(m_physicalTextures.size(), -1);
+	std::vector<PHYSICAL_TEXTURE> kept;
+	for (size_t i = 0; i < m_physicalTextures.size(); i++)
+	{
+		if (bUsed[i] == true)
+		{
+			newIndex[i] = (int)kept.size();
+			kept.push_back(m_physicalTextures[i]);
+		}
+		else
+		{
+			glDeleteTextures(1, &m_physicalTextures[i].textureID);
+		}
+	}
+	m_physicalTextures.swap(kept);
+	for (size_t i = 1; i < m_textures.size(); i++)
+	{
+		if (m_textures[i].physicalIndex >= 0)
+		{
+			m_textures[i].physicalIndex = newIndex[m_textures[i].physicalIndex];
+		}
+	}
+}
+
+/***********************************************************
+ *  CreateFramebuffers()
+ *
+ *  This method is used for making a framebuffer for every
+ *  pass that runs and draws into textures, with the color
+ *  textures it writes attached in the order it declared
+ *  them.  Returns false if one of them is not complete.
+ ***********************************************************/
+bool RenderGraph::CreateFramebuffers()
+{
+	GLint savedFramebuffer = 0;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &savedFramebuffer);
+
+	bool bComplete = true;
+	m_compiledFramebuffers.clear();
+	for (size_t i = 0; i < m_passOrder.size(); i++)
+	{
+		GRAPH_PASS& pass = m_passes[m_passOrder[i]];
+		pass.framebufferID = 0;
+		pass.width = 0;
+		pass.height = 0;
+
+		bool bWindow = false;
+		std::vector<int> textures;
+		for (size_t j = 0; j < pass.writes.size(); j++)
+		{
+			if (pass.writes[j] == BACKBUFFER)
+			{
+				bWindow = true;
+			}
+			else
+			{
+				textures.push_back(pass.writes[j]);
+			}
+		}
+		if ((bWindow == true) || (textures.empty() == true))
+		{
+			if ((bWindow == true) && (textures.empty() == false))
+			{
+				std::cout << "Render graph pass " << pass.name
+					<< " writes the window and textures, it only draws into the window" << std::endl;
+			}
+			m_compiledFramebuffers.push_back(0);
+			continue;
+		}
+
+		glGenFramebuffers(1, &pass.framebufferID);
+		glBindFramebuffer(GL_FRAMEBUFFER, pass.framebufferID);
+		GLenum drawBuffers[MAX_COLOR_ATTACHMENTS];
+		int numColors = 0;
+		for (size_t j = 0; j < textures.size(); j++)
+		{
+			const GRAPH_TEXTURE& texture = m_textures[textures[j]];
+			GLuint textureID = m_physicalTextures[texture.physicalIndex].textureID;
+			pass.width = texture.desc.width;
+			pass.height = texture.desc.height;
+
+			if (IsDepthFormat(texture.desc.format) == true)
+			{
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textureID, 0);
+			}
+			else if (numColors < MAX_COLOR_ATTACHMENTS)
+			{
+				drawBuffers[numColors] = GL_COLOR_ATTACHMENT0 + numColors;
+				glFramebufferTexture2D(GL_FRAMEBUFFER, drawBuffers[numColors], GL_TEXTURE_2D, textureID, 0);
+				numColors++;
+			}
+		}
+		if (numColors > 0)
+		{
+			glDrawBuffers(numColors, drawBuffers);
+		}
+		else
+		{
+			glDrawBuffer(GL_NONE);
+		}
+
+		GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		if (status != GL_FRAMEBUFFER_COMPLETE)
+		{
+			std::cout << "Render graph pass " << pass.name << " framebuffer is not complete:" << status << std::endl;
+			bComplete = false;
+		}
+		m_compiledFramebuffers.push_back(pass.framebufferID);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)savedFramebuffer);
+	return(bComplete);
+}
+
+/***********************************************************
+ *  DestroyFramebuffers()
+ *
+ *  This method is used for freeing the framebuffers of the
+ *  compiled graph.
+ ***********************************************************/
+void RenderGraph::DestroyFramebuffers()
+{
+	for (size_t i = 0; i < m_compiledFramebuffers.size(); i++)
+	{
+		if (0 != m_compiledFramebuffers[i])
+		{
+			glDeleteFramebuffers(1, &m_compiledFramebuffers[i]);
+		}
+	}
+	m_compiledFramebuffers.clear();
+	for (size_t i = 0; i < m_passes.size(); i++)
+	{
+		m_passes[i].framebufferID = 0;
+	}
+}
+
+/***********************************************************
+ *  CountTextureMemory()
+ *
+ *  This method is used for counting the bytes the textures
+ *  of the pool take, and the bytes the transient textures
+ *  would take without sharing any.
+ ***********************************************************/
+void RenderGraph::CountTextureMemory() const
+{
+	if (NULL == m_pRenderStats)
+	{
+		return;
+	}
+
+	uint64_t placedBytes = 0;
+	for (size_t i = 0; i < m_physicalTextures.size(); i++)
+	{
+		placedBytes += GetTextureBytes(m_physicalTextures[i].desc);
+	}
+	uint64_t unaliasedBytes = 0;
+	for (size_t i = 1; i < m_textures.size(); i++)
+	{
+		if (m_textures[i].physicalIndex >= 0)
+		{
+			unaliasedBytes += GetTextureBytes(m_textures[i].desc);
+		}
+	}
+	m_pRenderStats->CountTransientMemory(placedBytes, unaliasedBytes);
+}
+
+/***********************************************************
+ *  ReadPassTimers()
+ *
+ *  This method is used for counting the GPU time of every
+ *  pass of the measured frames that are done.  The frames
+ *  finish in the order they were drawn, so the reading
+ *  starts at the oldest and stops at the first one still
+ *  running.  The results are only polled, never waited on.
+ ***********************************************************/
+void RenderGraph::ReadPassTimers()
+{
+	for (int i = 0; i < NUM_PASS_TIMERS; i++)
+	{
+		PASS_TIMER& timer = m_passTimers[(m_passTimerIndex + i) % NUM_PASS_TIMERS];
+		if (timer.bPending == false)
+		{
+			continue;
+		}
+
+		size_t numPasses = timer.passNames.size();
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(timer.queryIDs[numPasses], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == GL_FALSE)
+		{
+			break;
+		}
+
+		GLuint64 previous = 0;
+		glGetQueryObjectui64v(timer.queryIDs[0], GL_QUERY_RESULT, &previous);
+		for (size_t j = 0; j < numPasses; j++)
+		{
+			GLuint64 current = 0;
+			glGetQueryObjectui64v(timer.queryIDs[j + 1], GL_QUERY_RESULT, &current);
+			if (NULL != m_pRenderStats)
+			{
+				m_pRenderStats->CountPassTime(timer.passNames[j], (float)((current - previous) / 1000000.0));
+			}
+			previous = current;
+		}
+		timer.bPending = false;
+	}
+}
+
+/***********************************************************
+ *  CreatePhysicalTexture()
+ *
+ *  This method is used for making an OpenGL texture of the
+ *  passed in size and format.  The color textures are
+ *  filtered, for passes that scale them, and the depth
+ *  textures are read texel for texel.  The texture bound to
+ *  the active unit is put back, as the scene textures stay
+ *  bound to their units.
+ ***********************************************************/
+GLuint RenderGraph::CreatePhysicalTexture(const TEXTURE_DESC& desc)
+{
+	GLenum format = GL_RGBA;
+	GLenum type = GL_UNSIGNED_BYTE;
+	GLint filter = GL_LINEAR;
+	if (desc.format == GL_RGBA16F)
+	{
+		type = GL_FLOAT;
+	}
+	else if (desc.format == GL_R32F)
+	{
+		format = GL_RED;
+		type = GL_FLOAT;
+	}
+	else if (IsDepthFormat(desc.format) == true)
+	{
+		format = GL_DEPTH_COMPONENT;
+		type = (desc.format == GL_DEPTH_COMPONENT32F) ? GL_FLOAT : GL_UNSIGNED_INT;
+		filter = GL_NEAREST;
+	}
+
+	GLint boundTexture = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexture);
+
+	GLuint textureID = 0;
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_2D, textureID);
+	glTexImage2D(GL_TEXTURE_2D, 0, desc.format, desc.width, desc.height, 0, format, type, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, (GLuint)boundTexture);
+
+	return(textureID);
+}
+
+/***********************************************************
+ *  IsDepthFormat()
+ *
+ *  This method is used for checking whether a format is
+ *  attached as the depth of a framebuffer.
+ ***********************************************************/
+bool RenderGraph::IsDepthFormat(GLenum format)
+{
+	return((format == GL_DEPTH_COMPONENT24) || (format == GL_DEPTH_COMPONENT32F));
+}
+
+/***********************************************************
+ *  GetTextureBytes()
+ *
+ *  This method is used for getting roughly the bytes a
+ *  texture of the passed in description takes on the GPU.
+ ***********************************************************/
+size_t RenderGraph::GetTextureBytes(const TEXTURE_DESC& desc)
+{
+	size_t bytesPerTexel = 4;
+	if (desc.format == GL_RGBA16F)
+	{
+		bytesPerTexel = 8;
+	}
+	return((size_t)desc.width * (size_t)desc.height * bytesPerTexel);
+}
@@ -0,0 +1,187 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendergraph.h
+// ============
+// schedule the passes of a frame from the textures they read and write
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "RenderStats.h"
+
+#include <GL/glew.h>        // GLEW library
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  RenderGraph
+ *
+ *  This class contains the code for running the passes of a
+ *  frame from a description of the textures each one reads
+ *  and writes, rather than from framebuffers set up by hand.
+ *
+ *  Every frame the passes are added again, each with the
+ *  function that draws it, and the textures are declared by
+ *  their size and format.  Those are transient - they only
+ *  hold anything between the pass that writes them and the
+ *  last pass that reads them, and start out undefined, so a
+ *  pass has to clear what it writes.  The window is the one
+ *  imported texture, which holds the result.
+ *
+ *  Compiling the graph orders the passes so every pass runs
+ *  after the passes that write what it reads, keeping the
+ *  order they were added in otherwise, and drops the passes
+ *  nothing reads the output of.  Two transient textures of
+ *  the same size and format share one OpenGL texture when
+ *  the passes that use them don't overlap, so the memory
+ *  only grows with the textures alive at the same time.  A
+ *  frame added the same way as the last reuses its compiled
+ *  graph, textures and framebuffers.
+ *
+ *  The GPU time of every pass is measured with timestamp
+ *  queries, read a few frames later, and counted in the
+ *  render stats by the name of the pass.
+ ***********************************************************/
+class RenderGraph
+{
+public:
+	// size and format of a transient texture
+	struct TEXTURE_DESC
+	{
+		int width;
+		int height;
+		// GL_RGBA8, GL_RGBA16F, GL_R32F, GL_DEPTH_COMPONENT24
+		// or GL_DEPTH_COMPONENT32F
+		GLenum format;
+	};
+
+	// the window, every graph has it as texture 0
+	static const int BACKBUFFER = 0;
+
+	// constructor
+	RenderGraph();
+	// destructor
+	~RenderGraph();
+
+	// set the render stats the pass times and texture memory
+	// are counted in
+	void SetRenderStats(RenderStats* pRenderStats) { m_pRenderStats = pRenderStats; }
+
+	// start adding the passes of a new frame
+	void BeginGraph();
+	// declare a transient texture and get its handle
+	int CreateTexture(const char* name, const TEXTURE_DESC& desc);
+	// add a pass that runs the passed in function, and get its
+	// handle for declaring what it reads and writes
+	int AddPass(const char* name, std::function<void()> execute);
+	// declare a texture the pass samples
+	void ReadTexture(int pass, int texture);
+	// declare a texture the pass draws into, as a color or the
+	// depth attachment by its format
+	void WriteTexture(int pass, int texture);
+	// keep the pass even when nothing reads what it writes
+	void SetSideEffects(int pass);
+
+	// order and cull the passes and place the textures
+	bool Compile();
+	// run the passes, each with its framebuffer bound and the
+	// viewport the size of what it writes
+	void Execute();
+
+	// get the OpenGL texture of a texture, while the graph runs
+	GLuint GetTextureID(int texture) const;
+
+	// free the OpenGL objects
+	void Destroy();
+
+private:
+	// a texture of the graph
+	struct GRAPH_TEXTURE
+	{
+		std::string name;
+		TEXTURE_DESC desc;
+		// texture of the pool it was placed in, -1 for the window
+		int physicalIndex;
+		// first and last place in the order of the passes that
+		// use it, -1 when none of them run
+		int firstUse;
+		int lastUse;
+	};
+
+	// a pass of the graph
+	struct GRAPH_PASS
+	{
+		std::string name;
+		std::function<void()> execute;
+		std::vector<int> reads;
+		std::vector<int> writes;
+		bool bSideEffects;
+		// framebuffer of the textures it writes, 0 for the window
+		GLuint framebufferID;
+		int width;
+		int height;
+	};
+
+	// an OpenGL texture textures of the graph are placed in
+	struct PHYSICAL_TEXTURE
+	{
+		TEXTURE_DESC desc;
+		GLuint textureID;
+		// last place in the order it is used at, while placing
+		int lastUse;
+	};
+
+	// timestamps of the passes of one frame, on their way back
+	struct PASS_TIMER
+	{
+		// one before every pass and one after the last
+		std::vector<GLuint> queryIDs;
+		std::vector<std::string> passNames;
+		bool bPending;
+	};
+
+	static const int NUM_PASS_TIMERS = 4;
+
+	RenderStats* m_pRenderStats;
+	std::vector<GRAPH_TEXTURE> m_textures;
+	std::vector<GRAPH_PASS> m_passes;
+	// the passes that run, in the order they run
+	std::vector<int> m_passOrder;
+	std::vector<PHYSICAL_TEXTURE> m_physicalTextures;
+
+	// description of the compiled graph, to find a frame added
+	// the same way as the last
+	std::string m_compiledSignature;
+	std::vector<int> m_compiledOrder;
+	std::vector<int> m_compiledPhysical;
+	std::vector<GLuint> m_compiledFramebuffers;
+	bool m_bCompiled;
+
+	PASS_TIMER m_passTimers[NUM_PASS_TIMERS];
+	int m_passTimerIndex;
+
+	// describe the passes and textures added this frame
+	std::string GetSignature() const;
+	// order the passes so the writers of a texture run first
+	bool SortPasses(std::vector<int>& order) const;
+	// drop the passes nothing that runs reads from
+	void CullPasses(std::vector<int>& order) const;
+	// place the transient textures in the pool, sharing the
+	// textures of those that don't overlap
+	void PlaceTextures();
+	// make the framebuffer of every pass that runs
+	bool CreateFramebuffers();
+	void DestroyFramebuffers();
+	// count the memory the textures take, and would take each
+	// in their own texture
+	void CountTextureMemory() const;
+	// read the pass times that are done, oldest first
+	void ReadPassTimers();
+
+	// make an OpenGL texture of the passed in description
+	static GLuint CreatePhysicalTexture(const TEXTURE_DESC& desc);
+	static bool IsDepthFormat(GLenum format);
+	static size_t GetTextureBytes(const TEXTURE_DESC& desc);
+};
@@ -0,0 +1,548 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderstats.cpp
+// ============
+// per-frame render statistics - draw calls, primitives, state changes, uploads
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderStats.h"
+
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+
+// declaration of global variables
+namespace
+{
+	// names used when printing the per mesh type draw counts
+	const char* g_MeshTypeNames[MESH_TYPE_COUNT] =
+	{
+		"plane",
+		"box",
+		"cylinder",
+		"sphere",
+		"halfSphere",
+		"model"
+	};
+
+	// default number of seconds between printed reports
+	const double DEFAULT_REPORT_INTERVAL = 5.0;
+}
+
+/***********************************************************
+ *  RenderStats()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderStats::RenderStats()
+{
+	ClearStats(m_currentFrame);
+	ClearStats(m_lastFrame);
+	ClearStats(m_reportTotals);
+	m_reportFrames = 0;
+	m_lastReportTime = -1.0;
+	m_reportInterval = DEFAULT_REPORT_INTERVAL;
+	m_frameCount = 0;
+	m_totalBytesUploaded = 0;
+	m_pendingSkippedFrames = 0;
+	m_skippedFrameCount = 0;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for resetting the counters before
+ *  the next frame is rendered.  Anything counted before the
+ *  first frame (load time uploads) is kept in the totals.
+ *  The frames skipped since the last one are counted in it.
+ ***********************************************************/
+void RenderStats::BeginFrame()
+{
+	ClearStats(m_currentFrame);
+	m_currentFrame.skippedFrames = m_pendingSkippedFrames;
+	m_pendingSkippedFrames = 0;
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for closing the current frame, making
+ *  its counters queryable, and printing the averaged report
+ *  when the report interval has elapsed.
+ ***********************************************************/
+void RenderStats::EndFrame(double currentTime)
+{
+	m_lastFrame = m_currentFrame;
+	AccumulateStats(m_reportTotals, m_currentFrame);
+	m_reportFrames++;
+	m_frameCount++;
+
+	// the first completed frame starts the report timer
+	if (m_lastReportTime < 0.0)
+	{
+		m_lastReportTime = currentTime;
+		return;
+	}
+
+	double elapsed = currentTime - m_lastReportTime;
+	if ((m_reportInterval > 0.0) && (elapsed >= m_reportInterval))
+	{
+		PrintStats(m_reportTotals, m_reportFrames, elapsed);
+		PrintPassTimes();
+		ClearStats(m_reportTotals);
+		m_reportFrames = 0;
+		m_lastReportTime = currentTime;
+	}
+}
+
+/***********************************************************
+ *  CountDraw()
+ *
+ *  This method is used for counting one draw call of the
+ *  passed in mesh type and the primitives it submitted.
+ ***********************************************************/
+void RenderStats::CountDraw(MESH_TYPE meshType, bool bLines, uint64_t primitives)
+{
+	m_currentFrame.drawCalls++;
+	if (bLines == true)
+	{
+		m_currentFrame.lineDrawCalls[meshType]++;
+		m_currentFrame.lines += primitives;
+	}
+	else
+	{
+		m_currentFrame.meshDrawCalls[meshType]++;
+		m_currentFrame.triangles += primitives;
+	}
+}
+
+/***********************************************************
+ *  CountMultiDraw()
+ *
+ *  This method is used for counting one draw call of a list
+ *  of indirect commands.  The commands are written on the
+ *  GPU, so their meshes and primitives aren't known here.
+ ***********************************************************/
+void RenderStats::CountMultiDraw()
+{
+	m_currentFrame.drawCalls++;
+	m_currentFrame.multiDrawCalls++;
+}
+
+/***********************************************************
+ *  CountStaticBatchDraw()
+ *
+ *  This method is used for counting one draw call of a batch
+ *  of merged static objects, which has no one mesh type, and
+ *  the primitives it submitted.
+ ***********************************************************/
+void RenderStats::CountStaticBatchDraw(bool bLines, uint64_t primitives)
+{
+	m_currentFrame.drawCalls++;
+	m_currentFrame.staticBatchDraws++;
+	if (bLines == true)
+	{
+		m_currentFrame.lines += primitives;
+	}
+	else
+	{
+		m_currentFrame.triangles += primitives;
+	}
+}
+
+/***********************************************************
+ *  CountStaticLayer()
+ *
+ *  This method is used for counting whether the image of
+ *  the static layer was drawn for the frame or reused.
+ ***********************************************************/
+void RenderStats::CountStaticLayer(bool bReused)
+{
+	if (bReused == true)
+		m_currentFrame.staticLayerReuses++;
+	else
+		m_currentFrame.staticLayerDraws++;
+}
+
+/***********************************************************
+ *  CountUniformWrite()
+ *
+ *  This method is used for counting one uniform write and
+ *  the size of the uniform data sent to the driver.
+ ***********************************************************/
+void RenderStats::CountUniformWrite(uint32_t numBytes)
+{
+	m_currentFrame.uniformWrites++;
+	CountUpload(numBytes);
+}
+
+/***********************************************************
+ *  CountProgramBind()
+ *
+ *  This method is used for counting one shader program bind.
+ ***********************************************************/
+void RenderStats::CountProgramBind()
+{
+	m_currentFrame.programBinds++;
+}
+
+/***********************************************************
+ *  CountTextureBind()
+ *
+ *  This method is used for counting one texture bind.
+ ***********************************************************/
+void RenderStats::CountTextureBind()
+{
+	m_currentFrame.textureBinds++;
+}
+
+/***********************************************************
+ *  CountBufferBind()
+ *
+ *  This method is used for counting one buffer range bind.
+ ***********************************************************/
+void RenderStats::CountBufferBind()
+{
+	m_currentFrame.bufferBinds++;
+}
+
+/***********************************************************
+ *  CountFenceWait()
+ *
+ *  This method is used for counting one wait of the CPU on
+ *  a fence the GPU had not reached yet, and how long it was.
+ ***********************************************************/
+void RenderStats::CountFenceWait(float milliseconds)
+{
+	m_currentFrame.fenceWaits++;
+	m_currentFrame.fenceWaitMs += milliseconds;
+}
+
+/***********************************************************
+ *  CountFramesInFlight()
+ *
+ *  This method is used for keeping the number of frames the
+ *  GPU was still working on when the frame began, which is
+ *  how far the CPU runs ahead of it.
+ ***********************************************************/
+void RenderStats::CountFramesInFlight(uint32_t numFrames)
+{
+	m_currentFrame.framesInFlight = numFrames;
+}
+
+/***********************************************************
+ *  CountUpload()
+ *
+ *  This method is used for counting bytes sent to the driver.
+ ***********************************************************/
+void RenderStats::CountUpload(uint64_t numBytes)
+{
+	m_currentFrame.bytesUploaded += numBytes;
+	m_totalBytesUploaded += numBytes;
+}
+
+/***********************************************************
+ *  CountCulling()
+ *
+ *  This method is used for counting the scene objects that
+ *  were drawn and the ones rejected by the visibility test.
+ ***********************************************************/
+void RenderStats::CountCulling(uint32_t numVisible, uint32_t numCulled)
+{
+	m_currentFrame.visibleObjects += numVisible;
+	m_currentFrame.culledObjects += numCulled;
+}
+
+/***********************************************************
+ *  CountOcclusion()
+ *
+ *  This method is used for counting the culled scene objects
+ *  that were inside the view but behind the occluders.
+ ***********************************************************/
+void RenderStats::CountOcclusion(uint32_t numOccluded)
+{
+	m_currentFrame.occludedObjects += numOccluded;
+}
+
+/***********************************************************
+ *  CountMeshlets()
+ *
+ *  This method is used for counting the meshlets of a model
+ *  that passed and failed the meshlet culling.
+ ***********************************************************/
+void RenderStats::CountMeshlets(uint32_t numVisible, uint32_t numCulled)
+{
+	m_currentFrame.visibleMeshlets += numVisible;
+	m_currentFrame.culledMeshlets += numCulled;
+}
+
+/***********************************************************
+ *  CountRenderScale()
+ *
+ *  This method is used for keeping the scale the frame is
+ *  drawn at with dynamic resolution, and the GPU frame time
+ *  it was chosen from.
+ ***********************************************************/
+void RenderStats::CountRenderScale(float renderScale, float gpuMilliseconds)
+{
+	m_currentFrame.renderScale = renderScale;
+	m_currentFrame.gpuMilliseconds = gpuMilliseconds;
+}
+
+/***********************************************************
+ *  CountSkippedFrames()
+ *
+ *  This method is used for counting the frames that were not
+ *  drawn as nothing on the screen changed - the refresh
+ *  intervals that passed while waiting.  It is called between
+ *  frames, so they are added to the next frame drawn.
+ ***********************************************************/
+void RenderStats::CountSkippedFrames(uint32_t numFrames)
+{
+	m_pendingSkippedFrames += numFrames;
+	m_skippedFrameCount += numFrames;
+}
+
+/***********************************************************
+ *  CountFrameLatency()
+ *
+ *  This method is used for counting the time from the start
+ *  of a frame, and from the oldest input it showed, to the
+ *  GPU finishing it.  Frames are only seen to finish a frame
+ *  or more later, so they are counted in a later frame.
+ ***********************************************************/
+void RenderStats::CountFrameLatency(float frameMilliseconds, float inputMilliseconds)
+{
+	m_currentFrame.latencyFrames++;
+	m_currentFrame.frameLatencyMs += frameMilliseconds;
+	if (inputMilliseconds >= 0.0f)
+	{
+		m_currentFrame.inputLatencyFrames++;
+		m_currentFrame.inputLatencyMs += inputMilliseconds;
+		m_currentFrame.maxInputLatencyMs = std::max(m_currentFrame.maxInputLatencyMs, inputMilliseconds);
+	}
+}
+
+/***********************************************************
+ *  CountPacingWait()
+ *
+ *  This method is used for counting the time the frame
+ *  waited for the GPU to catch up or for the frame limit.
+ ***********************************************************/
+void RenderStats::CountPacingWait(float milliseconds)
+{
+	m_currentFrame.pacingWaitMs += milliseconds;
+}
+
+/***********************************************************
+ *  CountTransientMemory()
+ *
+ *  This method is used for counting the memory the transient
+ *  textures of the render graph take, and would take if no
+ *  two of them shared a texture.
+ ***********************************************************/
+void RenderStats::CountTransientMemory(uint64_t numBytes, uint64_t numUnaliasedBytes)
+{
+	m_currentFrame.transientBytes = numBytes;
+	m_currentFrame.unaliasedTransientBytes = numUnaliasedBytes;
+}
+
+/***********************************************************
+ *  CountPassTime()
+ *
+ *  This method is used for counting the GPU time of one
+ *  render graph pass, by the name of the pass.
+ ***********************************************************/
+void RenderStats::CountPassTime(const std::string& passName, float milliseconds)
+{
+	for (size_t i = 0; i < m_passTimes.size(); i++)
+	{
+		if (m_passTimes[i].name == passName)
+		{
+			m_passTimes[i].totalMilliseconds += milliseconds;
+			m_passTimes[i].samples++;
+			return;
+		}
+	}
+
+	PASS_TIME passTime;
+	passTime.name = passName;
+	passTime.totalMilliseconds = milliseconds;
+	passTime.samples = 1;
+	m_passTimes.push_back(passTime);
+}
+
+/***********************************************************
+ *  CountTransformUpdates()
+ *
+ *  This method is used for counting the scene graph nodes
+ *  whose world matrix was recalculated.
+ ***********************************************************/
+void RenderStats::CountTransformUpdates(uint32_t numNodes)
+{
+	m_currentFrame.transformUpdates += numNodes;
+}
+
+/***********************************************************
+ *  PrintStats()
+ *
+ *  This method is used for printing the per frame averages
+ *  of the passed in counter totals to stdout.
+ ***********************************************************/
+void RenderStats::PrintStats(const FRAME_STATS& stats, uint64_t numFrames, double elapsedSeconds)
+{
+	if (numFrames == 0)
+	{
+		return;
+	}
+
+	double frames = (double)numFrames;
+
+	std::cout << "STATS: " << numFrames << " frames in " << elapsedSeconds << "s ("
+		<< (frames / elapsedSeconds) << " fps), per frame averages:" << std::endl;
+	std::cout << "STATS:   draw calls:" << (stats.drawCalls / frames)
+		<< ", multi-draws:" << (stats.multiDrawCalls / frames)
+		<< ", static batches:" << (stats.staticBatchDraws / frames)
+		<< ", triangles:" << (stats.triangles / frames)
+		<< ", lines:" << (stats.lines / frames) << std::endl;
+
+	std::cout << "STATS:   draws by mesh (filled/lines):";
+	for (int i = 0; i < MESH_TYPE_COUNT; i++)
+	{
+		if ((stats.meshDrawCalls[i] > 0) || (stats.lineDrawCalls[i] > 0))
+		{
+			std::cout << " " << g_MeshTypeNames[i] << ":"
+				<< (stats.meshDrawCalls[i] / frames) << "/"
+				<< (stats.lineDrawCalls[i] / frames);
+		}
+	}
+	std::cout << std::endl;
+
+	std::cout << "STATS:   objects visible:" << (stats.visibleObjects / frames)
+		<< ", culled:" << (stats.culledObjects / frames)
+		<< ", occluded:" << (stats.occludedObjects / frames)
+		<< ", meshlets visible:" << (stats.visibleMeshlets / frames)
+		<< ", culled:" << (stats.culledMeshlets / frames)
+		<< ", transforms updated:" << (stats.transformUpdates / frames) << std::endl;
+
+	std::cout << "STATS:   uniform writes:" << (stats.uniformWrites / frames)
+		<< ", program binds:" << (stats.programBinds / frames)
+		<< ", texture binds:" << (stats.textureBinds / frames)
+		<< ", buffer binds:" << (stats.bufferBinds / frames)
+		<< ", bytes uploaded:" << (stats.bytesUploaded / frames) << std::endl;
+	std::cout << "STATS:   fence waits:" << (stats.fenceWaits / frames)
+		<< ", ms stalled:" << (stats.fenceWaitMs / frames)
+		<< ", frames in flight:" << (stats.framesInFlight / frames) << std::endl;
+	if ((stats.staticLayerDraws > 0) || (stats.staticLayerReuses > 0))
+	{
+		std::cout << "STATS:   static layer drawn:" << stats.staticLayerDraws
+			<< ", reused:" << stats.staticLayerReuses << std::endl;
+	}
+	if (stats.skippedFrames > 0)
+	{
+		std::cout << "STATS:   frames skipped:" << stats.skippedFrames
+			<< " (" << (stats.skippedFrames / frames) << " per frame drawn)" << std::endl;
+	}
+	if (stats.latencyFrames > 0)
+	{
+		std::cout << "STATS:   latency ms, frame start to GPU done:"
+			<< (stats.frameLatencyMs / stats.latencyFrames);
+		if (stats.inputLatencyFrames > 0)
+		{
+			std::cout << ", input to GPU done:" << (stats.inputLatencyMs / stats.inputLatencyFrames)
+				<< " (max " << stats.maxInputLatencyMs << ")";
+		}
+		std::cout << ", pacing wait:" << (stats.pacingWaitMs / frames) << std::endl;
+	}
+	if (stats.renderScale > 0.0f)
+	{
+		std::cout << "STATS:   render scale:" << (stats.renderScale / frames)
+			<< ", GPU ms:" << (stats.gpuMilliseconds / frames) << std::endl;
+	}
+	if (stats.unaliasedTransientBytes > 0)
+	{
+		std::cout << "STATS:   transient texture MB:" << (stats.transientBytes / frames / (1024.0 * 1024.0))
+			<< ", without sharing:" << (stats.unaliasedTransientBytes / frames / (1024.0 * 1024.0)) << std::endl;
+	}
+}
+
+/***********************************************************
+ *  PrintPassTimes()
+ *
+ *  This method is used for printing the average GPU time of
+ *  every render graph pass measured since the last report,
+ *  and starting the next report over.
+ ***********************************************************/
+void RenderStats::PrintPassTimes()
+{
+	if (m_passTimes.empty() == true)
+	{
+		return;
+	}
+
+	std::cout << "STATS:   pass GPU ms:";
+	for (size_t i = 0; i < m_passTimes.size(); i++)
+	{
+		std::cout << " " << m_passTimes[i].name << ":"
+			<< (m_passTimes[i].totalMilliseconds / m_passTimes[i].samples);
+	}
+	std::cout << std::endl;
+	m_passTimes.clear();
+}
+
+/***********************************************************
+ *  ClearStats()
+ *
+ *  This method is used for zeroing all the passed in counters.
+ ***********************************************************/
+void RenderStats::ClearStats(FRAME_STATS& stats)
+{
+	memset(&stats, 0, sizeof(FRAME_STATS));
+}
+
+/***********************************************************
+ *  AccumulateStats()
+ *
+ *  This method is used for adding the counters of one frame
+ *  into the passed in running totals.
+ ***********************************************************/
+void RenderStats::AccumulateStats(FRAME_STATS& total, const FRAME_STATS& frame)
+{
+	for (int i = 0; i < MESH_TYPE_COUNT; i++)
+	{
+		total.meshDrawCalls[i] += frame.meshDrawCalls[i];
+		total.lineDrawCalls[i] += frame.lineDrawCalls[i];
+	}
+	total.drawCalls += frame.drawCalls;
+	total.multiDrawCalls += frame.multiDrawCalls;
+	total.staticBatchDraws += frame.staticBatchDraws;
+	total.staticLayerDraws += frame.staticLayerDraws;
+	total.staticLayerReuses += frame.staticLayerReuses;
+	total.transformUpdates += frame.transformUpdates;
+	total.visibleObjects += frame.visibleObjects;
+	total.culledObjects += frame.culledObjects;
+	total.occludedObjects += frame.occludedObjects;
+	total.visibleMeshlets += frame.visibleMeshlets;
+	total.culledMeshlets += frame.culledMeshlets;
+	total.triangles += frame.triangles;
+	total.lines += frame.lines;
+	total.uniformWrites += frame.uniformWrites;
+	total.programBinds += frame.programBinds;
+	total.textureBinds += frame.textureBinds;
+	total.bufferBinds += frame.bufferBinds;
+	total.fenceWaits += frame.fenceWaits;
+	total.fenceWaitMs += frame.fenceWaitMs;
+	total.framesInFlight += frame.framesInFlight;
+	total.bytesUploaded += frame.bytesUploaded;
+	total.renderScale += frame.renderScale;
+	total.gpuMilliseconds += frame.gpuMilliseconds;
+	total.skippedFrames += frame.skippedFrames;
+	total.latencyFrames += frame.latencyFrames;
+	total.frameLatencyMs += frame.frameLatencyMs;
+	total.inputLatencyFrames += frame.inputLatencyFrames;
+	total.inputLatencyMs += frame.inputLatencyMs;
+	total.maxInputLatencyMs = std::max(total.maxInputLatencyMs, frame.maxInputLatencyMs);
+	total.pacingWaitMs += frame.pacingWaitMs;
+	total.transientBytes += frame.transientBytes;
+	total.unaliasedTransientBytes += frame.unaliasedTransientBytes;
+}
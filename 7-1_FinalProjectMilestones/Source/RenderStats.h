@@ -0,0 +1,199 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderstats.h
+// ============
+// per-frame render statistics - draw calls, primitives, state changes, uploads
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  MESH_TYPE
+ *
+ *  Identifies each basic shape mesh so the draw counts can
+ *  be broken down per mesh type.  Every imported model mesh
+ *  is counted as MESH_MODEL.
+ ***********************************************************/
+enum MESH_TYPE
+{
+	MESH_PLANE = 0,
+	MESH_BOX,
+	MESH_CYLINDER,
+	MESH_SPHERE,
+	MESH_HALF_SPHERE,
+	MESH_MODEL,
+	MESH_TYPE_COUNT
+};
+
+/***********************************************************
+ *  FRAME_STATS
+ *
+ *  The counters collected over the course of one frame.
+ ***********************************************************/
+struct FRAME_STATS
+{
+	// filled draw calls per mesh type
+	uint32_t meshDrawCalls[MESH_TYPE_COUNT];
+	// wireframe (lines) draw calls per mesh type
+	uint32_t lineDrawCalls[MESH_TYPE_COUNT];
+	// total draw calls of any kind
+	uint32_t drawCalls;
+	// draw calls that drew a list of indirect commands
+	uint32_t multiDrawCalls;
+	// draw calls of the merged static objects
+	uint32_t staticBatchDraws;
+	// frames that drew the static layer image, and that reused it
+	uint32_t staticLayerDraws;
+	uint32_t staticLayerReuses;
+	// primitives submitted to the GPU
+	uint64_t triangles;
+	uint64_t lines;
+	// scene graph nodes whose world matrix was recalculated
+	uint32_t transformUpdates;
+	// scene objects that passed and failed the visibility test
+	uint32_t visibleObjects;
+	uint32_t culledObjects;
+	// culled objects that were hidden behind the occluders
+	uint32_t occludedObjects;
+	// meshlets of the large models that were drawn and culled
+	uint32_t visibleMeshlets;
+	uint32_t culledMeshlets;
+	// shader state changes
+	uint32_t uniformWrites;
+	uint32_t programBinds;
+	uint32_t textureBinds;
+	uint32_t bufferBinds;
+	// times the CPU had to wait on the GPU, for a free buffer
+	// or for the frames in flight, and the milliseconds waited
+	uint32_t fenceWaits;
+	float fenceWaitMs;
+	// frames queued on the GPU ahead of the frame, when it began
+	uint32_t framesInFlight;
+	// bytes sent to the driver (uniforms, textures, buffers)
+	uint64_t bytesUploaded;
+	// share of the window size the scene was drawn at, and the
+	// smoothed GPU frame time it was chosen from, zero when the
+	// resolution is fixed
+	float renderScale;
+	float gpuMilliseconds;
+	// refresh intervals skipped since the frame before, as
+	// nothing changed
+	uint32_t skippedFrames;
+	// frames the GPU was seen to finish, with the milliseconds
+	// from their start to the GPU finishing them
+	uint32_t latencyFrames;
+	float frameLatencyMs;
+	// the same from the oldest input event they showed, for the
+	// frames that had input, and the longest of them
+	uint32_t inputLatencyFrames;
+	float inputLatencyMs;
+	float maxInputLatencyMs;
+	// milliseconds waited for the frame limit
+	float pacingWaitMs;
+	// bytes of the transient textures of the render graph, and
+	// the bytes they would take without sharing textures
+	uint64_t transientBytes;
+	uint64_t unaliasedTransientBytes;
+};
+
+/***********************************************************
+ *  RenderStats
+ *
+ *  This class collects the render counters for the frame
+ *  in progress, keeps the totals of the last completed
+ *  frame for queries, and periodically prints the averages
+ *  to stdout.
+ ***********************************************************/
+class RenderStats
+{
+public:
+	// constructor
+	RenderStats();
+
+	// reset the counters for the frame about to be rendered
+	void BeginFrame();
+	// close the current frame and print the report when due
+	void EndFrame(double currentTime);
+
+	// counters for the frame in progress
+	void CountDraw(MESH_TYPE meshType, bool bLines, uint64_t primitives);
+	void CountMultiDraw();
+	void CountStaticBatchDraw(bool bLines, uint64_t primitives);
+	void CountStaticLayer(bool bReused);
+	void CountUniformWrite(uint32_t numBytes);
+	void CountProgramBind();
+	void CountTextureBind();
+	void CountBufferBind();
+	void CountFenceWait(float milliseconds);
+	void CountFramesInFlight(uint32_t numFrames);
+	void CountUpload(uint64_t numBytes);
+	void CountCulling(uint32_t numVisible, uint32_t numCulled);
+	void CountOcclusion(uint32_t numOccluded);
+	void CountMeshlets(uint32_t numVisible, uint32_t numCulled);
+	void CountRenderScale(float renderScale, float gpuMilliseconds);
+	// count the refresh intervals that passed without drawing,
+	// between frames
+	void CountSkippedFrames(uint32_t numFrames);
+	// count the latency of a frame the GPU finished, the input
+	// latency is negative when the frame had no input
+	void CountFrameLatency(float frameMilliseconds, float inputMilliseconds);
+	void CountPacingWait(float milliseconds);
+	void CountTransientMemory(uint64_t numBytes, uint64_t numUnaliasedBytes);
+	// count the GPU time of a render graph pass, which comes in
+	// a few frames late so it is kept apart from the frames
+	void CountPassTime(const std::string& passName, float milliseconds);
+	void CountTransformUpdates(uint32_t numNodes);
+
+	// counters of the last completed frame
+	const FRAME_STATS& GetLastFrame() const { return(m_lastFrame); }
+	// number of frames completed since startup
+	uint64_t GetFrameCount() const { return(m_frameCount); }
+	// number of frames skipped since startup
+	uint64_t GetSkippedFrameCount() const { return(m_skippedFrameCount); }
+	// bytes uploaded since startup, including load time
+	uint64_t GetTotalBytesUploaded() const { return(m_totalBytesUploaded); }
+
+	// seconds between printed reports, zero disables printing
+	void SetReportInterval(double seconds) { m_reportInterval = seconds; }
+
+	// print the passed in counters to stdout
+	static void PrintStats(const FRAME_STATS& stats, uint64_t numFrames, double elapsedSeconds);
+
+private:
+	// GPU time of a render graph pass since the last report
+	struct PASS_TIME
+	{
+		std::string name;
+		float totalMilliseconds;
+		uint32_t samples;
+	};
+
+	// counters for the frame in progress
+	FRAME_STATS m_currentFrame;
+	// counters of the last completed frame
+	FRAME_STATS m_lastFrame;
+	// counters summed since the last printed report
+	FRAME_STATS m_reportTotals;
+	uint64_t m_reportFrames;
+	double m_lastReportTime;
+	double m_reportInterval;
+
+	uint64_t m_frameCount;
+	uint64_t m_totalBytesUploaded;
+	// frames skipped since the last completed frame
+	uint32_t m_pendingSkippedFrames;
+	uint64_t m_skippedFrameCount;
+	// pass times since the last printed report, in the order
+	// the passes were first seen
+	std::vector<PASS_TIME> m_passTimes;
+
+	// print the pass times and start them over
+	void PrintPassTimes();
+
+	static void ClearStats(FRAME_STATS& stats);
+	static void AccumulateStats(FRAME_STATS& total, const FRAME_STATS& frame);
+};
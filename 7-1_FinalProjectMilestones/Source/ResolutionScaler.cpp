@@ -0,0 +1,356 @@
+///////////////////////////////////////////////////////////////////////////////
+// resolutionscaler.cpp
+// ============
+// render the scene offscreen at a scale that holds a target GPU frame time
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ResolutionScaler.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// GLSL files of the upscale shader program
+	const char* UPSCALE_VERTEX_SHADER_FILE = "shaders/upscaleVertexShader.glsl";
+	const char* UPSCALE_FRAGMENT_SHADER_FILE = "shaders/upscaleFragmentShader.glsl";
+	const char* g_SceneTextureName = "sceneTexture";
+	const char* g_RenderScaleName = "renderScale";
+	const char* g_TexelSizeName = "texelSize";
+	const char* g_SharpnessName = "sharpness";
+
+	// the scene textures use the first 16 texture units, so the
+	// offscreen target is read from the one after them
+	const int SCENE_TEXTURE_UNIT = 16;
+
+	// smallest and largest scale of the window size
+	const float MIN_RENDER_SCALE = 0.5f;
+	const float MAX_RENDER_SCALE = 1.0f;
+	// most the scale moves in one frame
+	const float MAX_SCALE_STEP = 0.05f;
+	// the scale aims for this share of the target, and is left
+	// alone while the time is between the lower share and it
+	const float TARGET_SHARE = 0.95f;
+	const float LOWER_SHARE = 0.8f;
+	// weight of the newest GPU time in the smoothed time
+	const float FRAME_TIME_SMOOTHING = 0.2f;
+}
+
+const int ResolutionScaler::NUM_FRAME_TIMERS;
+
+/***********************************************************
+ *  ResolutionScaler()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ResolutionScaler::ResolutionScaler()
+{
+	m_pUpscaleShader = NULL;
+	m_pRenderStats = NULL;
+	m_vertexArrayID = 0;
+	m_windowWidth = 0;
+	m_windowHeight = 0;
+	for (int i = 0; i < NUM_FRAME_TIMERS; i++)
+	{
+		m_frameTimers[i].queryID = 0;
+		m_frameTimers[i].bPending = false;
+	}
+	m_frameTimerIndex = 0;
+	m_bTimingFrame = false;
+	m_targetMilliseconds = 1000.0f / 60.0f;
+	m_gpuMilliseconds = 0.0f;
+	m_renderScale = MAX_RENDER_SCALE;
+	m_sharpness = 0.0f;
+	m_renderWidth = 0;
+	m_renderHeight = 0;
+}
+
+/***********************************************************
+ *  ~ResolutionScaler()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ResolutionScaler::~ResolutionScaler()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the timer queries and
+ *  the upscale shader program.  The offscreen target is a
+ *  texture of the render graph.  Returns false, with
+ *  everything freed again, if the shaders don't load.
+ ***********************************************************/
+bool ResolutionScaler::Create(const ShaderManager* pSceneShaders, int windowWidth, int windowHeight)
+{
+	Destroy();
+
+	if ((windowWidth <= 0) || (windowHeight <= 0))
+	{
+		return(false);
+	}
+	m_windowWidth = windowWidth;
+	m_windowHeight = windowHeight;
+	m_renderWidth = windowWidth;
+	m_renderHeight = windowHeight;
+
+	m_pRenderStats = pSceneShaders->GetRenderStats();
+	m_pUpscaleShader = new ShaderManager();
+	m_pUpscaleShader->SetRenderStats(pSceneShaders->GetRenderStats());
+	m_pUpscaleShader->SetAssetArchive(pSceneShaders->GetAssetArchive());
+	m_pUpscaleShader->SetProgramCacheDirectory(pSceneShaders->GetProgramCacheDirectory());
+	if (0 == m_pUpscaleShader->LoadShaders(UPSCALE_VERTEX_SHADER_FILE, UPSCALE_FRAGMENT_SHADER_FILE))
+	{
+		std::cout << "Dynamic resolution is off, the upscale shaders did not load" << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	glGenVertexArrays(1, &m_vertexArrayID);
+	for (int i = 0; i < NUM_FRAME_TIMERS; i++)
+	{
+		glGenQueries(1, &m_frameTimers[i].queryID);
+	}
+
+	std::cout << "Dynamic resolution on, target GPU time:" << m_targetMilliseconds
+		<< "ms, window:" << windowWidth << "x" << windowHeight
+		<< ", smallest scale:" << MIN_RENDER_SCALE << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the OpenGL objects.
+ ***********************************************************/
+void ResolutionScaler::Destroy()
+{
+	for (int i = 0; i < NUM_FRAME_TIMERS; i++)
+	{
+		if (0 != m_frameTimers[i].queryID)
+		{
+			glDeleteQueries(1, &m_frameTimers[i].queryID);
+			m_frameTimers[i].queryID = 0;
+		}
+		m_frameTimers[i].bPending = false;
+	}
+	if (0 != m_vertexArrayID)
+	{
+		glDeleteVertexArrays(1, &m_vertexArrayID);
+		m_vertexArrayID = 0;
+	}
+	if (NULL != m_pUpscaleShader)
+	{
+		delete m_pUpscaleShader;
+		m_pUpscaleShader = NULL;
+	}
+
+	m_frameTimerIndex = 0;
+	m_bTimingFrame = false;
+	m_gpuMilliseconds = 0.0f;
+	m_renderScale = MAX_RENDER_SCALE;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for choosing the scale of the frame
+ *  from the GPU times that are in, and starting the timer
+ *  query of the frame.
+ ***********************************************************/
+void ResolutionScaler::BeginFrame()
+{
+	if (NULL == m_pUpscaleShader)
+	{
+		return;
+	}
+
+	ReadFrameTimers();
+
+	m_renderWidth = std::max(1, (int)(m_windowWidth * m_renderScale + 0.5f));
+	m_renderHeight = std::max(1, (int)(m_windowHeight * m_renderScale + 0.5f));
+	if (NULL != m_pRenderStats)
+	{
+		m_pRenderStats->CountRenderScale(m_renderScale, m_gpuMilliseconds);
+	}
+
+	// with every timer still in flight this frame goes unmeasured
+	FRAME_TIMER& frameTimer = m_frameTimers[m_frameTimerIndex];
+	m_bTimingFrame = (frameTimer.bPending == false);
+	if (m_bTimingFrame == true)
+	{
+		glBeginQuery(GL_TIME_ELAPSED, frameTimer.queryID);
+	}
+}
+
+/***********************************************************
+ *  SetSceneViewport()
+ *
+ *  This method is used for setting the viewport to the
+ *  corner of the offscreen target the scene is drawn into
+ *  at the scale of the frame.
+ ***********************************************************/
+void ResolutionScaler::SetSceneViewport()
+{
+	glViewport(0, 0, m_renderWidth, m_renderHeight);
+}
+
+/***********************************************************
+ *  Upscale()
+ *
+ *  This method is used for drawing the corner of the passed
+ *  in offscreen target the scene was drawn into over the
+ *  whole viewport of the bound framebuffer.  The caller
+ *  makes the scene shader program active again.
+ ***********************************************************/
+void ResolutionScaler::Upscale(GLuint sceneTextureID)
+{
+	if (NULL == m_pUpscaleShader)
+	{
+		return;
+	}
+
+	glDisable(GL_DEPTH_TEST);
+
+	// the texture is bound every frame, as a texture loaded
+	// since may have been bound to the unit
+	glActiveTexture(GL_TEXTURE0 + SCENE_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, sceneTextureID);
+	glActiveTexture(GL_TEXTURE0);
+
+	glm::vec2 renderScale(
+		(float)m_renderWidth / (float)m_windowWidth,
+		(float)m_renderHeight / (float)m_windowHeight);
+	glm::vec2 texelSize(1.0f / (float)m_windowWidth, 1.0f / (float)m_windowHeight);
+
+	m_pUpscaleShader->use();
+	m_pUpscaleShader->setSampler2DValue(g_SceneTextureName, SCENE_TEXTURE_UNIT);
+	m_pUpscaleShader->setVec2Value(g_RenderScaleName, renderScale);
+	m_pUpscaleShader->setVec2Value(g_TexelSizeName, texelSize);
+	// at full scale the texels are copied one to one
+	m_pUpscaleShader->setFloatValue(g_SharpnessName, (m_renderScale < MAX_RENDER_SCALE) ? m_sharpness : 0.0f);
+
+	glBindVertexArray(m_vertexArrayID);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	if (NULL != m_pRenderStats)
+	{
+		m_pRenderStats->CountTextureBind();
+	}
+
+	glEnable(GL_DEPTH_TEST);
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for ending the timer query of the
+ *  frame, after the last pass that draws it.
+ ***********************************************************/
+void ResolutionScaler::EndFrame()
+{
+	if (m_bTimingFrame == true)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+		m_frameTimers[m_frameTimerIndex].bPending = true;
+		m_frameTimerIndex = (m_frameTimerIndex + 1) % NUM_FRAME_TIMERS;
+		m_bTimingFrame = false;
+	}
+}
+
+/***********************************************************
+ *  ReadFrameTimers()
+ *
+ *  This method is used for reading the GPU time of every
+ *  measured frame that is done.  The queries finish in the
+ *  order they were made, so the reading starts at the
+ *  oldest and stops at the first one still running.  Their
+ *  results are only polled, never waited on.
+ ***********************************************************/
+void ResolutionScaler::ReadFrameTimers()
+{
+	for (int i = 0; i < NUM_FRAME_TIMERS; i++)
+	{
+		FRAME_TIMER& frameTimer = m_frameTimers[(m_frameTimerIndex + i) % NUM_FRAME_TIMERS];
+		if (frameTimer.bPending == false)
+		{
+			continue;
+		}
+
+		GLint bAvailable = 0;
+		glGetQueryObjectiv(frameTimer.queryID, GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+		if (bAvailable == 0)
+		{
+			break;
+		}
+
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(frameTimer.queryID, GL_QUERY_RESULT, &nanoseconds);
+		frameTimer.bPending = false;
+		UpdateRenderScale((float)(nanoseconds / 1000000.0));
+	}
+}
+
+/***********************************************************
+ *  UpdateRenderScale()
+ *
+ *  This method is used for moving the scale toward the one
+ *  that brings the smoothed GPU time to the target.  The
+ *  time of a frame is a few frames old when it is read, so
+ *  the scale only moves a little each frame, which keeps
+ *  it from swinging past the scale it is after.
+ ***********************************************************/
+void ResolutionScaler::UpdateRenderScale(float gpuMilliseconds)
+{
+	if (m_gpuMilliseconds <= 0.0f)
+		m_gpuMilliseconds = gpuMilliseconds;
+	else
+		m_gpuMilliseconds += (gpuMilliseconds - m_gpuMilliseconds) * FRAME_TIME_SMOOTHING;
+
+	if ((m_gpuMilliseconds <= 0.0f) || (m_targetMilliseconds <= 0.0f))
+	{
+		return;
+	}
+
+	float share = m_gpuMilliseconds / m_targetMilliseconds;
+	if ((share >= LOWER_SHARE) && (share <= TARGET_SHARE))
+	{
+		return;
+	}
+
+	float scale = m_renderScale * sqrtf(TARGET_SHARE / share);
+	scale = glm::clamp(scale, m_renderScale - MAX_SCALE_STEP, m_renderScale + MAX_SCALE_STEP);
+	m_renderScale = glm::clamp(scale, MIN_RENDER_SCALE, MAX_RENDER_SCALE);
+}
+
+/***********************************************************
+ *  BeginLoadShaders()
+ *
+ *  This method is used for starting to build the upscale
+ *  shader program, so it compiles while the other programs
+ *  of startup do.  Create() finishes it.
+ ***********************************************************/
+void ResolutionScaler::BeginLoadShaders(ShaderManager* pSceneShaders)
+{
+	pSceneShaders->BeginLoadShaders(UPSCALE_VERTEX_SHADER_FILE, UPSCALE_FRAGMENT_SHADER_FILE);
+}
+
+/***********************************************************
+ *  GetShaderFiles()
+ *
+ *  This method is used for getting the GLSL files of the
+ *  upscale shader program, for packing them in the asset
+ *  archive.
+ ***********************************************************/
+void ResolutionScaler::GetShaderFiles(std::vector<std::string>& files)
+{
+	files.push_back(UPSCALE_VERTEX_SHADER_FILE);
+	files.push_back(UPSCALE_FRAGMENT_SHADER_FILE);
+}
@@ -0,0 +1,126 @@
+///////////////////////////////////////////////////////////////////////////////
+// resolutionscaler.h
+// ============
+// render the scene offscreen at a scale that holds a target GPU frame time
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+
+#include <GL/glew.h>        // GLEW library
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  ResolutionScaler
+ *
+ *  This class contains the code for drawing the scene into
+ *  an offscreen target at a lower resolution than the window
+ *  when the GPU can't keep up, and scaling it up to the
+ *  window at the end of the frame.
+ *
+ *  The target is a texture of the render graph the size of
+ *  the window, and the scene is drawn into its lower left
+ *  corner, so changing the scale only changes the viewport
+ *  and the graph stays the same from frame to frame.  The
+ *  aspect of the corner is that of the window, so the
+ *  projection is the same at every scale.
+ *
+ *  The GPU time of every frame is measured with a timer
+ *  query, read a few frames later once it is done, so the
+ *  CPU never waits for it.  The pixels drawn, and roughly the
+ *  GPU time, go with the square of the scale, so the scale
+ *  is moved by the square root of how far the smoothed time
+ *  is from the target.  Inside a band below the target it is
+ *  left alone, so it doesn't flicker from frame to frame.
+ *
+ *  The upscale is bilinear, with an optional sharpening of
+ *  the result limited to the range of the neighbouring
+ *  texels.
+ ***********************************************************/
+class ResolutionScaler
+{
+public:
+	// constructor
+	ResolutionScaler();
+	// destructor
+	~ResolutionScaler();
+
+	// create the timer queries for a window of the passed in
+	// size and the upscale shader program, loaded the same way
+	// as the scene shaders
+	bool Create(const ShaderManager* pSceneShaders, int windowWidth, int windowHeight);
+	// free the OpenGL objects
+	void Destroy();
+
+	// set the GPU frame time the scale is chosen for
+	void SetTargetFrameTime(float milliseconds) { m_targetMilliseconds = milliseconds; }
+	// set how much the upscaled image is sharpened, from 0 to 1
+	void SetSharpness(float sharpness) { m_sharpness = sharpness; }
+
+	// pick the scale from the finished timer queries and start
+	// the timer query of the frame
+	void BeginFrame();
+	// set the viewport to the corner of the offscreen target
+	// the scene is drawn into at this frame's scale
+	void SetSceneViewport();
+	// scale the corner of the passed in offscreen target up to
+	// the bound framebuffer, the caller makes the scene shader
+	// program active again
+	void Upscale(GLuint sceneTextureID);
+	// end the timer query of the frame
+	void EndFrame();
+
+	// size of the window, which the offscreen target is made at
+	int GetWindowWidth() const { return(m_windowWidth); }
+	int GetWindowHeight() const { return(m_windowHeight); }
+
+	// scale of the frame in progress and the smoothed GPU time
+	float GetRenderScale() const { return(m_renderScale); }
+	float GetGpuFrameTime() const { return(m_gpuMilliseconds); }
+
+	// get the GLSL files of the upscale shader program
+	static void GetShaderFiles(std::vector<std::string>& files);
+	// start building the upscale shader program ahead of
+	// Create(), with the other programs of startup
+	static void BeginLoadShaders(ShaderManager* pSceneShaders);
+
+private:
+	// a frame's GPU time on its way to the CPU
+	struct FRAME_TIMER
+	{
+		GLuint queryID;
+		bool bPending;
+	};
+
+	static const int NUM_FRAME_TIMERS = 4;
+
+	// upscale shader program
+	ShaderManager* m_pUpscaleShader;
+	RenderStats* m_pRenderStats;
+	// empty vertex array, the upscale triangle has no vertices
+	GLuint m_vertexArrayID;
+	int m_windowWidth;
+	int m_windowHeight;
+
+	FRAME_TIMER m_frameTimers[NUM_FRAME_TIMERS];
+	// timer the next frame is measured with
+	int m_frameTimerIndex;
+	bool m_bTimingFrame;
+
+	float m_targetMilliseconds;
+	float m_gpuMilliseconds;
+	float m_renderScale;
+	float m_sharpness;
+	// size of the corner the frame in progress is drawn into
+	int m_renderWidth;
+	int m_renderHeight;
+
+	// read the timer queries that are done, oldest first
+	void ReadFrameTimers();
+	// move the scale toward the target for a new GPU time
+	void UpdateRenderScale(float gpuMilliseconds);
+};
@@ -0,0 +1,298 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.cpp
+// ============
+// read the groups and objects of a 3D scene from a text scene file
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneFile.h"
+#include "ModelImporter.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// words in a group and an object record
+	const size_t GROUP_WORDS = 5;
+	const size_t OBJECT_WORDS = 19;
+}
+
+/***********************************************************
+ *  LoadFile()
+ *
+ *  This method is used for reading the records of a scene
+ *  file.
+ ***********************************************************/
+bool SceneFile::LoadFile(const char* filename, std::vector<SCENE_RECORD>& records)
+{
+	records.clear();
+
+	std::ifstream file(filename);
+	if (!file)
+	{
+		std::cout << "ERROR: could not open scene file " << filename << std::endl;
+		return(false);
+	}
+
+	return(ParseRecords(filename, file, records));
+}
+
+/***********************************************************
+ *  LoadText()
+ *
+ *  This method is used for reading the records of a scene
+ *  file whose text is already in memory.
+ ***********************************************************/
+bool SceneFile::LoadText(const char* filename, const char* pText, size_t size, std::vector<SCENE_RECORD>& records)
+{
+	records.clear();
+
+	std::istringstream text(std::string(pText, size));
+	return(ParseRecords(filename, text, records));
+}
+
+/***********************************************************
+ *  ParseRecords()
+ *
+ *  This method is used for reading the records from the
+ *  lines of a scene file.  Objects with the same name in the
+ *  same group are told apart by the order they appear in.
+ ***********************************************************/
+bool SceneFile::ParseRecords(const char* filename, std::istream& file, std::vector<SCENE_RECORD>& records)
+{
+	// keys of the groups open at the current line
+	std::vector<std::string> groupStack;
+	// records seen so far per key, for numbering repeated names
+	std::map<std::string, int> keyCounts;
+
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+
+		std::vector<std::string> words;
+		if (SplitLine(line, words) == false)
+		{
+			std::cout << "ERROR: " << filename << "(" << lineNumber << "): unmatched quote" << std::endl;
+			records.clear();
+			return(false);
+		}
+		if (words.empty())
+		{
+			continue;
+		}
+
+		SCENE_RECORD record;
+		record.groupKey = groupStack.empty() ? "" : groupStack.back();
+		record.meshType = MESH_BOX;
+		record.scaleXYZ = glm::vec3(1.0f);
+		record.XrotationDegrees = 0.0f;
+		record.YrotationDegrees = 0.0f;
+		record.ZrotationDegrees = 0.0f;
+		record.color = glm::vec4(1.0f);
+		record.bDrawLines = false;
+
+		bool bValid = false;
+		if ((words[0] == "end") && (words.size() == 1) && (groupStack.empty() == false))
+		{
+			groupStack.pop_back();
+			continue;
+		}
+		else if ((words[0] == "group") && (words.size() == GROUP_WORDS))
+		{
+			float position[3] = { 0.0f, 0.0f, 0.0f };
+			record.type = RECORD_GROUP;
+			record.name = words[1];
+			bValid = ParseFloats(words, 2, 3, position);
+			record.positionXYZ = glm::vec3(position[0], position[1], position[2]);
+		}
+		else if ((words[0] == "object") && (words.size() == OBJECT_WORDS))
+		{
+			float values[13] = { 0.0f };
+			record.type = RECORD_OBJECT;
+			record.name = words[1];
+			bValid = (ParseMeshType(words[2], record.meshType) == true) &&
+				(ParseFloats(words, 3, 13, values) == true) &&
+				((words[18] == "lines") || (words[18] == "fill"));
+			if (record.meshType == MESH_MODEL)
+			{
+				record.modelFile = words[2];
+			}
+			record.scaleXYZ = glm::vec3(values[0], values[1], values[2]);
+			record.XrotationDegrees = values[3];
+			record.YrotationDegrees = values[4];
+			record.ZrotationDegrees = values[5];
+			record.positionXYZ = glm::vec3(values[6], values[7], values[8]);
+			record.color = glm::vec4(values[9], values[10], values[11], values[12]);
+			record.textureTag = (words[16] == "-") ? "" : words[16];
+			record.materialTag = words[17];
+			record.bDrawLines = (words[18] == "lines");
+		}
+
+		if (bValid == false)
+		{
+			std::cout << "ERROR: " << filename << "(" << lineNumber << "): invalid record" << std::endl;
+			records.clear();
+			return(false);
+		}
+
+		// the key is the group path plus the name, numbered
+		// when the same name was already used in the group
+		std::string key = record.groupKey + "/" + record.name;
+		int count = keyCounts[key]++;
+		if (count > 0)
+		{
+			key += "#" + std::to_string(count);
+		}
+		record.key = key;
+
+		if (record.type == RECORD_GROUP)
+		{
+			groupStack.push_back(key);
+		}
+		records.push_back(record);
+	}
+
+	if (groupStack.empty() == false)
+	{
+		std::cout << "ERROR: " << filename << ": group " << groupStack.back() << " has no end" << std::endl;
+		records.clear();
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  IsSameTransform()
+ *
+ *  This method is used for checking whether two records have
+ *  the same transformation values.
+ ***********************************************************/
+bool SceneFile::IsSameTransform(const SCENE_RECORD& a, const SCENE_RECORD& b)
+{
+	return((a.scaleXYZ == b.scaleXYZ) &&
+		(a.XrotationDegrees == b.XrotationDegrees) &&
+		(a.YrotationDegrees == b.YrotationDegrees) &&
+		(a.ZrotationDegrees == b.ZrotationDegrees) &&
+		(a.positionXYZ == b.positionXYZ));
+}
+
+/***********************************************************
+ *  IsSameAppearance()
+ *
+ *  This method is used for checking whether two records are
+ *  drawn with the same mesh, color, texture and material.
+ ***********************************************************/
+bool SceneFile::IsSameAppearance(const SCENE_RECORD& a, const SCENE_RECORD& b)
+{
+	return((a.meshType == b.meshType) &&
+		(a.modelFile == b.modelFile) &&
+		(a.color == b.color) &&
+		(a.textureTag == b.textureTag) &&
+		(a.materialTag == b.materialTag) &&
+		(a.bDrawLines == b.bDrawLines));
+}
+
+/***********************************************************
+ *  SplitLine()
+ *
+ *  This method is used for splitting a line into words at
+ *  spaces and tabs.  Text in double quotes is one word and
+ *  anything after a # outside quotes is ignored.
+ ***********************************************************/
+bool SceneFile::SplitLine(const std::string& line, std::vector<std::string>& words)
+{
+	words.clear();
+
+	size_t i = 0;
+	while (i < line.size())
+	{
+		char c = line[i];
+		if ((c == ' ') || (c == '\t') || (c == '\r'))
+		{
+			i++;
+		}
+		else if (c == '#')
+		{
+			break;
+		}
+		else if (c == '"')
+		{
+			size_t closingQuote = line.find('"', i + 1);
+			if (closingQuote == std::string::npos)
+			{
+				return(false);
+			}
+			words.push_back(line.substr(i + 1, closingQuote - i - 1));
+			i = closingQuote + 1;
+		}
+		else
+		{
+			size_t wordEnd = line.find_first_of(" \t\r#", i);
+			if (wordEnd == std::string::npos)
+			{
+				wordEnd = line.size();
+			}
+			words.push_back(line.substr(i, wordEnd - i));
+			i = wordEnd;
+		}
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  ParseMeshType()
+ *
+ *  This method is used for converting a mesh name into the
+ *  mesh type.  Any word naming a model file is a model.
+ ***********************************************************/
+bool SceneFile::ParseMeshType(const std::string& word, MESH_TYPE& meshType)
+{
+	static const char* const meshNames[MESH_MODEL] =
+	{
+		"plane", "box", "cylinder", "sphere", "half_sphere"
+	};
+
+	for (int i = 0; i < MESH_MODEL; i++)
+	{
+		if (word == meshNames[i])
+		{
+			meshType = (MESH_TYPE)i;
+			return(true);
+		}
+	}
+	if (ModelImporter::IsModelFile(word) == true)
+	{
+		meshType = MESH_MODEL;
+		return(true);
+	}
+	return(false);
+}
+
+/***********************************************************
+ *  ParseFloats()
+ *
+ *  This method is used for converting a run of words into
+ *  numbers.  Returns false if any of them is not a number.
+ ***********************************************************/
+bool SceneFile::ParseFloats(const std::vector<std::string>& words, size_t first, size_t count, float* values)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		const char* text = words[first + i].c_str();
+		char* textEnd = NULL;
+		values[i] = strtof(text, &textEnd);
+		if ((textEnd == text) || (*textEnd != '\0'))
+		{
+			return(false);
+		}
+	}
+	return(true);
+}
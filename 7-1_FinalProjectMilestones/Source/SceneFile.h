@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.h
+// ============
+// read the groups and objects of a 3D scene from a text scene file
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "RenderStats.h"
+
+#include <glm/glm.hpp>
+
+#include <istream>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  SceneFile
+ *
+ *  This class contains the code for reading a scene file
+ *  into a list of records, one per group and object.  Every
+ *  record gets a key built from its group path and name, so
+ *  the records of two versions of the file can be matched to
+ *  find what was changed, added and removed.
+ *
+ *  The file holds one record per line, # starts a comment:
+ *      group "<tag>" posX posY posZ
+ *          object "<name>" <mesh>  scaleX scaleY scaleZ
+ *              rotX rotY rotZ  posX posY posZ  r g b a
+ *              <texture tag or -> <material tag> <lines|fill>
+ *      end
+ *  (an object record is written on one line).  Groups can
+ *  be nested and positions inside a group are relative to
+ *  it.  The mesh is one of plane, box, cylinder, sphere or
+ *  half_sphere, or the path of an .obj, .gltf or .glb model
+ *  file to import.
+ ***********************************************************/
+class SceneFile
+{
+public:
+	enum RECORD_TYPE
+	{
+		RECORD_GROUP = 0,
+		RECORD_OBJECT
+	};
+
+	struct SCENE_RECORD
+	{
+		RECORD_TYPE type;
+		// object name, or group tag
+		std::string name;
+		// key of the group holding the record, empty for none
+		std::string groupKey;
+		// unique key of the record within the file
+		std::string key;
+		MESH_TYPE meshType;
+		// model file path when the mesh type is MESH_MODEL
+		std::string modelFile;
+		glm::vec3 scaleXYZ;
+		float XrotationDegrees;
+		float YrotationDegrees;
+		float ZrotationDegrees;
+		glm::vec3 positionXYZ;
+		glm::vec4 color;
+		// empty when the object is drawn with its color
+		std::string textureTag;
+		std::string materialTag;
+		bool bDrawLines;
+	};
+
+	// read the records of the scene file, returns false and
+	// leaves the records empty if the file has an error
+	static bool LoadFile(const char* filename, std::vector<SCENE_RECORD>& records);
+	// read the records from the text of a scene file in memory,
+	// the file name is only used in the error messages
+	static bool LoadText(const char* filename, const char* pText, size_t size, std::vector<SCENE_RECORD>& records);
+
+	// check whether two object records place and draw the
+	// object the same way
+	static bool IsSameTransform(const SCENE_RECORD& a, const SCENE_RECORD& b);
+	static bool IsSameAppearance(const SCENE_RECORD& a, const SCENE_RECORD& b);
+
+private:
+	// read the records from the lines of a scene file
+	static bool ParseRecords(const char* filename, std::istream& file, std::vector<SCENE_RECORD>& records);
+	// split a line into words, keeping quoted words whole
+	static bool SplitLine(const std::string& line, std::vector<std::string>& words);
+	static bool ParseMeshType(const std::string& word, MESH_TYPE& meshType);
+	static bool ParseFloats(const std::vector<std::string>& words, size_t first, size_t count, float* values);
+};
@@ -0,0 +1,381 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegraph.cpp
+// ============
+// parent / child transform hierarchy with dirty-flag world matrix updates
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneGraph.h"
+
+#include <algorithm>
+
+const int SceneGraph::NO_PARENT;
+const int SceneGraph::REMOVED_NODE;
+
+/***********************************************************
+ *  SceneGraph()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneGraph::SceneGraph()
+{
+	m_updateCount = 0;
+	m_bLayoutDirty = false;
+}
+
+/***********************************************************
+ *  AddNode()
+ *
+ *  This method is used for adding a node below the passed in
+ *  parent node, or as a root node for NO_PARENT.  The ID of a
+ *  removed node is reused when there is one.  The storage
+ *  order is rebuilt on the next update.
+ ***********************************************************/
+int SceneGraph::AddNode(
+	int parentNode,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	// the parent must already exist
+	if (IsNode(parentNode) == false)
+	{
+		parentNode = NO_PARENT;
+	}
+
+	NODE_TRANSFORM transform;
+	transform.scaleXYZ = scaleXYZ;
+	transform.XrotationDegrees = XrotationDegrees;
+	transform.YrotationDegrees = YrotationDegrees;
+	transform.ZrotationDegrees = ZrotationDegrees;
+	transform.positionXYZ = positionXYZ;
+
+	m_bLayoutDirty = true;
+	if (m_freeNodes.empty() == false)
+	{
+		int node = m_freeNodes.back();
+		m_freeNodes.pop_back();
+		m_nodeParents[node] = parentNode;
+		m_nodeTransforms[node] = transform;
+		return(node);
+	}
+
+	m_nodeParents.push_back(parentNode);
+	m_nodeTransforms.push_back(transform);
+	m_nodeSlots.push_back(0);
+
+	return((int)m_nodeParents.size() - 1);
+}
+
+/***********************************************************
+ *  RemoveNode()
+ *
+ *  This method is used for removing a node from the graph.
+ *  Its children are moved up to its parent, and its ID is
+ *  kept for the next node added.  The storage order is
+ *  rebuilt without it on the next update.
+ ***********************************************************/
+void SceneGraph::RemoveNode(int node)
+{
+	if (IsNode(node) == false)
+	{
+		return;
+	}
+
+	int parentNode = m_nodeParents[node];
+	for (size_t i = 0; i < m_nodeParents.size(); i++)
+	{
+		if (m_nodeParents[i] == node)
+		{
+			m_nodeParents[i] = parentNode;
+		}
+	}
+
+	m_nodeParents[node] = REMOVED_NODE;
+	m_freeNodes.push_back(node);
+	m_bLayoutDirty = true;
+}
+
+/***********************************************************
+ *  SetLocalTransform()
+ *
+ *  This method is used for changing the local transformation
+ *  values of a node.  The node and everything below it are
+ *  recalculated on the next update.
+ ***********************************************************/
+void SceneGraph::SetLocalTransform(
+	int node,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	if (IsNode(node) == false)
+	{
+		return;
+	}
+
+	NODE_TRANSFORM& transform = m_nodeTransforms[node];
+	transform.scaleXYZ = scaleXYZ;
+	transform.XrotationDegrees = XrotationDegrees;
+	transform.YrotationDegrees = YrotationDegrees;
+	transform.ZrotationDegrees = ZrotationDegrees;
+	transform.positionXYZ = positionXYZ;
+
+	// a pending rebuild recalculates every node anyway
+	if (m_bLayoutDirty == true)
+	{
+		return;
+	}
+
+	uint32_t slot = m_nodeSlots[node];
+	m_localTransforms.SetTransform(
+		slot,
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
+	if (m_localDirty[slot] == 0)
+	{
+		m_localDirty[slot] = 1;
+		m_dirtySlots.push_back(slot);
+	}
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all the nodes.
+ ***********************************************************/
+void SceneGraph::Clear()
+{
+	m_nodeParents.clear();
+	m_nodeTransforms.clear();
+	m_nodeSlots.clear();
+	m_freeNodes.clear();
+	m_slotNodes.clear();
+	m_slotParents.clear();
+	m_slotFirstChild.clear();
+	m_slotChildCount.clear();
+	m_localTransforms.Clear();
+	m_localMatrices.clear();
+	m_worldMatrices.clear();
+	m_localDirty.clear();
+	m_updateStamps.clear();
+	m_dirtySlots.clear();
+	m_bLayoutDirty = false;
+}
+
+/***********************************************************
+ *  UpdateWorldMatrices()
+ *
+ *  This method is used for recalculating the world matrices
+ *  below every node that changed since the last update.  The
+ *  changed slots are visited in storage order, so an ancestor
+ *  is always handled before its descendants and a descendant
+ *  already covered by its ancestor's subtree is skipped.
+ ***********************************************************/
+size_t SceneGraph::UpdateWorldMatrices(std::vector<int>* pUpdatedNodes)
+{
+	if (m_bLayoutDirty == true)
+	{
+		RebuildLayout();
+	}
+	if (m_dirtySlots.empty())
+	{
+		return(0);
+	}
+
+	std::sort(m_dirtySlots.begin(), m_dirtySlots.end());
+
+	m_updateCount++;
+	size_t numUpdated = 0;
+	for (size_t i = 0; i < m_dirtySlots.size(); i++)
+	{
+		uint32_t slot = m_dirtySlots[i];
+		if (m_updateStamps[slot] != m_updateCount)
+		{
+			numUpdated += UpdateSubtree(slot, pUpdatedNodes);
+		}
+	}
+	m_dirtySlots.clear();
+
+	return(numUpdated);
+}
+
+/***********************************************************
+ *  GetWorldMatrix()
+ *
+ *  This method is used for getting the world matrix of the
+ *  node as of the last update.
+ ***********************************************************/
+const glm::mat4& SceneGraph::GetWorldMatrix(int node) const
+{
+	static const glm::mat4 identity(1.0f);
+
+	if ((IsNode(node) == false) || (m_bLayoutDirty == true))
+	{
+		return(identity);
+	}
+	return(m_worldMatrices[m_nodeSlots[node]]);
+}
+
+/***********************************************************
+ *  IsNode()
+ *
+ *  This method is used for checking whether the passed in ID
+ *  is of a node in the graph.
+ ***********************************************************/
+bool SceneGraph::IsNode(int node) const
+{
+	return((node >= 0) && (node < (int)m_nodeParents.size()) && (m_nodeParents[node] != REMOVED_NODE));
+}
+
+/***********************************************************
+ *  RebuildLayout()
+ *
+ *  This method is used for putting the nodes into breadth-
+ *  first storage order, leaving out the removed nodes.
+ *  Every local matrix is recalculated in one batch and every
+ *  root is marked as changed.
+ ***********************************************************/
+void SceneGraph::RebuildLayout()
+{
+	size_t numNodes = m_nodeParents.size();
+
+	// children of each node ID, in the order they were added
+	std::vector<uint32_t> childCounts(numNodes + 1, 0);
+	for (size_t node = 0; node < numNodes; node++)
+	{
+		if (m_nodeParents[node] != REMOVED_NODE)
+		{
+			childCounts[m_nodeParents[node] + 1]++;
+		}
+	}
+	std::vector<uint32_t> childStarts(numNodes + 2, 0);
+	for (size_t i = 0; i <= numNodes; i++)
+	{
+		childStarts[i + 1] = childStarts[i] + childCounts[i];
+	}
+	std::vector<uint32_t> children(numNodes);
+	std::vector<uint32_t> fill(childStarts.begin(), childStarts.end() - 1);
+	for (size_t node = 0; node < numNodes; node++)
+	{
+		if (m_nodeParents[node] != REMOVED_NODE)
+		{
+			children[fill[m_nodeParents[node] + 1]++] = (uint32_t)node;
+		}
+	}
+
+	// breadth-first order - the roots, then their children...
+	std::vector<uint32_t> slotNodes;
+	slotNodes.reserve(numNodes);
+	for (uint32_t i = childStarts[0]; i < childStarts[1]; i++)
+	{
+		slotNodes.push_back(children[i]);
+	}
+	for (size_t slot = 0; slot < slotNodes.size(); slot++)
+	{
+		uint32_t node = slotNodes[slot];
+		for (uint32_t i = childStarts[node + 1]; i < childStarts[node + 2]; i++)
+		{
+			slotNodes.push_back(children[i]);
+		}
+	}
+
+	// one slot for every node that wasn't removed
+	size_t numSlots = slotNodes.size();
+	m_slotNodes = slotNodes;
+	m_slotParents.resize(numSlots);
+	m_slotFirstChild.resize(numSlots);
+	m_slotChildCount.resize(numSlots);
+	m_localMatrices.resize(numSlots);
+	m_worldMatrices.resize(numSlots);
+	m_localDirty.assign(numSlots, 0);
+	m_updateStamps.assign(numSlots, m_updateCount);
+	m_localTransforms.Clear();
+	m_dirtySlots.clear();
+
+	for (size_t slot = 0; slot < numSlots; slot++)
+	{
+		m_nodeSlots[slotNodes[slot]] = (uint32_t)slot;
+	}
+	uint32_t nextChildSlot = childStarts[1];
+	for (size_t slot = 0; slot < numSlots; slot++)
+	{
+		uint32_t node = slotNodes[slot];
+		int parentNode = m_nodeParents[node];
+		const NODE_TRANSFORM& transform = m_nodeTransforms[node];
+
+		m_slotParents[slot] = (parentNode == NO_PARENT) ? NO_PARENT : (int)m_nodeSlots[parentNode];
+		m_slotChildCount[slot] = childCounts[node + 1];
+		m_slotFirstChild[slot] = nextChildSlot;
+		nextChildSlot += m_slotChildCount[slot];
+
+		m_localTransforms.AddTransform(
+			transform.scaleXYZ,
+			transform.XrotationDegrees,
+			transform.YrotationDegrees,
+			transform.ZrotationDegrees,
+			transform.positionXYZ);
+
+		if (parentNode == NO_PARENT)
+		{
+			m_dirtySlots.push_back((uint32_t)slot);
+		}
+	}
+
+	m_localTransforms.ComputeModelMatrices(0, numSlots, m_localMatrices.data());
+	m_bLayoutDirty = false;
+}
+
+/***********************************************************
+ *  UpdateSubtree()
+ *
+ *  This method is used for recalculating the world matrices
+ *  of a node and everything below it, level by level.  The
+ *  children of each node are one contiguous run of slots.
+ ***********************************************************/
+size_t SceneGraph::UpdateSubtree(uint32_t rootSlot, std::vector<int>* pUpdatedNodes)
+{
+	m_updateQueue.clear();
+	m_updateQueue.push_back(rootSlot);
+
+	for (size_t i = 0; i < m_updateQueue.size(); i++)
+	{
+		uint32_t slot = m_updateQueue[i];
+
+		if (m_localDirty[slot] != 0)
+		{
+			m_localTransforms.ComputeModelMatrices(slot, slot + 1, m_localMatrices.data());
+			m_localDirty[slot] = 0;
+		}
+
+		int parentSlot = m_slotParents[slot];
+		if (parentSlot == NO_PARENT)
+		{
+			m_worldMatrices[slot] = m_localMatrices[slot];
+		}
+		else
+		{
+			m_worldMatrices[slot] = m_worldMatrices[parentSlot] * m_localMatrices[slot];
+		}
+		m_updateStamps[slot] = m_updateCount;
+		if (NULL != pUpdatedNodes)
+		{
+			pUpdatedNodes->push_back((int)m_slotNodes[slot]);
+		}
+
+		uint32_t firstChild = m_slotFirstChild[slot];
+		for (uint32_t child = 0; child < m_slotChildCount[slot]; child++)
+		{
+			m_updateQueue.push_back(firstChild + child);
+		}
+	}
+
+	return(m_updateQueue.size());
+}
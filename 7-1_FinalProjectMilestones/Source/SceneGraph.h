@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegraph.h
+// ============
+// parent / child transform hierarchy with dirty-flag world matrix updates
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "TransformBatch.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  SceneGraph
+ *
+ *  This class contains a hierarchy of transform nodes.  Each
+ *  node has a local scale, rotation and position relative to
+ *  its parent, and a world matrix that is only recalculated
+ *  when the node or one of its ancestors has changed.
+ *
+ *  The nodes are stored in breadth-first order, so a parent
+ *  always comes before its children and the children of a
+ *  node sit next to each other in memory.  An update walks
+ *  only the subtrees below the changed nodes, so the cost of
+ *  moving one assembly does not grow with the rest of the
+ *  scene.  Node IDs stay the same when the storage order is
+ *  rebuilt after nodes are added or removed, and the IDs of
+ *  removed nodes are given to the nodes added after them.
+ ***********************************************************/
+class SceneGraph
+{
+public:
+	static const int NO_PARENT = -1;
+
+	// constructor
+	SceneGraph();
+
+	// add a node below the passed in parent, returns its ID
+	int AddNode(
+		int parentNode,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+	// remove a node, its children move up to its parent
+	void RemoveNode(int node);
+	// change the local transformation values of a node
+	void SetLocalTransform(
+		int node,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+	void Clear();
+
+	// recalculate the world matrices below every changed node,
+	// returns the number of nodes that were recalculated and,
+	// when a list is passed in, adds their IDs to it
+	size_t UpdateWorldMatrices(std::vector<int>* pUpdatedNodes = NULL);
+
+	// world matrix of the node as of the last update
+	const glm::mat4& GetWorldMatrix(int node) const;
+	// one past the largest node ID, removed nodes included
+	size_t GetNodeCount() const { return(m_nodeParents.size()); }
+
+private:
+	// local transformation values of a node
+	struct NODE_TRANSFORM
+	{
+		glm::vec3 scaleXYZ;
+		float XrotationDegrees;
+		float YrotationDegrees;
+		float ZrotationDegrees;
+		glm::vec3 positionXYZ;
+	};
+
+	// parent of a removed node
+	static const int REMOVED_NODE = -2;
+
+	// node data by ID, kept for rebuilding the storage order
+	std::vector<int> m_nodeParents;
+	std::vector<NODE_TRANSFORM> m_nodeTransforms;
+	// storage slot of each node ID
+	std::vector<uint32_t> m_nodeSlots;
+	// IDs of removed nodes, for reuse
+	std::vector<int> m_freeNodes;
+
+	// node data by breadth-first storage slot
+	std::vector<uint32_t> m_slotNodes;
+	std::vector<int> m_slotParents;
+	std::vector<uint32_t> m_slotFirstChild;
+	std::vector<uint32_t> m_slotChildCount;
+	TransformBatch m_localTransforms;
+	std::vector<glm::mat4> m_localMatrices;
+	std::vector<glm::mat4> m_worldMatrices;
+	std::vector<uint8_t> m_localDirty;
+	// update number that last recalculated the slot
+	std::vector<uint32_t> m_updateStamps;
+
+	// slots whose subtree needs recalculating
+	std::vector<uint32_t> m_dirtySlots;
+	// breadth-first queue reused by every subtree update
+	std::vector<uint32_t> m_updateQueue;
+	uint32_t m_updateCount;
+	// nodes were added since the storage order was built
+	bool m_bLayoutDirty;
+
+	// check whether the ID is of a node that wasn't removed
+	bool IsNode(int node) const;
+	// put the nodes into breadth-first storage order
+	void RebuildLayout();
+	// recalculate the world matrices of a subtree
+	size_t UpdateSubtree(uint32_t rootSlot, std::vector<int>* pUpdatedNodes);
+};
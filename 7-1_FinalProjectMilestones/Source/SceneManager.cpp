@@ -16,14 +16,52 @@
 
 #include <glm/gtx/transform.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+
 // declaration of global variables
 namespace
 {
-	const char* g_ModelName = "model";
-	const char* g_ColorValueName = "objectColor";
 	const char* g_TextureValueName = "objectTexture";
-	const char* g_UseTextureName = "bUseTexture";
 	const char* g_UseLightingName = "bUseLighting";
+	const char* g_ObjectBlockName = "ObjectBlock";
+	const char* g_OctahedralNormalsName = "bOctahedralNormals";
+
+	// uniform buffer binding point of the per-object values
+	const GLuint OBJECT_BLOCK_BINDING = 0;
+
+	// scene objects evaluated by one job of the job system
+	const size_t OBJECTS_PER_JOB = 256;
+	// view depth that maps to the last depth sort bucket
+	const float MAX_SORT_DEPTH = 100.0f;
+	// an opaque object is an occluder when the two largest
+	// sides of its world box are at least this long
+	const float OCCLUDER_MIN_SIZE = 2.0f;
+
+	// GPU culler buckets - the triangles, then the lines, of
+	// the untextured objects and of each texture slot
+	const uint32_t NUM_GPU_BUCKETS = 2 * (16 + 1);
+
+	// meshlet count of a draw that is drawn whole
+	const uint32_t NO_MESHLETS = 0xFFFFFFFF;
+
+	// image files of the scene textures and their tags
+	struct SCENE_TEXTURE
+	{
+		const char* filename;
+		const char* tag;
+	};
+	const SCENE_TEXTURE g_SceneTextures[] =
+	{
+		{ "C:/Users/adrea/OneDrive/Pictures/Screenshots/object texture one.jpg", "couch" },
+		{ "C:/Users/adrea/OneDrive/Pictures/Screenshots/object texture three.jpg", "wall" },
+		{ "C:/Users/adrea/OneDrive/Pictures/Screenshots/object texture two.jpg", "floor" }
+	};
+
+	// scene file the objects of the 3D scene are loaded from
+	const char* g_SceneFileName = "scenes/living_room.scene";
 }
 
 /***********************************************************
@@ -35,6 +73,34 @@ SceneManager::SceneManager(ShaderManager *pShaderManager)
 {
 	m_pShaderManager = pShaderManager;
 	m_basicMeshes = new ShapeMeshes();
+	m_pJobSystem = new JobSystem();
+	m_pModelImporter = new ModelImporter(m_pJobSystem);
+	m_pAssetArchive = NULL;
+	m_pObjectBuffer = new FrameRingBuffer(GL_UNIFORM_BUFFER);
+	m_pipelineDepth = FrameRingBuffer::DEFAULT_FRAMES;
+	m_objectBlockStride = sizeof(OBJECT_BLOCK);
+	m_loadedTextures = 0;
+	m_viewProjection = glm::mat4(1.0f);
+	m_bViewProjectionSet = false;
+	m_pOcclusionCuller = NULL;
+	m_bOcclusionCulling = false;
+	m_pGpuCuller = NULL;
+	m_bGpuCulling = false;
+	m_bGpuObjectsDirty = true;
+	m_bMeshletCulling = false;
+	m_cameraPosition = glm::vec3(0.0f);
+	m_pStaticBatcher = NULL;
+	m_bStaticBatching = false;
+	m_pStaticLayerCache = NULL;
+	m_bStaticLayerCache = false;
+	m_bStaticObjectsDirty = true;
+	m_staticVersion = 0;
+	for (int i = 0; i < MESH_TYPE_COUNT; i++)
+	{
+		m_meshPrimitives[i] = 0;
+		m_meshLinePrimitives[i] = 0;
+		m_meshDecodes[i] = glm::mat4(1.0f);
+	}
 }
 
 /***********************************************************
@@ -45,8 +111,35 @@ SceneManager::SceneManager(ShaderManager *pShaderManager)
 SceneManager::~SceneManager()
 {
 	m_pShaderManager = NULL;
+	m_pAssetArchive = NULL;
 	delete m_basicMeshes;
 	m_basicMeshes = NULL;
+	delete m_pModelImporter;
+	m_pModelImporter = NULL;
+	delete m_pJobSystem;
+	m_pJobSystem = NULL;
+	delete m_pObjectBuffer;
+	m_pObjectBuffer = NULL;
+	if (NULL != m_pOcclusionCuller)
+	{
+		delete m_pOcclusionCuller;
+		m_pOcclusionCuller = NULL;
+	}
+	if (NULL != m_pGpuCuller)
+	{
+		delete m_pGpuCuller;
+		m_pGpuCuller = NULL;
+	}
+	if (NULL != m_pStaticBatcher)
+	{
+		delete m_pStaticBatcher;
+		m_pStaticBatcher = NULL;
+	}
+	if (NULL != m_pStaticLayerCache)
+	{
+		delete m_pStaticLayerCache;
+		m_pStaticLayerCache = NULL;
+	}
 }
 
 /***********************************************************
@@ -59,10 +152,53 @@ SceneManager::~SceneManager()
  ***********************************************************/
 bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 {
+	GLuint textureID = 0;
+
+	glGenTextures(1, &textureID);
+	if (LoadTextureImage(textureID, filename) == false)
+	{
+		glDeleteTextures(1, &textureID);
+		return false;
+	}
+
+	// register the loaded texture and associate it with the special tag string
+	m_textureIDs[m_loadedTextures].ID = textureID;
+	m_textureIDs[m_loadedTextures].tag = tag;
+	m_textureIDs[m_loadedTextures].filename = filename;
+	m_loadedTextures++;
+
+	return true;
+}
+
+/***********************************************************
+ *  LoadTextureImage()
+ *
+ *  This method is used for reading an image file into the
+ *  passed in OpenGL texture, replacing any image it held,
+ *  and generating the mipmaps.  The texture is left unbound.
+ *  An image packed in the asset archive was decoded when the
+ *  archive was built, and is uploaded from the mapped pages.
+ ***********************************************************/
+bool SceneManager::LoadTextureImage(GLuint textureID, const char* filename)
+{
+	AssetArchive::ASSET_VIEW asset;
+	if ((NULL != m_pAssetArchive) && (m_pAssetArchive->FindAsset(filename, asset) == true))
+	{
+		AssetArchive::TEXTURE_HEADER header;
+		const unsigned char* pPixels = NULL;
+		if (AssetArchive::GetTexture(asset, header, pPixels) == false)
+		{
+			std::cout << "Could not load packed image:" << filename << std::endl;
+			return false;
+		}
+
+		std::cout << "Successfully loaded packed image:" << filename << ", width:" << header.width << ", height:" << header.height << ", channels:" << header.colorChannels << std::endl;
+		return(UploadTextureImage(textureID, pPixels, (int)header.width, (int)header.height, (int)header.colorChannels));
+	}
+
 	int width = 0;
 	int height = 0;
 	int colorChannels = 0;
-	GLuint textureID = 0;
 
 	// indicate to always flip images vertically when loaded
 	stbi_set_flip_vertically_on_load(true);
@@ -80,41 +216,12 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 	{
 		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
 
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
-		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
-			return false;
-		}
-
-		// generate the texture mipmaps for mapping textures to lower resolutions
-		glGenerateMipmap(GL_TEXTURE_2D);
+		bool bReturn = UploadTextureImage(textureID, image, width, height, colorChannels);
 
 		// free the image data from local memory
 		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
 
-		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
-
-		return true;
+		return(bReturn);
 	}
 
 	std::cout << "Could not load image:" << filename << std::endl;
@@ -123,6 +230,56 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 	return false;
 }
 
+/***********************************************************
+ *  UploadTextureImage()
+ *
+ *  This method is used for sending the rows of pixels of an
+ *  image to the passed in OpenGL texture and generating the
+ *  mipmaps.  The rows are tightly packed, with no padding.
+ ***********************************************************/
+bool SceneManager::UploadTextureImage(GLuint textureID, const unsigned char* image, int width, int height, int colorChannels)
+{
+	if ((colorChannels != 3) && (colorChannels != 4))
+	{
+		std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
+		return false;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, textureID);
+
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// RGB rows are not padded to 4 bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	// if the loaded image is in RGB format
+	if (colorChannels == 3)
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
+	// if the loaded image is in RGBA format - it supports transparency
+	else
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	// count the image data sent to the driver
+	if (NULL != GetRenderStats())
+	{
+		GetRenderStats()->CountUpload((uint64_t)width * height * colorChannels);
+	}
+
+	// generate the texture mipmaps for mapping textures to lower resolutions
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+
+	return true;
+}
+
 /***********************************************************
  *  BindGLTextures()
  *
@@ -136,6 +293,10 @@ void SceneManager::BindGLTextures()
 		// bind textures on corresponding texture units
 		glActiveTexture(GL_TEXTURE0 + i);
 		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
+		if (NULL != GetRenderStats())
+		{
+			GetRenderStats()->CountTextureBind();
+		}
 	}
 }
 
@@ -239,154 +400,383 @@ bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
 }
 
 /***********************************************************
- *  SetTransformations()
+ *  FindMaterialIndex()
  *
- *  This method is used for setting the transform buffer
- *  using the passed in transformation values.
+ *  This method is used for getting the index of the defined
+ *  material associated with the passed in tag, or -1.
  ***********************************************************/
-void SceneManager::SetTransformations(
-	glm::vec3 scaleXYZ,
-	float XrotationDegrees,
-	float YrotationDegrees,
-	float ZrotationDegrees,
-	glm::vec3 positionXYZ)
+int SceneManager::FindMaterialIndex(std::string tag)
 {
-	// variables for this method
-	glm::mat4 modelView;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
-
-	// set the scale value in the transform buffer
-	scale = glm::scale(scaleXYZ);
-	// set the rotation values in the transform buffer
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-	// set the translation value in the transform buffer
-	translation = glm::translate(positionXYZ);
-
-	modelView = translation * rotationZ * rotationY * rotationX * scale;
+	for (size_t i = 0; i < m_objectMaterials.size(); i++)
+	{
+		if (m_objectMaterials[i].tag.compare(tag) == 0)
+		{
+			return((int)i);
+		}
+	}
+	return(-1);
+}
 
+/***********************************************************
+ *  SetTextureUVScale()
+ *
+ *  This method is used for setting the texture UV scale
+ *  values into the shader.
+ ***********************************************************/
+void SceneManager::SetTextureUVScale(float u, float v)
+{
 	if (NULL != m_pShaderManager)
 	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
+		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
+	}
+}
+
+
+void SceneManager::LoadSceneTextures()
+{
+	/*** STUDENTS - add the code BELOW for loading the textures that ***/
+	/*** will be used for mapping to objects in the 3D scene. Up to  ***/
+	/*** 16 textures can be loaded per scene. Refer to the code in   ***/
+	/*** the OpenGL Sample for help.                                 ***/
+
+	// the image files are listed in g_SceneTextures, so the
+	// asset archive can be built with the same list
+	for (size_t i = 0; i < sizeof(g_SceneTextures) / sizeof(g_SceneTextures[0]); i++)
+	{
+		CreateGLTexture(g_SceneTextures[i].filename, g_SceneTextures[i].tag);
 	}
+
+	//texture image data loaded into memory
+	// loaded textures bound to texture slots
+	BindGLTextures();
 }
 
+
+
 /***********************************************************
- *  SetShaderColor()
+ *  SetPackedVertices()
  *
- *  This method is used for setting the passed in color
- *  into the shader for the next draw command
+ *  This method is used for storing the vertices of the basic
+ *  shape meshes in the packed format, which halves their
+ *  memory and the vertex data fetched by every draw.
  ***********************************************************/
-void SceneManager::SetShaderColor(
-	float redColorValue,
-	float greenColorValue,
-	float blueColorValue,
-	float alphaValue)
+void SceneManager::SetPackedVertices(bool bPacked)
 {
-	// variables for this method
-	glm::vec4 currentColor;
-
-	currentColor.r = redColorValue;
-	currentColor.g = greenColorValue;
-	currentColor.b = blueColorValue;
-	currentColor.a = alphaValue;
+	m_basicMeshes->SetPackedVertices(bPacked);
+}
 
-	if (NULL != m_pShaderManager)
+/***********************************************************
+ *  SetPipelineDepth()
+ *
+ *  This method is used for setting the number of frames of
+ *  the per-frame buffers.  The CPU writes the blocks of the
+ *  next frame into a part the GPU is done with while the GPU
+ *  still draws the frames before, and only waits when every
+ *  part is still in use.  A depth of one makes every frame
+ *  wait for the one before to finish.
+ ***********************************************************/
+void SceneManager::SetPipelineDepth(int numFrames)
+{
+	m_pipelineDepth = numFrames;
+	m_pObjectBuffer->SetNumFrames(numFrames);
+	if (NULL != m_pGpuCuller)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
+		m_pGpuCuller->SetPipelineDepth(numFrames);
 	}
 }
 
 /***********************************************************
- *  SetShaderTexture()
+ *  SetMeshletCulling()
+ *
+ *  This method is used for having the large models split
+ *  into meshlets as they are imported, and culled meshlet by
+ *  meshlet as they are drawn.
+ ***********************************************************/
+void SceneManager::SetMeshletCulling(bool bMeshletCulling)
+{
+	m_bMeshletCulling = bMeshletCulling;
+	m_pModelImporter->SetBuildMeshlets(bMeshletCulling);
+}
+
+/***********************************************************
+ *  GetRenderStats()
  *
- *  This method is used for setting the texture data
- *  associated with the passed in ID into the shader.
+ *  This method is used for getting the render stats object
+ *  that the frame work is counted in, which is shared with
+ *  the shader manager.  Returns NULL when stats are off.
  ***********************************************************/
-void SceneManager::SetShaderTexture(
-	std::string textureTag)
+RenderStats* SceneManager::GetRenderStats() const
 {
 	if (NULL != m_pShaderManager)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
-
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
+		return(m_pShaderManager->GetRenderStats());
 	}
+	return(NULL);
 }
 
 /***********************************************************
- *  SetTextureUVScale()
+ *  DrawShapeMesh()
  *
- *  This method is used for setting the texture UV scale
- *  values into the shader.
+ *  This method is used for issuing the draw command of the
+ *  basic shape mesh of the passed in type.  Nothing is drawn
+ *  for the lines of a mesh without a line variant.
  ***********************************************************/
-void SceneManager::SetTextureUVScale(float u, float v)
+void SceneManager::DrawShapeMesh(MESH_TYPE meshType, bool bLines)
 {
-	if (NULL != m_pShaderManager)
+	switch (meshType)
 	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
+	case MESH_PLANE:
+		if (bLines == false)
+			m_basicMeshes->DrawPlaneMesh();
+		break;
+	case MESH_BOX:
+		if (bLines == true)
+			m_basicMeshes->DrawBoxMeshLines();
+		else
+			m_basicMeshes->DrawBoxMesh();
+		break;
+	case MESH_CYLINDER:
+		if (bLines == true)
+			m_basicMeshes->DrawCylinderMeshLines();
+		else
+			m_basicMeshes->DrawCylinderMesh();
+		break;
+	case MESH_SPHERE:
+		if (bLines == false)
+			m_basicMeshes->DrawSphereMesh();
+		break;
+	case MESH_HALF_SPHERE:
+		if (bLines == true)
+			m_basicMeshes->DrawHalfSphereMeshLines();
+		else
+			m_basicMeshes->DrawHalfSphereMesh();
+		break;
+	default:
+		break;
 	}
 }
 
+/***********************************************************
+ *  HasShapeMeshLines()
+ *
+ *  This method is used for checking whether the basic shape
+ *  mesh of the passed in type is drawn with wireframe lines.
+ *  The plane and the sphere have no line variant.
+ ***********************************************************/
+bool SceneManager::HasShapeMeshLines(MESH_TYPE meshType)
+{
+	return((meshType == MESH_BOX) || (meshType == MESH_CYLINDER) || (meshType == MESH_HALF_SPHERE));
+}
 
-void SceneManager::LoadSceneTextures()
+/***********************************************************
+ *  GetShapeMeshDecode()
+ *
+ *  This method is used for getting the transform from the
+ *  stored positions of the basic shape mesh of the passed in
+ *  type to model space.
+ ***********************************************************/
+glm::mat4 SceneManager::GetShapeMeshDecode(MESH_TYPE meshType) const
 {
-	/*** STUDENTS - add the code BELOW for loading the textures that ***/
-	/*** will be used for mapping to objects in the 3D scene. Up to  ***/
-	/*** 16 textures can be loaded per scene. Refer to the code in   ***/
-	/*** the OpenGL Sample for help.                                 ***/
+	switch (meshType)
+	{
+	case MESH_PLANE:
+		return(m_basicMeshes->GetPlaneMeshDecode());
+	case MESH_BOX:
+		return(m_basicMeshes->GetBoxMeshDecode());
+	case MESH_CYLINDER:
+		return(m_basicMeshes->GetCylinderMeshDecode());
+	case MESH_SPHERE:
+		return(m_basicMeshes->GetSphereMeshDecode());
+	case MESH_HALF_SPHERE:
+		return(m_basicMeshes->GetHalfSphereMeshDecode());
+	default:
+		break;
+	}
+	return(glm::mat4(1.0f));
+}
 
-	bool bReturn = false;
+/***********************************************************
+ *  GetShapeMeshID()
+ *
+ *  This method is used for getting the ID of a basic shape
+ *  mesh in the geometry pool, -1 for one not loaded.
+ ***********************************************************/
+int SceneManager::GetShapeMeshID(MESH_TYPE meshType) const
+{
+	switch (meshType)
+	{
+	case MESH_PLANE:
+		return(m_basicMeshes->GetPlaneMesh());
+	case MESH_BOX:
+		return(m_basicMeshes->GetBoxMesh());
+	case MESH_CYLINDER:
+		return(m_basicMeshes->GetCylinderMesh());
+	case MESH_SPHERE:
+		return(m_basicMeshes->GetSphereMesh());
+	case MESH_HALF_SPHERE:
+		return(m_basicMeshes->GetHalfSphereMesh());
+	default:
+		break;
+	}
+	return(-1);
+}
 
-	bReturn = CreateGLTexture(
-		"C:/Users/adrea/OneDrive/Pictures/Screenshots/object texture one.jpg",
-		"couch");
+/***********************************************************
+ *  LoadModel()
+ *
+ *  This method is used for importing a model file into the
+ *  geometry pool shared with the basic shape meshes.  Every
+ *  object using the same file draws the same mesh.
+ ***********************************************************/
+int SceneManager::LoadModel(const std::string& filename)
+{
+	for (size_t i = 0; i < m_models.size(); i++)
+	{
+		if (m_models[i].filename == filename)
+		{
+			return((int)i);
+		}
+	}
 
-	bReturn = CreateGLTexture(
-		"C:/Users/adrea/OneDrive/Pictures/Screenshots/object texture three.jpg", 
-		"wall");
+	GeometryPool* pGeometryPool = m_basicMeshes->GetGeometryPool();
+	ModelImporter::IMPORT_RESULT result;
+	AssetArchive::ASSET_VIEW asset;
+	bool bImported = false;
+	if ((NULL != m_pAssetArchive) && (m_pAssetArchive->FindAsset(filename, asset) == true))
+	{
+		// parsed where it lies in the mapped archive
+		bImported = m_pModelImporter->ImportData(filename.c_str(), asset.pData, asset.size, pGeometryPool, result);
+	}
+	else
+	{
+		bImported = m_pModelImporter->ImportFile(filename.c_str(), pGeometryPool, result);
+	}
+	if (bImported == false)
+	{
+		return(-1);
+	}
 
-	bReturn = CreateGLTexture(
-		"C:/Users/adrea/OneDrive/Pictures/Screenshots/object texture two.jpg",
-		"floor");
+	MODEL_INFO model;
+	model.filename = filename;
+	model.mesh = result.mesh;
+	model.boundsMin = result.boundsMin;
+	model.boundsMax = result.boundsMax;
+	model.decode = pGeometryPool->GetPositionDecode(result.mesh);
+	model.primitives = result.numTriangles;
+	model.meshlets = result.meshlets;
+	m_models.push_back(model);
+
+	return((int)m_models.size() - 1);
+}
 
-	//texture image data loaded into memory
-	// loaded textures bound to texture slots
-	BindGLTextures();
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for drawing the filled basic shape
+ *  mesh or imported model and counting the draw call in the
+ *  render stats.
+ ***********************************************************/
+void SceneManager::DrawMesh(MESH_TYPE meshType, int modelIndex)
+{
+	uint64_t primitives = 0;
+	if (meshType == MESH_MODEL)
+	{
+		m_basicMeshes->GetGeometryPool()->DrawMesh(m_models[modelIndex].mesh);
+		primitives = m_models[modelIndex].primitives;
+	}
+	else
+	{
+		DrawShapeMesh(meshType, false);
+		primitives = m_meshPrimitives[meshType];
+	}
+	if (NULL != GetRenderStats())
+	{
+		GetRenderStats()->CountDraw(meshType, false, primitives);
+	}
 }
 
+/***********************************************************
+ *  DrawModelMeshlets()
+ *
+ *  This method is used for drawing the meshlets of a model
+ *  kept by the culling for one draw of the draw list, and
+ *  counting them in the render stats.
+ ***********************************************************/
+void SceneManager::DrawModelMeshlets(int modelIndex, size_t drawIndex)
+{
+	const std::vector<GeometryPool::INDEX_RANGE>& ranges = m_drawMeshletRanges[drawIndex];
+	const MeshletCuller::MESHLET_SET& meshlets = m_models[modelIndex].meshlets;
+
+	uint64_t primitives = 0;
+	for (size_t i = 0; i < ranges.size(); i++)
+	{
+		primitives += (uint64_t)(ranges[i].numIndices / 3);
+	}
+	if (ranges.empty() == false)
+	{
+		m_basicMeshes->GetGeometryPool()->DrawMeshRanges(m_models[modelIndex].mesh, ranges.data(), ranges.size());
+	}
 
+	if (NULL != GetRenderStats())
+	{
+		uint32_t numKept = m_drawMeshletCounts[drawIndex];
+		if (ranges.empty() == false)
+		{
+			GetRenderStats()->CountDraw(MESH_MODEL, false, primitives);
+		}
+		GetRenderStats()->CountMeshlets(numKept, (uint32_t)meshlets.ranges.size() - numKept);
+	}
+}
 
+/***********************************************************
+ *  DrawMeshLines()
+ *
+ *  This method is used for drawing the wireframe lines of
+ *  the basic shape mesh and counting the draw call in the
+ *  render stats.  Imported models, and the shape meshes
+ *  without a line variant, have no wireframe lines.
+ ***********************************************************/
+void SceneManager::DrawMeshLines(MESH_TYPE meshType, int modelIndex)
+{
+	if ((meshType == MESH_MODEL) || (HasShapeMeshLines(meshType) == false))
+	{
+		return;
+	}
 
+	DrawShapeMesh(meshType, true);
+	if (NULL != GetRenderStats())
+	{
+		GetRenderStats()->CountDraw(meshType, true, m_meshLinePrimitives[meshType]);
+	}
+}
 
 /***********************************************************
- *  SetShaderMaterial()
+ *  MeasureMeshPrimitives()
  *
- *  This method is used for passing the material values
- *  into the shader.
+ *  This method is used for finding out how many triangles
+ *  and lines one draw of each loaded mesh submits, from the
+ *  index ranges of the meshes in the geometry pool.  A mesh
+ *  without a line variant draws no lines.
  ***********************************************************/
-void SceneManager::SetShaderMaterial(
-	std::string materialTag)
+void SceneManager::MeasureMeshPrimitives()
 {
-	if (m_objectMaterials.size() > 0)
+	const GeometryPool* pGeometryPool = m_basicMeshes->GetGeometryPool();
+
+	for (int i = 0; i < MESH_MODEL; i++)
 	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
+		m_meshPrimitives[i] = 0;
+		m_meshLinePrimitives[i] = 0;
 
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
+		int mesh = GetShapeMeshID((MESH_TYPE)i);
+		if (mesh < 0)
+		{
+			continue;
+		}
+		const GeometryPool::MESH_RANGE& range = pGeometryPool->GetMeshRange(mesh);
+		m_meshPrimitives[i] = (uint64_t)(range.numIndices / 3);
+		if (HasShapeMeshLines((MESH_TYPE)i) == true)
 		{
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
+			m_meshLinePrimitives[i] = (uint64_t)(range.numLineIndices / 2);
 		}
 	}
 }
@@ -421,6 +811,9 @@ void SceneManager::DefineObjectMaterials()
 //added SetupSceneLights
 void SceneManager::SetupSceneLights()
 {
+	// the objects that don't move are lit differently
+	m_staticVersion++;
+
 	m_pShaderManager->setBoolValue(g_UseLightingName, true);
 
 	m_pShaderManager->setVec3Value("pointLights[0].position", -15.0f, 10.0f, -5.75f);
@@ -439,6 +832,34 @@ void SceneManager::SetupSceneLights()
 }
 
 
+/***********************************************************
+ *  BeginLoadShaders()
+ *
+ *  This method is used for starting to build the shader
+ *  programs PrepareScene() loads for the turned on features,
+ *  so they compile side by side with the scene program.  The
+ *  scene is drawn with the passed in fragment shader when it
+ *  is culled on the GPU as well.
+ ***********************************************************/
+void SceneManager::BeginLoadShaders(const char* fragmentShaderPath)
+{
+	if ((m_bGpuCulling == true) && (GpuCuller::IsSupported() == true))
+	{
+		GpuCuller::BeginLoadShaders(m_pShaderManager);
+		m_pShaderManager->BeginLoadShaders(GpuCuller::GetVertexShaderFile(), fragmentShaderPath);
+		// the features below are off with GPU culling
+		return;
+	}
+	if (m_bOcclusionCulling == true)
+	{
+		OcclusionCuller::BeginLoadShaders(m_pShaderManager);
+	}
+	if (m_bStaticLayerCache == true)
+	{
+		StaticLayerCache::BeginLoadShaders(m_pShaderManager);
+	}
+}
+
 /***********************************************************
  *  PrepareScene()
  *
@@ -448,6 +869,61 @@ void SceneManager::SetupSceneLights()
  ***********************************************************/
 void SceneManager::PrepareScene()
 {
+	// the objects culled on the GPU are drawn with a vertex
+	// shader that reads them from the object buffer, loaded
+	// ahead of any uniform values being set
+	if ((m_bGpuCulling == true) && (GpuCuller::IsSupported() == false))
+	{
+		std::cout << "GPU culling needs OpenGL 4.6, the objects are culled on the CPU" << std::endl;
+	}
+	else if (m_bGpuCulling == true)
+	{
+		std::string vertexShaderPath = m_pShaderManager->GetVertexShaderPath();
+		std::string fragmentShaderPath = m_pShaderManager->GetFragmentShaderPath();
+
+		m_pGpuCuller = new GpuCuller();
+		m_pGpuCuller->SetPipelineDepth(m_pipelineDepth);
+		if ((m_pGpuCuller->Create(m_pShaderManager) == false) ||
+			(0 == m_pShaderManager->LoadShaders(GpuCuller::GetVertexShaderFile(), fragmentShaderPath.c_str())))
+		{
+			std::cout << "GPU culling shaders did not load, the objects are culled on the CPU" << std::endl;
+			delete m_pGpuCuller;
+			m_pGpuCuller = NULL;
+			m_pShaderManager->LoadShaders(vertexShaderPath.c_str(), fragmentShaderPath.c_str());
+		}
+		m_pShaderManager->use();
+	}
+
+	// the static batches are built from copies of the meshes,
+	// which have to be kept as the meshes are loaded
+	if ((m_bStaticBatching == true) && (NULL != m_pGpuCuller))
+	{
+		std::cout << "Static batching is off, it is not used with GPU culling" << std::endl;
+	}
+	else if (m_bStaticBatching == true)
+	{
+		m_pStaticBatcher = new StaticBatcher();
+		m_pStaticBatcher->SetVertexFormat(m_basicMeshes->GetGeometryPool()->GetVertexFormat());
+		m_basicMeshes->GetGeometryPool()->SetKeepMeshData(true);
+		m_bStaticObjectsDirty = true;
+	}
+
+	// the objects culled on the GPU are all drawn every frame
+	if ((m_bStaticLayerCache == true) && (NULL != m_pGpuCuller))
+	{
+		std::cout << "Static layer cache is off, it is not used with GPU culling" << std::endl;
+	}
+	else if (m_bStaticLayerCache == true)
+	{
+		m_pStaticLayerCache = new StaticLayerCache();
+		if (m_pStaticLayerCache->Create(m_pShaderManager) == false)
+		{
+			delete m_pStaticLayerCache;
+			m_pStaticLayerCache = NULL;
+		}
+		m_pShaderManager->use();
+		m_bStaticObjectsDirty = true;
+	}
 
 	LoadSceneTextures();
 	DefineObjectMaterials();
@@ -463,1476 +939,1614 @@ void SceneManager::PrepareScene()
 	m_basicMeshes->LoadBoxMesh();
 	m_basicMeshes->LoadCylinderMesh(); 
 	m_basicMeshes->LoadSphereMesh();
+
+	// find the primitive counts used by the render stats
+	MeasureMeshPrimitives();
+
+	for (int i = 0; i < MESH_TYPE_COUNT; i++)
+	{
+		m_meshDecodes[i] = GetShapeMeshDecode((MESH_TYPE)i);
+	}
+	GeometryPool* pGeometryPool = m_basicMeshes->GetGeometryPool();
+	std::cout << "Shape mesh vertices:" << ((m_basicMeshes->IsPackedVertices() == true) ? "packed" : "float")
+		<< ", bytes per vertex:" << pGeometryPool->GetVertexSize() << std::endl;
+
+	// the object blocks in the object buffer have to start on
+	// the uniform buffer offset alignment
+	GLint alignment = 1;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	if (alignment < 1)
+	{
+		alignment = 1;
+	}
+	m_objectBlockStride = ((sizeof(OBJECT_BLOCK) + alignment - 1) / alignment) * alignment;
+	m_pShaderManager->SetUniformBlockBinding(g_ObjectBlockName, OBJECT_BLOCK_BINDING);
+
+	if ((m_bOcclusionCulling == true) && (NULL != m_pGpuCuller))
+	{
+		std::cout << "Occlusion culling is off, it is not used with GPU culling" << std::endl;
+	}
+	else if (m_bOcclusionCulling == true)
+	{
+		m_pOcclusionCuller = new OcclusionCuller();
+		if (m_pOcclusionCuller->Create(m_pShaderManager) == false)
+		{
+			delete m_pOcclusionCuller;
+			m_pOcclusionCuller = NULL;
+		}
+	}
+
+	// load the objects that make up the 3D scene
+	LoadSceneFile(g_SceneFileName);
 }
 
 /***********************************************************
- *  RenderScene()
+ *  LoadSceneFile()
  *
- *  This method is used for rendering the 3D scene by 
- *  transforming and drawing the basic 3D shapes
+ *  This method is used for loading every object of the 3D
+ *  scene - its mesh, transformation values, color, texture
+ *  and material - from the passed in scene file.  The
+ *  objects are turned into draw commands every frame by
+ *  RenderScene().
  ***********************************************************/
-void SceneManager::RenderScene()
+bool SceneManager::LoadSceneFile(const char* filename)
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
-
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
-	/******************************************************************/
-
-	
-	//Code for the bottom plane
-
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(20.0f, 1.0f, 10.0f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	SetShaderColor(0.753, 0.753, 0.753, 1);\
-
-	SetShaderTexture("floor");
-	SetShaderMaterial("wood");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-
-	//Code for top plane
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(20.0f, 1.0f, 10.0f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 9.0f, -10.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(0.827, 0.827, 0.827, 1);
-
-	SetShaderTexture("wall");
-	SetShaderMaterial("wood");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-
-	//Code for base of couch
-
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(5.0f, 0.25f, 20.0f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 90.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 2.0f,-5.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(1.000, 1.000, 1.000, 1);
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-
-	m_basicMeshes->DrawBoxMeshLines();
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-
-	//Code for the back left leg of the couch
-
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.2f, 2.0f, 0.2f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 90.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-9.0f, 0.0f, -7.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(1.000, 1.000, 1.000, 1);
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawCylinderMesh();
-
-	m_basicMeshes->DrawCylinderMeshLines();
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-
-	//Code for the front left leg of the couch
-
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.2f, 2.0f, 0.2f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 90.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-9.0f, 0.0f, -3.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(1.000, 1.000, 1.000, 1);
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawCylinderMesh();
-
-	m_basicMeshes->DrawCylinderMeshLines();
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-
-	//Code for the back right leg of the couch
-
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.2f, 2.0f, 0.2f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 90.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(9.0f, 0.0f, -7.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(1.000, 1.000, 1.000, 1);
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawCylinderMesh();
-
-	m_basicMeshes->DrawCylinderMeshLines();
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-
-	//Code for the front right leg of the couch
-
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.2f, 2.0f, 0.2f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 90.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(9.0f, 0.0f, -3.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(1.000, 1.000, 1.000, 1);
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawCylinderMesh();
-
-	m_basicMeshes->DrawCylinderMeshLines();
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-
-	//Code for the back left couch cushion
-
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(6.5f, 0.25f, 5.0f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-6.25f, 4.5f, -7.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(0.663, 0.663, 0.663, 1);
-
-	SetShaderTexture("couch");
-	SetShaderMaterial("fabric");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-
-	m_basicMeshes->DrawBoxMeshLines();
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-
-
-	//Code for the back middle couch cushion
-
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(6.5f, 0.25f, 5.0f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.25f, 4.5f, -7.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(0.663, 0.663, 0.663, 1);
-
-	SetShaderTexture("couch");
-	SetShaderMaterial("fabric");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-
-	m_basicMeshes->DrawBoxMeshLines();
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-	//Code for the back right couch cushion
-
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(6.0f, 0.25f, 5.0f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(6.5f, 4.5f, -7.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(0.663, 0.663, 0.663, 1);
-
-	SetShaderTexture("couch");
-	SetShaderMaterial("fabric");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-
-	m_basicMeshes->DrawBoxMeshLines();
-
-	/****************************************************************/
-	/****************************************************************/
-	/****************************************************************/
-
-
-	//Code for the left front couch cushion
-
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(6.5f, 0.5f, 4.5f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(-6.25f, 2.25f, -5.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(0.663, 0.663, 0.663, 1);
-
-	SetShaderTexture("couch");
-	SetShaderMaterial("fabric");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-
-	m_basicMeshes->DrawBoxMeshLines();
-
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-
-
-//Code for the middle front couch cushion
-
-
-// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(6.5f, 0.5f, 4.5f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(0.25f, 2.25f, -5.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(0.663, 0.663, 0.663, 1);
-
-	SetShaderTexture("couch");
-	SetShaderMaterial("fabric");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-
-	m_basicMeshes->DrawBoxMeshLines();
-
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-
-	//Code for the right front couch cushion
-
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(6.5f, 0.5f, 4.5f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(6.25f, 2.25f, -5.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(0.663, 0.663, 0.663, 1);
-
-	SetShaderTexture("couch");
-	SetShaderMaterial("fabric");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-
-	m_basicMeshes->DrawBoxMeshLines();
-
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-	//Table top
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(6.5f, 0.5f, 4.5f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(-15.0f, 3.25f, -5.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(0.545, 0.271, 0.075, 1);
-
-	SetShaderTexture("floor");
-	SetShaderMaterial("wood");
-
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-
-	m_basicMeshes->DrawBoxMeshLines();
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-
-//Back left table leg
-
-// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.5f, 3.0f, 0.5f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(-18.0f, 1.5f, -7.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(1.000, 1.000, 1.000, 1);
-
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-
-	m_basicMeshes->DrawBoxMeshLines();
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-
-//Back right table leg
-
-// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.5f, 3.0f, 0.5f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(-12.0f, 1.5f, -7.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(1.000, 1.000, 1.000, 1);
-
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-
-	m_basicMeshes->DrawBoxMeshLines();
-
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-
-//Front left table leg
-
-// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.5f, 3.0f, 0.5f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(-18.0f, 1.5f, -7.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(1.000, 1.000, 1.000, 1);
-
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-
-	m_basicMeshes->DrawBoxMeshLines();
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-
-	//Back bottom table leg
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(5.5f, 0.5f, 0.5f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(-15.0f, 0.25f, -7.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(1.000, 1.000, 1.000, 1);
-
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-
-	m_basicMeshes->DrawBoxMeshLines();
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-
-//Back bottom left table leg
-
-// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.5f, 0.5f, 4.5f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(-18.0f, 0.25f, -5.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(1.000, 1.000, 1.000, 1);
-
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-
-	m_basicMeshes->DrawBoxMeshLines();
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-
-//Back bottom left table leg
-
-// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.5f, 0.5f, 4.5f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(-12.0f, 0.25f, -5.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(1.000, 1.000, 1.000, 1);
-
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-
-	m_basicMeshes->DrawBoxMeshLines();
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-
-//Back bottom table leg
-
-// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(5.5f, 0.5f, 0.5f);
-
-// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(-15.0f, 0.25f, -3.0f);
-
-// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-// set the color values into the shader
-	SetShaderColor(1.000, 1.000, 1.000, 1);
-
-
-// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-
-	m_basicMeshes->DrawBoxMeshLines();
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-
-//Lamp base
-	
-// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(1.5f, 0.08f, 1.5f);
-
-// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(-15.0f, 3.55f, -5.75f);
-
-// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-// set the color values into the shader
-	SetShaderColor(0.392, 0.584, 0.929, 1);
-
-
-// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-
-	m_basicMeshes->DrawBoxMeshLines();
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-//Lamp stand
-
-// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.15f, 3.0f, 0.15f);
-
-// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(-15.0f, 5.0f, -5.75f);
-
-// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-// set the color values into the shader
-	SetShaderColor(0.392, 0.584, 0.929, 1);
-
-
-// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-
-	m_basicMeshes->DrawBoxMeshLines();
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-//Lamp top
-
-// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.75f, -1.5f, 0.75f);
-
-// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(-15.0f, 7.6f, -5.75f);
-
-// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-// set the color values into the shader
-	SetShaderColor(0.392, 0.584, 0.929, 1);
-
-
-// draw the mesh with transformation values
-	m_basicMeshes->DrawHalfSphereMesh();
-
-	m_basicMeshes->DrawHalfSphereMeshLines();
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-	//Lamp bulb
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.6f, 0.5f, 0.6f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(-15.0f, 7.4f, -5.75f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(1.000, 1.000, 0.878, 1);
-
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawHalfSphereMesh();
-
-	m_basicMeshes->DrawHalfSphereMeshLines();
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-//Lamp power button
-
-// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.25f, 0.01f, 0.05f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(-15.0f, 3.6f, -5.25f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(0.753, 0.753, 0.753, 1);
-
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-
-	m_basicMeshes->DrawBoxMeshLines();
-
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-	//Bowl
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(1.2f, -0.8f, 1.2f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(-17.0f, 4.3f, -3.8f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(0.753, 0.753, 0.753, 1);
-
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawHalfSphereMesh();
-
-	m_basicMeshes->DrawHalfSphereMeshLines();
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
-
-	//Table top
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(6.5f, 0.5f, 4.5f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(15.0f, 3.25f, -5.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(0.545, 0.271, 0.075, 1);
-
-	SetShaderTexture("floor");
-	SetShaderMaterial("wood");
-
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
+	std::vector<SceneFile::SCENE_RECORD> records;
+	AssetArchive::ASSET_VIEW asset;
+	if ((NULL != m_pAssetArchive) && (m_pAssetArchive->FindAsset(filename, asset) == true))
+	{
+		if (SceneFile::LoadText(filename, (const char*)asset.pData, asset.size, records) == false)
+		{
+			return(false);
+		}
+	}
+	else if (SceneFile::LoadFile(filename, records) == false)
+	{
+		return(false);
+	}
 
-	m_basicMeshes->DrawBoxMeshLines();
+	m_sceneFilePath = filename;
+	BuildScene(records);
+	return(true);
+}
 
+/***********************************************************
+ *  BuildScene()
+ *
+ *  This method is used for replacing all the scene objects
+ *  and groups with the ones of the passed in records.
+ ***********************************************************/
+void SceneManager::BuildScene(const std::vector<SceneFile::SCENE_RECORD>& records)
+{
+	m_sceneObjects.Clear();
+	m_sceneGraph.Clear();
+	m_sceneGroups.clear();
+	m_groupStack.clear();
+	m_recordHandles.clear();
+
+	// group records have no object
+	SceneObjectStore::OBJECT_HANDLE noObject;
+	noObject.slot = SceneObjectStore::INVALID_INDEX;
+	noObject.generation = 0;
+
+	for (size_t i = 0; i < records.size(); i++)
+	{
+		const SceneFile::SCENE_RECORD& record = records[i];
 
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
+		// a group comes before the records inside it, so its
+		// node already exists
+		m_groupStack.clear();
+		int groupNode = FindSceneGroupNode(record.groupKey);
+		if (groupNode != SceneGraph::NO_PARENT)
+		{
+			m_groupStack.push_back(groupNode);
+		}
 
+		if (record.type == SceneFile::RECORD_GROUP)
+		{
+			BeginSceneGroup(record.name, record.positionXYZ);
+			m_sceneGroups.back().key = record.key;
+			m_recordHandles.push_back(noObject);
+		}
+		else
+		{
+			m_recordHandles.push_back(AddSceneObject(
+				record.name,
+				record.meshType,
+				record.modelFile,
+				record.scaleXYZ,
+				record.XrotationDegrees,
+				record.YrotationDegrees,
+				record.ZrotationDegrees,
+				record.positionXYZ,
+				record.color,
+				record.textureTag,
+				record.materialTag,
+				record.bDrawLines));
+		}
+	}
 
-	//Back left table leg
+	m_groupStack.clear();
+	m_sceneRecords = records;
+}
 
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.5f, 3.0f, 0.5f);
+/***********************************************************
+ *  ApplySceneChanges()
+ *
+ *  This method is used for bringing the scene up to date
+ *  with a new version of the scene file without rebuilding
+ *  it.  Records are matched by key - changed records update
+ *  their object in place, new records add an object and
+ *  missing records remove theirs, so only the objects that
+ *  were edited are touched.  Adding, removing or moving a
+ *  group changes the structure of the scene graph, which is
+ *  left to a full rebuild.
+ ***********************************************************/
+bool SceneManager::ApplySceneChanges(const std::vector<SceneFile::SCENE_RECORD>& records)
+{
+	// the group keys hold the whole group path, so equal key
+	// lists mean an equal group structure
+	std::vector<std::string> oldGroupKeys;
+	std::vector<std::string> newGroupKeys;
+	for (size_t i = 0; i < m_sceneRecords.size(); i++)
+	{
+		if (m_sceneRecords[i].type == SceneFile::RECORD_GROUP)
+		{
+			oldGroupKeys.push_back(m_sceneRecords[i].key);
+		}
+	}
+	for (size_t i = 0; i < records.size(); i++)
+	{
+		if (records[i].type == SceneFile::RECORD_GROUP)
+		{
+			newGroupKeys.push_back(records[i].key);
+		}
+	}
+	if (oldGroupKeys != newGroupKeys)
+	{
+		return(false);
+	}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	std::map<std::string, size_t> oldRecordIndices;
+	for (size_t i = 0; i < m_sceneRecords.size(); i++)
+	{
+		oldRecordIndices[m_sceneRecords[i].key] = i;
+	}
 
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(18.0f, 1.5f, -7.0f);
+	SceneObjectStore::OBJECT_HANDLE noObject;
+	noObject.slot = SceneObjectStore::INVALID_INDEX;
+	noObject.generation = 0;
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	SceneObjectStore::COMPONENT_ARRAYS& objects = m_sceneObjects.GetComponents();
+	std::vector<SceneObjectStore::OBJECT_HANDLE> recordHandles(records.size(), noObject);
+	std::vector<bool> bMatched(m_sceneRecords.size(), false);
+	int numChanged = 0;
+	int numAdded = 0;
 
-	// set the color values into the shader
-	SetShaderColor(1.000, 1.000, 1.000, 1);
+	// the appearance of the objects is only sent to the GPU
+	// culler when the objects are given to it, and only put
+	// in the static batches when they are built
+	m_bGpuObjectsDirty = true;
+	m_bStaticObjectsDirty = true;
+	int numRemoved = 0;
 
+	for (size_t i = 0; i < records.size(); i++)
+	{
+		const SceneFile::SCENE_RECORD& record = records[i];
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
+		std::map<std::string, size_t>::const_iterator found = oldRecordIndices.find(record.key);
+		if (found == oldRecordIndices.end())
+		{
+			// only object records can be new at this point
+			m_groupStack.clear();
+			int groupNode = FindSceneGroupNode(record.groupKey);
+			if (groupNode != SceneGraph::NO_PARENT)
+			{
+				m_groupStack.push_back(groupNode);
+			}
+			recordHandles[i] = AddSceneObject(
+				record.name,
+				record.meshType,
+				record.modelFile,
+				record.scaleXYZ,
+				record.XrotationDegrees,
+				record.YrotationDegrees,
+				record.ZrotationDegrees,
+				record.positionXYZ,
+				record.color,
+				record.textureTag,
+				record.materialTag,
+				record.bDrawLines);
+			m_groupStack.clear();
+			numAdded++;
+			continue;
+		}
 
-	m_basicMeshes->DrawBoxMeshLines();
+		const SceneFile::SCENE_RECORD& oldRecord = m_sceneRecords[found->second];
+		bMatched[found->second] = true;
 
+		if (record.type == SceneFile::RECORD_GROUP)
+		{
+			if (record.positionXYZ != oldRecord.positionXYZ)
+			{
+				m_sceneGraph.SetLocalTransform(
+					FindSceneGroupNode(record.key),
+					glm::vec3(1.0f, 1.0f, 1.0f),
+					0.0f,
+					0.0f,
+					0.0f,
+					record.positionXYZ);
+				numChanged++;
+			}
+			continue;
+		}
 
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
+		recordHandles[i] = m_recordHandles[found->second];
+		uint32_t index = m_sceneObjects.GetDenseIndex(recordHandles[i]);
+		if (index == SceneObjectStore::INVALID_INDEX)
+		{
+			// the object was removed by the application
+			continue;
+		}
 
+		bool bChanged = false;
+		if (SceneFile::IsSameTransform(record, oldRecord) == false)
+		{
+			m_sceneGraph.SetLocalTransform(
+				objects.sceneNodes[index],
+				record.scaleXYZ,
+				record.XrotationDegrees,
+				record.YrotationDegrees,
+				record.ZrotationDegrees,
+				record.positionXYZ);
+			bChanged = true;
+		}
+		if (SceneFile::IsSameAppearance(record, oldRecord) == false)
+		{
+			MESH_TYPE meshType = record.meshType;
+			int modelIndex = -1;
+			if (meshType == MESH_MODEL)
+			{
+				modelIndex = LoadModel(record.modelFile);
+				if (modelIndex < 0)
+				{
+					meshType = MESH_BOX;
+				}
+			}
+			objects.meshTypes[index] = (uint8_t)meshType;
+			objects.modelIndices[index] = modelIndex;
+			objects.textureSlots[index] = -1;
+			if (record.textureTag.empty() == false)
+			{
+				objects.textureSlots[index] = FindTextureSlot(record.textureTag);
+			}
+			objects.materialIndices[index] = FindMaterialIndex(record.materialTag);
+			objects.colors[index] = record.color;
+			if (record.bDrawLines == true)
+			{
+				objects.flags[index] |= SceneObjectStore::OBJECT_DRAW_LINES;
+			}
+			else
+			{
+				objects.flags[index] &= ~SceneObjectStore::OBJECT_DRAW_LINES;
+			}
+			bChanged = true;
+		}
+		if (bChanged == true)
+		{
+			numChanged++;
+		}
+	}
 
-	//Back right table leg
+	for (size_t i = 0; i < m_sceneRecords.size(); i++)
+	{
+		if ((bMatched[i] == false) && (m_sceneRecords[i].type == SceneFile::RECORD_OBJECT))
+		{
+			RemoveSceneObject(m_recordHandles[i]);
+			numRemoved++;
+		}
+	}
 
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.5f, 3.0f, 0.5f);
+	m_sceneRecords = records;
+	m_recordHandles = recordHandles;
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	std::cout << "Reloaded scene file:" << m_sceneFilePath << ", changed:" << numChanged << ", added:" << numAdded << ", removed:" << numRemoved << std::endl;
+	return(true);
+}
 
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(12.0f, 1.5f, -7.0f);
+/***********************************************************
+ *  ReloadTexture()
+ *
+ *  This method is used for reading the image file of a
+ *  loaded texture again into the same OpenGL texture, so the
+ *  texture slot and the objects using it stay the same.  If
+ *  the image can't be read the old image is kept.
+ ***********************************************************/
+bool SceneManager::ReloadTexture(int textureSlot)
+{
+	if ((textureSlot < 0) || (textureSlot >= m_loadedTextures))
+	{
+		return(false);
+	}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	bool bReturn = LoadTextureImage(
+		m_textureIDs[textureSlot].ID,
+		m_textureIDs[textureSlot].filename.c_str());
 
-	// set the color values into the shader
-	SetShaderColor(1.000, 1.000, 1.000, 1);
+	// loading unbinds the texture of the active slot
+	BindGLTextures();
+	m_staticVersion++;
+	return(bReturn);
+}
 
+/***********************************************************
+ *  GetSourceFiles()
+ *
+ *  This method is used for getting the paths of the texture
+ *  images and the scene file the scene was loaded from.
+ ***********************************************************/
+void SceneManager::GetSourceFiles(std::vector<std::string>& files) const
+{
+	files.clear();
+	for (int i = 0; i < m_loadedTextures; i++)
+	{
+		files.push_back(m_textureIDs[i].filename);
+	}
+	if (m_sceneFilePath.empty() == false)
+	{
+		files.push_back(m_sceneFilePath);
+	}
+}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
+/***********************************************************
+ *  GetAssetFiles()
+ *
+ *  This method is used for getting the paths of every file
+ *  the scene is loaded from - the texture images, the scene
+ *  file and the model files it uses - for building the asset
+ *  archive.  It needs no OpenGL context.
+ ***********************************************************/
+bool SceneManager::GetAssetFiles(std::vector<std::string>& files)
+{
+	for (size_t i = 0; i < sizeof(g_SceneTextures) / sizeof(g_SceneTextures[0]); i++)
+	{
+		files.push_back(g_SceneTextures[i].filename);
+	}
+	files.push_back(g_SceneFileName);
+	OcclusionCuller::GetShaderFiles(files);
+	GpuCuller::GetShaderFiles(files);
+	StaticLayerCache::GetShaderFiles(files);
 
-	m_basicMeshes->DrawBoxMeshLines();
+	std::vector<SceneFile::SCENE_RECORD> records;
+	if (SceneFile::LoadFile(g_SceneFileName, records) == false)
+	{
+		return(false);
+	}
+	for (size_t i = 0; i < records.size(); i++)
+	{
+		if ((records[i].meshType == MESH_MODEL) &&
+			(std::find(files.begin(), files.end(), records[i].modelFile) == files.end()))
+		{
+			files.push_back(records[i].modelFile);
+		}
+	}
+	return(true);
+}
 
+/***********************************************************
+ *  ReloadSourceFile()
+ *
+ *  This method is used for bringing the scene up to date
+ *  after one of its texture images or its scene file was
+ *  saved.  A scene file with an error is ignored and the
+ *  current scene kept, so a half-finished edit does no harm.
+ ***********************************************************/
+bool SceneManager::ReloadSourceFile(const std::string& filePath)
+{
+	if (filePath == m_sceneFilePath)
+	{
+		std::vector<SceneFile::SCENE_RECORD> records;
+		if (SceneFile::LoadFile(filePath.c_str(), records) == false)
+		{
+			std::cout << "Keeping the current scene" << std::endl;
+			return(true);
+		}
 
+		if (ApplySceneChanges(records) == false)
+		{
+			BuildScene(records);
+			std::cout << "Rebuilt scene from file:" << m_sceneFilePath << ", objects:" << m_sceneObjects.GetCount() << std::endl;
+		}
+		return(true);
+	}
 
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
+	for (int i = 0; i < m_loadedTextures; i++)
+	{
+		if (m_textureIDs[i].filename == filePath)
+		{
+			ReloadTexture(i);
+			return(true);
+		}
+	}
 
+	return(false);
+}
 
-	//Front left table leg
+/***********************************************************
+ *  FindSceneGroupNode()
+ *
+ *  This method is used for getting the scene graph node of
+ *  the group with the passed in record key.  An empty key is
+ *  the top of the scene, which has no node.
+ ***********************************************************/
+int SceneManager::FindSceneGroupNode(const std::string& key) const
+{
+	if (key.empty() == true)
+	{
+		return(SceneGraph::NO_PARENT);
+	}
 
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.5f, 3.0f, 0.5f);
+	for (size_t i = 0; i < m_sceneGroups.size(); i++)
+	{
+		if (m_sceneGroups[i].key == key)
+		{
+			return(m_sceneGroups[i].sceneNode);
+		}
+	}
+	return(SceneGraph::NO_PARENT);
+}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+/***********************************************************
+ *  AddSceneObject()
+ *
+ *  This method is used for adding one object to the scene.
+ *  An empty texture tag draws the object with its color.  A
+ *  model file that can't be imported is drawn as a box, so
+ *  the object still shows where it was placed.
+ ***********************************************************/
+SceneObjectStore::OBJECT_HANDLE SceneManager::AddSceneObject(
+	std::string name,
+	MESH_TYPE meshType,
+	std::string modelFile,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ,
+	glm::vec4 color,
+	std::string textureTag,
+	std::string materialTag,
+	bool bDrawLines)
+{
+	// look up the texture slot and material once, rather
+	// than by tag every frame
+	int textureSlot = -1;
+	if (textureTag.empty() == false)
+	{
+		textureSlot = FindTextureSlot(textureTag);
+	}
+	int materialIndex = FindMaterialIndex(materialTag);
 
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(18.0f, 1.5f, -7.0f);
+	int modelIndex = -1;
+	if (meshType == MESH_MODEL)
+	{
+		modelIndex = LoadModel(modelFile);
+		if (modelIndex < 0)
+		{
+			meshType = MESH_BOX;
+		}
+	}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// the transformation values are relative to the current group
+	int parentNode = m_groupStack.empty() ? SceneGraph::NO_PARENT : m_groupStack.back();
+	int sceneNode = m_sceneGraph.AddNode(
+		parentNode,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
 		positionXYZ);
 
-	// set the color values into the shader
-	SetShaderColor(1.000, 1.000, 1.000, 1);
-
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-
-	m_basicMeshes->DrawBoxMeshLines();
-
-	/****************************************************************/
-	/****************************************************************/
-	/****************************************************************/
-
-
-	//Back bottom table leg
+	uint8_t flags = 0;
+	if (bDrawLines == true)
+	{
+		flags |= SceneObjectStore::OBJECT_DRAW_LINES;
+	}
 
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(5.5f, 0.5f, 0.5f);
+	m_bGpuObjectsDirty = true;
+	m_bStaticObjectsDirty = true;
+	return(m_sceneObjects.AddObject(
+		name,
+		sceneNode,
+		meshType,
+		modelIndex,
+		textureSlot,
+		materialIndex,
+		color,
+		flags));
+}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+/***********************************************************
+ *  RemoveSceneObject()
+ *
+ *  This method is used for removing one object, and its
+ *  scene graph node, from the scene.  Returns false when
+ *  the handle is stale.
+ ***********************************************************/
+bool SceneManager::RemoveSceneObject(SceneObjectStore::OBJECT_HANDLE handle)
+{
+	uint32_t index = m_sceneObjects.GetDenseIndex(handle);
+	if (index == SceneObjectStore::INVALID_INDEX)
+	{
+		return(false);
+	}
 
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(15.0f, 0.25f, -7.0f);
+	m_sceneGraph.RemoveNode(m_sceneObjects.GetComponents().sceneNodes[index]);
+	m_bGpuObjectsDirty = true;
+	m_bStaticObjectsDirty = true;
+	return(m_sceneObjects.RemoveObject(handle));
+}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
+/***********************************************************
+ *  BeginSceneGroup()
+ *
+ *  This method is used for starting a group of scene objects
+ *  that are placed relative to the passed in position.  The
+ *  objects added until EndSceneGroup() move with the group.
+ *  Groups can be nested inside other groups.
+ ***********************************************************/
+void SceneManager::BeginSceneGroup(std::string tag, glm::vec3 positionXYZ)
+{
+	int parentNode = m_groupStack.empty() ? SceneGraph::NO_PARENT : m_groupStack.back();
+
+	SCENE_GROUP sceneGroup;
+	sceneGroup.tag = tag;
+	sceneGroup.key = tag;
+	sceneGroup.sceneNode = m_sceneGraph.AddNode(
+		parentNode,
+		glm::vec3(1.0f, 1.0f, 1.0f),
+		0.0f,
+		0.0f,
+		0.0f,
 		positionXYZ);
 
-	// set the color values into the shader
-	SetShaderColor(1.000, 1.000, 1.000, 1);
-
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-
-	m_basicMeshes->DrawBoxMeshLines();
-
-
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
+	m_sceneGroups.push_back(sceneGroup);
+	m_groupStack.push_back(sceneGroup.sceneNode);
+}
 
+/***********************************************************
+ *  EndSceneGroup()
+ *
+ *  This method is used for ending the current group of scene
+ *  objects.
+ ***********************************************************/
+void SceneManager::EndSceneGroup()
+{
+	if (m_groupStack.empty() == false)
+	{
+		m_groupStack.pop_back();
+	}
+}
 
-	//Back bottom left table leg
+/***********************************************************
+ *  SetSceneGroupTransform()
+ *
+ *  This method is used for moving a whole group of scene
+ *  objects by changing the transformation values of the
+ *  group.  Only the objects in the group are recalculated.
+ ***********************************************************/
+bool SceneManager::SetSceneGroupTransform(
+	std::string tag,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	for (size_t i = 0; i < m_sceneGroups.size(); i++)
+	{
+		if (m_sceneGroups[i].tag.compare(tag) == 0)
+		{
+			m_sceneGraph.SetLocalTransform(
+				m_sceneGroups[i].sceneNode,
+				scaleXYZ,
+				XrotationDegrees,
+				YrotationDegrees,
+				ZrotationDegrees,
+				positionXYZ);
+			return(true);
+		}
+	}
+	return(false);
+}
 
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.5f, 0.5f, 4.5f);
+/***********************************************************
+ *  SetViewProjection()
+ *
+ *  This method is used for passing in the view and
+ *  projection matrices of the frame, which the visibility
+ *  tests and the depth part of the sort keys are based on.
+ ***********************************************************/
+void SceneManager::SetViewProjection(const glm::mat4& view, const glm::mat4& projection)
+{
+	m_viewProjection = projection * view;
+	m_cameraPosition = glm::vec3(glm::inverse(view)[3]);
+	m_bViewProjectionSet = true;
+}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering the 3D scene by 
+ *  transforming and drawing the basic 3D shapes
+ ***********************************************************/
+void SceneManager::RenderScene()
+{
+	// objects culled on the GPU skip the stages below
+	if (NULL != m_pGpuCuller)
+	{
+		UpdateGpuObjects();
+		SubmitGpuDraws();
+		return;
+	}
 
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(18.0f, 0.25f, -5.0f);
+	// take the newest occluder depth the GPU has finished
+	if (NULL != m_pOcclusionCuller)
+	{
+		m_pOcclusionCuller->BeginFrame();
+	}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// evaluate every object on all cores
+	UpdateSceneObjects();
 
-	// set the color values into the shader
-	SetShaderColor(1.000, 1.000, 1.000, 1);
+	// find the objects that don't move, for the static batches
+	// and the static layer
+	UpdateStaticObjects();
 
+	// merge the visible objects into one sorted draw list
+	BuildDrawList();
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
+	// send the draw list to OpenGL on this thread
+	SubmitDrawList();
 
-	m_basicMeshes->DrawBoxMeshLines();
+	// draw the occluders for the tests of the coming frames
+	DrawOccluders();
+}
 
+/***********************************************************
+ *  UpdateSceneObjects()
+ *
+ *  This method is used for calculating the per-frame data of
+ *  every scene object - model matrix, world bounds, frustum
+ *  and occlusion visibility and draw sort key.  Each object only writes
+ *  its own array entries, so the ranges are evaluated in
+ *  parallel by the job system without any locking.  Within
+ *  a range each pass runs over the whole range in turn, so
+ *  it streams through just the component arrays it uses.
+ ***********************************************************/
+void SceneManager::UpdateSceneObjects()
+{
+	SceneObjectStore::COMPONENT_ARRAYS& objects = m_sceneObjects.GetComponents();
+	size_t numObjects = m_sceneObjects.GetCount();
+
+	// recalculate the world matrices of the groups and objects
+	// that changed since the last frame
+	m_updatedNodes.clear();
+	size_t numNodesUpdated = m_sceneGraph.UpdateWorldMatrices(&m_updatedNodes);
+	if (NULL != GetRenderStats())
+	{
+		GetRenderStats()->CountTransformUpdates((uint32_t)numNodesUpdated);
+	}
 
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
+	// the frustum planes are shared by every job
+	glm::vec4 frustumPlanes[6];
+	ExtractFrustumPlanes(m_viewProjection, frustumPlanes);
+	bool bCull = m_bViewProjectionSet;
+	const OcclusionCuller* pOcclusionCuller = (bCull == true) ? m_pOcclusionCuller : NULL;
 
+	m_pJobSystem->ParallelFor(numObjects, OBJECTS_PER_JOB,
+		[this, &objects, &frustumPlanes, bCull, pOcclusionCuller](size_t begin, size_t end)
+		{
+			// transform evaluation
+			for (size_t i = begin; i < end; i++)
+			{
+				objects.models[i] = m_sceneGraph.GetWorldMatrix(objects.sceneNodes[i]);
+			}
+
+			// bounds update
+			for (size_t i = begin; i < end; i++)
+			{
+				// the basic shape meshes fit in the box [-1, 1]
+				glm::vec3 localMin(-1.0f);
+				glm::vec3 localMax(1.0f);
+				if (objects.modelIndices[i] >= 0)
+				{
+					localMin = m_models[objects.modelIndices[i]].boundsMin;
+					localMax = m_models[objects.modelIndices[i]].boundsMax;
+				}
+				ComputeWorldBounds(objects.models[i], localMin, localMax, objects.boundsMin[i], objects.boundsMax[i]);
+			}
+
+			// visibility test
+			for (size_t i = begin; i < end; i++)
+			{
+				bool bVisible = true;
+				bool bOccluded = false;
+				if (bCull == true)
+				{
+					bVisible = IsBoxInFrustum(frustumPlanes, objects.boundsMin[i], objects.boundsMax[i]);
+				}
+				if ((bVisible == true) && (NULL != pOcclusionCuller))
+				{
+					bOccluded = pOcclusionCuller->IsBoxOccluded(objects.boundsMin[i], objects.boundsMax[i]);
+					bVisible = !bOccluded;
+				}
+				objects.flags[i] &= ~(SceneObjectStore::OBJECT_VISIBLE | SceneObjectStore::OBJECT_OCCLUDED);
+				if (bVisible == true)
+				{
+					objects.flags[i] |= SceneObjectStore::OBJECT_VISIBLE;
+				}
+				else if (bOccluded == true)
+				{
+					objects.flags[i] |= SceneObjectStore::OBJECT_OCCLUDED;
+				}
+			}
+
+			// sort key generation
+			for (size_t i = begin; i < end; i++)
+			{
+				if ((objects.flags[i] & SceneObjectStore::OBJECT_VISIBLE) != 0)
+				{
+					objects.sortKeys[i] = ComputeSortKey(
+						objects.textureSlots[i],
+						objects.materialIndices[i],
+						(MESH_TYPE)objects.meshTypes[i],
+						objects.modelIndices[i],
+						objects.boundsMin[i],
+						objects.boundsMax[i]);
+				}
+			}
+		});
+}
 
-	//Back bottom left table leg
+/***********************************************************
+ *  BuildDrawList()
+ *
+ *  This method is used for merging the visible objects into
+ *  one draw list ordered by sort key, so objects sharing a
+ *  texture, material and mesh are drawn back to back.  The
+ *  objects in the static batches are drawn with their batch.
+ ***********************************************************/
+void SceneManager::BuildDrawList()
+{
+	const SceneObjectStore::COMPONENT_ARRAYS& objects = m_sceneObjects.GetComponents();
+	size_t numObjects = m_sceneObjects.GetCount();
 
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.5f, 0.5f, 4.5f);
+	m_drawList.clear();
+	uint32_t numVisible = 0;
+	uint32_t numOccluded = 0;
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	for (size_t i = 0; i < numObjects; i++)
+	{
+		if ((objects.flags[i] & SceneObjectStore::OBJECT_VISIBLE) != 0)
+		{
+			numVisible++;
+			if ((objects.flags[i] & SceneObjectStore::OBJECT_STATIC) != 0)
+			{
+				continue;
+			}
+
+			DRAW_ITEM drawItem;
+			drawItem.sortKey = objects.sortKeys[i];
+			drawItem.objectIndex = (uint32_t)i;
+			m_drawList.push_back(drawItem);
+		}
+		else if ((objects.flags[i] & SceneObjectStore::OBJECT_OCCLUDED) != 0)
+		{
+			numOccluded++;
+		}
+	}
 
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(12.0f, 0.25f, -5.0f);
+	std::sort(m_drawList.begin(), m_drawList.end(),
+		[](const DRAW_ITEM& a, const DRAW_ITEM& b)
+		{
+			if (a.sortKey != b.sortKey)
+				return(a.sortKey < b.sortKey);
+			return(a.objectIndex < b.objectIndex);
+		});
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	if (NULL != GetRenderStats())
+	{
+		GetRenderStats()->CountCulling(numVisible, (uint32_t)numObjects - numVisible);
+		GetRenderStats()->CountOcclusion(numOccluded);
+	}
+}
 
-	// set the color values into the shader
-	SetShaderColor(1.000, 1.000, 1.000, 1);
+/***********************************************************
+ *  SubmitDrawList()
+ *
+ *  This method is used for sending the draw list to OpenGL.
+ *  Shader values are only written when they differ from the
+ *  previous draw, which the sorted order makes the usual case.
+ ***********************************************************/
+void SceneManager::SubmitDrawList()
+{
+	size_t numBatches = (NULL != m_pStaticBatcher) ? m_pStaticBatcher->GetBatchCount() : 0;
+	if ((NULL == m_pShaderManager) || ((m_drawList.empty()) && (numBatches == 0)))
+	{
+		return;
+	}
 
+	const SceneObjectStore::COMPONENT_ARRAYS& objects = m_sceneObjects.GetComponents();
+	size_t numDraws = m_drawList.size();
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
+	// get this frame's part of the object buffer, with the
+	// blocks of the static batches after those of the draws
+	float waitMilliseconds = 0.0f;
+	unsigned char* pFrameData = (unsigned char*)m_pObjectBuffer->BeginFrame(
+		(numDraws + numBatches) * m_objectBlockStride,
+		waitMilliseconds);
+	if (NULL == pFrameData)
+	{
+		return;
+	}
+	if (NULL != GetRenderStats())
+	{
+		if (waitMilliseconds > 0.0f)
+		{
+			GetRenderStats()->CountFenceWait(waitMilliseconds);
+		}
+		GetRenderStats()->CountUpload((numDraws + numBatches) * sizeof(OBJECT_BLOCK));
+	}
 
-	m_basicMeshes->DrawBoxMeshLines();
+	// write the values of each draw into its own block, on all
+	// cores.  Every block is built locally and copied whole, as
+	// the mapped memory is slow to read and best written in order
+	bool bPackedVertices = m_basicMeshes->IsPackedVertices();
+	m_pJobSystem->ParallelFor(numDraws, OBJECTS_PER_JOB,
+		[this, pFrameData, bPackedVertices](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				OBJECT_BLOCK block;
+				FillObjectBlock(m_drawList[i].objectIndex, bPackedVertices, block);
+				memcpy(pFrameData + i * m_objectBlockStride, &block, sizeof(OBJECT_BLOCK));
+			}
+		});
+	for (size_t i = 0; i < numBatches; i++)
+	{
+		const StaticBatcher::BATCH& batch = m_pStaticBatcher->GetBatch(i);
+		int materialIndex = batch.materialIndex;
+
+		// the vertices are in world space already
+		OBJECT_BLOCK block = OBJECT_BLOCK();
+		block.model = m_pStaticBatcher->GetPositionDecode(i);
+		block.color = batch.color;
+		if (materialIndex >= 0)
+		{
+			block.diffuseColor = m_objectMaterials[materialIndex].diffuseColor;
+			block.specularColor = m_objectMaterials[materialIndex].specularColor;
+			block.shininess = m_objectMaterials[materialIndex].shininess;
+		}
+		block.bUseTexture = (batch.textureSlot >= 0) ? 1 : 0;
+		memcpy(pFrameData + (numDraws + i) * m_objectBlockStride, &block, sizeof(OBJECT_BLOCK));
+	}
 
+	// cull the meshlets of the large models on all cores, each
+	// draw into its own range list.  The lists only ever grow,
+	// so their memory is reused from frame to frame
+	if (m_drawMeshletRanges.size() < numDraws)
+	{
+		m_drawMeshletRanges.resize(numDraws);
+	}
+	m_drawMeshletCounts.assign(numDraws, NO_MESHLETS);
+	if ((m_bMeshletCulling == true) && (m_bViewProjectionSet == true))
+	{
+		m_pJobSystem->ParallelFor(numDraws, OBJECTS_PER_JOB,
+			[this, &objects](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					int modelIndex = objects.modelIndices[m_drawList[i].objectIndex];
+					if ((modelIndex >= 0) && (m_models[modelIndex].meshlets.ranges.empty() == false))
+					{
+						m_drawMeshletCounts[i] = MeshletCuller::CullMeshlets(
+							m_models[modelIndex].meshlets,
+							objects.models[m_drawList[i].objectIndex],
+							m_viewProjection,
+							m_cameraPosition,
+							true,
+							m_drawMeshletRanges[i]);
+					}
+				}
+			});
+	}
+	m_pObjectBuffer->EndWrites();
 
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
+	GLuint bufferID = m_pObjectBuffer->GetBufferID();
+	size_t frameOffset = m_pObjectBuffer->GetFrameOffset();
 
+	// the texture slot is the only value still set as a plain
+	// uniform, and the draws are sorted by it
+	int currentTextureSlot = -1;
+	m_pShaderManager->setBoolValue(g_OctahedralNormalsName, bPackedVertices);
 
-	//Back bottom table leg
+	if (NULL == m_pStaticLayerCache)
+	{
+		if (numBatches > 0)
+		{
+			SubmitStaticBatches(bufferID, frameOffset + numDraws * m_objectBlockStride, currentTextureSlot);
+		}
+		SubmitDraws(bufferID, frameOffset, currentTextureSlot, true, true);
+	}
+	else
+	{
+		// the layer is drawn again when the view, the objects in
+		// it, or the ones of them that passed the culling change
+		StaticLayerCache::LAYER_KEY layerKey;
+		layerKey.viewProjection = m_viewProjection;
+		layerKey.cameraPosition = m_cameraPosition;
+		layerKey.sceneVersion = m_staticVersion;
+		layerKey.drawHash = 14695981039346656037ULL;
+		for (size_t i = 0; i < numDraws; i++)
+		{
+			if (IsStaticLayerObject(m_drawList[i].objectIndex) == true)
+			{
+				layerKey.drawHash = (layerKey.drawHash ^ m_drawList[i].objectIndex) * 1099511628211ULL;
+			}
+		}
 
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(5.5f, 0.5f, 0.5f);
+		bool bReused = m_pStaticLayerCache->IsValid(layerKey);
+		if (bReused == false)
+		{
+			m_pStaticLayerCache->BeginLayer(layerKey);
+			if (numBatches > 0)
+			{
+				SubmitStaticBatches(bufferID, frameOffset + numDraws * m_objectBlockStride, currentTextureSlot);
+			}
+			SubmitDraws(bufferID, frameOffset, currentTextureSlot, true, false);
+			m_pStaticLayerCache->EndLayer();
+		}
+		if (NULL != GetRenderStats())
+		{
+			GetRenderStats()->CountStaticLayer(bReused);
+		}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+		// the moving objects are depth tested against the layer
+		m_pStaticLayerCache->DrawLayer();
+		m_pShaderManager->use();
+		SubmitDraws(bufferID, frameOffset, currentTextureSlot, false, true);
+	}
 
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(15.0f, 0.25f, -3.0f);
+	// the GPU is done with this frame's part once it passes here
+	m_pObjectBuffer->EndFrame();
+}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+/***********************************************************
+ *  IsStaticLayerObject()
+ *
+ *  This method is used for checking whether an object is
+ *  drawn in the static layer - it hasn't moved, and it is
+ *  opaque, as the transparent objects have to be drawn after
+ *  every object behind them.
+ ***********************************************************/
+bool SceneManager::IsStaticLayerObject(uint32_t objectIndex) const
+{
+	const SceneObjectStore::COMPONENT_ARRAYS& objects = m_sceneObjects.GetComponents();
 
-	// set the color values into the shader
-	SetShaderColor(1.00, 1.000, 1.000, 1);
+	return(((objects.flags[objectIndex] & SceneObjectStore::OBJECT_MOVED) == 0) &&
+		(objects.colors[objectIndex].a >= 1.0f));
+}
 
+/***********************************************************
+ *  SubmitDraws()
+ *
+ *  This method is used for drawing the items of the draw
+ *  list in the static layer, the dynamic layer or both, each
+ *  with its object block in this frame's part of the object
+ *  buffer.  Without the static layer cache every item is
+ *  drawn in one pass.
+ ***********************************************************/
+void SceneManager::SubmitDraws(GLuint bufferID, size_t frameOffset, int& currentTextureSlot, bool bStaticLayer, bool bDynamicLayer)
+{
+	const SceneObjectStore::COMPONENT_ARRAYS& objects = m_sceneObjects.GetComponents();
+	size_t numDraws = m_drawList.size();
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
+	// every mesh lives in the one geometry pool, so the vertex
+	// array is bound once for the whole list
+	m_basicMeshes->BindMeshes();
 
-	m_basicMeshes->DrawBoxMeshLines();
+	for (size_t i = 0; i < numDraws; i++)
+	{
+		uint32_t objectIndex = m_drawList[i].objectIndex;
 
+		// with both layers every item is drawn
+		if ((bStaticLayer != bDynamicLayer) &&
+			(IsStaticLayerObject(objectIndex) != bStaticLayer))
+		{
+			continue;
+		}
 
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
+		int textureSlot = objects.textureSlots[objectIndex];
+		MESH_TYPE meshType = (MESH_TYPE)objects.meshTypes[objectIndex];
+		int modelIndex = objects.modelIndices[objectIndex];
+
+		// point the object block of the shaders at this draw's values
+		glBindBufferRange(
+			GL_UNIFORM_BUFFER,
+			OBJECT_BLOCK_BINDING,
+			bufferID,
+			frameOffset + i * m_objectBlockStride,
+			sizeof(OBJECT_BLOCK));
+		if (NULL != GetRenderStats())
+		{
+			GetRenderStats()->CountBufferBind();
+		}
 
+		if ((textureSlot >= 0) && (textureSlot != currentTextureSlot))
+		{
+			m_pShaderManager->setSampler2DValue(g_TextureValueName, textureSlot);
+			currentTextureSlot = textureSlot;
+		}
 
-	//Lamp base
+		// draw the mesh with transformation values
+		if (m_drawMeshletCounts[i] != NO_MESHLETS)
+			DrawModelMeshlets(modelIndex, i);
+		else
+			DrawMesh(meshType, modelIndex);
+		if ((objects.flags[objectIndex] & SceneObjectStore::OBJECT_DRAW_LINES) != 0)
+		{
+			DrawMeshLines(meshType, modelIndex);
+		}
+	}
+}
 
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(1.5f, 0.08f, 1.5f);
+/***********************************************************
+ *  DrawOccluders()
+ *
+ *  This method is used for drawing the large opaque objects
+ *  inside the view into the occlusion buffer.  Objects that
+ *  were hidden this frame are drawn as well, as they still
+ *  hide whatever is behind them.
+ ***********************************************************/
+void SceneManager::DrawOccluders()
+{
+	if ((NULL == m_pOcclusionCuller) || (m_bViewProjectionSet == false))
+	{
+		return;
+	}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	const SceneObjectStore::COMPONENT_ARRAYS& objects = m_sceneObjects.GetComponents();
+	size_t numObjects = m_sceneObjects.GetCount();
+	bool bPackedVertices = m_basicMeshes->IsPackedVertices();
 
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(15.0f, 3.55f, -5.75f);
+	m_pOcclusionCuller->BeginOccluderPass(m_viewProjection);
+	m_basicMeshes->BindMeshes();
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	for (size_t i = 0; i < numObjects; i++)
+	{
+		if (((objects.flags[i] & (SceneObjectStore::OBJECT_VISIBLE | SceneObjectStore::OBJECT_OCCLUDED)) == 0) ||
+			(objects.colors[i].a < 1.0f))
+		{
+			continue;
+		}
+
+		// the two largest sides are the two after the smallest
+		glm::vec3 extents = objects.boundsMax[i] - objects.boundsMin[i];
+		float smallest = std::min(extents.x, std::min(extents.y, extents.z));
+		float middle = extents.x + extents.y + extents.z - smallest -
+			std::max(extents.x, std::max(extents.y, extents.z));
+		if (middle < OCCLUDER_MIN_SIZE)
+		{
+			continue;
+		}
 
-	// set the color values into the shader
-	SetShaderColor(0.392, 0.584, 0.929, 1);
+		MESH_TYPE meshType = (MESH_TYPE)objects.meshTypes[i];
+		int modelIndex = objects.modelIndices[i];
+		glm::mat4 model = objects.models[i];
+		if (bPackedVertices == true)
+		{
+			if (modelIndex >= 0)
+				model = model * m_models[modelIndex].decode;
+			else
+				model = model * m_meshDecodes[meshType];
+		}
+		m_pOcclusionCuller->SetOccluderTransform(m_viewProjection * model);
+		DrawMesh(meshType, modelIndex);
+	}
 
+	m_pOcclusionCuller->EndOccluderPass();
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
+	// the scene shader program draws the rest of the frame
+	m_pShaderManager->use();
+}
 
-	m_basicMeshes->DrawBoxMeshLines();
+/***********************************************************
+ *  FillObjectBlock()
+ *
+ *  This method is used for filling the shader values of one
+ *  object, from its model matrix, color, material and
+ *  texture, safe on any thread.
+ ***********************************************************/
+void SceneManager::FillObjectBlock(uint32_t objectIndex, bool bPackedVertices, OBJECT_BLOCK& block) const
+{
+	const SceneObjectStore::COMPONENT_ARRAYS& objects = m_sceneObjects.GetComponents();
+	int materialIndex = objects.materialIndices[objectIndex];
 
+	// value initialized, so the padding is zero as well
+	block = OBJECT_BLOCK();
+	block.model = objects.models[objectIndex];
+	if (bPackedVertices == true)
+	{
+		// packed positions are relative to the mesh bounds
+		int modelIndex = objects.modelIndices[objectIndex];
+		if (modelIndex >= 0)
+			block.model = block.model * m_models[modelIndex].decode;
+		else
+			block.model = block.model * m_meshDecodes[objects.meshTypes[objectIndex]];
+	}
+	block.color = objects.colors[objectIndex];
+	if (materialIndex >= 0)
+	{
+		block.diffuseColor = m_objectMaterials[materialIndex].diffuseColor;
+		block.specularColor = m_objectMaterials[materialIndex].specularColor;
+		block.shininess = m_objectMaterials[materialIndex].shininess;
+	}
+	// an untextured object is drawn with its color
+	block.bUseTexture = (objects.textureSlots[objectIndex] >= 0) ? 1 : 0;
+}
 
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
+/***********************************************************
+ *  UpdateStaticObjects()
+ *
+ *  This method is used for keeping track of the objects that
+ *  don't move, for the static batches and the static layer.
+ *  An object that is moved at run time is marked as moved
+ *  for good, which takes it out of the batches and the layer
+ *  to be drawn on its own, and the batches are built again
+ *  whenever anything changed.
+ ***********************************************************/
+void SceneManager::UpdateStaticObjects()
+{
+	if ((NULL == m_pStaticBatcher) && (NULL == m_pStaticLayerCache))
+	{
+		return;
+	}
 
-	//Lamp stand
+	// the nodes of a scene change are updated along with it,
+	// and the objects they belong to still don't move
+	SceneObjectStore::COMPONENT_ARRAYS& objects = m_sceneObjects.GetComponents();
+	if (m_bStaticObjectsDirty == false)
+	{
+		for (size_t i = 0; i < m_updatedNodes.size(); i++)
+		{
+			int node = m_updatedNodes[i];
+			if (((size_t)node >= m_nodeObjects.size()) ||
+				(m_nodeObjects[node] == SceneObjectStore::INVALID_INDEX))
+			{
+				continue;
+			}
+
+			uint32_t objectIndex = m_nodeObjects[node];
+			if ((objects.flags[objectIndex] & SceneObjectStore::OBJECT_MOVED) == 0)
+			{
+				objects.flags[objectIndex] &= ~SceneObjectStore::OBJECT_STATIC;
+				objects.flags[objectIndex] |= SceneObjectStore::OBJECT_MOVED;
+				m_bStaticObjectsDirty = true;
+			}
+		}
+	}
 
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.15f, 3.0f, 0.15f);
+	if (m_bStaticObjectsDirty == true)
+	{
+		size_t numObjects = m_sceneObjects.GetCount();
+		m_nodeObjects.assign(m_sceneGraph.GetNodeCount(), SceneObjectStore::INVALID_INDEX);
+		for (size_t i = 0; i < numObjects; i++)
+		{
+			m_nodeObjects[objects.sceneNodes[i]] = (uint32_t)i;
+		}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+		if (NULL != m_pStaticBatcher)
+		{
+			BuildStaticBatches();
+		}
+		m_staticVersion++;
+		m_bStaticObjectsDirty = false;
+	}
+}
 
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(15.0f, 5.0f, -5.75f);
+/***********************************************************
+ *  BuildStaticBatches()
+ *
+ *  This method is used for merging every object that has
+ *  not moved into the static batches, with the model matrix
+ *  from this frame's update.  Transparent objects are left
+ *  out as they are drawn in the order of the draw list, and
+ *  so are the models culled by meshlet.
+ ***********************************************************/
+void SceneManager::BuildStaticBatches()
+{
+	SceneObjectStore::COMPONENT_ARRAYS& objects = m_sceneObjects.GetComponents();
+	size_t numObjects = m_sceneObjects.GetCount();
+	const GeometryPool* pGeometryPool = m_basicMeshes->GetGeometryPool();
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	m_pStaticBatcher->Clear();
 
-	// set the color values into the shader
-	SetShaderColor(0.392, 0.584, 0.929, 1);
+	size_t numBatched = 0;
+	for (size_t i = 0; i < numObjects; i++)
+	{
+		objects.flags[i] &= ~SceneObjectStore::OBJECT_STATIC;
 
+		int modelIndex = objects.modelIndices[i];
+		if (((objects.flags[i] & SceneObjectStore::OBJECT_MOVED) != 0) ||
+			(objects.colors[i].a < 1.0f) ||
+			((m_bMeshletCulling == true) && (modelIndex >= 0) &&
+			 (m_models[modelIndex].meshlets.ranges.empty() == false)))
+		{
+			continue;
+		}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
+		int mesh = (modelIndex >= 0) ? m_models[modelIndex].mesh : GetShapeMeshID((MESH_TYPE)objects.meshTypes[i]);
+		const GeometryPool::MESH_DATA* pMeshData = pGeometryPool->GetMeshData(mesh);
+		if (NULL == pMeshData)
+		{
+			continue;
+		}
 
-	m_basicMeshes->DrawBoxMeshLines();
+		m_pStaticBatcher->AddObject(
+			*pMeshData,
+			objects.models[i],
+			(objects.flags[i] & SceneObjectStore::OBJECT_DRAW_LINES) != 0,
+			objects.textureSlots[i],
+			objects.materialIndices[i],
+			objects.colors[i]);
+		objects.flags[i] |= SceneObjectStore::OBJECT_STATIC;
+		numBatched++;
+	}
+	m_pStaticBatcher->Upload();
 
+	std::cout << "Static batching: " << numBatched << " objects in "
+		<< m_pStaticBatcher->GetBatchCount() << " batches, "
+		<< m_pStaticBatcher->GetMemorySize() << " bytes" << std::endl;
+}
 
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
+/***********************************************************
+ *  SubmitStaticBatches()
+ *
+ *  This method is used for drawing the static batches that
+ *  are in the view, each with the object block written after
+ *  the blocks of the draw list.  They are drawn first, so
+ *  the large surfaces they tend to hold fill the depth
+ *  buffer before the objects drawn on their own.
+ ***********************************************************/
+void SceneManager::SubmitStaticBatches(GLuint bufferID, size_t firstBlockOffset, int& currentTextureSlot)
+{
+	size_t numBatches = m_pStaticBatcher->GetBatchCount();
+	if (numBatches == 0)
+	{
+		return;
+	}
 
-	//Lamp top
+	glm::vec4 frustumPlanes[6];
+	ExtractFrustumPlanes(m_viewProjection, frustumPlanes);
 
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.75f, -1.5f, 0.75f);
+	m_pStaticBatcher->Bind();
+	for (size_t i = 0; i < numBatches; i++)
+	{
+		const StaticBatcher::BATCH& batch = m_pStaticBatcher->GetBatch(i);
+		if ((m_bViewProjectionSet == true) &&
+			(IsBoxInFrustum(frustumPlanes, batch.boundsMin, batch.boundsMax) == false))
+		{
+			continue;
+		}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+		glBindBufferRange(
+			GL_UNIFORM_BUFFER,
+			OBJECT_BLOCK_BINDING,
+			bufferID,
+			firstBlockOffset + i * m_objectBlockStride,
+			sizeof(OBJECT_BLOCK));
 
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(15.0f, 7.6f, -5.75f);
+		if ((batch.textureSlot >= 0) && (batch.textureSlot != currentTextureSlot))
+		{
+			m_pShaderManager->setSampler2DValue(g_TextureValueName, batch.textureSlot);
+			currentTextureSlot = batch.textureSlot;
+		}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+		m_pStaticBatcher->DrawBatch(i);
+		if (batch.numLines > 0)
+		{
+			m_pStaticBatcher->DrawBatchLines(i);
+		}
 
-	// set the color values into the shader
-	SetShaderColor(0.392, 0.584, 0.929, 1);
+		if (NULL != GetRenderStats())
+		{
+			GetRenderStats()->CountBufferBind();
+			GetRenderStats()->CountStaticBatchDraw(false, batch.numTriangles);
+			if (batch.numLines > 0)
+			{
+				GetRenderStats()->CountStaticBatchDraw(true, batch.numLines);
+			}
+		}
+	}
+}
 
+/***********************************************************
+ *  UpdateGpuObjects()
+ *
+ *  This method is used for bringing the objects of the GPU
+ *  culler up to date.  Only the objects below the scene
+ *  graph nodes that changed are visited, unless the objects
+ *  themselves changed and are all given to it again.
+ ***********************************************************/
+void SceneManager::UpdateGpuObjects()
+{
+	m_updatedNodes.clear();
+	size_t numNodesUpdated = m_sceneGraph.UpdateWorldMatrices(&m_updatedNodes);
+	if (NULL != GetRenderStats())
+	{
+		GetRenderStats()->CountTransformUpdates((uint32_t)numNodesUpdated);
+	}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawHalfSphereMesh();
+	if (m_bGpuObjectsDirty == true)
+	{
+		BuildGpuObjects();
+		m_bGpuObjectsDirty = false;
+		return;
+	}
 
-	m_basicMeshes->DrawHalfSphereMeshLines();
+	SceneObjectStore::COMPONENT_ARRAYS& objects = m_sceneObjects.GetComponents();
+	bool bPackedVertices = m_basicMeshes->IsPackedVertices();
+	for (size_t i = 0; i < m_updatedNodes.size(); i++)
+	{
+		int node = m_updatedNodes[i];
+		if (((size_t)node >= m_nodeObjects.size()) ||
+			(m_nodeObjects[node] == SceneObjectStore::INVALID_INDEX))
+		{
+			continue;
+		}
 
+		uint32_t objectIndex = m_nodeObjects[node];
+		objects.models[objectIndex] = m_sceneGraph.GetWorldMatrix(node);
 
-/****************************************************************/
-/****************************************************************/
-/****************************************************************/
+		OBJECT_BLOCK block;
+		FillObjectBlock(objectIndex, bPackedVertices, block);
+		m_pGpuCuller->UpdateObject(objectIndex, &block);
+	}
+}
 
-	//Lamp bulb
+/***********************************************************
+ *  BuildGpuObjects()
+ *
+ *  This method is used for giving the GPU culler the object
+ *  block and draw record of every object.  Each object goes
+ *  in the bucket of its texture slot, so the draws of a
+ *  bucket share one texture, and objects drawn with lines
+ *  go in the lines bucket of the slot as well.
+ ***********************************************************/
+void SceneManager::BuildGpuObjects()
+{
+	SceneObjectStore::COMPONENT_ARRAYS& objects = m_sceneObjects.GetComponents();
+	size_t numObjects = m_sceneObjects.GetCount();
+	bool bPackedVertices = m_basicMeshes->IsPackedVertices();
+	const GeometryPool* pGeometryPool = m_basicMeshes->GetGeometryPool();
 
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.6f, 0.5f, 0.6f);
+	// value initialized, so the padding is zero as well
+	std::vector<OBJECT_BLOCK> blocks(numObjects);
+	std::vector<GpuCuller::DRAW_RECORD> records(numObjects);
+	m_nodeObjects.assign(m_sceneGraph.GetNodeCount(), SceneObjectStore::INVALID_INDEX);
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	for (size_t i = 0; i < numObjects; i++)
+	{
+		MESH_TYPE meshType = (MESH_TYPE)objects.meshTypes[i];
+		int modelIndex = objects.modelIndices[i];
 
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(15.0f, 7.4f, -5.75f);
+		objects.models[i] = m_sceneGraph.GetWorldMatrix(objects.sceneNodes[i]);
+		m_nodeObjects[objects.sceneNodes[i]] = (uint32_t)i;
+		FillObjectBlock((uint32_t)i, bPackedVertices, blocks[i]);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+		int mesh = (modelIndex >= 0) ? m_models[modelIndex].mesh : GetShapeMeshID(meshType);
+		const GeometryPool::MESH_RANGE& range = pGeometryPool->GetMeshRange(mesh);
 
-	// set the color values into the shader
-	SetShaderColor(1.000, 1.000, 0.878, 1);
+		// the box is around the positions as they are stored,
+		// which the model matrix in the object block expects
+		GpuCuller::DRAW_RECORD& record = records[i];
+		if (bPackedVertices == true)
+		{
+			record.boundsMin = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+			record.boundsMax = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+		}
+		else if (modelIndex >= 0)
+		{
+			record.boundsMin = glm::vec4(m_models[modelIndex].boundsMin, 1.0f);
+			record.boundsMax = glm::vec4(m_models[modelIndex].boundsMax, 1.0f);
+		}
+		else
+		{
+			// the basic shape meshes fit in the box [-1, 1]
+			record.boundsMin = glm::vec4(-1.0f, -1.0f, -1.0f, 1.0f);
+			record.boundsMax = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+		}
 
+		uint32_t bucket = 2 * (uint32_t)(objects.textureSlots[i] + 1);
+		record.triangles[0] = (uint32_t)range.numIndices;
+		record.triangles[1] = range.firstIndex;
+		record.triangles[2] = bucket;
+		record.lines[2] = GpuCuller::NO_BUCKET;
+		record.baseVertex[0] = range.baseVertex;
+
+		// the same meshes as DrawShapeMesh() draws lines for
+		bool bLines = ((objects.flags[i] & SceneObjectStore::OBJECT_DRAW_LINES) != 0) &&
+			(HasShapeMeshLines(meshType) == true);
+		if (bLines == true)
+		{
+			record.lines[0] = (uint32_t)range.numLineIndices;
+			record.lines[1] = range.firstLineIndex;
+			record.lines[2] = bucket + 1;
+		}
+	}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawHalfSphereMesh();
+	m_pGpuCuller->SetObjects(blocks.data(), sizeof(OBJECT_BLOCK), records, NUM_GPU_BUCKETS);
+}
 
-	m_basicMeshes->DrawHalfSphereMeshLines();
+/***********************************************************
+ *  SubmitGpuDraws()
+ *
+ *  This method is used for culling the objects on the GPU
+ *  and drawing the commands it wrote, one multi draw per
+ *  used bucket.  The CPU only sets the texture of each
+ *  bucket, whatever the number of objects.
+ ***********************************************************/
+void SceneManager::SubmitGpuDraws()
+{
+	// without a view every object passes
+	glm::vec4 frustumPlanes[6];
+	ExtractFrustumPlanes(m_viewProjection, frustumPlanes);
+	if (m_bViewProjectionSet == false)
+	{
+		for (int i = 0; i < 6; i++)
+		{
+			frustumPlanes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+	}
+	m_pGpuCuller->Cull(frustumPlanes);
 
+	m_pShaderManager->use();
+	m_basicMeshes->BindMeshes();
+	m_pShaderManager->setBoolValue(g_OctahedralNormalsName, m_basicMeshes->IsPackedVertices());
+	m_pGpuCuller->BindBuffers();
 
-	/****************************************************************/
-	/****************************************************************/
-	/****************************************************************/
+	for (uint32_t bucket = 0; bucket < NUM_GPU_BUCKETS; bucket += 2)
+	{
+		if ((m_pGpuCuller->GetBucketCapacity(bucket) == 0) &&
+			(m_pGpuCuller->GetBucketCapacity(bucket + 1) == 0))
+		{
+			continue;
+		}
 
-	//Lamp power button
+		int textureSlot = (int)(bucket / 2) - 1;
+		if (textureSlot >= 0)
+		{
+			m_pShaderManager->setSampler2DValue(g_TextureValueName, textureSlot);
+		}
+		m_pGpuCuller->DrawBucket(bucket, GL_TRIANGLES);
+		m_pGpuCuller->DrawBucket(bucket + 1, GL_LINES);
+	}
+}
 
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.25f, 0.01f, 0.05f);
+/***********************************************************
+ *  ComputeWorldBounds()
+ *
+ *  This method is used for calculating the world space box
+ *  around a mesh placed by the passed in model matrix, from
+ *  the box around the mesh in model space.
+ ***********************************************************/
+void SceneManager::ComputeWorldBounds(
+	const glm::mat4& model,
+	const glm::vec3& localMin,
+	const glm::vec3& localMax,
+	glm::vec3& boundsMin,
+	glm::vec3& boundsMax)
+{
+	glm::vec3 localCenter = (localMin + localMax) * 0.5f;
+	glm::vec3 localExtents = (localMax - localMin) * 0.5f;
+
+	// transform the center, and the extents by the absolute
+	// values of the rotation and scale part of the matrix
+	glm::vec3 center = glm::vec3(model * glm::vec4(localCenter, 1.0f));
+	glm::vec3 extents;
+	for (int row = 0; row < 3; row++)
+	{
+		extents[row] =
+			fabsf(model[0][row]) * localExtents.x +
+			fabsf(model[1][row]) * localExtents.y +
+			fabsf(model[2][row]) * localExtents.z;
+	}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	boundsMin = center - extents;
+	boundsMax = center + extents;
+}
 
-	// set the XYZ position for the 2mesh
-	positionXYZ = glm::vec3(15.0f, 3.6f, -5.25f);
+/***********************************************************
+ *  ExtractFrustumPlanes()
+ *
+ *  This method is used for getting the six clipping planes
+ *  from the view projection matrix, with the plane normals
+ *  pointing into the frustum.
+ ***********************************************************/
+void SceneManager::ExtractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+{
+	glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+	glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+	glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+	glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+	planes[0] = row3 + row0;	// left
+	planes[1] = row3 - row0;	// right
+	planes[2] = row3 + row1;	// bottom
+	planes[3] = row3 - row1;	// top
+	planes[4] = row3 + row2;	// near
+	planes[5] = row3 - row2;	// far
+}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+/***********************************************************
+ *  IsBoxInFrustum()
+ *
+ *  This method is used for testing a world space box against
+ *  the frustum planes.  The box is only rejected when it is
+ *  completely behind one of the planes.
+ ***********************************************************/
+bool SceneManager::IsBoxInFrustum(const glm::vec4 planes[6], const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		// the box corner furthest along the plane normal
+		glm::vec3 corner(
+			(planes[i].x >= 0.0f) ? boundsMax.x : boundsMin.x,
+			(planes[i].y >= 0.0f) ? boundsMax.y : boundsMin.y,
+			(planes[i].z >= 0.0f) ? boundsMax.z : boundsMin.z);
 
-	// set the color values into the shader
-	SetShaderColor(0.753, 0.753, 0.753, 1);
+		if (planes[i].x * corner.x + planes[i].y * corner.y + planes[i].z * corner.z + planes[i].w < 0.0f)
+		{
+			return(false);
+		}
+	}
+	return(true);
+}
 
+/***********************************************************
+ *  ComputeSortKey()
+ *
+ *  This method is used for building the 64-bit draw order
+ *  key of a visible object.  From the most significant bits
+ *  down: texture slot, material, mesh type, then the view
+ *  depth so that objects sharing all their state are drawn
+ *  front to back.  Imported models are told apart in the
+ *  mesh type bits by their model index.
+ ***********************************************************/
+uint64_t SceneManager::ComputeSortKey(
+	int textureSlot,
+	int materialIndex,
+	MESH_TYPE meshType,
+	int modelIndex,
+	const glm::vec3& boundsMin,
+	const glm::vec3& boundsMax) const
+{
+	glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+	float depth = (m_viewProjection * glm::vec4(center, 1.0f)).w;
+	depth = glm::clamp(depth / MAX_SORT_DEPTH, 0.0f, 1.0f);
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
+	int meshKey = meshType;
+	if (modelIndex >= 0)
+	{
+		meshKey = glm::min(MESH_MODEL + modelIndex, 255);
+	}
 
-	m_basicMeshes->DrawBoxMeshLines();
+	uint64_t sortKey = 0;
+	sortKey |= (uint64_t)(uint8_t)(textureSlot + 1) << 56;
+	sortKey |= (uint64_t)(uint8_t)(materialIndex + 1) << 48;
+	sortKey |= (uint64_t)(uint8_t)meshKey << 40;
+	sortKey |= (uint64_t)(uint32_t)(depth * 16777215.0f) << 16;
 
+	return(sortKey);
 }
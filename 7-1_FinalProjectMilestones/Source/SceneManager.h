@@ -11,6 +11,18 @@
 
 #include "ShaderManager.h"
 #include "ShapeMeshes.h"
+#include "RenderStats.h"
+#include "JobSystem.h"
+#include "SceneGraph.h"
+#include "SceneObjectStore.h"
+#include "SceneFile.h"
+#include "FrameRingBuffer.h"
+#include "ModelImporter.h"
+#include "MeshletCuller.h"
+#include "StaticBatcher.h"
+#include "StaticLayerCache.h"
+#include "OcclusionCuller.h"
+#include "GpuCuller.h"
 
 #include <string>
 #include <vector>
@@ -33,6 +45,8 @@ public:
 	{
 		std::string tag;
 		uint32_t ID;
+		// image file the texture was loaded from
+		std::string filename;
 	};
 
 	struct OBJECT_MATERIAL
@@ -43,6 +57,53 @@ public:
 		std::string tag;
 	};
 
+	// named group of scene objects that move together
+	struct SCENE_GROUP
+	{
+		std::string tag;
+		// key of the group record in the scene file
+		std::string key;
+		int sceneNode;
+	};
+
+	// per-object values in the std140 layout of the ObjectBlock
+	// uniform block of the shaders
+	struct OBJECT_BLOCK
+	{
+		glm::mat4 model;
+		glm::vec4 color;
+		// material, each vec3 padded to 16 bytes
+		glm::vec3 diffuseColor;
+		float padding0;
+		glm::vec3 specularColor;
+		float shininess;
+		// a bool takes 4 bytes
+		int bUseTexture;
+		int padding1[3];
+	};
+
+	// model file imported into the geometry pool
+	struct MODEL_INFO
+	{
+		std::string filename;
+		int mesh;
+		// model space box around the mesh
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		// transform from the stored positions to model space
+		glm::mat4 decode;
+		// triangles submitted by one draw
+		uint64_t primitives;
+		// meshlets of a large model, culled one by one
+		MeshletCuller::MESHLET_SET meshlets;
+	};
+
+	struct DRAW_ITEM
+	{
+		uint64_t sortKey;
+		uint32_t objectIndex;
+	};
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
@@ -54,9 +115,88 @@ private:
 	TEXTURE_INFO m_textureIDs[16];
 	// defined object materials
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// primitives submitted by one draw of each mesh type
+	uint64_t m_meshPrimitives[MESH_TYPE_COUNT];
+	uint64_t m_meshLinePrimitives[MESH_TYPE_COUNT];
+	// transform from the stored positions of each mesh type to
+	// model space, applied ahead of the model matrices
+	glm::mat4 m_meshDecodes[MESH_TYPE_COUNT];
+	// job system for spreading the per-object work over all cores
+	JobSystem* m_pJobSystem;
+	// imports model files into the geometry pool of the meshes
+	ModelImporter* m_pModelImporter;
+	// imported models, each file is only imported once
+	std::vector<MODEL_INFO> m_models;
+	// archive the assets are read from, NULL for loose files
+	const AssetArchive* m_pAssetArchive;
+	// defined scene objects and their per-frame data
+	SceneObjectStore m_sceneObjects;
+	// transform hierarchy of the scene objects and groups
+	SceneGraph m_sceneGraph;
+	std::vector<SCENE_GROUP> m_sceneGroups;
+	// groups open while the scene objects are being defined
+	std::vector<int> m_groupStack;
+	// scene file the objects were loaded from, its records,
+	// and the object added for each record
+	std::string m_sceneFilePath;
+	std::vector<SceneFile::SCENE_RECORD> m_sceneRecords;
+	std::vector<SceneObjectStore::OBJECT_HANDLE> m_recordHandles;
+	// visible objects in submission order
+	std::vector<DRAW_ITEM> m_drawList;
+	// per-frame object blocks of the draws, read by the shaders
+	FrameRingBuffer* m_pObjectBuffer;
+	// frames the CPU can write the per-frame buffers of while
+	// the GPU draws the ones before
+	int m_pipelineDepth;
+	// bytes between the object blocks of two draws
+	size_t m_objectBlockStride;
+	// view projection matrix of the frame being rendered
+	glm::mat4 m_viewProjection;
+	bool m_bViewProjectionSet;
+	// tests the objects against the depth of the occluders,
+	// NULL when occlusion culling is off
+	OcclusionCuller* m_pOcclusionCuller;
+	bool m_bOcclusionCulling;
+	// culls the objects and writes their draws on the GPU,
+	// NULL when the objects are culled on the CPU
+	GpuCuller* m_pGpuCuller;
+	bool m_bGpuCulling;
+	// objects were added, removed or changed since the GPU
+	// culler was given them
+	bool m_bGpuObjectsDirty;
+	// object index of each scene graph node, for sending only
+	// the objects that moved
+	std::vector<uint32_t> m_nodeObjects;
+	std::vector<int> m_updatedNodes;
+	// cull the meshlets of the large models
+	bool m_bMeshletCulling;
+	// world position of the camera of the frame being rendered
+	glm::vec3 m_cameraPosition;
+	// index ranges of the meshlets kept for each draw of the
+	// draw list, and the number of meshlets kept
+	std::vector<std::vector<GeometryPool::INDEX_RANGE> > m_drawMeshletRanges;
+	std::vector<uint32_t> m_drawMeshletCounts;
+	// merged batches of the objects that don't move, NULL
+	// when static batching is off
+	StaticBatcher* m_pStaticBatcher;
+	bool m_bStaticBatching;
+	// image of the objects that don't move, kept while the
+	// camera is still, NULL when the cache is off
+	StaticLayerCache* m_pStaticLayerCache;
+	bool m_bStaticLayerCache;
+	// objects were added, removed or changed since the objects
+	// that don't move were found
+	bool m_bStaticObjectsDirty;
+	// bumped whenever the objects that don't move, or the way
+	// they look, change
+	uint32_t m_staticVersion;
 
 	// load texture images and convert to OpenGL texture data
 	bool CreateGLTexture(const char* filename, std::string tag);
+	// read an image file into an existing OpenGL texture
+	bool LoadTextureImage(GLuint textureID, const char* filename);
+	// send decoded pixels to an existing OpenGL texture
+	bool UploadTextureImage(GLuint textureID, const unsigned char* image, int width, int height, int colorChannels);
 	// bind loaded OpenGL textures to slots in memory
 	void BindGLTextures();
 	// free the loaded OpenGL textures
@@ -66,36 +206,108 @@ private:
 	int FindTextureSlot(std::string tag);
 	// find a defined material by tag
 	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	int FindMaterialIndex(std::string tag);
+
+	// set the UV scale for the texture mapping
+	void SetTextureUVScale(
+		float u, float v);
 
-	// set the transformation values 
-	// into the transform buffer
-	void SetTransformations(
+	void LoadSceneTextures();
+
+	// draw a basic shape mesh or imported model and count it in
+	// the render stats
+	void DrawMesh(MESH_TYPE meshType, int modelIndex);
+	void DrawMeshLines(MESH_TYPE meshType, int modelIndex);
+	// draw the meshlets of a model kept for one draw of the
+	// draw list and count them in the render stats
+	void DrawModelMeshlets(int modelIndex, size_t drawIndex);
+	// issue the draw command for a basic shape mesh
+	void DrawShapeMesh(MESH_TYPE meshType, bool bLines);
+	// find the number of primitives each loaded mesh submits
+	void MeasureMeshPrimitives();
+	// check whether a basic shape mesh has wireframe lines
+	static bool HasShapeMeshLines(MESH_TYPE meshType);
+	// get the position decode transform of a basic shape mesh
+	glm::mat4 GetShapeMeshDecode(MESH_TYPE meshType) const;
+	// get the geometry pool mesh ID of a basic shape mesh
+	int GetShapeMeshID(MESH_TYPE meshType) const;
+	// import a model file, or find it if it was imported
+	// already, returns -1 if it can't be read
+	int LoadModel(const std::string& filename);
+
+	// add an object to the 3D scene
+	SceneObjectStore::OBJECT_HANDLE AddSceneObject(
+		std::string name,
+		MESH_TYPE meshType,
+		std::string modelFile,
 		glm::vec3 scaleXYZ,
 		float XrotationDegrees,
 		float YrotationDegrees,
 		float ZrotationDegrees,
-		glm::vec3 positionXYZ);
+		glm::vec3 positionXYZ,
+		glm::vec4 color,
+		std::string textureTag,
+		std::string materialTag,
+		bool bDrawLines);
 
-	// set the color values into the shader
-	void SetShaderColor(
-		float redColorValue,
-		float greenColorValue,
-		float blueColorValue,
-		float alphaValue);
+	// start and end a group of objects placed relative to it
+	void BeginSceneGroup(std::string tag, glm::vec3 positionXYZ);
+	void EndSceneGroup();
+	// find the scene graph node of a group by its record key
+	int FindSceneGroupNode(const std::string& key) const;
 
-	// set the texture data into the shader
-	void SetShaderTexture(
-		std::string textureTag);
+	// create the scene objects for the scene file records
+	void BuildScene(const std::vector<SceneFile::SCENE_RECORD>& records);
+	// apply the differences from the loaded records, returns
+	// false when the groups changed and a rebuild is needed
+	bool ApplySceneChanges(const std::vector<SceneFile::SCENE_RECORD>& records);
+	// reload the image of a loaded texture
+	bool ReloadTexture(int textureSlot);
 
-	// set the UV scale for the texture mapping
-	void SetTextureUVScale(
-		float u, float v);
+	// per-frame stages of rendering the scene objects
+	void UpdateSceneObjects();
+	void BuildDrawList();
+	void SubmitDrawList();
+	// draw the large objects into the occlusion buffer for
+	// the occlusion tests of the coming frames
+	void DrawOccluders();
+	// per-frame stages of rendering the objects culled on the
+	// GPU, in place of the three above
+	void UpdateGpuObjects();
+	void SubmitGpuDraws();
+	// give the GPU culler every object
+	void BuildGpuObjects();
+	// mark the objects that moved at run time, and rebuild the
+	// static batches when anything changed
+	void UpdateStaticObjects();
+	void BuildStaticBatches();
+	// draw the static batches inside the view, with their
+	// object blocks from the passed in offset of the buffer
+	void SubmitStaticBatches(GLuint bufferID, size_t firstBlockOffset, int& currentTextureSlot);
+	// check whether an object is drawn in the static layer
+	bool IsStaticLayerObject(uint32_t objectIndex) const;
+	// draw the items of the draw list in the passed in layers
+	void SubmitDraws(GLuint bufferID, size_t frameOffset, int& currentTextureSlot, bool bStaticLayer, bool bDynamicLayer);
 
-	void LoadSceneTextures();
+	// fill the shader values of one object
+	void FillObjectBlock(uint32_t objectIndex, bool bPackedVertices, OBJECT_BLOCK& block) const;
 
-	// set the object material into the shader
-	void SetShaderMaterial(
-		std::string materialTag);
+	// helpers for the per-object work, safe on any thread
+	static void ComputeWorldBounds(
+		const glm::mat4& model,
+		const glm::vec3& localMin,
+		const glm::vec3& localMax,
+		glm::vec3& boundsMin,
+		glm::vec3& boundsMax);
+	static void ExtractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+	static bool IsBoxInFrustum(const glm::vec4 planes[6], const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+	uint64_t ComputeSortKey(
+		int textureSlot,
+		int materialIndex,
+		MESH_TYPE meshType,
+		int modelIndex,
+		const glm::vec3& boundsMin,
+		const glm::vec3& boundsMax) const;
 
 public:
 
@@ -104,9 +316,68 @@ public:
 	void PrepareScene();
 	void RenderScene();
 
+	// start building the shader programs of the turned on
+	// features, called after they are set and before the
+	// scene is prepared
+	void BeginLoadShaders(const char* fragmentShaderPath);
+
+	// store the shape mesh vertices packed, called before
+	// the scene is prepared
+	void SetPackedVertices(bool bPacked);
+	// read the textures, models and scene file from an asset
+	// archive, called before the scene is prepared
+	void SetAssetArchive(const AssetArchive* pAssetArchive) { m_pAssetArchive = pAssetArchive; }
+	// skip drawing the objects hidden behind the large objects
+	// of the scene, called before the scene is prepared
+	void SetOcclusionCulling(bool bOcclusionCulling) { m_bOcclusionCulling = bOcclusionCulling; }
+	// cull the objects and write their draws on the GPU when
+	// the context can, called before the scene is prepared
+	void SetGpuCulling(bool bGpuCulling) { m_bGpuCulling = bGpuCulling; }
+	// split the large models into meshlets and skip the ones
+	// outside the view or facing away, called before the scene
+	// is prepared
+	void SetMeshletCulling(bool bMeshletCulling);
+	// merge the objects that don't move into a few batches in
+	// world space, called before the scene is prepared
+	void SetStaticBatching(bool bStaticBatching) { m_bStaticBatching = bStaticBatching; }
+	// keep an image of the objects that don't move while the
+	// camera is still, called before the scene is prepared
+	void SetStaticLayerCache(bool bStaticLayerCache) { m_bStaticLayerCache = bStaticLayerCache; }
+	// set how many frames of per-frame buffers there are, so
+	// how far the CPU can run ahead of the GPU
+	void SetPipelineDepth(int numFrames);
+	// get the files the scene is loaded from, for packing
+	static bool GetAssetFiles(std::vector<std::string>& files);
+
+	// get the render stats object used for counting the frame work
+	RenderStats* GetRenderStats() const;
+
+	// set the view and projection used for culling and sorting
+	void SetViewProjection(const glm::mat4& view, const glm::mat4& projection);
+
+	// remove an object from the 3D scene
+	bool RemoveSceneObject(SceneObjectStore::OBJECT_HANDLE handle);
+
+	// move a whole group of scene objects
+	bool SetSceneGroupTransform(
+		std::string tag,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+
 	//added pre-set light sources for 3D scene
 	void SetupSceneLights();
 	//added pre-define the object materials for lighting
 	void DefineObjectMaterials();
+	// load the objects that make up the 3D scene from a scene file
+	bool LoadSceneFile(const char* filename);
+
+	// get the texture and scene files the scene was loaded from
+	void GetSourceFiles(std::vector<std::string>& files) const;
+	// reload a texture or scene file after it was changed,
+	// returns false if the file is not used by the scene
+	bool ReloadSourceFile(const std::string& filePath);
 
 };
\ No newline at end of file
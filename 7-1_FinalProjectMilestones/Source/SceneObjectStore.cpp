@@ -0,0 +1,171 @@
+///////////////////////////////////////////////////////////////////////////////
+// sceneobjectstore.cpp
+// ============
+// dense structure-of-arrays storage for scene objects with checked handles
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneObjectStore.h"
+
+const uint32_t SceneObjectStore::INVALID_INDEX;
+
+/***********************************************************
+ *  SceneObjectStore()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneObjectStore::SceneObjectStore()
+{
+}
+
+/***********************************************************
+ *  AddObject()
+ *
+ *  This method is used for adding an object to the end of
+ *  the component arrays.  A freed slot is reused when there
+ *  is one; its generation was bumped when it was freed, so
+ *  the old handles to it stay invalid.
+ ***********************************************************/
+SceneObjectStore::OBJECT_HANDLE SceneObjectStore::AddObject(
+	std::string name,
+	int sceneNode,
+	MESH_TYPE meshType,
+	int modelIndex,
+	int textureSlot,
+	int materialIndex,
+	glm::vec4 color,
+	uint8_t flags)
+{
+	uint32_t slot;
+	if (m_freeSlots.empty() == false)
+	{
+		slot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	}
+	else
+	{
+		slot = (uint32_t)m_slotGenerations.size();
+		m_slotGenerations.push_back(0);
+		m_slotIndices.push_back(INVALID_INDEX);
+	}
+
+	m_slotIndices[slot] = (uint32_t)m_denseSlots.size();
+	m_denseSlots.push_back(slot);
+
+	m_components.sceneNodes.push_back(sceneNode);
+	m_components.models.push_back(glm::mat4(1.0f));
+	m_components.boundsMin.push_back(glm::vec3(0.0f));
+	m_components.boundsMax.push_back(glm::vec3(0.0f));
+	m_components.meshTypes.push_back((uint8_t)meshType);
+	m_components.modelIndices.push_back(modelIndex);
+	m_components.textureSlots.push_back(textureSlot);
+	m_components.materialIndices.push_back(materialIndex);
+	m_components.colors.push_back(color);
+	m_components.sortKeys.push_back(0);
+	m_components.flags.push_back(flags);
+	m_components.names.push_back(name);
+
+	OBJECT_HANDLE handle;
+	handle.slot = slot;
+	handle.generation = m_slotGenerations[slot];
+	return(handle);
+}
+
+/***********************************************************
+ *  RemoveObject()
+ *
+ *  This method is used for removing an object.  The last
+ *  object is moved into its place in every component array
+ *  and the moved object's slot is pointed at its new index.
+ ***********************************************************/
+bool SceneObjectStore::RemoveObject(OBJECT_HANDLE handle)
+{
+	uint32_t index = GetDenseIndex(handle);
+	if (index == INVALID_INDEX)
+	{
+		return(false);
+	}
+
+	uint32_t lastSlot = m_denseSlots.back();
+
+	SwapErase(m_components.sceneNodes, index);
+	SwapErase(m_components.models, index);
+	SwapErase(m_components.boundsMin, index);
+	SwapErase(m_components.boundsMax, index);
+	SwapErase(m_components.meshTypes, index);
+	SwapErase(m_components.modelIndices, index);
+	SwapErase(m_components.textureSlots, index);
+	SwapErase(m_components.materialIndices, index);
+	SwapErase(m_components.colors, index);
+	SwapErase(m_components.sortKeys, index);
+	SwapErase(m_components.flags, index);
+	SwapErase(m_components.names, index);
+	SwapErase(m_denseSlots, index);
+
+	m_slotIndices[lastSlot] = index;
+	m_slotIndices[handle.slot] = INVALID_INDEX;
+	m_slotGenerations[handle.slot]++;
+	m_freeSlots.push_back(handle.slot);
+
+	return(true);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing every object.  Every
+ *  slot in use is freed, so all the issued handles become
+ *  invalid.
+ ***********************************************************/
+void SceneObjectStore::Clear()
+{
+	for (size_t i = 0; i < m_denseSlots.size(); i++)
+	{
+		uint32_t slot = m_denseSlots[i];
+		m_slotIndices[slot] = INVALID_INDEX;
+		m_slotGenerations[slot]++;
+		m_freeSlots.push_back(slot);
+	}
+	m_denseSlots.clear();
+
+	m_components.sceneNodes.clear();
+	m_components.models.clear();
+	m_components.boundsMin.clear();
+	m_components.boundsMax.clear();
+	m_components.meshTypes.clear();
+	m_components.modelIndices.clear();
+	m_components.textureSlots.clear();
+	m_components.materialIndices.clear();
+	m_components.colors.clear();
+	m_components.sortKeys.clear();
+	m_components.flags.clear();
+	m_components.names.clear();
+}
+
+/***********************************************************
+ *  IsValid()
+ *
+ *  This method is used for checking whether the handle
+ *  still refers to an object.
+ ***********************************************************/
+bool SceneObjectStore::IsValid(OBJECT_HANDLE handle) const
+{
+	return(GetDenseIndex(handle) != INVALID_INDEX);
+}
+
+/***********************************************************
+ *  GetDenseIndex()
+ *
+ *  This method is used for getting the index of the object
+ *  in the component arrays, or INVALID_INDEX when the handle
+ *  is out of range or from an earlier generation of its slot.
+ ***********************************************************/
+uint32_t SceneObjectStore::GetDenseIndex(OBJECT_HANDLE handle) const
+{
+	if ((handle.slot >= m_slotGenerations.size()) ||
+		(m_slotGenerations[handle.slot] != handle.generation))
+	{
+		return(INVALID_INDEX);
+	}
+	return(m_slotIndices[handle.slot]);
+}
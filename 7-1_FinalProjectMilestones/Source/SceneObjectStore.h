@@ -0,0 +1,132 @@
+///////////////////////////////////////////////////////////////////////////////
+// sceneobjectstore.h
+// ============
+// dense structure-of-arrays storage for scene objects with checked handles
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "RenderStats.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  SceneObjectStore
+ *
+ *  This class contains the per-object data of the scene as
+ *  one dense array per component - transform, bounds, render
+ *  info and flags - so each per-frame pass reads only the
+ *  arrays it needs, front to back with no gaps.
+ *
+ *  Objects are referred to by handles.  A handle holds a slot
+ *  index and the generation of the slot when it was issued,
+ *  so a handle kept after its object was removed is detected
+ *  instead of reaching whichever object reused the slot.
+ *  Removal moves the last object into the gap, so adding and
+ *  removing are both constant time and the arrays stay dense.
+ *  Dense indices change on removal; handles do not.
+ ***********************************************************/
+class SceneObjectStore
+{
+public:
+	// constructor
+	SceneObjectStore();
+
+	struct OBJECT_HANDLE
+	{
+		uint32_t slot;
+		uint32_t generation;
+	};
+
+	enum OBJECT_FLAGS
+	{
+		// draw the wireframe lines over the filled mesh
+		OBJECT_DRAW_LINES = 0x01,
+		// passed the visibility test this frame
+		OBJECT_VISIBLE = 0x02,
+		// inside the view, but hidden behind the occluders
+		OBJECT_OCCLUDED = 0x04,
+		// drawn as part of a static batch
+		OBJECT_STATIC = 0x08,
+		// moved after the scene was loaded, kept out of the
+		// static batches
+		OBJECT_MOVED = 0x10
+	};
+
+	// component arrays, one entry per object in dense order
+	struct COMPONENT_ARRAYS
+	{
+		// transform
+		std::vector<int> sceneNodes;
+		std::vector<glm::mat4> models;
+		// bounds
+		std::vector<glm::vec3> boundsMin;
+		std::vector<glm::vec3> boundsMax;
+		// render info
+		std::vector<uint8_t> meshTypes;
+		// imported model of a MESH_MODEL object, otherwise -1
+		std::vector<int> modelIndices;
+		std::vector<int> textureSlots;
+		std::vector<int> materialIndices;
+		std::vector<glm::vec4> colors;
+		std::vector<uint64_t> sortKeys;
+		// OBJECT_FLAGS bits
+		std::vector<uint8_t> flags;
+		// only read when debugging
+		std::vector<std::string> names;
+	};
+
+	static const uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+	// add an object and get the handle for it
+	OBJECT_HANDLE AddObject(
+		std::string name,
+		int sceneNode,
+		MESH_TYPE meshType,
+		int modelIndex,
+		int textureSlot,
+		int materialIndex,
+		glm::vec4 color,
+		uint8_t flags);
+	// remove the object, returns false for a stale handle
+	bool RemoveObject(OBJECT_HANDLE handle);
+	// remove every object and invalidate every handle
+	void Clear();
+
+	// check whether the handle still refers to an object
+	bool IsValid(OBJECT_HANDLE handle) const;
+	// get the dense index of the object, or INVALID_INDEX
+	uint32_t GetDenseIndex(OBJECT_HANDLE handle) const;
+	size_t GetCount() const { return(m_denseSlots.size()); }
+
+	COMPONENT_ARRAYS& GetComponents() { return(m_components); }
+	const COMPONENT_ARRAYS& GetComponents() const { return(m_components); }
+
+private:
+	COMPONENT_ARRAYS m_components;
+
+	// slot of the object at each dense index
+	std::vector<uint32_t> m_denseSlots;
+	// dense index of the object in each slot
+	std::vector<uint32_t> m_slotIndices;
+	// bumped every time the slot is freed
+	std::vector<uint32_t> m_slotGenerations;
+	// slots free for reuse
+	std::vector<uint32_t> m_freeSlots;
+
+	// move the last entry of the array into the index
+	template <typename T>
+	static void SwapErase(std::vector<T>& values, size_t index)
+	{
+		if (index + 1 < values.size())
+		{
+			values[index] = values.back();
+		}
+		values.pop_back();
+	}
+};
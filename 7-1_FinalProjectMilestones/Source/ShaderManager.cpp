@@ -0,0 +1,859 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadermanager.cpp
+// ============
+// manage the loading of GLSL shader programs and the setting of uniform values
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderManager.h"
+#include "MappedFile.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#if defined(_WIN32)
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// declaration of the global variables and defines
+namespace
+{
+	// folder the program binaries are cached in
+	const char* const DEFAULT_PROGRAM_CACHE_DIRECTORY = "shadercache";
+	// "PBIN" read as a little endian integer
+	const uint32_t PROGRAM_CACHE_MAGIC = 0x4E494250;
+
+	const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+	const uint64_t FNV_PRIME = 1099511628211ULL;
+
+	/***********************************************************
+	 *  HashBytes()
+	 *
+	 *  Continues a 64-bit FNV-1a hash over a run of bytes.
+	 ***********************************************************/
+	uint64_t HashBytes(uint64_t hash, const char* pData, size_t size)
+	{
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= (unsigned char)pData[i];
+			hash *= FNV_PRIME;
+		}
+		return(hash);
+	}
+}
+
+#include <glm/gtc/type_ptr.hpp>
+
+// programs begun ahead of being loaded
+std::vector<ShaderManager::PROGRAM_BUILD> ShaderManager::m_pendingBuilds;
+
+/***********************************************************
+ *  ShaderManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShaderManager::ShaderManager()
+{
+	m_programID = 0;
+	m_pRenderStats = NULL;
+	m_pAssetArchive = NULL;
+	m_programCacheDirectory = DEFAULT_PROGRAM_CACHE_DIRECTORY;
+	m_bParallelCompileChecked = false;
+}
+
+/***********************************************************
+ *  ~ShaderManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShaderManager::~ShaderManager()
+{
+	if (0 != m_programID)
+	{
+		glDeleteProgram(m_programID);
+		m_programID = 0;
+	}
+	m_pRenderStats = NULL;
+}
+
+/***********************************************************
+ *  LoadShaders()
+ *
+ *  This method is used for reading the vertex and fragment
+ *  shader source files, compiling them, and linking them
+ *  into the shader program.  A program linked from the same
+ *  sources by the same driver before is loaded from the
+ *  program binary cache instead, and one begun ahead with
+ *  BeginLoadShaders() is only waited on.
+ ***********************************************************/
+GLuint ShaderManager::LoadShaders(const char* vertexShaderPath, const char* fragmentShaderPath)
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	// remember the source files for reloading them later
+	m_vertexShaderPath = vertexShaderPath;
+	m_fragmentShaderPath = fragmentShaderPath;
+
+	const GLenum shaderTypes[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+	const char* shaderPaths[2] = { vertexShaderPath, fragmentShaderPath };
+	PROGRAM_BUILD build;
+	GLuint programID = 0;
+	if ((TakePendingBuild(2, shaderPaths, build) == true) ||
+		(BeginProgramBuild(2, shaderTypes, shaderPaths, build) == true))
+	{
+		programID = FinishProgramBuild(build);
+	}
+
+	if (0 != programID)
+	{
+		if (0 != m_programID)
+		{
+			glDeleteProgram(m_programID);
+		}
+		m_programID = programID;
+		m_uniformLocations.clear();
+		ApplyUniformBlockBindings();
+
+		double milliseconds = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - startTime).count();
+		std::cout << "Shader program " << ((build.bFromCache == true) ? "loaded from cache" : "compiled")
+			<< ":" << vertexShaderPath << ", " << fragmentShaderPath << ", time:" << milliseconds << "ms" << std::endl;
+	}
+
+	return(programID);
+}
+
+/***********************************************************
+ *  LoadComputeShader()
+ *
+ *  This method is used for reading a compute shader source
+ *  file, compiling it, and linking it into the shader
+ *  program, the same way as above.
+ ***********************************************************/
+GLuint ShaderManager::LoadComputeShader(const char* computeShaderPath)
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	const GLenum shaderTypes[1] = { GL_COMPUTE_SHADER };
+	const char* shaderPaths[1] = { computeShaderPath };
+	PROGRAM_BUILD build;
+	GLuint programID = 0;
+	if ((TakePendingBuild(1, shaderPaths, build) == true) ||
+		(BeginProgramBuild(1, shaderTypes, shaderPaths, build) == true))
+	{
+		programID = FinishProgramBuild(build);
+	}
+
+	if (0 != programID)
+	{
+		if (0 != m_programID)
+		{
+			glDeleteProgram(m_programID);
+		}
+		m_programID = programID;
+		m_uniformLocations.clear();
+		m_vertexShaderPath.clear();
+		m_fragmentShaderPath.clear();
+
+		double milliseconds = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - startTime).count();
+		std::cout << "Shader program " << ((build.bFromCache == true) ? "loaded from cache" : "compiled")
+			<< ":" << computeShaderPath << ", time:" << milliseconds << "ms" << std::endl;
+	}
+
+	return(programID);
+}
+
+/***********************************************************
+ *  BeginLoadShaders()
+ *
+ *  This method is used for starting to build the program of
+ *  the passed in vertex and fragment shader files, without
+ *  waiting for it.  Every program begun this way compiles at
+ *  the same time as the others, and is finished by the first
+ *  LoadShaders() of the same files, on any shader manager.
+ ***********************************************************/
+void ShaderManager::BeginLoadShaders(const char* vertexShaderPath, const char* fragmentShaderPath)
+{
+	const GLenum shaderTypes[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+	const char* shaderPaths[2] = { vertexShaderPath, fragmentShaderPath };
+	PROGRAM_BUILD build;
+	if (TakePendingBuild(2, shaderPaths, build) == true)
+	{
+		// already begun, put it back as it was
+		m_pendingBuilds.push_back(build);
+		return;
+	}
+	if (BeginProgramBuild(2, shaderTypes, shaderPaths, build) == true)
+	{
+		m_pendingBuilds.push_back(build);
+	}
+}
+
+/***********************************************************
+ *  BeginLoadComputeShader()
+ *
+ *  This method is used for starting to build the program of
+ *  the passed in compute shader file, finished by the first
+ *  LoadComputeShader() of the same file.
+ ***********************************************************/
+void ShaderManager::BeginLoadComputeShader(const char* computeShaderPath)
+{
+	const GLenum shaderTypes[1] = { GL_COMPUTE_SHADER };
+	const char* shaderPaths[1] = { computeShaderPath };
+	PROGRAM_BUILD build;
+	if (TakePendingBuild(1, shaderPaths, build) == true)
+	{
+		m_pendingBuilds.push_back(build);
+		return;
+	}
+	if (BeginProgramBuild(1, shaderTypes, shaderPaths, build) == true)
+	{
+		m_pendingBuilds.push_back(build);
+	}
+}
+
+/***********************************************************
+ *  DiscardPendingBuilds()
+ *
+ *  This method is used for freeing the programs begun ahead
+ *  that nothing loaded, such as those of a feature that
+ *  turned itself off.  It is called once startup is done.
+ ***********************************************************/
+void ShaderManager::DiscardPendingBuilds()
+{
+	for (size_t i = 0; i < m_pendingBuilds.size(); i++)
+	{
+		DiscardProgramBuild(m_pendingBuilds[i]);
+	}
+	m_pendingBuilds.clear();
+}
+
+/***********************************************************
+ *  ReloadShaders()
+ *
+ *  This method is used for compiling and linking the shader
+ *  program again from the files it was loaded from, after
+ *  they were edited.  The current program stays in use if
+ *  the edited files don't compile or link.  The uniform
+ *  values are not carried over to a new program, so the
+ *  caller has to set them again when this returns non-zero.
+ ***********************************************************/
+GLuint ShaderManager::ReloadShaders()
+{
+	if (m_vertexShaderPath.empty() || m_fragmentShaderPath.empty())
+	{
+		return(0);
+	}
+
+	// copied, as loading overwrites the stored paths
+	std::string vertexShaderPath = m_vertexShaderPath;
+	std::string fragmentShaderPath = m_fragmentShaderPath;
+	return(LoadShaders(vertexShaderPath.c_str(), fragmentShaderPath.c_str()));
+}
+
+/***********************************************************
+ *  IsShaderFile()
+ *
+ *  This method is used for checking whether the passed in
+ *  path is one of the GLSL files of the shader program.
+ ***********************************************************/
+bool ShaderManager::IsShaderFile(const std::string& filePath) const
+{
+	return((filePath == m_vertexShaderPath) || (filePath == m_fragmentShaderPath));
+}
+
+/***********************************************************
+ *  use()
+ *
+ *  This method is used for making the shader program the
+ *  active one for the following draw commands.
+ ***********************************************************/
+void ShaderManager::use()
+{
+	glUseProgram(m_programID);
+	if (NULL != m_pRenderStats)
+	{
+		m_pRenderStats->CountProgramBind();
+	}
+}
+
+/***********************************************************
+ *  SetUniformBlockBinding()
+ *
+ *  This method is used for connecting the named uniform block
+ *  of the shader program to the passed in binding point, so
+ *  the block reads from the buffer range bound there.  The
+ *  binding is part of the program, so it is set again every
+ *  time the program is reloaded.
+ ***********************************************************/
+void ShaderManager::SetUniformBlockBinding(const std::string& blockName, GLuint bindingPoint)
+{
+	m_uniformBlockBindings[blockName] = bindingPoint;
+	ApplyUniformBlockBindings();
+}
+
+/***********************************************************
+ *  ApplyUniformBlockBindings()
+ *
+ *  This method is used for setting the binding points of all
+ *  the known uniform blocks into the shader program.
+ ***********************************************************/
+void ShaderManager::ApplyUniformBlockBindings()
+{
+	if (0 == m_programID)
+	{
+		return;
+	}
+
+	std::unordered_map<std::string, GLuint>::const_iterator it;
+	for (it = m_uniformBlockBindings.begin(); it != m_uniformBlockBindings.end(); ++it)
+	{
+		GLuint blockIndex = glGetUniformBlockIndex(m_programID, it->first.c_str());
+		if (GL_INVALID_INDEX != blockIndex)
+		{
+			glUniformBlockBinding(m_programID, blockIndex, it->second);
+		}
+	}
+}
+
+/***********************************************************
+ *  ReadShaderFile()
+ *
+ *  This method is used for reading the whole text of the
+ *  passed in GLSL source file.
+ ***********************************************************/
+bool ShaderManager::ReadShaderFile(const char* filePath, std::string& shaderSource)
+{
+	std::ifstream shaderFile(filePath, std::ios::in | std::ios::binary);
+	if (!shaderFile.is_open())
+	{
+		std::cout << "ERROR: could not open shader file:" << filePath << std::endl;
+		return(false);
+	}
+
+	std::stringstream sourceStream;
+	sourceStream << shaderFile.rdbuf();
+	shaderSource = sourceStream.str();
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetShaderSource()
+ *
+ *  This method is used for getting the text of a GLSL source
+ *  file.  When it is packed in the asset archive the text is
+ *  used where it lies in the mapped archive, otherwise the
+ *  file is read into the passed in string.
+ ***********************************************************/
+bool ShaderManager::GetShaderSource(const char* filePath, std::string& fileSource, const char*& pSource, size_t& length)
+{
+	AssetArchive::ASSET_VIEW asset;
+	if ((NULL != m_pAssetArchive) && (m_pAssetArchive->FindAsset(filePath, asset) == true))
+	{
+		pSource = (const char*)asset.pData;
+		length = asset.size;
+		return(true);
+	}
+
+	if (ReadShaderFile(filePath, fileSource) == false)
+	{
+		return(false);
+	}
+	pSource = fileSource.c_str();
+	length = fileSource.size();
+	return(true);
+}
+
+/***********************************************************
+ *  BeginProgramBuild()
+ *
+ *  This method is used for starting to build a shader
+ *  program from one source file per stage.  The program
+ *  binary cache is tried first.  Otherwise the stages are
+ *  compiled and the program is linked without asking for
+ *  any result, as every query waits for the driver - the
+ *  stages, and the programs begun before the first one is
+ *  finished, compile side by side on the driver's compiler
+ *  threads.
+ ***********************************************************/
+bool ShaderManager::BeginProgramBuild(
+	int numShaders,
+	const GLenum* pShaderTypes,
+	const char* const* pShaderPaths,
+	PROGRAM_BUILD& build)
+{
+	build.programID = 0;
+	build.numShaders = 0;
+	build.cacheKey = 0;
+	build.bFromCache = false;
+
+	std::string fileSources[MAX_PROGRAM_SHADERS];
+	const char* pSources[MAX_PROGRAM_SHADERS] = { "", "" };
+	size_t lengths[MAX_PROGRAM_SHADERS] = { 0, 0 };
+	for (int i = 0; i < numShaders; i++)
+	{
+		if (GetShaderSource(pShaderPaths[i], fileSources[i], pSources[i], lengths[i]) == false)
+		{
+			return(false);
+		}
+		build.shaders[i] = 0;
+		build.shaderPaths[i] = pShaderPaths[i];
+	}
+	build.numShaders = numShaders;
+
+	EnableParallelCompile();
+
+	// a compute program hashes an empty second source, which
+	// keeps its key apart from a vertex shader with the same text
+	build.cacheKey = GetProgramCacheKey(pSources[0], lengths[0], pSources[1], lengths[1]);
+	build.programID = glCreateProgram();
+	if (LoadProgramBinary(build.programID, build.cacheKey) == true)
+	{
+		build.bFromCache = true;
+		return(true);
+	}
+
+	// a rejected binary leaves the program unlinked, it is
+	// simply started over
+	glDeleteProgram(build.programID);
+	build.programID = glCreateProgram();
+
+	// link the compiled shader stages into the program
+	for (int i = 0; i < numShaders; i++)
+	{
+		build.shaders[i] = CompileShader(pShaderTypes[i], pSources[i], lengths[i]);
+		glAttachShader(build.programID, build.shaders[i]);
+	}
+	glProgramParameteri(build.programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glLinkProgram(build.programID);
+
+	return(true);
+}
+
+/***********************************************************
+ *  FinishProgramBuild()
+ *
+ *  This method is used for waiting for a program begun with
+ *  BeginProgramBuild() to link, printing the compiler or
+ *  linker log if it failed, and storing the binary of a
+ *  newly linked program in the cache.
+ ***********************************************************/
+GLuint ShaderManager::FinishProgramBuild(PROGRAM_BUILD& build)
+{
+	if (build.bFromCache == true)
+	{
+		return(build.programID);
+	}
+
+	GLuint programID = build.programID;
+	GLint result = GL_FALSE;
+	glGetProgramiv(programID, GL_LINK_STATUS, &result);
+	if (GL_FALSE == result)
+	{
+		// a stage that failed to compile fails the link, and its
+		// log is the one that tells why
+		bool bCompiled = true;
+		for (int i = 0; i < build.numShaders; i++)
+		{
+			if (IsShaderCompiled(build.shaders[i], build.shaderPaths[i].c_str()) == false)
+			{
+				bCompiled = false;
+			}
+		}
+		if (bCompiled == true)
+		{
+			GLint logLength = 0;
+			glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &logLength);
+			std::vector<char> errorLog(logLength + 1, 0);
+			glGetProgramInfoLog(programID, logLength, NULL, errorLog.data());
+			std::cout << "ERROR: shader program linking failed\n" << errorLog.data() << std::endl;
+		}
+
+		glDeleteProgram(programID);
+		programID = 0;
+	}
+	else
+	{
+		// the compiled stages are no longer needed once linked
+		for (int i = 0; i < build.numShaders; i++)
+		{
+			glDetachShader(programID, build.shaders[i]);
+		}
+	}
+	for (int i = 0; i < build.numShaders; i++)
+	{
+		glDeleteShader(build.shaders[i]);
+	}
+
+	if (0 != programID)
+	{
+		SaveProgramBinary(programID, build.cacheKey);
+	}
+	return(programID);
+}
+
+/***********************************************************
+ *  TakePendingBuild()
+ *
+ *  This method is used for taking the program begun ahead
+ *  from the passed in files off the pending list.  Returns
+ *  false if no such program was begun.
+ ***********************************************************/
+bool ShaderManager::TakePendingBuild(int numShaders, const char* const* pShaderPaths, PROGRAM_BUILD& build)
+{
+	for (size_t i = 0; i < m_pendingBuilds.size(); i++)
+	{
+		bool bMatch = (m_pendingBuilds[i].numShaders == numShaders);
+		for (int j = 0; (j < numShaders) && (bMatch == true); j++)
+		{
+			bMatch = (m_pendingBuilds[i].shaderPaths[j] == pShaderPaths[j]);
+		}
+		if (bMatch == true)
+		{
+			build = m_pendingBuilds[i];
+			m_pendingBuilds.erase(m_pendingBuilds.begin() + i);
+			return(true);
+		}
+	}
+	return(false);
+}
+
+/***********************************************************
+ *  DiscardProgramBuild()
+ *
+ *  This method is used for freeing the program and the
+ *  compiled stages of a build that won't be finished.
+ ***********************************************************/
+void ShaderManager::DiscardProgramBuild(PROGRAM_BUILD& build)
+{
+	if (0 != build.programID)
+	{
+		glDeleteProgram(build.programID);
+		build.programID = 0;
+	}
+	if (build.bFromCache == false)
+	{
+		for (int i = 0; i < build.numShaders; i++)
+		{
+			glDeleteShader(build.shaders[i]);
+		}
+	}
+	build.numShaders = 0;
+}
+
+/***********************************************************
+ *  CompileShader()
+ *
+ *  This method is used for starting the compile of one
+ *  shader stage.  The source doesn't have to end in a null
+ *  character.  The result is checked once the program is
+ *  linked.
+ ***********************************************************/
+GLuint ShaderManager::CompileShader(GLenum shaderType, const char* pSource, size_t length)
+{
+	GLuint shaderID = glCreateShader(shaderType);
+	GLint sourceLength = (GLint)length;
+	glShaderSource(shaderID, 1, &pSource, &sourceLength);
+	glCompileShader(shaderID);
+
+	return(shaderID);
+}
+
+/***********************************************************
+ *  IsShaderCompiled()
+ *
+ *  This method is used for checking whether a shader stage
+ *  compiled, and printing the compiler log if it did not.
+ ***********************************************************/
+bool ShaderManager::IsShaderCompiled(GLuint shaderID, const char* filePath) const
+{
+	GLint result = GL_FALSE;
+	glGetShaderiv(shaderID, GL_COMPILE_STATUS, &result);
+	if (GL_FALSE == result)
+	{
+		GLint logLength = 0;
+		glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &logLength);
+		std::vector<char> errorLog(logLength + 1, 0);
+		glGetShaderInfoLog(shaderID, logLength, NULL, errorLog.data());
+		std::cout << "ERROR: shader compilation failed:" << filePath << "\n" << errorLog.data() << std::endl;
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  EnableParallelCompile()
+ *
+ *  This method is used for letting the driver compile and
+ *  link on as many threads as it likes, when it supports
+ *  parallel shader compiles.  It is done once, with the
+ *  first program, as it needs the OpenGL context.
+ ***********************************************************/
+void ShaderManager::EnableParallelCompile()
+{
+	if (m_bParallelCompileChecked == true)
+	{
+		return;
+	}
+	m_bParallelCompileChecked = true;
+
+	if (GLEW_KHR_parallel_shader_compile)
+	{
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+		std::cout << "INFO: parallel shader compile enabled" << std::endl;
+	}
+	else if (GLEW_ARB_parallel_shader_compile)
+	{
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+		std::cout << "INFO: parallel shader compile enabled" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  GetProgramCacheKey()
+ *
+ *  This method is used for getting the key a program binary
+ *  is cached under - a hash of both sources and of the
+ *  driver vendor, renderer and version, since a binary only
+ *  loads into the driver that produced it.
+ ***********************************************************/
+uint64_t ShaderManager::GetProgramCacheKey(
+	const char* pVertexSource,
+	size_t vertexLength,
+	const char* pFragmentSource,
+	size_t fragmentLength) const
+{
+	const GLenum driverStrings[3] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+
+	uint64_t cacheKey = FNV_OFFSET_BASIS;
+	for (int i = 0; i < 3; i++)
+	{
+		const char* pString = (const char*)glGetString(driverStrings[i]);
+		if (NULL != pString)
+		{
+			// the terminating null keeps the strings apart
+			cacheKey = HashBytes(cacheKey, pString, strlen(pString) + 1);
+		}
+	}
+	cacheKey = HashBytes(cacheKey, pVertexSource, vertexLength);
+	cacheKey = HashBytes(cacheKey, "\0", 1);
+	cacheKey = HashBytes(cacheKey, pFragmentSource, fragmentLength);
+
+	return(cacheKey);
+}
+
+/***********************************************************
+ *  GetProgramCachePath()
+ *
+ *  This method is used for getting the cache file of the
+ *  program binary with the passed in key.
+ ***********************************************************/
+std::string ShaderManager::GetProgramCachePath(uint64_t cacheKey) const
+{
+	std::ostringstream path;
+	path << m_programCacheDirectory << "/" << std::hex << std::setw(16) << std::setfill('0') << cacheKey << ".bin";
+	return(path.str());
+}
+
+/***********************************************************
+ *  LoadProgramBinary()
+ *
+ *  This method is used for loading the cached binary of a
+ *  program into the passed in program.  Returns false when
+ *  there is no binary or the driver rejects it, which
+ *  happens silently after a driver update.
+ ***********************************************************/
+bool ShaderManager::LoadProgramBinary(GLuint programID, uint64_t cacheKey)
+{
+	GLint numFormats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+	if ((m_programCacheDirectory.empty() == true) || (numFormats <= 0))
+	{
+		return(false);
+	}
+
+	MappedFile file;
+	std::string cachePath = GetProgramCachePath(cacheKey);
+	if ((file.Open(cachePath.c_str()) == false) || (file.GetSize() < sizeof(PROGRAM_CACHE_HEADER)))
+	{
+		return(false);
+	}
+
+	PROGRAM_CACHE_HEADER header;
+	memcpy(&header, file.GetData(), sizeof(header));
+	if ((header.magic != PROGRAM_CACHE_MAGIC) ||
+		(header.cacheKey != cacheKey) ||
+		(header.length > file.GetSize() - sizeof(PROGRAM_CACHE_HEADER)))
+	{
+		return(false);
+	}
+
+	glProgramBinary(programID, header.binaryFormat, file.GetData() + sizeof(PROGRAM_CACHE_HEADER), (GLsizei)header.length);
+
+	GLint result = GL_FALSE;
+	glGetProgramiv(programID, GL_LINK_STATUS, &result);
+	return(GL_FALSE != result);
+}
+
+/***********************************************************
+ *  SaveProgramBinary()
+ *
+ *  This method is used for writing the binary of a linked
+ *  program to the cache, creating the cache folder when it
+ *  is missing.  Failing to write it only costs a compile
+ *  next time, so it is not an error.
+ ***********************************************************/
+void ShaderManager::SaveProgramBinary(GLuint programID, uint64_t cacheKey)
+{
+	GLint length = 0;
+	glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &length);
+	if ((m_programCacheDirectory.empty() == true) || (length <= 0))
+	{
+		return;
+	}
+
+	std::vector<char> binary(length);
+	GLenum binaryFormat = 0;
+	GLsizei written = 0;
+	glGetProgramBinary(programID, length, &written, &binaryFormat, binary.data());
+	if (written <= 0)
+	{
+		return;
+	}
+
+#if defined(_WIN32)
+	_mkdir(m_programCacheDirectory.c_str());
+#else
+	mkdir(m_programCacheDirectory.c_str(), 0755);
+#endif
+
+	PROGRAM_CACHE_HEADER header;
+	header.magic = PROGRAM_CACHE_MAGIC;
+	header.binaryFormat = binaryFormat;
+	header.cacheKey = cacheKey;
+	header.length = (uint32_t)written;
+	header.reserved = 0;
+
+	std::string cachePath = GetProgramCachePath(cacheKey);
+	std::ofstream file(cachePath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (file.is_open())
+	{
+		file.write((const char*)&header, sizeof(header));
+		file.write(binary.data(), written);
+	}
+}
+
+/***********************************************************
+ *  GetUniformLocation()
+ *
+ *  This method is used for getting the location of the
+ *  named uniform, asking the driver only the first time.
+ ***********************************************************/
+GLint ShaderManager::GetUniformLocation(const std::string& name) const
+{
+	std::unordered_map<std::string, GLint>::const_iterator found = m_uniformLocations.find(name);
+	if (found != m_uniformLocations.end())
+	{
+		return(found->second);
+	}
+
+	GLint location = glGetUniformLocation(m_programID, name.c_str());
+	m_uniformLocations[name] = location;
+
+	return(location);
+}
+
+/***********************************************************
+ *  CountUniformWrite()
+ *
+ *  This method is used for counting one uniform write in
+ *  the render stats, when a stats object has been set.
+ ***********************************************************/
+void ShaderManager::CountUniformWrite(uint32_t numBytes) const
+{
+	if (NULL != m_pRenderStats)
+	{
+		m_pRenderStats->CountUniformWrite(numBytes);
+	}
+}
+
+/***********************************************************
+ *  set*Value()
+ *
+ *  These methods are used for setting the passed in value
+ *  into the named uniform of the active shader program.
+ ***********************************************************/
+void ShaderManager::setBoolValue(const std::string& name, bool value) const
+{
+	glUniform1i(GetUniformLocation(name), (int)value);
+	CountUniformWrite(sizeof(GLint));
+}
+
+void ShaderManager::setIntValue(const std::string& name, int value) const
+{
+	glUniform1i(GetUniformLocation(name), value);
+	CountUniformWrite(sizeof(GLint));
+}
+
+void ShaderManager::setFloatValue(const std::string& name, float value) const
+{
+	glUniform1f(GetUniformLocation(name), value);
+	CountUniformWrite(sizeof(GLfloat));
+}
+
+void ShaderManager::setSampler2DValue(const std::string& name, int value) const
+{
+	glUniform1i(GetUniformLocation(name), value);
+	CountUniformWrite(sizeof(GLint));
+}
+
+void ShaderManager::setVec2Value(const std::string& name, const glm::vec2& value) const
+{
+	glUniform2fv(GetUniformLocation(name), 1, glm::value_ptr(value));
+	CountUniformWrite(sizeof(glm::vec2));
+}
+
+void ShaderManager::setVec2Value(const std::string& name, float x, float y) const
+{
+	glUniform2f(GetUniformLocation(name), x, y);
+	CountUniformWrite(sizeof(glm::vec2));
+}
+
+void ShaderManager::setVec3Value(const std::string& name, const glm::vec3& value) const
+{
+	glUniform3fv(GetUniformLocation(name), 1, glm::value_ptr(value));
+	CountUniformWrite(sizeof(glm::vec3));
+}
+
+void ShaderManager::setVec3Value(const std::string& name, float x, float y, float z) const
+{
+	glUniform3f(GetUniformLocation(name), x, y, z);
+	CountUniformWrite(sizeof(glm::vec3));
+}
+
+void ShaderManager::setVec4Value(const std::string& name, const glm::vec4& value) const
+{
+	glUniform4fv(GetUniformLocation(name), 1, glm::value_ptr(value));
+	CountUniformWrite(sizeof(glm::vec4));
+}
+
+void ShaderManager::setVec4Value(const std::string& name, float x, float y, float z, float w) const
+{
+	glUniform4f(GetUniformLocation(name), x, y, z, w);
+	CountUniformWrite(sizeof(glm::vec4));
+}
+
+void ShaderManager::setMat4Value(const std::string& name, const glm::mat4& value) const
+{
+	glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
+	CountUniformWrite(sizeof(glm::mat4));
+}
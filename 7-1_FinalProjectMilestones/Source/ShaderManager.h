@@ -0,0 +1,189 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadermanager.h
+// ============
+// manage the loading of GLSL shader programs and the setting of uniform values
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "RenderStats.h"
+#include "AssetArchive.h"
+
+/***********************************************************
+ *  ShaderManager
+ *
+ *  This class contains the code for compiling and linking
+ *  the shader program and for passing uniform values into
+ *  it.  Uniform locations are looked up once and cached,
+ *  and every uniform write is counted in the render stats.
+ *
+ *  Linked programs are saved with glGetProgramBinary() in a
+ *  cache folder, under a hash of their sources and of the
+ *  driver, and loaded from there on later runs.  A binary
+ *  the driver rejects is quietly compiled again.
+ *
+ *  Programs can be begun ahead of being loaded, so every
+ *  program used at startup compiles side by side on the
+ *  driver's threads before the first one is waited on.
+ ***********************************************************/
+class ShaderManager
+{
+public:
+	// constructor
+	ShaderManager();
+	// destructor
+	~ShaderManager();
+
+	// load, compile and link the shader program from GLSL files
+	GLuint LoadShaders(const char* vertexShaderPath, const char* fragmentShaderPath);
+	// load, compile and link a compute shader program from one
+	// GLSL file, which can't be reloaded
+	GLuint LoadComputeShader(const char* computeShaderPath);
+	// start building a program ahead of loading it, a load of
+	// the same files by any shader manager finishes it
+	void BeginLoadShaders(const char* vertexShaderPath, const char* fragmentShaderPath);
+	void BeginLoadComputeShader(const char* computeShaderPath);
+	// free the programs begun that were never loaded
+	static void DiscardPendingBuilds();
+	// load the shader program again from the same GLSL files,
+	// keeping the current program if the new one fails
+	GLuint ReloadShaders();
+	// check whether the file is one of the GLSL source files
+	bool IsShaderFile(const std::string& filePath) const;
+	// make the shader program the active one
+	void use();
+	// connect the named uniform block to a buffer binding point,
+	// kept for programs loaded later as well
+	void SetUniformBlockBinding(const std::string& blockName, GLuint bindingPoint);
+
+	// get the OpenGL ID of the linked shader program
+	GLuint GetProgramID() const { return(m_programID); }
+	const std::string& GetVertexShaderPath() const { return(m_vertexShaderPath); }
+	const std::string& GetFragmentShaderPath() const { return(m_fragmentShaderPath); }
+
+	// read the GLSL sources from an asset archive when they are
+	// packed in it, rather than from the files
+	void SetAssetArchive(const AssetArchive* pAssetArchive) { m_pAssetArchive = pAssetArchive; }
+	const AssetArchive* GetAssetArchive() const { return(m_pAssetArchive); }
+	// set the folder linked programs are cached in, empty
+	// turns the program binary cache off
+	void SetProgramCacheDirectory(const std::string& directory) { m_programCacheDirectory = directory; }
+	const std::string& GetProgramCacheDirectory() const { return(m_programCacheDirectory); }
+
+	// set the render stats object used for counting state changes
+	void SetRenderStats(RenderStats* pRenderStats) { m_pRenderStats = pRenderStats; }
+	RenderStats* GetRenderStats() const { return(m_pRenderStats); }
+
+	// set uniform values into the active shader program
+	void setBoolValue(const std::string& name, bool value) const;
+	void setIntValue(const std::string& name, int value) const;
+	void setFloatValue(const std::string& name, float value) const;
+	void setSampler2DValue(const std::string& name, int value) const;
+	void setVec2Value(const std::string& name, const glm::vec2& value) const;
+	void setVec2Value(const std::string& name, float x, float y) const;
+	void setVec3Value(const std::string& name, const glm::vec3& value) const;
+	void setVec3Value(const std::string& name, float x, float y, float z) const;
+	void setVec4Value(const std::string& name, const glm::vec4& value) const;
+	void setVec4Value(const std::string& name, float x, float y, float z, float w) const;
+	void setMat4Value(const std::string& name, const glm::mat4& value) const;
+
+private:
+	// header of a program binary cache file, followed by the
+	// binary itself
+	struct PROGRAM_CACHE_HEADER
+	{
+		uint32_t magic;
+		GLenum binaryFormat;
+		uint64_t cacheKey;
+		uint32_t length;
+		uint32_t reserved;
+	};
+
+	// most shader stages of a program, vertex and fragment
+	static const int MAX_PROGRAM_SHADERS = 2;
+
+	// a shader program being compiled and linked
+	struct PROGRAM_BUILD
+	{
+		GLuint programID;
+		// stages being compiled, a compute program has only one
+		int numShaders;
+		GLuint shaders[MAX_PROGRAM_SHADERS];
+		std::string shaderPaths[MAX_PROGRAM_SHADERS];
+		uint64_t cacheKey;
+		// loaded from the program binary cache, nothing to wait for
+		bool bFromCache;
+	};
+
+	// OpenGL ID of the linked shader program
+	GLuint m_programID;
+	// GLSL source files of the shader program
+	std::string m_vertexShaderPath;
+	std::string m_fragmentShaderPath;
+	// uniform locations already looked up in the shader program
+	mutable std::unordered_map<std::string, GLint> m_uniformLocations;
+	// binding points of the uniform blocks
+	std::unordered_map<std::string, GLuint> m_uniformBlockBindings;
+	// render stats object used for counting state changes
+	RenderStats* m_pRenderStats;
+	// archive the GLSL sources are read from, NULL for files
+	const AssetArchive* m_pAssetArchive;
+	// folder of the program binary cache, empty when it is off
+	std::string m_programCacheDirectory;
+	// the driver was asked for parallel compiles already
+	bool m_bParallelCompileChecked;
+	// programs begun and not loaded yet, shared by every shader
+	// manager as the programs belong to the OpenGL context
+	static std::vector<PROGRAM_BUILD> m_pendingBuilds;
+
+	// read the text of a GLSL source file
+	bool ReadShaderFile(const char* filePath, std::string& shaderSource);
+	// get the text of a GLSL source, from the asset archive or
+	// read from the file into the passed in string
+	bool GetShaderSource(const char* filePath, std::string& fileSource, const char*& pSource, size_t& length);
+	// start or finish building a program from its sources
+	bool BeginProgramBuild(
+		int numShaders,
+		const GLenum* pShaderTypes,
+		const char* const* pShaderPaths,
+		PROGRAM_BUILD& build);
+	GLuint FinishProgramBuild(PROGRAM_BUILD& build);
+	// take the program begun ahead from the same files, if any
+	bool TakePendingBuild(int numShaders, const char* const* pShaderPaths, PROGRAM_BUILD& build);
+	// free the program and stages of a build that wasn't finished
+	static void DiscardProgramBuild(PROGRAM_BUILD& build);
+	// start compiling one shader stage
+	GLuint CompileShader(GLenum shaderType, const char* pSource, size_t length);
+	// check the compile status, printing the log on failure
+	bool IsShaderCompiled(GLuint shaderID, const char* filePath) const;
+	// let the driver compile on its own threads, if it can
+	void EnableParallelCompile();
+
+	// program binary cache
+	uint64_t GetProgramCacheKey(
+		const char* pVertexSource,
+		size_t vertexLength,
+		const char* pFragmentSource,
+		size_t fragmentLength) const;
+	std::string GetProgramCachePath(uint64_t cacheKey) const;
+	bool LoadProgramBinary(GLuint programID, uint64_t cacheKey);
+	void SaveProgramBinary(GLuint programID, uint64_t cacheKey);
+
+	// set the binding points of the uniform blocks into the program
+	void ApplyUniformBlockBindings();
+
+	// get the cached location of the named uniform
+	GLint GetUniformLocation(const std::string& name) const;
+	// count one uniform write of the passed in size
+	void CountUniformWrite(uint32_t numBytes) const;
+};
@@ -0,0 +1,450 @@
+///////////////////////////////////////////////////////////////////////////////
+// shapemeshes.cpp
+// ============
+// create and draw the meshes of the basic 3D shapes from one geometry pool
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShapeMeshes.h"
+#include "MeshOptimizer.h"
+
+#include <cmath>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	const float PI = 3.14159265358979f;
+
+	// tessellation of the round shapes
+	const int NUM_SLICES = 36;
+	const int NUM_STACKS = 18;
+
+	typedef GeometryPool::VERTEX VERTEX;
+	typedef GeometryPool::MESH_DATA MESH_DATA;
+
+	/***********************************************************
+	 *  AddVertex()
+	 *
+	 *  This function is used to append one vertex to the mesh
+	 *  and get its index.
+	 ***********************************************************/
+	uint32_t AddVertex(MESH_DATA& mesh, glm::vec3 position, glm::vec3 normal, glm::vec2 textureCoordinate)
+	{
+		VERTEX vertex;
+		vertex.position = position;
+		vertex.normal = normal;
+		vertex.textureCoordinate = textureCoordinate;
+		mesh.vertices.push_back(vertex);
+		return((uint32_t)mesh.vertices.size() - 1);
+	}
+
+	/***********************************************************
+	 *  AddGrid()
+	 *
+	 *  This function is used to add the triangles of a grid of
+	 *  vertices stored row by row, rows running from the top
+	 *  down and columns counterclockwise around the outside.
+	 *  Triangles that collapse to a point at a pole are left
+	 *  out.  The line indices outline the rows and columns.
+	 ***********************************************************/
+	void AddGrid(MESH_DATA& mesh, uint32_t firstVertex, int numRows, int numColumns, bool bTopPole, bool bBottomPole)
+	{
+		uint32_t rowLength = (uint32_t)numColumns + 1;
+
+		for (int row = 0; row < numRows; row++)
+		{
+			for (int column = 0; column < numColumns; column++)
+			{
+				uint32_t upperLeft = firstVertex + row * rowLength + column;
+				uint32_t lowerLeft = upperLeft + rowLength;
+
+				if ((row > 0) || (bTopPole == false))
+				{
+					mesh.indices.push_back(upperLeft);
+					mesh.indices.push_back(lowerLeft);
+					mesh.indices.push_back(upperLeft + 1);
+				}
+				if ((row < numRows - 1) || (bBottomPole == false))
+				{
+					mesh.indices.push_back(upperLeft + 1);
+					mesh.indices.push_back(lowerLeft);
+					mesh.indices.push_back(lowerLeft + 1);
+				}
+
+				// the edge down the left of the cell
+				mesh.lineIndices.push_back(upperLeft);
+				mesh.lineIndices.push_back(lowerLeft);
+			}
+		}
+
+		// the edges along the rows, except at the poles
+		for (int row = 0; row <= numRows; row++)
+		{
+			if (((row == 0) && (bTopPole == true)) ||
+				((row == numRows) && (bBottomPole == true)))
+			{
+				continue;
+			}
+			for (int column = 0; column < numColumns; column++)
+			{
+				uint32_t left = firstVertex + row * rowLength + column;
+				mesh.lineIndices.push_back(left);
+				mesh.lineIndices.push_back(left + 1);
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  BuildSphere()
+	 *
+	 *  This function is used to generate a sphere of radius 1,
+	 *  or only its top half, from the north pole down.
+	 ***********************************************************/
+	void BuildSphere(MESH_DATA& mesh, int numSlices, int numStacks, bool bHalf)
+	{
+		int numRows = bHalf ? (numStacks / 2) : numStacks;
+
+		for (int row = 0; row <= numRows; row++)
+		{
+			float latitude = 0.5f * PI - (PI * row) / numStacks;
+			float y = sinf(latitude);
+			float radius = cosf(latitude);
+
+			for (int column = 0; column <= numSlices; column++)
+			{
+				float angle = (2.0f * PI * column) / numSlices;
+				glm::vec3 position(radius * sinf(angle), y, radius * cosf(angle));
+				AddVertex(mesh, position, position, glm::vec2(
+					(float)column / numSlices,
+					1.0f - (float)row / numStacks));
+			}
+		}
+
+		AddGrid(mesh, 0, numRows, numSlices, true, (bHalf == false));
+	}
+}
+
+/***********************************************************
+ *  ShapeMeshes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShapeMeshes::ShapeMeshes()
+{
+	m_pGeometryPool = new GeometryPool();
+	m_planeMesh = -1;
+	m_boxMesh = -1;
+	m_cylinderMesh = -1;
+	m_sphereMesh = -1;
+	m_halfSphereMesh = -1;
+}
+
+/***********************************************************
+ *  ~ShapeMeshes()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShapeMeshes::~ShapeMeshes()
+{
+	delete m_pGeometryPool;
+	m_pGeometryPool = NULL;
+}
+
+/***********************************************************
+ *  SetPackedVertices()
+ *
+ *  This method is used for choosing between the float and
+ *  the packed vertex format.  Switching frees the meshes
+ *  that were already loaded, so it is done before loading.
+ ***********************************************************/
+void ShapeMeshes::SetPackedVertices(bool bPacked)
+{
+	GeometryPool::VERTEX_FORMAT format = (bPacked == true) ?
+		GeometryPool::VERTEX_FORMAT_PACKED :
+		GeometryPool::VERTEX_FORMAT_FLOAT;
+
+	if (format != m_pGeometryPool->GetVertexFormat())
+	{
+		m_pGeometryPool->SetVertexFormat(format);
+		m_planeMesh = -1;
+		m_boxMesh = -1;
+		m_cylinderMesh = -1;
+		m_sphereMesh = -1;
+		m_halfSphereMesh = -1;
+	}
+}
+
+/***********************************************************
+ *  IsPackedVertices()
+ *
+ *  This method is used for checking whether the vertices are
+ *  stored in the packed format.
+ ***********************************************************/
+bool ShapeMeshes::IsPackedVertices() const
+{
+	return(m_pGeometryPool->GetVertexFormat() == GeometryPool::VERTEX_FORMAT_PACKED);
+}
+
+/***********************************************************
+ *  LoadPlaneMesh()
+ *
+ *  This method is used for generating the plane mesh.
+ ***********************************************************/
+void ShapeMeshes::LoadPlaneMesh()
+{
+	MESH_DATA mesh;
+	glm::vec3 normal(0.0f, 1.0f, 0.0f);
+
+	AddVertex(mesh, glm::vec3(-1.0f, 0.0f, 1.0f), normal, glm::vec2(0.0f, 0.0f));
+	AddVertex(mesh, glm::vec3(1.0f, 0.0f, 1.0f), normal, glm::vec2(1.0f, 0.0f));
+	AddVertex(mesh, glm::vec3(1.0f, 0.0f, -1.0f), normal, glm::vec2(1.0f, 1.0f));
+	AddVertex(mesh, glm::vec3(-1.0f, 0.0f, -1.0f), normal, glm::vec2(0.0f, 1.0f));
+
+	const uint32_t indices[] = { 0, 1, 2, 0, 2, 3 };
+	const uint32_t lineIndices[] = { 0, 1, 1, 2, 2, 3, 3, 0 };
+	mesh.indices.assign(indices, indices + 6);
+	mesh.lineIndices.assign(lineIndices, lineIndices + 8);
+
+	m_planeMesh = AddOptimizedMesh("plane", mesh);
+}
+
+/***********************************************************
+ *  LoadBoxMesh()
+ *
+ *  This method is used for generating the box mesh.  Each
+ *  face has its own four vertices so the normals and texture
+ *  coordinates are per face.  The lines are the twelve edges
+ *  of the box.
+ ***********************************************************/
+void ShapeMeshes::LoadBoxMesh()
+{
+	// the normal of each face, and the two directions across
+	// it, chosen so that across x up equals the normal
+	const glm::vec3 faces[6][3] =
+	{
+		{ glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f) },
+		{ glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) }
+	};
+	const glm::vec2 corners[4] =
+	{
+		glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec2(0.0f, 1.0f)
+	};
+
+	MESH_DATA mesh;
+	for (int face = 0; face < 6; face++)
+	{
+		const glm::vec3& normal = faces[face][0];
+		const glm::vec3& across = faces[face][1];
+		const glm::vec3& up = faces[face][2];
+
+		uint32_t first = (uint32_t)mesh.vertices.size();
+		for (int corner = 0; corner < 4; corner++)
+		{
+			glm::vec3 position = 0.5f * normal +
+				(corners[corner].x - 0.5f) * across +
+				(corners[corner].y - 0.5f) * up;
+			AddVertex(mesh, position, normal, corners[corner]);
+		}
+
+		mesh.indices.push_back(first);
+		mesh.indices.push_back(first + 1);
+		mesh.indices.push_back(first + 2);
+		mesh.indices.push_back(first);
+		mesh.indices.push_back(first + 2);
+		mesh.indices.push_back(first + 3);
+
+		// each edge is shared by two faces, keep the first one
+		for (int corner = 0; corner < 4; corner++)
+		{
+			uint32_t a = first + corner;
+			uint32_t b = first + (corner + 1) % 4;
+			bool bFound = false;
+			for (size_t i = 0; (i < mesh.lineIndices.size()) && (bFound == false); i += 2)
+			{
+				const glm::vec3& c = mesh.vertices[mesh.lineIndices[i]].position;
+				const glm::vec3& d = mesh.vertices[mesh.lineIndices[i + 1]].position;
+				const glm::vec3& pa = mesh.vertices[a].position;
+				const glm::vec3& pb = mesh.vertices[b].position;
+				bFound = ((c == pa) && (d == pb)) || ((c == pb) && (d == pa));
+			}
+			if (bFound == false)
+			{
+				mesh.lineIndices.push_back(a);
+				mesh.lineIndices.push_back(b);
+			}
+		}
+	}
+
+	m_boxMesh = AddOptimizedMesh("box", mesh);
+}
+
+/***********************************************************
+ *  LoadCylinderMesh()
+ *
+ *  This method is used for generating the cylinder mesh -
+ *  the side, and a cap on the top and bottom.
+ ***********************************************************/
+void ShapeMeshes::LoadCylinderMesh()
+{
+	MESH_DATA mesh;
+
+	// the side, top edge row first
+	for (int row = 0; row <= 1; row++)
+	{
+		float y = 1.0f - (float)row;
+		for (int column = 0; column <= NUM_SLICES; column++)
+		{
+			float angle = (2.0f * PI * column) / NUM_SLICES;
+			glm::vec3 normal(sinf(angle), 0.0f, cosf(angle));
+			AddVertex(mesh, glm::vec3(normal.x, y, normal.z), normal,
+				glm::vec2((float)column / NUM_SLICES, y));
+		}
+	}
+	AddGrid(mesh, 0, 1, NUM_SLICES, false, false);
+
+	// the caps, as fans around their centers
+	for (int cap = 0; cap < 2; cap++)
+	{
+		float y = (cap == 0) ? 1.0f : 0.0f;
+		glm::vec3 normal(0.0f, (cap == 0) ? 1.0f : -1.0f, 0.0f);
+
+		uint32_t center = AddVertex(mesh, glm::vec3(0.0f, y, 0.0f), normal, glm::vec2(0.5f, 0.5f));
+		for (int column = 0; column <= NUM_SLICES; column++)
+		{
+			float angle = (2.0f * PI * column) / NUM_SLICES;
+			AddVertex(mesh, glm::vec3(sinf(angle), y, cosf(angle)), normal,
+				glm::vec2(0.5f + 0.5f * sinf(angle), 0.5f + 0.5f * cosf(angle)));
+		}
+		for (int column = 0; column < NUM_SLICES; column++)
+		{
+			uint32_t edge = center + 1 + column;
+			mesh.indices.push_back(center);
+			// counterclockwise seen from outside the cap
+			mesh.indices.push_back((cap == 0) ? edge : edge + 1);
+			mesh.indices.push_back((cap == 0) ? edge + 1 : edge);
+		}
+	}
+
+	m_cylinderMesh = AddOptimizedMesh("cylinder", mesh);
+}
+
+/***********************************************************
+ *  LoadSphereMesh()
+ *
+ *  This method is used for generating the sphere mesh and
+ *  the half sphere mesh.
+ ***********************************************************/
+void ShapeMeshes::LoadSphereMesh()
+{
+	MESH_DATA sphere;
+	BuildSphere(sphere, NUM_SLICES, NUM_STACKS, false);
+	m_sphereMesh = AddOptimizedMesh("sphere", sphere);
+
+	MESH_DATA halfSphere;
+	BuildSphere(halfSphere, NUM_SLICES, NUM_STACKS, true);
+	m_halfSphereMesh = AddOptimizedMesh("half sphere", halfSphere);
+}
+
+/***********************************************************
+ *  GenerateSphere()
+ *
+ *  This method is used for generating the triangles of a
+ *  sphere of radius 1 at any tessellation, without adding it
+ *  to the geometry pool.
+ ***********************************************************/
+void ShapeMeshes::GenerateSphere(GeometryPool::MESH_DATA& mesh, int numSlices, int numStacks)
+{
+	mesh.vertices.clear();
+	mesh.indices.clear();
+	mesh.lineIndices.clear();
+	BuildSphere(mesh, numSlices, numStacks, false);
+}
+
+/***********************************************************
+ *  BindMeshes()
+ *
+ *  This method is used for binding the geometry pool that
+ *  holds every mesh, before drawing any of them.
+ ***********************************************************/
+void ShapeMeshes::BindMeshes()
+{
+	m_pGeometryPool->Bind();
+}
+
+/***********************************************************
+ *  AddOptimizedMesh()
+ *
+ *  This method is used for reordering the triangles and
+ *  vertices of a generated mesh for the vertex cache and
+ *  overdraw, printing the vertex cache cost before and after,
+ *  and adding the mesh to the geometry pool.
+ ***********************************************************/
+int ShapeMeshes::AddOptimizedMesh(const char* name, GeometryPool::MESH_DATA& mesh)
+{
+	MeshOptimizer::CACHE_STATS before;
+	MeshOptimizer::CACHE_STATS after;
+	MeshOptimizer::OptimizeMesh(mesh, before, after);
+
+	std::cout << "Optimized mesh:" << name
+		<< ", ACMR:" << before.acmr << " -> " << after.acmr
+		<< ", ATVR:" << before.atvr << " -> " << after.atvr << std::endl;
+
+	return(m_pGeometryPool->AddMesh(mesh));
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for drawing the triangles or lines of
+ *  a loaded mesh from the bound geometry pool.
+ ***********************************************************/
+void ShapeMeshes::DrawMesh(int mesh, bool bLines)
+{
+	if (mesh < 0)
+	{
+		return;
+	}
+
+	if (bLines == true)
+		m_pGeometryPool->DrawMeshLines(mesh);
+	else
+		m_pGeometryPool->DrawMesh(mesh);
+}
+
+void ShapeMeshes::DrawPlaneMesh() { DrawMesh(m_planeMesh, false); }
+void ShapeMeshes::DrawBoxMesh() { DrawMesh(m_boxMesh, false); }
+void ShapeMeshes::DrawCylinderMesh() { DrawMesh(m_cylinderMesh, false); }
+void ShapeMeshes::DrawSphereMesh() { DrawMesh(m_sphereMesh, false); }
+void ShapeMeshes::DrawHalfSphereMesh() { DrawMesh(m_halfSphereMesh, false); }
+
+void ShapeMeshes::DrawPlaneMeshLines() { DrawMesh(m_planeMesh, true); }
+void ShapeMeshes::DrawBoxMeshLines() { DrawMesh(m_boxMesh, true); }
+void ShapeMeshes::DrawCylinderMeshLines() { DrawMesh(m_cylinderMesh, true); }
+void ShapeMeshes::DrawSphereMeshLines() { DrawMesh(m_sphereMesh, true); }
+void ShapeMeshes::DrawHalfSphereMeshLines() { DrawMesh(m_halfSphereMesh, true); }
+
+/***********************************************************
+ *  GetMeshDecode()
+ *
+ *  This method is used for getting the transform from the
+ *  stored positions of a loaded mesh to model space.
+ ***********************************************************/
+glm::mat4 ShapeMeshes::GetMeshDecode(int mesh) const
+{
+	if (mesh < 0)
+	{
+		return(glm::mat4(1.0f));
+	}
+	return(m_pGeometryPool->GetPositionDecode(mesh));
+}
+
+glm::mat4 ShapeMeshes::GetPlaneMeshDecode() const { return(GetMeshDecode(m_planeMesh)); }
+glm::mat4 ShapeMeshes::GetBoxMeshDecode() const { return(GetMeshDecode(m_boxMesh)); }
+glm::mat4 ShapeMeshes::GetCylinderMeshDecode() const { return(GetMeshDecode(m_cylinderMesh)); }
+glm::mat4 ShapeMeshes::GetSphereMeshDecode() const { return(GetMeshDecode(m_sphereMesh)); }
+glm::mat4 ShapeMeshes::GetHalfSphereMeshDecode() const { return(GetMeshDecode(m_halfSphereMesh)); }
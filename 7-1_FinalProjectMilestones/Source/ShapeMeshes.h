@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+// shapemeshes.h
+// ============
+// create and draw the meshes of the basic 3D shapes from one geometry pool
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GeometryPool.h"
+
+/***********************************************************
+ *  ShapeMeshes
+ *
+ *  This class contains the code for generating the basic
+ *  shape meshes - plane, box, cylinder, sphere and half
+ *  sphere - and drawing them.  All of the meshes are kept in
+ *  one geometry pool, so BindMeshes() is called once before
+ *  a run of draws instead of every draw binding the buffers
+ *  of its own mesh.
+ *
+ *  The shapes fit in a 2 x 2 x 2 box around the origin:
+ *      plane       - 2 x 2 in XZ, facing +Y
+ *      box         - 1 x 1 x 1, centered
+ *      cylinder    - radius 1, from Y 0 to Y 1
+ *      sphere      - radius 1, centered
+ *      half sphere - the top half of the sphere, open below
+ *
+ *  Each mesh is reordered for the vertex cache and overdraw
+ *  as it is loaded, and its cost before and after is printed.
+ *
+ *  With packed vertices the positions are stored relative to
+ *  the bounds of each mesh, and the decode transform of the
+ *  mesh has to be applied ahead of its model matrix.
+ ***********************************************************/
+class ShapeMeshes
+{
+public:
+	// constructor
+	ShapeMeshes();
+	// destructor
+	~ShapeMeshes();
+
+	// store the vertices packed into 16 bytes instead of 32,
+	// called before the meshes are loaded
+	void SetPackedVertices(bool bPacked);
+	bool IsPackedVertices() const;
+
+	// generate the meshes and add them to the geometry pool
+	void LoadPlaneMesh();
+	void LoadBoxMesh();
+	void LoadCylinderMesh();
+	// loads both the sphere and the half sphere
+	void LoadSphereMesh();
+
+	// generate a sphere with the passed in tessellation into
+	// mesh data, such as for benchmarks
+	static void GenerateSphere(GeometryPool::MESH_DATA& mesh, int numSlices, int numStacks);
+
+	// bind the geometry pool for the following draws
+	void BindMeshes();
+
+	// draw the triangles of a loaded mesh
+	void DrawPlaneMesh();
+	void DrawBoxMesh();
+	void DrawCylinderMesh();
+	void DrawSphereMesh();
+	void DrawHalfSphereMesh();
+
+	// draw the wireframe lines of a loaded mesh
+	void DrawPlaneMeshLines();
+	void DrawBoxMeshLines();
+	void DrawCylinderMeshLines();
+	void DrawSphereMeshLines();
+	void DrawHalfSphereMeshLines();
+
+	// transform from the stored positions of a loaded mesh to
+	// model space, identity unless the vertices are packed
+	glm::mat4 GetPlaneMeshDecode() const;
+	glm::mat4 GetBoxMeshDecode() const;
+	glm::mat4 GetCylinderMeshDecode() const;
+	glm::mat4 GetSphereMeshDecode() const;
+	glm::mat4 GetHalfSphereMeshDecode() const;
+
+	GeometryPool* GetGeometryPool() { return(m_pGeometryPool); }
+	// mesh IDs of the loaded meshes in the geometry pool
+	int GetPlaneMesh() const { return(m_planeMesh); }
+	int GetBoxMesh() const { return(m_boxMesh); }
+	int GetCylinderMesh() const { return(m_cylinderMesh); }
+	int GetSphereMesh() const { return(m_sphereMesh); }
+	int GetHalfSphereMesh() const { return(m_halfSphereMesh); }
+
+private:
+	GeometryPool* m_pGeometryPool;
+	// mesh IDs in the geometry pool, -1 until loaded
+	int m_planeMesh;
+	int m_boxMesh;
+	int m_cylinderMesh;
+	int m_sphereMesh;
+	int m_halfSphereMesh;
+
+	// optimize the order of a generated mesh, print its vertex
+	// cache cost and add it to the geometry pool
+	int AddOptimizedMesh(const char* name, GeometryPool::MESH_DATA& mesh);
+	// draw a loaded mesh, does nothing for one not loaded
+	void DrawMesh(int mesh, bool bLines);
+	// decode transform of a mesh, identity for one not loaded
+	glm::mat4 GetMeshDecode(int mesh) const;
+};
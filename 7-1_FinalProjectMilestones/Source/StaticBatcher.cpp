@@ -0,0 +1,244 @@
+///////////////////////////////////////////////////////////////////////////////
+// staticbatcher.cpp
+// ============
+// bake the objects that never move into merged world space batches
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "StaticBatcher.h"
+
+/***********************************************************
+ *  StaticBatcher()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+StaticBatcher::StaticBatcher()
+{
+	m_pGeometryPool = new GeometryPool();
+}
+
+/***********************************************************
+ *  ~StaticBatcher()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+StaticBatcher::~StaticBatcher()
+{
+	delete m_pGeometryPool;
+	m_pGeometryPool = NULL;
+}
+
+/***********************************************************
+ *  SetVertexFormat()
+ *
+ *  This method is used for choosing how the vertices of the
+ *  batches are stored, which should match the shape meshes
+ *  as the shaders decode both the same way.
+ ***********************************************************/
+void StaticBatcher::SetVertexFormat(GeometryPool::VERTEX_FORMAT format)
+{
+	m_pGeometryPool->SetVertexFormat(format);
+	m_batches.clear();
+	m_batchData.clear();
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for freeing the batches, so a new set
+ *  can be built.
+ ***********************************************************/
+void StaticBatcher::Clear()
+{
+	m_pGeometryPool->Clear();
+	m_batches.clear();
+	m_batchData.clear();
+}
+
+/***********************************************************
+ *  FindBatch()
+ *
+ *  This method is used for finding the batch the objects of
+ *  an appearance go in.  The color is only part of the
+ *  appearance of untextured objects, as a texture replaces it.
+ ***********************************************************/
+size_t StaticBatcher::FindBatch(int textureSlot, int materialIndex, const glm::vec4& color)
+{
+	for (size_t i = 0; i < m_batches.size(); i++)
+	{
+		if ((m_batches[i].textureSlot == textureSlot) &&
+			(m_batches[i].materialIndex == materialIndex) &&
+			((textureSlot >= 0) || (m_batches[i].color == color)))
+		{
+			return(i);
+		}
+	}
+
+	BATCH batch;
+	batch.mesh = -1;
+	batch.textureSlot = textureSlot;
+	batch.materialIndex = materialIndex;
+	batch.color = color;
+	batch.boundsMin = glm::vec3(0.0f);
+	batch.boundsMax = glm::vec3(0.0f);
+	batch.numObjects = 0;
+	batch.numTriangles = 0;
+	batch.numLines = 0;
+	m_batches.push_back(batch);
+	m_batchData.push_back(GeometryPool::MESH_DATA());
+
+	return(m_batches.size() - 1);
+}
+
+/***********************************************************
+ *  AddObject()
+ *
+ *  This method is used for appending the mesh of one object
+ *  to the batch of its appearance, with its positions moved
+ *  into world space.  The shaders use the mesh normals as
+ *  they are, without the model matrix, so the normals are
+ *  copied as they are too and the object is lit the same as
+ *  when it is drawn on its own.
+ ***********************************************************/
+void StaticBatcher::AddObject(
+	const GeometryPool::MESH_DATA& mesh,
+	const glm::mat4& model,
+	bool bDrawLines,
+	int textureSlot,
+	int materialIndex,
+	const glm::vec4& color)
+{
+	if (mesh.vertices.empty() == true)
+	{
+		return;
+	}
+
+	size_t batchIndex = FindBatch(textureSlot, materialIndex, color);
+	BATCH& batch = m_batches[batchIndex];
+	GeometryPool::MESH_DATA& batchData = m_batchData[batchIndex];
+	uint32_t firstVertex = (uint32_t)batchData.vertices.size();
+
+	batchData.vertices.reserve(batchData.vertices.size() + mesh.vertices.size());
+	for (size_t i = 0; i < mesh.vertices.size(); i++)
+	{
+		GeometryPool::VERTEX vertex = mesh.vertices[i];
+		vertex.position = glm::vec3(model * glm::vec4(vertex.position, 1.0f));
+		if ((batch.numObjects == 0) && (i == 0))
+		{
+			batch.boundsMin = vertex.position;
+			batch.boundsMax = vertex.position;
+		}
+		batch.boundsMin = glm::min(batch.boundsMin, vertex.position);
+		batch.boundsMax = glm::max(batch.boundsMax, vertex.position);
+		batchData.vertices.push_back(vertex);
+	}
+
+	batchData.indices.reserve(batchData.indices.size() + mesh.indices.size());
+	for (size_t i = 0; i < mesh.indices.size(); i++)
+	{
+		batchData.indices.push_back(firstVertex + mesh.indices[i]);
+	}
+	batch.numTriangles += mesh.indices.size() / 3;
+
+	if (bDrawLines == true)
+	{
+		batchData.lineIndices.reserve(batchData.lineIndices.size() + mesh.lineIndices.size());
+		for (size_t i = 0; i < mesh.lineIndices.size(); i++)
+		{
+			batchData.lineIndices.push_back(firstVertex + mesh.lineIndices[i]);
+		}
+		batch.numLines += mesh.lineIndices.size() / 2;
+	}
+
+	batch.numObjects++;
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for adding the merged mesh of every
+ *  batch to the geometry pool of the batches, and freeing
+ *  the mesh data it was built in.
+ ***********************************************************/
+void StaticBatcher::Upload()
+{
+	for (size_t i = 0; i < m_batches.size(); i++)
+	{
+		if (m_batches[i].mesh < 0)
+		{
+			m_batches[i].mesh = m_pGeometryPool->AddMesh(m_batchData[i]);
+		}
+	}
+	m_batchData.clear();
+}
+
+/***********************************************************
+ *  GetPositionDecode()
+ *
+ *  This method is used for getting the transform from the
+ *  stored positions of a batch to world space.
+ ***********************************************************/
+glm::mat4 StaticBatcher::GetPositionDecode(size_t batch) const
+{
+	return(m_pGeometryPool->GetPositionDecode(m_batches[batch].mesh));
+}
+
+/***********************************************************
+ *  GetMemorySize()
+ *
+ *  This method is used for adding up the bytes the vertices
+ *  and indices of the batches take in their buffers.
+ ***********************************************************/
+size_t StaticBatcher::GetMemorySize() const
+{
+	size_t bytes = 0;
+	for (size_t i = 0; i < m_batches.size(); i++)
+	{
+		if (m_batches[i].mesh >= 0)
+		{
+			const GeometryPool::MESH_RANGE& range = m_pGeometryPool->GetMeshRange(m_batches[i].mesh);
+			bytes += range.numVertices * m_pGeometryPool->GetVertexSize();
+			bytes += (range.numIndices + range.numLineIndices) * sizeof(uint32_t);
+		}
+	}
+	return(bytes);
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for binding the vertex array of the
+ *  batches, before drawing any of them.
+ ***********************************************************/
+void StaticBatcher::Bind() const
+{
+	m_pGeometryPool->Bind();
+}
+
+/***********************************************************
+ *  DrawBatch()
+ *
+ *  This method is used for drawing the triangles of every
+ *  object in a batch.
+ ***********************************************************/
+void StaticBatcher::DrawBatch(size_t batch) const
+{
+	if (m_batches[batch].mesh >= 0)
+	{
+		m_pGeometryPool->DrawMesh(m_batches[batch].mesh);
+	}
+}
+
+/***********************************************************
+ *  DrawBatchLines()
+ *
+ *  This method is used for drawing the wireframe lines of
+ *  the objects in a batch that are drawn with lines.
+ ***********************************************************/
+void StaticBatcher::DrawBatchLines(size_t batch) const
+{
+	if ((m_batches[batch].mesh >= 0) && (m_batches[batch].numLines > 0))
+	{
+		m_pGeometryPool->DrawMeshLines(m_batches[batch].mesh);
+	}
+}
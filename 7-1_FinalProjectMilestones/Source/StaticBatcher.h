@@ -0,0 +1,101 @@
+///////////////////////////////////////////////////////////////////////////////
+// staticbatcher.h
+// ============
+// bake the objects that never move into merged world space batches
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GeometryPool.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+/***********************************************************
+ *  StaticBatcher
+ *
+ *  This class contains the code for merging the meshes of
+ *  the objects that don't move into a few large batches, one
+ *  per appearance - texture and material, plus the color for
+ *  untextured objects.  Each object's vertices are moved into
+ *  world space by its model matrix as they are added, so the
+ *  batches are drawn with no transform of their own, and a
+ *  whole batch is one draw call however many objects are in
+ *  it.  The wireframe lines of the objects drawn with lines
+ *  are merged the same way.
+ *
+ *  The batches are kept in a geometry pool of their own, in
+ *  the vertex format of the shape meshes.  Every object in a
+ *  batch has its own copy of its mesh, so the batches take
+ *  more memory than the shared meshes they are made from.
+ ***********************************************************/
+class StaticBatcher
+{
+public:
+	// merged meshes of the objects with one appearance
+	struct BATCH
+	{
+		// mesh ID in the geometry pool of the batches
+		int mesh;
+		int textureSlot;
+		int materialIndex;
+		glm::vec4 color;
+		// world space box around the batch
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		size_t numObjects;
+		uint64_t numTriangles;
+		uint64_t numLines;
+	};
+
+	// constructor
+	StaticBatcher();
+	// destructor
+	~StaticBatcher();
+
+	// store the batches in the passed in vertex format, which
+	// frees any batches already built
+	void SetVertexFormat(GeometryPool::VERTEX_FORMAT format);
+
+	// free the batches to build a new set
+	void Clear();
+	// add the mesh of one object, moved into world space by its
+	// model matrix, to the batch of its appearance
+	void AddObject(
+		const GeometryPool::MESH_DATA& mesh,
+		const glm::mat4& model,
+		bool bDrawLines,
+		int textureSlot,
+		int materialIndex,
+		const glm::vec4& color);
+	// send the added objects to the GPU as the batches
+	void Upload();
+
+	size_t GetBatchCount() const { return(m_batches.size()); }
+	const BATCH& GetBatch(size_t batch) const { return(m_batches[batch]); }
+	// transform from the stored positions of a batch to world
+	// space, identity unless the vertices are packed
+	glm::mat4 GetPositionDecode(size_t batch) const;
+	// bytes of vertices and indices the batches take
+	size_t GetMemorySize() const;
+
+	// bind the geometry pool of the batches for the following
+	// draws
+	void Bind() const;
+	// draw the triangles or wireframe lines of one batch
+	void DrawBatch(size_t batch) const;
+	void DrawBatchLines(size_t batch) const;
+
+private:
+	GeometryPool* m_pGeometryPool;
+	std::vector<BATCH> m_batches;
+	// mesh data of the batches being added to, freed once they
+	// are uploaded
+	std::vector<GeometryPool::MESH_DATA> m_batchData;
+
+	// find the batch of an appearance, adding it if it is new
+	size_t FindBatch(int textureSlot, int materialIndex, const glm::vec4& color);
+};
@@ -0,0 +1,347 @@
+///////////////////////////////////////////////////////////////////////////////
+// staticlayercache.cpp
+// ============
+// keep a color and depth image of the objects that don't move between frames
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "StaticLayerCache.h"
+
+#include "GLFW/glfw3.h"     // GLFW library
+
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// GLSL files of the copy shader program
+	const char* LAYER_VERTEX_SHADER_FILE = "shaders/layerVertexShader.glsl";
+	const char* LAYER_FRAGMENT_SHADER_FILE = "shaders/layerFragmentShader.glsl";
+	const char* g_LayerColorName = "layerColor";
+	const char* g_LayerDepthName = "layerDepth";
+
+	// the scene textures use the first 16 texture units and the
+	// dynamic resolution target the one after them
+	const int LAYER_COLOR_UNIT = 17;
+	const int LAYER_DEPTH_UNIT = 18;
+}
+
+/***********************************************************
+ *  StaticLayerCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+StaticLayerCache::StaticLayerCache()
+{
+	m_pCopyShader = NULL;
+	m_pRenderStats = NULL;
+	m_framebufferID = 0;
+	m_colorTextureID = 0;
+	m_depthTextureID = 0;
+	m_vertexArrayID = 0;
+	m_width = 0;
+	m_height = 0;
+	m_layerWidth = 0;
+	m_layerHeight = 0;
+	m_key.viewProjection = glm::mat4(1.0f);
+	m_key.cameraPosition = glm::vec3(0.0f);
+	m_key.sceneVersion = 0;
+	m_key.drawHash = 0;
+	m_bValid = false;
+	m_bDrawingLayer = false;
+	m_savedFramebuffer = 0;
+}
+
+/***********************************************************
+ *  ~StaticLayerCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+StaticLayerCache::~StaticLayerCache()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the copy shader program,
+ *  the empty vertex array it draws with, and the images at
+ *  the size of the window of the current context.  Returns
+ *  false, with everything freed again, if any of them can't
+ *  be created.
+ ***********************************************************/
+bool StaticLayerCache::Create(const ShaderManager* pSceneShaders)
+{
+	Destroy();
+
+	m_pRenderStats = pSceneShaders->GetRenderStats();
+	m_pCopyShader = new ShaderManager();
+	m_pCopyShader->SetRenderStats(pSceneShaders->GetRenderStats());
+	m_pCopyShader->SetAssetArchive(pSceneShaders->GetAssetArchive());
+	m_pCopyShader->SetProgramCacheDirectory(pSceneShaders->GetProgramCacheDirectory());
+	if (0 == m_pCopyShader->LoadShaders(LAYER_VERTEX_SHADER_FILE, LAYER_FRAGMENT_SHADER_FILE))
+	{
+		std::cout << "Static layer cache is off, the layer shaders did not load" << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	int windowWidth = 0;
+	int windowHeight = 0;
+	glfwGetFramebufferSize(glfwGetCurrentContext(), &windowWidth, &windowHeight);
+	if ((windowWidth <= 0) || (windowHeight <= 0) || (CreateImages(windowWidth, windowHeight) == false))
+	{
+		std::cout << "Static layer cache is off, the layer images could not be made" << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	glGenVertexArrays(1, &m_vertexArrayID);
+
+	std::cout << "Static layer cache on" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the OpenGL objects.
+ ***********************************************************/
+void StaticLayerCache::Destroy()
+{
+	DestroyImages();
+	if (0 != m_vertexArrayID)
+	{
+		glDeleteVertexArrays(1, &m_vertexArrayID);
+		m_vertexArrayID = 0;
+	}
+	if (NULL != m_pCopyShader)
+	{
+		delete m_pCopyShader;
+		m_pCopyShader = NULL;
+	}
+}
+
+/***********************************************************
+ *  DestroyImages()
+ *
+ *  This method is used for freeing the image and its
+ *  framebuffer.
+ ***********************************************************/
+void StaticLayerCache::DestroyImages()
+{
+	if (0 != m_framebufferID)
+	{
+		glDeleteFramebuffers(1, &m_framebufferID);
+		m_framebufferID = 0;
+	}
+	if (0 != m_colorTextureID)
+	{
+		glDeleteTextures(1, &m_colorTextureID);
+		m_colorTextureID = 0;
+	}
+	if (0 != m_depthTextureID)
+	{
+		glDeleteTextures(1, &m_depthTextureID);
+		m_depthTextureID = 0;
+	}
+	m_width = 0;
+	m_height = 0;
+	m_bValid = false;
+}
+
+/***********************************************************
+ *  CreateImages()
+ *
+ *  This method is used for making the color and depth images
+ *  the passed in size.  Both are read texel for texel, so
+ *  they are not filtered.  The texture and framebuffer bound
+ *  before are put back, as the scene textures stay bound to
+ *  their units.
+ ***********************************************************/
+bool StaticLayerCache::CreateImages(int width, int height)
+{
+	DestroyImages();
+
+	GLint boundTexture = 0;
+	GLint boundFramebuffer = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexture);
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &boundFramebuffer);
+
+	glGenTextures(1, &m_colorTextureID);
+	glBindTexture(GL_TEXTURE_2D, m_colorTextureID);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	glGenTextures(1, &m_depthTextureID);
+	glBindTexture(GL_TEXTURE_2D, m_depthTextureID);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, (GLuint)boundTexture);
+
+	glGenFramebuffers(1, &m_framebufferID);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_colorTextureID, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depthTextureID, 0);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)boundFramebuffer);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Static layer image is not complete:" << status << std::endl;
+		DestroyImages();
+		return(false);
+	}
+
+	m_width = width;
+	m_height = height;
+	return(true);
+}
+
+/***********************************************************
+ *  IsValid()
+ *
+ *  This method is used for checking whether the image can be
+ *  used for the frame - it was drawn with the same key, into
+ *  a corner the size of the current viewport.
+ ***********************************************************/
+bool StaticLayerCache::IsValid(const LAYER_KEY& key) const
+{
+	if (m_bValid == false)
+	{
+		return(false);
+	}
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	return((viewport[2] == m_layerWidth) && (viewport[3] == m_layerHeight) &&
+		(key.sceneVersion == m_key.sceneVersion) &&
+		(key.drawHash == m_key.drawHash) &&
+		(key.cameraPosition == m_key.cameraPosition) &&
+		(key.viewProjection == m_key.viewProjection));
+}
+
+/***********************************************************
+ *  BeginLayer()
+ *
+ *  This method is used for switching the drawing over to the
+ *  image, keeping the viewport, so the layer is drawn into
+ *  its lower left corner, and clearing it with the clear
+ *  values of the frame.  The image is only marked valid once
+ *  it is drawn.
+ ***********************************************************/
+void StaticLayerCache::BeginLayer(const LAYER_KEY& key)
+{
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &m_savedFramebuffer);
+
+	// a viewport the image can't hold has the layer drawn
+	// straight into the frame, and not copied
+	m_bValid = false;
+	m_bDrawingLayer = false;
+	if ((0 == m_framebufferID) || (viewport[0] != 0) || (viewport[1] != 0) ||
+		(viewport[2] > m_width) || (viewport[3] > m_height))
+	{
+		return;
+	}
+
+	m_bDrawingLayer = true;
+	m_key = key;
+	m_layerWidth = viewport[2];
+	m_layerHeight = viewport[3];
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+/***********************************************************
+ *  EndLayer()
+ *
+ *  This method is used for switching the drawing back to the
+ *  framebuffer of the frame.  A layer drawn straight into the
+ *  frame leaves the image invalid, so it is not copied.
+ ***********************************************************/
+void StaticLayerCache::EndLayer()
+{
+	if (m_bDrawingLayer == false)
+	{
+		return;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)m_savedFramebuffer);
+	m_bDrawingLayer = false;
+	m_bValid = true;
+}
+
+/***********************************************************
+ *  DrawLayer()
+ *
+ *  This method is used for copying the image into the color
+ *  and depth of the frame, with a triangle over the whole
+ *  viewport that writes every depth as it is in the image.
+ *  Nothing is copied when the layer was drawn straight into
+ *  the frame.
+ ***********************************************************/
+void StaticLayerCache::DrawLayer()
+{
+	if (m_bValid == false)
+	{
+		return;
+	}
+
+	// the textures are bound every time, as a texture loaded
+	// since may have been bound to the units
+	glActiveTexture(GL_TEXTURE0 + LAYER_COLOR_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_colorTextureID);
+	glActiveTexture(GL_TEXTURE0 + LAYER_DEPTH_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_depthTextureID);
+	glActiveTexture(GL_TEXTURE0);
+
+	m_pCopyShader->use();
+	m_pCopyShader->setSampler2DValue(g_LayerColorName, LAYER_COLOR_UNIT);
+	m_pCopyShader->setSampler2DValue(g_LayerDepthName, LAYER_DEPTH_UNIT);
+
+	// the depth test stays on, as it has to be for the depth
+	// to be written, but always passes
+	glDepthFunc(GL_ALWAYS);
+	glDisable(GL_BLEND);
+	glBindVertexArray(m_vertexArrayID);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	glEnable(GL_BLEND);
+	glDepthFunc(GL_LESS);
+
+	if (NULL != m_pRenderStats)
+	{
+		m_pRenderStats->CountTextureBind();
+		m_pRenderStats->CountTextureBind();
+	}
+}
+
+/***********************************************************
+ *  BeginLoadShaders()
+ *
+ *  This method is used for starting to build the copy
+ *  shader program, so it compiles while the other programs
+ *  of startup do.  Create() finishes it.
+ ***********************************************************/
+void StaticLayerCache::BeginLoadShaders(ShaderManager* pSceneShaders)
+{
+	pSceneShaders->BeginLoadShaders(LAYER_VERTEX_SHADER_FILE, LAYER_FRAGMENT_SHADER_FILE);
+}
+
+/***********************************************************
+ *  GetShaderFiles()
+ *
+ *  This method is used for getting the GLSL files of the
+ *  copy shader program, for packing them in the asset
+ *  archive.
+ ***********************************************************/
+void StaticLayerCache::GetShaderFiles(std::vector<std::string>& files)
+{
+	files.push_back(LAYER_VERTEX_SHADER_FILE);
+	files.push_back(LAYER_FRAGMENT_SHADER_FILE);
+}
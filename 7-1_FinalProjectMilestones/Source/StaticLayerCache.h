@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////////////////////////////////
+// staticlayercache.h
+// ============
+// keep a color and depth image of the objects that don't move between frames
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "RenderStats.h"
+
+#include <GL/glew.h>        // GLEW library
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  StaticLayerCache
+ *
+ *  This class contains the code for drawing the objects that
+ *  don't move once, into a color and depth image, and using
+ *  the image in the frames after for as long as the camera
+ *  stays still.  Those frames copy the image into their own
+ *  color and depth, and only draw the objects that move, so
+ *  the moving objects are still hidden behind the objects in
+ *  the image.
+ *
+ *  The image is kept with a key of everything it was drawn
+ *  from - the view projection and the camera position, the
+ *  size of the viewport, a version the scene bumps whenever
+ *  the objects in it or their look change, and a hash of
+ *  the objects that passed the culling.  Any difference
+ *  draws the image again, in the frame it is found.
+ *
+ *  The image is made once, at the size of the window, and
+ *  the layer is drawn into its lower left corner at the size
+ *  of the frame's viewport, which has to start at the corner
+ *  of the framebuffer.  With dynamic resolution the viewport
+ *  changes with the scale, which only draws the layer again
+ *  and never makes the image again.
+ ***********************************************************/
+class StaticLayerCache
+{
+public:
+	// everything the static layer image is drawn from
+	struct LAYER_KEY
+	{
+		glm::mat4 viewProjection;
+		glm::vec3 cameraPosition;
+		uint32_t sceneVersion;
+		uint64_t drawHash;
+	};
+
+	// constructor
+	StaticLayerCache();
+	// destructor
+	~StaticLayerCache();
+
+	// create the copy shader program, loaded the same way as
+	// the scene shaders, and the images at the window size
+	bool Create(const ShaderManager* pSceneShaders);
+	// free the OpenGL objects
+	void Destroy();
+
+	// check whether the image was drawn with the passed in key
+	// at the size of the current viewport
+	bool IsValid(const LAYER_KEY& key) const;
+	// forget the image, so the next frame draws it again
+	void Invalidate() { m_bValid = false; }
+
+	// switch the drawing over to the corner of the image the
+	// size of the current viewport, and clear it
+	void BeginLayer(const LAYER_KEY& key);
+	// switch the drawing back to the framebuffer of the frame
+	void EndLayer();
+
+	// copy the color and depth of the image into the frame,
+	// the caller makes the scene shader program active again
+	void DrawLayer();
+
+	// get the GLSL files of the copy shader program
+	static void GetShaderFiles(std::vector<std::string>& files);
+	// start building the copy shader program ahead of
+	// Create(), with the other programs of startup
+	static void BeginLoadShaders(ShaderManager* pSceneShaders);
+
+private:
+	// copy shader program
+	ShaderManager* m_pCopyShader;
+	RenderStats* m_pRenderStats;
+	// image of the static layer
+	GLuint m_framebufferID;
+	GLuint m_colorTextureID;
+	GLuint m_depthTextureID;
+	// empty vertex array, the copy triangle has no vertices
+	GLuint m_vertexArrayID;
+	int m_width;
+	int m_height;
+
+	// key the image was drawn with, and the size of the
+	// viewport it was drawn at
+	LAYER_KEY m_key;
+	int m_layerWidth;
+	int m_layerHeight;
+	bool m_bValid;
+	// set while the layer is drawn into the image, and not
+	// straight into the frame
+	bool m_bDrawingLayer;
+	// framebuffer of the frame, put back after the layer
+	GLint m_savedFramebuffer;
+
+	// make the images the passed in size
+	bool CreateImages(int width, int height);
+	void DestroyImages();
+};
@@ -0,0 +1,556 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformbatch.cpp
+// ============
+// structure-of-arrays transform store with SIMD model matrix kernels
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransformBatch.h"
+#include "TransformBatchAVX2.h"
+
+#include <glm/gtx/transform.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include <emmintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// declaration of the global variables and defines
+namespace
+{
+	const float DEGREES_TO_RADIANS = 3.14159265358979f / 180.0f;
+
+	// Cephes single precision sine and cosine constants
+	const float FOUR_OVER_PI = 1.27323954473516f;
+	const float PI_OVER_4_PART1 = -0.78515625f;
+	const float PI_OVER_4_PART2 = -2.4187564849853515625e-4f;
+	const float PI_OVER_4_PART3 = -3.77489497744594108e-8f;
+	const float SIN_COEF0 = -1.9515295891e-4f;
+	const float SIN_COEF1 = 8.3321608736e-3f;
+	const float SIN_COEF2 = -1.6666654611e-1f;
+	const float COS_COEF0 = 2.443315711809948e-5f;
+	const float COS_COEF1 = -1.388731625493765e-3f;
+	const float COS_COEF2 = 4.166664568298827e-2f;
+
+	// times each kernel is run by the benchmark, best one counts
+	const int BENCHMARK_RUNS = 5;
+
+	/***********************************************************
+	 *  SinCosSSE2()
+	 *
+	 *  This function is used for calculating the sine and cosine
+	 *  of four angles in radians at once.  The angle is reduced
+	 *  to an octant, then both polynomials are evaluated and
+	 *  selected per lane, with no branches.
+	 ***********************************************************/
+	void SinCosSSE2(__m128 x, __m128& sinResult, __m128& cosResult)
+	{
+		const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32((int)0x80000000));
+
+		__m128 sinSign = _mm_and_ps(x, signMask);
+		x = _mm_andnot_ps(signMask, x);
+
+		// octant of the angle, rounded up to an even number
+		__m128i octant = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(FOUR_OVER_PI)));
+		octant = _mm_add_epi32(octant, _mm_set1_epi32(1));
+		octant = _mm_and_si128(octant, _mm_set1_epi32(~1));
+		__m128 y = _mm_cvtepi32_ps(octant);
+
+		__m128 sinSwap = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(octant, _mm_set1_epi32(4)), 29));
+		__m128 polyMask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(octant, _mm_set1_epi32(2)), _mm_setzero_si128()));
+		__m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(
+			_mm_andnot_si128(_mm_sub_epi32(octant, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+		sinSign = _mm_xor_ps(sinSign, sinSwap);
+
+		// extended precision reduction to [-pi/4, pi/4]
+		x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(PI_OVER_4_PART1)));
+		x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(PI_OVER_4_PART2)));
+		x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(PI_OVER_4_PART3)));
+		__m128 z = _mm_mul_ps(x, x);
+
+		// cosine polynomial
+		__m128 cosPoly = _mm_set1_ps(COS_COEF0);
+		cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(COS_COEF1));
+		cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(COS_COEF2));
+		cosPoly = _mm_mul_ps(_mm_mul_ps(cosPoly, z), z);
+		cosPoly = _mm_sub_ps(cosPoly, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+		cosPoly = _mm_add_ps(cosPoly, _mm_set1_ps(1.0f));
+
+		// sine polynomial
+		__m128 sinPoly = _mm_set1_ps(SIN_COEF0);
+		sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(SIN_COEF1));
+		sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(SIN_COEF2));
+		sinPoly = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinPoly, z), x), x);
+
+		// pick the polynomial that matches each octant
+		__m128 sinValue = _mm_or_ps(_mm_and_ps(polyMask, sinPoly), _mm_andnot_ps(polyMask, cosPoly));
+		__m128 cosValue = _mm_or_ps(_mm_and_ps(polyMask, cosPoly), _mm_andnot_ps(polyMask, sinPoly));
+
+		sinResult = _mm_xor_ps(sinValue, sinSign);
+		cosResult = _mm_xor_ps(cosValue, cosSign);
+	}
+
+	/***********************************************************
+	 *  StoreColumnsSSE2()
+	 *
+	 *  This function is used for transposing one matrix column
+	 *  of four objects from component arrays into the column
+	 *  of each object's matrix.
+	 ***********************************************************/
+	void StoreColumnsSSE2(__m128 x, __m128 y, __m128 z, __m128 w, glm::mat4* pModels, int column)
+	{
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_ps(&pModels[0][column][0], x);
+		_mm_storeu_ps(&pModels[1][column][0], y);
+		_mm_storeu_ps(&pModels[2][column][0], z);
+		_mm_storeu_ps(&pModels[3][column][0], w);
+	}
+
+	/***********************************************************
+	 *  ComputeModelMatrixGLM()
+	 *
+	 *  This function is used for calculating the model matrix
+	 *  the way SceneManager::SetTransformations() does, as the
+	 *  reference for the benchmark.
+	 ***********************************************************/
+	glm::mat4 ComputeModelMatrixGLM(
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ)
+	{
+		glm::mat4 scale = glm::scale(scaleXYZ);
+		glm::mat4 rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
+		glm::mat4 rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
+		glm::mat4 translation = glm::translate(positionXYZ);
+
+		return(translation * rotationZ * rotationY * rotationX * scale);
+	}
+
+	/***********************************************************
+	 *  GetMaxError()
+	 *
+	 *  This function is used for finding the largest difference
+	 *  between the elements of two lists of matrices.
+	 ***********************************************************/
+	float GetMaxError(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b)
+	{
+		float maxError = 0.0f;
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				for (int row = 0; row < 4; row++)
+				{
+					float error = fabsf(a[i][column][row] - b[i][column][row]);
+					if (error > maxError)
+					{
+						maxError = error;
+					}
+				}
+			}
+		}
+		return(maxError);
+	}
+}
+
+/***********************************************************
+ *  TransformBatch()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TransformBatch::TransformBatch()
+{
+}
+
+/***********************************************************
+ *  AddTransform()
+ *
+ *  This method is used for adding the transformation values
+ *  of one object to the end of the arrays.
+ ***********************************************************/
+size_t TransformBatch::AddTransform(
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	m_scaleX.push_back(scaleXYZ.x);
+	m_scaleY.push_back(scaleXYZ.y);
+	m_scaleZ.push_back(scaleXYZ.z);
+	m_rotationX.push_back(XrotationDegrees);
+	m_rotationY.push_back(YrotationDegrees);
+	m_rotationZ.push_back(ZrotationDegrees);
+	m_positionX.push_back(positionXYZ.x);
+	m_positionY.push_back(positionXYZ.y);
+	m_positionZ.push_back(positionXYZ.z);
+
+	return(m_positionX.size() - 1);
+}
+
+/***********************************************************
+ *  SetTransform()
+ *
+ *  This method is used for replacing the transformation
+ *  values of an object that was already added.
+ ***********************************************************/
+void TransformBatch::SetTransform(
+	size_t index,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	if (index >= GetCount())
+	{
+		return;
+	}
+
+	m_scaleX[index] = scaleXYZ.x;
+	m_scaleY[index] = scaleXYZ.y;
+	m_scaleZ[index] = scaleXYZ.z;
+	m_rotationX[index] = XrotationDegrees;
+	m_rotationY[index] = YrotationDegrees;
+	m_rotationZ[index] = ZrotationDegrees;
+	m_positionX[index] = positionXYZ.x;
+	m_positionY[index] = positionXYZ.y;
+	m_positionZ[index] = positionXYZ.z;
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all the transforms.
+ ***********************************************************/
+void TransformBatch::Clear()
+{
+	m_scaleX.clear();
+	m_scaleY.clear();
+	m_scaleZ.clear();
+	m_rotationX.clear();
+	m_rotationY.clear();
+	m_rotationZ.clear();
+	m_positionX.clear();
+	m_positionY.clear();
+	m_positionZ.clear();
+}
+
+/***********************************************************
+ *  ComputeModelMatrices()
+ *
+ *  This method is used for calculating the model matrices of
+ *  a range of objects with the widest supported kernel.  It
+ *  only reads the arrays, so separate ranges can be computed
+ *  on separate threads.
+ ***********************************************************/
+void TransformBatch::ComputeModelMatrices(size_t begin, size_t end, glm::mat4* pModels) const
+{
+	// checked once, the CPU will not change while running
+	static const KERNEL_TYPE bestKernel = GetBestKernel();
+
+	ComputeModelMatrices(begin, end, pModels, bestKernel);
+}
+
+/***********************************************************
+ *  ComputeModelMatrices()
+ *
+ *  This method is used for calculating the model matrices of
+ *  a range of objects with the passed in kernel.
+ ***********************************************************/
+void TransformBatch::ComputeModelMatrices(size_t begin, size_t end, glm::mat4* pModels, KERNEL_TYPE kernel) const
+{
+	if (end > GetCount())
+	{
+		end = GetCount();
+	}
+	if ((NULL == pModels) || (begin >= end))
+	{
+		return;
+	}
+
+	switch (kernel)
+	{
+	case KERNEL_AVX2:
+		ComputeAVX2(begin, end, pModels);
+		break;
+	case KERNEL_SSE2:
+		ComputeSSE2(begin, end, pModels);
+		break;
+	default:
+		ComputeScalar(begin, end, pModels);
+		break;
+	}
+}
+
+/***********************************************************
+ *  GetBestKernel()
+ *
+ *  This method is used for finding the widest kernel that
+ *  the CPU and the operating system support.  AVX2 needs the
+ *  CPU feature bit and the OS saving the YMM registers.
+ ***********************************************************/
+TransformBatch::KERNEL_TYPE TransformBatch::GetBestKernel()
+{
+	bool bAVX2 = false;
+
+#if defined(_MSC_VER)
+	int cpuInfo[4];
+	__cpuid(cpuInfo, 0);
+	if (cpuInfo[0] >= 7)
+	{
+		__cpuid(cpuInfo, 1);
+		bool bOSXSave = (cpuInfo[2] & (1 << 27)) != 0;
+		bool bAVX = (cpuInfo[2] & (1 << 28)) != 0;
+		if ((bOSXSave == true) && (bAVX == true) && ((_xgetbv(0) & 0x6) == 0x6))
+		{
+			__cpuidex(cpuInfo, 7, 0);
+			bAVX2 = (cpuInfo[1] & (1 << 5)) != 0;
+		}
+	}
+#elif defined(__GNUC__)
+	bAVX2 = (__builtin_cpu_supports("avx2") != 0);
+#endif
+
+	if (bAVX2 == true)
+	{
+		return(KERNEL_AVX2);
+	}
+	// SSE2 is part of every CPU this application targets
+	return(KERNEL_SSE2);
+}
+
+/***********************************************************
+ *  GetKernelName()
+ *
+ *  This method is used for getting the display name of a
+ *  kernel.
+ ***********************************************************/
+const char* TransformBatch::GetKernelName(KERNEL_TYPE kernel)
+{
+	switch (kernel)
+	{
+	case KERNEL_AVX2:
+		return("AVX2");
+	case KERNEL_SSE2:
+		return("SSE2");
+	default:
+		return("scalar");
+	}
+}
+
+/***********************************************************
+ *  ComputeScalar()
+ *
+ *  This method is used for calculating the model matrices
+ *  one object at a time.  With c and s the cosine and sine
+ *  of the X (a), Y (b) and Z (c) angles, the rotation part
+ *  of translate * Rz * Ry * Rx * scale has the columns
+ *      sx * ( cz*cy,            sz*cy,            -sy   )
+ *      sy * ( cz*sy*sx - sz*cx, sz*sy*sx + cz*cx, cy*sx )
+ *      sz * ( cz*sy*cx + sz*sx, sz*sy*cx - cz*sx, cy*cx )
+ *  and the position is the last column.
+ ***********************************************************/
+void TransformBatch::ComputeScalar(size_t begin, size_t end, glm::mat4* pModels) const
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		float angleX = m_rotationX[i] * DEGREES_TO_RADIANS;
+		float angleY = m_rotationY[i] * DEGREES_TO_RADIANS;
+		float angleZ = m_rotationZ[i] * DEGREES_TO_RADIANS;
+		float cx = cosf(angleX);
+		float sx = sinf(angleX);
+		float cy = cosf(angleY);
+		float sy = sinf(angleY);
+		float cz = cosf(angleZ);
+		float sz = sinf(angleZ);
+
+		glm::mat4& model = pModels[i];
+		model[0][0] = cz * cy * m_scaleX[i];
+		model[0][1] = sz * cy * m_scaleX[i];
+		model[0][2] = -sy * m_scaleX[i];
+		model[0][3] = 0.0f;
+		model[1][0] = (cz * sy * sx - sz * cx) * m_scaleY[i];
+		model[1][1] = (sz * sy * sx + cz * cx) * m_scaleY[i];
+		model[1][2] = cy * sx * m_scaleY[i];
+		model[1][3] = 0.0f;
+		model[2][0] = (cz * sy * cx + sz * sx) * m_scaleZ[i];
+		model[2][1] = (sz * sy * cx - cz * sx) * m_scaleZ[i];
+		model[2][2] = cy * cx * m_scaleZ[i];
+		model[2][3] = 0.0f;
+		model[3][0] = m_positionX[i];
+		model[3][1] = m_positionY[i];
+		model[3][2] = m_positionZ[i];
+		model[3][3] = 1.0f;
+	}
+}
+
+/***********************************************************
+ *  ComputeSSE2()
+ *
+ *  This method is used for calculating the model matrices
+ *  four objects at a time with the same closed form as
+ *  ComputeScalar().
+ ***********************************************************/
+void TransformBatch::ComputeSSE2(size_t begin, size_t end, glm::mat4* pModels) const
+{
+	const __m128 toRadians = _mm_set1_ps(DEGREES_TO_RADIANS);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	size_t i = begin;
+	for (; i + 4 <= end; i += 4)
+	{
+		__m128 sx, cx, sy, cy, sz, cz;
+		SinCosSSE2(_mm_mul_ps(_mm_loadu_ps(&m_rotationX[i]), toRadians), sx, cx);
+		SinCosSSE2(_mm_mul_ps(_mm_loadu_ps(&m_rotationY[i]), toRadians), sy, cy);
+		SinCosSSE2(_mm_mul_ps(_mm_loadu_ps(&m_rotationZ[i]), toRadians), sz, cz);
+
+		__m128 scaleX = _mm_loadu_ps(&m_scaleX[i]);
+		__m128 scaleY = _mm_loadu_ps(&m_scaleY[i]);
+		__m128 scaleZ = _mm_loadu_ps(&m_scaleZ[i]);
+
+		// shared products of the closed form
+		__m128 czsy = _mm_mul_ps(cz, sy);
+		__m128 szsy = _mm_mul_ps(sz, sy);
+
+		__m128 m00 = _mm_mul_ps(_mm_mul_ps(cz, cy), scaleX);
+		__m128 m01 = _mm_mul_ps(_mm_mul_ps(sz, cy), scaleX);
+		__m128 m02 = _mm_sub_ps(zero, _mm_mul_ps(sy, scaleX));
+		__m128 m10 = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(czsy, sx), _mm_mul_ps(sz, cx)), scaleY);
+		__m128 m11 = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(szsy, sx), _mm_mul_ps(cz, cx)), scaleY);
+		__m128 m12 = _mm_mul_ps(_mm_mul_ps(cy, sx), scaleY);
+		__m128 m20 = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(czsy, cx), _mm_mul_ps(sz, sx)), scaleZ);
+		__m128 m21 = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(szsy, cx), _mm_mul_ps(cz, sx)), scaleZ);
+		__m128 m22 = _mm_mul_ps(_mm_mul_ps(cy, cx), scaleZ);
+
+		StoreColumnsSSE2(m00, m01, m02, zero, &pModels[i], 0);
+		StoreColumnsSSE2(m10, m11, m12, zero, &pModels[i], 1);
+		StoreColumnsSSE2(m20, m21, m22, zero, &pModels[i], 2);
+		StoreColumnsSSE2(
+			_mm_loadu_ps(&m_positionX[i]),
+			_mm_loadu_ps(&m_positionY[i]),
+			_mm_loadu_ps(&m_positionZ[i]),
+			one, &pModels[i], 3);
+	}
+
+	// leftover objects
+	ComputeScalar(i, end, pModels);
+}
+
+/***********************************************************
+ *  ComputeAVX2()
+ *
+ *  This method is used for calculating the model matrices
+ *  eight objects at a time with the AVX2 kernel, which is
+ *  handed raw pointers to the arrays and the matrices.
+ ***********************************************************/
+void TransformBatch::ComputeAVX2(size_t begin, size_t end, glm::mat4* pModels) const
+{
+	TRANSFORM_ARRAYS arrays;
+	arrays.pScaleX = m_scaleX.data();
+	arrays.pScaleY = m_scaleY.data();
+	arrays.pScaleZ = m_scaleZ.data();
+	arrays.pRotationX = m_rotationX.data();
+	arrays.pRotationY = m_rotationY.data();
+	arrays.pRotationZ = m_rotationZ.data();
+	arrays.pPositionX = m_positionX.data();
+	arrays.pPositionY = m_positionY.data();
+	arrays.pPositionZ = m_positionZ.data();
+
+	// a glm::mat4 is 16 column-major floats
+	size_t i = ComputeModelMatricesAVX2(&arrays, begin, end, reinterpret_cast<float*>(pModels));
+
+	// leftover objects
+	ComputeScalar(i, end, pModels);
+}
+
+/***********************************************************
+ *  RunBenchmark()
+ *
+ *  This method is used for timing the glm matrix path and
+ *  every kernel the CPU supports over the same set of random
+ *  transforms.  The largest difference from the glm result is
+ *  printed with each kernel's time.
+ ***********************************************************/
+void TransformBatch::RunBenchmark(size_t numTransforms)
+{
+	if (numTransforms == 0)
+	{
+		return;
+	}
+
+	// random transforms in the range the scene uses
+	TransformBatch batch;
+	srand(330);
+	for (size_t i = 0; i < numTransforms; i++)
+	{
+		float r[9];
+		for (int j = 0; j < 9; j++)
+		{
+			r[j] = (float)rand() / (float)RAND_MAX;
+		}
+		batch.AddTransform(
+			glm::vec3(0.1f + r[0] * 10.0f, 0.1f + r[1] * 10.0f, 0.1f + r[2] * 10.0f),
+			r[3] * 720.0f - 360.0f,
+			r[4] * 720.0f - 360.0f,
+			r[5] * 720.0f - 360.0f,
+			glm::vec3(r[6] * 40.0f - 20.0f, r[7] * 40.0f - 20.0f, r[8] * 40.0f - 20.0f));
+	}
+
+	std::vector<glm::mat4> reference(numTransforms);
+	std::vector<glm::mat4> results(numTransforms);
+
+	std::cout << "Transform benchmark, " << numTransforms << " transforms, best of "
+		<< BENCHMARK_RUNS << " runs" << std::endl;
+
+	// glm path
+	double glmTime = 0.0;
+	for (int run = 0; run < BENCHMARK_RUNS; run++)
+	{
+		auto startTime = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < numTransforms; i++)
+		{
+			reference[i] = ComputeModelMatrixGLM(
+				glm::vec3(batch.m_scaleX[i], batch.m_scaleY[i], batch.m_scaleZ[i]),
+				batch.m_rotationX[i],
+				batch.m_rotationY[i],
+				batch.m_rotationZ[i],
+				glm::vec3(batch.m_positionX[i], batch.m_positionY[i], batch.m_positionZ[i]));
+		}
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+		if ((run == 0) || (elapsed.count() < glmTime))
+		{
+			glmTime = elapsed.count();
+		}
+	}
+	std::cout << "  glm:    " << glmTime << " ms" << std::endl;
+
+	KERNEL_TYPE bestKernel = GetBestKernel();
+	for (int kernel = KERNEL_SCALAR; kernel <= bestKernel; kernel++)
+	{
+		double kernelTime = 0.0;
+		for (int run = 0; run < BENCHMARK_RUNS; run++)
+		{
+			auto startTime = std::chrono::high_resolution_clock::now();
+			batch.ComputeModelMatrices(0, numTransforms, results.data(), (KERNEL_TYPE)kernel);
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+			if ((run == 0) || (elapsed.count() < kernelTime))
+			{
+				kernelTime = elapsed.count();
+			}
+		}
+
+		std::cout << "  " << GetKernelName((KERNEL_TYPE)kernel) << ": " << kernelTime << " ms ("
+			<< (glmTime / kernelTime) << "x), max error " << GetMaxError(reference, results) << std::endl;
+	}
+}
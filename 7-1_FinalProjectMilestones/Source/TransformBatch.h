@@ -0,0 +1,93 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformbatch.h
+// ============
+// structure-of-arrays transform store with SIMD model matrix kernels
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+/***********************************************************
+ *  TransformBatch
+ *
+ *  This class contains the scale, Euler rotation and position
+ *  of many objects stored as separate arrays, and the kernels
+ *  that turn them into model matrices.  The matrix is built
+ *  in closed form - the same result as
+ *      translate * rotateZ * rotateY * rotateX * scale
+ *  without building and multiplying the five matrices.
+ *
+ *  The arrays let the SIMD kernels load the same component
+ *  of 4 (SSE2) or 8 (AVX2) objects with one instruction.  The
+ *  widest kernel the CPU supports is picked at start up, and
+ *  the scalar kernel is always available as the fallback.
+ ***********************************************************/
+class TransformBatch
+{
+public:
+	enum KERNEL_TYPE
+	{
+		KERNEL_SCALAR = 0,
+		KERNEL_SSE2,
+		KERNEL_AVX2
+	};
+
+	// constructor
+	TransformBatch();
+
+	// add one object's transformation values, returns its index
+	size_t AddTransform(
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+	// replace the transformation values of an object
+	void SetTransform(
+		size_t index,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+	void Clear();
+	size_t GetCount() const { return(m_positionX.size()); }
+
+	// calculate the model matrices of the objects in [begin, end)
+	// into pModels[begin] to pModels[end - 1]
+	void ComputeModelMatrices(size_t begin, size_t end, glm::mat4* pModels) const;
+	// same as above with a specific kernel, for testing
+	void ComputeModelMatrices(size_t begin, size_t end, glm::mat4* pModels, KERNEL_TYPE kernel) const;
+
+	// widest kernel supported by this CPU
+	static KERNEL_TYPE GetBestKernel();
+	static const char* GetKernelName(KERNEL_TYPE kernel);
+
+	// time the kernels against the glm matrix path and print
+	// the results to the console
+	static void RunBenchmark(size_t numTransforms);
+
+private:
+	// transformation values, one entry per object
+	std::vector<float> m_scaleX;
+	std::vector<float> m_scaleY;
+	std::vector<float> m_scaleZ;
+	std::vector<float> m_rotationX;
+	std::vector<float> m_rotationY;
+	std::vector<float> m_rotationZ;
+	std::vector<float> m_positionX;
+	std::vector<float> m_positionY;
+	std::vector<float> m_positionZ;
+
+	// the kernels - each one handles its whole range, the SIMD
+	// kernels finish any leftover objects with the scalar code
+	void ComputeScalar(size_t begin, size_t end, glm::mat4* pModels) const;
+	void ComputeSSE2(size_t begin, size_t end, glm::mat4* pModels) const;
+	// calls into TransformBatchAVX2.cpp, built with AVX2 enabled
+	void ComputeAVX2(size_t begin, size_t end, glm::mat4* pModels) const;
+};
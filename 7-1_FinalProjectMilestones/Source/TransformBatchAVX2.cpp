@@ -0,0 +1,176 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformbatchavx2.cpp
+// ============
+// AVX2 model matrix kernel of the transform batch - this file is built with
+// AVX2 code generation enabled (/arch:AVX2, or -mavx2 with gcc and clang)
+// and is only called after TransformBatch::GetBestKernel() found AVX2, so
+// it includes nothing with inline code but the intrinsics
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransformBatchAVX2.h"
+
+#include <immintrin.h>
+
+// declaration of the global variables and defines
+namespace
+{
+	const float DEGREES_TO_RADIANS = 3.14159265358979f / 180.0f;
+
+	// Cephes single precision sine and cosine constants
+	const float FOUR_OVER_PI = 1.27323954473516f;
+	const float PI_OVER_4_PART1 = -0.78515625f;
+	const float PI_OVER_4_PART2 = -2.4187564849853515625e-4f;
+	const float PI_OVER_4_PART3 = -3.77489497744594108e-8f;
+	const float SIN_COEF0 = -1.9515295891e-4f;
+	const float SIN_COEF1 = 8.3321608736e-3f;
+	const float SIN_COEF2 = -1.6666654611e-1f;
+	const float COS_COEF0 = 2.443315711809948e-5f;
+	const float COS_COEF1 = -1.388731625493765e-3f;
+	const float COS_COEF2 = 4.166664568298827e-2f;
+
+	/***********************************************************
+	 *  SinCosAVX2()
+	 *
+	 *  This function is used for calculating the sine and cosine
+	 *  of eight angles in radians at once - the eight lane form
+	 *  of SinCosSSE2() in TransformBatch.cpp.
+	 ***********************************************************/
+	void SinCosAVX2(__m256 x, __m256& sinResult, __m256& cosResult)
+	{
+		const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32((int)0x80000000));
+
+		__m256 sinSign = _mm256_and_ps(x, signMask);
+		x = _mm256_andnot_ps(signMask, x);
+
+		// octant of the angle, rounded up to an even number
+		__m256i octant = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(FOUR_OVER_PI)));
+		octant = _mm256_add_epi32(octant, _mm256_set1_epi32(1));
+		octant = _mm256_and_si256(octant, _mm256_set1_epi32(~1));
+		__m256 y = _mm256_cvtepi32_ps(octant);
+
+		__m256 sinSwap = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(octant, _mm256_set1_epi32(4)), 29));
+		__m256 polyMask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(octant, _mm256_set1_epi32(2)), _mm256_setzero_si256()));
+		__m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+			_mm256_andnot_si256(_mm256_sub_epi32(octant, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+		sinSign = _mm256_xor_ps(sinSign, sinSwap);
+
+		// extended precision reduction to [-pi/4, pi/4]
+		x = _mm256_add_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(PI_OVER_4_PART1)));
+		x = _mm256_add_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(PI_OVER_4_PART2)));
+		x = _mm256_add_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(PI_OVER_4_PART3)));
+		__m256 z = _mm256_mul_ps(x, x);
+
+		// cosine polynomial
+		__m256 cosPoly = _mm256_set1_ps(COS_COEF0);
+		cosPoly = _mm256_add_ps(_mm256_mul_ps(cosPoly, z), _mm256_set1_ps(COS_COEF1));
+		cosPoly = _mm256_add_ps(_mm256_mul_ps(cosPoly, z), _mm256_set1_ps(COS_COEF2));
+		cosPoly = _mm256_mul_ps(_mm256_mul_ps(cosPoly, z), z);
+		cosPoly = _mm256_sub_ps(cosPoly, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+		cosPoly = _mm256_add_ps(cosPoly, _mm256_set1_ps(1.0f));
+
+		// sine polynomial
+		__m256 sinPoly = _mm256_set1_ps(SIN_COEF0);
+		sinPoly = _mm256_add_ps(_mm256_mul_ps(sinPoly, z), _mm256_set1_ps(SIN_COEF1));
+		sinPoly = _mm256_add_ps(_mm256_mul_ps(sinPoly, z), _mm256_set1_ps(SIN_COEF2));
+		sinPoly = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(sinPoly, z), x), x);
+
+		// pick the polynomial that matches each octant
+		__m256 sinValue = _mm256_blendv_ps(cosPoly, sinPoly, polyMask);
+		__m256 cosValue = _mm256_blendv_ps(sinPoly, cosPoly, polyMask);
+
+		sinResult = _mm256_xor_ps(sinValue, sinSign);
+		cosResult = _mm256_xor_ps(cosValue, cosSign);
+	}
+
+	/***********************************************************
+	 *  StoreColumnsAVX2()
+	 *
+	 *  This function is used for transposing one matrix column
+	 *  of eight objects from component arrays into the column
+	 *  of each object's matrix.  The 4x4 transpose runs in both
+	 *  128-bit halves at once - the low half holds objects 0-3
+	 *  and the high half objects 4-7.  The matrices are 16
+	 *  column-major floats each.
+	 ***********************************************************/
+	void StoreColumnsAVX2(__m256 x, __m256 y, __m256 z, __m256 w, float* pModels, int column)
+	{
+		float* pColumn = pModels + column * 4;
+
+		__m256 xy0 = _mm256_unpacklo_ps(x, y);
+		__m256 xy1 = _mm256_unpackhi_ps(x, y);
+		__m256 zw0 = _mm256_unpacklo_ps(z, w);
+		__m256 zw1 = _mm256_unpackhi_ps(z, w);
+
+		__m256 object0 = _mm256_shuffle_ps(xy0, zw0, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 object1 = _mm256_shuffle_ps(xy0, zw0, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 object2 = _mm256_shuffle_ps(xy1, zw1, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 object3 = _mm256_shuffle_ps(xy1, zw1, _MM_SHUFFLE(3, 2, 3, 2));
+
+		_mm_storeu_ps(pColumn + 0 * 16, _mm256_castps256_ps128(object0));
+		_mm_storeu_ps(pColumn + 1 * 16, _mm256_castps256_ps128(object1));
+		_mm_storeu_ps(pColumn + 2 * 16, _mm256_castps256_ps128(object2));
+		_mm_storeu_ps(pColumn + 3 * 16, _mm256_castps256_ps128(object3));
+		_mm_storeu_ps(pColumn + 4 * 16, _mm256_extractf128_ps(object0, 1));
+		_mm_storeu_ps(pColumn + 5 * 16, _mm256_extractf128_ps(object1, 1));
+		_mm_storeu_ps(pColumn + 6 * 16, _mm256_extractf128_ps(object2, 1));
+		_mm_storeu_ps(pColumn + 7 * 16, _mm256_extractf128_ps(object3, 1));
+	}
+}
+
+/***********************************************************
+ *  ComputeModelMatricesAVX2()
+ *
+ *  This function is used for calculating the model matrices
+ *  eight objects at a time with the same closed form as
+ *  TransformBatch::ComputeScalar().  The objects left over
+ *  after the last eight are left to the caller.
+ ***********************************************************/
+size_t ComputeModelMatricesAVX2(
+	const TRANSFORM_ARRAYS* pArrays,
+	size_t begin,
+	size_t end,
+	float* pModels)
+{
+	const __m256 toRadians = _mm256_set1_ps(DEGREES_TO_RADIANS);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+
+	size_t i = begin;
+	for (; i + 8 <= end; i += 8)
+	{
+		__m256 sx, cx, sy, cy, sz, cz;
+		SinCosAVX2(_mm256_mul_ps(_mm256_loadu_ps(pArrays->pRotationX + i), toRadians), sx, cx);
+		SinCosAVX2(_mm256_mul_ps(_mm256_loadu_ps(pArrays->pRotationY + i), toRadians), sy, cy);
+		SinCosAVX2(_mm256_mul_ps(_mm256_loadu_ps(pArrays->pRotationZ + i), toRadians), sz, cz);
+
+		__m256 scaleX = _mm256_loadu_ps(pArrays->pScaleX + i);
+		__m256 scaleY = _mm256_loadu_ps(pArrays->pScaleY + i);
+		__m256 scaleZ = _mm256_loadu_ps(pArrays->pScaleZ + i);
+
+		// shared products of the closed form
+		__m256 czsy = _mm256_mul_ps(cz, sy);
+		__m256 szsy = _mm256_mul_ps(sz, sy);
+
+		__m256 m00 = _mm256_mul_ps(_mm256_mul_ps(cz, cy), scaleX);
+		__m256 m01 = _mm256_mul_ps(_mm256_mul_ps(sz, cy), scaleX);
+		__m256 m02 = _mm256_sub_ps(zero, _mm256_mul_ps(sy, scaleX));
+		__m256 m10 = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(czsy, sx), _mm256_mul_ps(sz, cx)), scaleY);
+		__m256 m11 = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(szsy, sx), _mm256_mul_ps(cz, cx)), scaleY);
+		__m256 m12 = _mm256_mul_ps(_mm256_mul_ps(cy, sx), scaleY);
+		__m256 m20 = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(czsy, cx), _mm256_mul_ps(sz, sx)), scaleZ);
+		__m256 m21 = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(szsy, cx), _mm256_mul_ps(cz, sx)), scaleZ);
+		__m256 m22 = _mm256_mul_ps(_mm256_mul_ps(cy, cx), scaleZ);
+
+		StoreColumnsAVX2(m00, m01, m02, zero, pModels + i * 16, 0);
+		StoreColumnsAVX2(m10, m11, m12, zero, pModels + i * 16, 1);
+		StoreColumnsAVX2(m20, m21, m22, zero, pModels + i * 16, 2);
+		StoreColumnsAVX2(
+			_mm256_loadu_ps(pArrays->pPositionX + i),
+			_mm256_loadu_ps(pArrays->pPositionY + i),
+			_mm256_loadu_ps(pArrays->pPositionZ + i),
+			one, pModels + i * 16, 3);
+	}
+
+	return(i);
+}
@@ -0,0 +1,42 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformbatchavx2.h
+// ============
+// plain C interface of the AVX2 model matrix kernel
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stddef.h>
+
+/***********************************************************
+ *  TRANSFORM_ARRAYS
+ *
+ *  The component arrays of a transform batch, one entry per
+ *  object.  The AVX2 kernel is built with AVX2 code generation
+ *  enabled, so it only sees raw pointers - any inline code of
+ *  glm or the standard library compiled into it could be the
+ *  copy the linker keeps for the whole program, and run on a
+ *  CPU without AVX2.
+ ***********************************************************/
+struct TRANSFORM_ARRAYS
+{
+	const float* pScaleX;
+	const float* pScaleY;
+	const float* pScaleZ;
+	const float* pRotationX;
+	const float* pRotationY;
+	const float* pRotationZ;
+	const float* pPositionX;
+	const float* pPositionY;
+	const float* pPositionZ;
+};
+
+// calculate the model matrices of the objects in [begin, end)
+// eight at a time, into 16 column-major floats per object at
+// pModels, and return the first object left for the caller
+extern "C" size_t ComputeModelMatricesAVX2(
+	const TRANSFORM_ARRAYS* pArrays,
+	size_t begin,
+	size_t end,
+	float* pModels);
@@ -0,0 +1,93 @@
+///////////////////////////////////////////////////////////////////////////////
+// triplebuffer.h
+// ============
+// lock-free single producer / single consumer triple buffer
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/***********************************************************
+ *  TripleBuffer
+ *
+ *  This template hands the latest state from one writer
+ *  thread to one reader thread without locks.  The writer
+ *  fills its back slot and swaps it with the shared middle
+ *  slot; the reader swaps the middle slot into its front
+ *  slot only when something new was published.  Neither
+ *  side ever waits for the other, and the reader always
+ *  sees the most recently completed state.
+ *
+ *  The shared middle slot index and the "new data" flag are
+ *  packed into one atomic byte so each swap is a single
+ *  atomic exchange.
+ ***********************************************************/
+template <typename T>
+class TripleBuffer
+{
+public:
+	// constructor
+	TripleBuffer()
+	{
+		m_backIndex = 0;
+		m_middle.store(1, std::memory_order_relaxed);
+		m_frontIndex = 2;
+	}
+
+	// writer side - get the slot to fill with the next state
+	T& GetWriteBuffer()
+	{
+		return(m_buffers[m_backIndex]);
+	}
+
+	// writer side - publish the filled slot to the reader
+	void Publish()
+	{
+		uint8_t previous = m_middle.exchange(
+			(uint8_t)(m_backIndex | NEW_DATA_FLAG),
+			std::memory_order_acq_rel);
+		m_backIndex = previous & INDEX_MASK;
+	}
+
+	// writer side - fill and publish in one call
+	void Write(const T& value)
+	{
+		GetWriteBuffer() = value;
+		Publish();
+	}
+
+	// reader side - get the latest published state, swapping
+	// it in first when the writer has published a new one
+	const T& Read()
+	{
+		if ((m_middle.load(std::memory_order_relaxed) & NEW_DATA_FLAG) != 0)
+		{
+			uint8_t previous = m_middle.exchange(
+				m_frontIndex,
+				std::memory_order_acq_rel);
+			m_frontIndex = previous & INDEX_MASK;
+		}
+		return(m_buffers[m_frontIndex]);
+	}
+
+	// reader side - check whether a new state is waiting
+	bool HasNewData() const
+	{
+		return((m_middle.load(std::memory_order_acquire) & NEW_DATA_FLAG) != 0);
+	}
+
+private:
+	static const uint8_t INDEX_MASK = 0x03;
+	static const uint8_t NEW_DATA_FLAG = 0x04;
+
+	T m_buffers[3];
+	// slot owned by the writer
+	uint8_t m_backIndex;
+	// shared slot index plus the new data flag
+	std::atomic<uint8_t> m_middle;
+	// slot owned by the reader
+	uint8_t m_frontIndex;
+};
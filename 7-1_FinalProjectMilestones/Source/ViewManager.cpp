@@ -39,6 +39,21 @@ namespace
 	// the following variable is false when orthographic projection
 	// is off and true when it is on
 	bool bOrthographicProjection = false;
+
+	// input recorder used for recording or replaying the input
+	InputRecorder* g_pInputRecorder = nullptr;
+	// camera path used for a scripted camera flight
+	CameraPath* g_pCameraPath = nullptr;
+
+	// timestep used while the camera is scripted - replays step
+	// by this amount every frame no matter how long frames take
+	float gFixedTimeStep = 1.0f / 60.0f;
+	// number of scripted frames advanced so far
+	unsigned int gScriptedFrames = 0;
+
+	// time of the oldest live input event not yet taken, for
+	// measuring the latency to the frame that shows it
+	double gFirstInputTime = -1.0;
 }
 
 /***********************************************************
@@ -52,6 +67,8 @@ ViewManager::ViewManager(
 	// initialize the member variables
 	m_pShaderManager = pShaderManager;
 	m_pWindow = NULL;
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
 	g_pCamera = new Camera();
 	// default camera view parameters
 	g_pCamera->Position = glm::vec3(0.0f, 5.0f, 12.0f);
@@ -69,6 +86,8 @@ ViewManager::ViewManager(
 ViewManager::~ViewManager()
 {
 	// free up allocated memory
+	StopInputRecording();
+
 	m_pShaderManager = NULL;
 	m_pWindow = NULL;
 	if (NULL != g_pCamera)
@@ -76,6 +95,16 @@ ViewManager::~ViewManager()
 		delete g_pCamera;
 		g_pCamera = NULL;
 	}
+	if (NULL != g_pInputRecorder)
+	{
+		delete g_pInputRecorder;
+		g_pInputRecorder = NULL;
+	}
+	if (NULL != g_pCameraPath)
+	{
+		delete g_pCameraPath;
+		g_pCameraPath = NULL;
+	}
 }
 
 /***********************************************************
@@ -106,6 +135,10 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 
 	// this callback is used to receive mouse moving events
 	glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
+	// this callback is used to receive mouse scroll events
+	glfwSetScrollCallback(window, &ViewManager::Mouse_Scroll_Callback);
+	// this callback is used to record key presses and releases
+	glfwSetKeyCallback(window, &ViewManager::Key_Callback);
 
 	// enable blending for supporting tranparent rendering
 	glEnable(GL_BLEND);
@@ -123,6 +156,30 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
  *  the mouse is moved within the active GLFW display window.
  ***********************************************************/
 void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos)
+{
+	// live mouse input is ignored while the camera is scripted
+	if (((NULL != g_pInputRecorder) && (g_pInputRecorder->IsReplaying())) ||
+		(NULL != g_pCameraPath))
+	{
+		return;
+	}
+
+	if ((NULL != g_pInputRecorder) && (g_pInputRecorder->IsRecording()))
+	{
+		g_pInputRecorder->RecordMouseMove(glfwGetTime(), xMousePos, yMousePos);
+	}
+
+	MarkInputTime();
+	ProcessMouseMovement(xMousePos, yMousePos);
+}
+
+/***********************************************************
+ *  ProcessMouseMovement()
+ *
+ *  This method is used for moving the 3D camera according
+ *  to a new mouse position, either live or replayed.
+ ***********************************************************/
+void ViewManager::ProcessMouseMovement(double xMousePos, double yMousePos)
 {
 	// when the first mouse move event is received, this needs to be recorded so that
 	// all subsequent mouse moves can correctly calculate the X position offset and Y
@@ -150,9 +207,66 @@ void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos,
 //scrollwheel call back
 void ViewManager::Mouse_Scroll_Callback(GLFWwindow* window, double xoffset, double yoffset)
 {
+	// live scrolling is ignored while the camera is scripted
+	if (((NULL != g_pInputRecorder) && (g_pInputRecorder->IsReplaying())) ||
+		(NULL != g_pCameraPath))
+	{
+		return;
+	}
+
+	if ((NULL != g_pInputRecorder) && (g_pInputRecorder->IsRecording()))
+	{
+		g_pInputRecorder->RecordMouseScroll(glfwGetTime(), xoffset, yoffset);
+	}
+	MarkInputTime();
 	g_pCamera->ProcessMouseScroll(yoffset);
 }
 
+/***********************************************************
+ *  Key_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  a key is pressed or released, and is used for adding the
+ *  key event to the input recording.
+ ***********************************************************/
+void ViewManager::Key_Callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	if ((NULL != g_pInputRecorder) && (g_pInputRecorder->IsRecording()))
+	{
+		g_pInputRecorder->RecordKey(glfwGetTime(), key, action);
+	}
+	MarkInputTime();
+}
+
+/***********************************************************
+ *  MarkInputTime()
+ *
+ *  This method is used for keeping the time of a live input
+ *  event, unless an older one hasn't been taken yet.
+ ***********************************************************/
+void ViewManager::MarkInputTime()
+{
+	if (gFirstInputTime < 0.0)
+	{
+		gFirstInputTime = glfwGetTime();
+	}
+}
+
+/***********************************************************
+ *  TakeInputTime()
+ *
+ *  This method is used for taking the time of the oldest
+ *  live input event since the last call, for the frame that
+ *  is about to show it.  It must be called on the thread
+ *  that polls the GLFW events.
+ ***********************************************************/
+double ViewManager::TakeInputTime()
+{
+	double inputTime = gFirstInputTime;
+	gFirstInputTime = -1.0;
+	return(inputTime);
+}
+
 /***********************************************************
  *  ProcessKeyboardEvents()
  *
@@ -169,38 +283,59 @@ void ViewManager::ProcessKeyboardEvents()
 	}
 
 	// process camera zooming in and out
-	if (glfwGetKey(m_pWindow, GLFW_KEY_W) == GLFW_PRESS)
+	if (IsKeyPressed(GLFW_KEY_W))
 	{
 		g_pCamera->ProcessKeyboard(FORWARD, gDeltaTime);
 	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_S) == GLFW_PRESS)
+	if (IsKeyPressed(GLFW_KEY_S))
 	{
 		g_pCamera->ProcessKeyboard(BACKWARD, gDeltaTime);
 	}
 
 	// process camera panning left and right
-	if (glfwGetKey(m_pWindow, GLFW_KEY_A) == GLFW_PRESS)
+	if (IsKeyPressed(GLFW_KEY_A))
 	{
 		g_pCamera->ProcessKeyboard(LEFT, gDeltaTime);
 	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_D) == GLFW_PRESS)
+	if (IsKeyPressed(GLFW_KEY_D))
 	{
 		g_pCamera->ProcessKeyboard(RIGHT, gDeltaTime);
 	}
 
 	//process camera panning up and down
-	if (glfwGetKey(m_pWindow, GLFW_KEY_Q) == GLFW_PRESS)
+	if (IsKeyPressed(GLFW_KEY_Q))
 	{
 		g_pCamera->ProcessKeyboard(UP, gDeltaTime);
 	}
 
-	if (glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS)
+	if (IsKeyPressed(GLFW_KEY_E))
 	{
 		g_pCamera->ProcessKeyboard(DOWN, gDeltaTime);
 	}
 }
 
 
+/***********************************************************
+ *  IsKeyPressed()
+ *
+ *  This method is used for checking whether a camera key is
+ *  held down - from the replayed input when a replay is
+ *  running, otherwise from the live keyboard.  The camera
+ *  path ignores the keyboard altogether.
+ ***********************************************************/
+bool ViewManager::IsKeyPressed(int key)
+{
+	if (NULL != g_pCameraPath)
+	{
+		return(false);
+	}
+	if ((NULL != g_pInputRecorder) && (g_pInputRecorder->IsReplaying()))
+	{
+		return(g_pInputRecorder->IsKeyDown(key));
+	}
+	return(glfwGetKey(m_pWindow, key) == GLFW_PRESS);
+}
+
 void ProcessInput (GLFWwindow* window)
 {
 	static const float cameraSpeed = 2.5f;
@@ -238,23 +373,40 @@ void ProcessInput (GLFWwindow* window)
  ***********************************************************/
 void ViewManager::PrepareSceneView()
 {
-	glm::mat4 view;
-	glm::mat4 projection;
-
 	// per-frame timing
 	float currentFrame = glfwGetTime();
-	gDeltaTime = currentFrame - gLastFrame;
+	float deltaTime = currentFrame - gLastFrame;
 	gLastFrame = currentFrame;
 
-	// process any keyboard events that may be waiting in the 
-	// event queue
-	ProcessKeyboardEvents();
+	// move the camera for the time since the last frame
+	UpdateCamera(deltaTime);
+
+	// set the view of the updated camera into the shader
+	PrepareSceneView(GetCameraState());
+}
+
+/***********************************************************
+ *  PrepareSceneView()
+ *
+ *  This method is used for setting the view and projection
+ *  of the passed in camera state into the shader.  It only
+ *  reads the passed in state, so the render thread can call
+ *  it while the camera is updated on another thread.
+ ***********************************************************/
+void ViewManager::PrepareSceneView(const CAMERA_STATE& cameraState)
+{
+	glm::mat4 view;
+	glm::mat4 projection;
 
-	// get the current view matrix from the camera
-	view = g_pCamera->GetViewMatrix();
+	// get the current view matrix from the camera state
+	view = glm::lookAt(cameraState.position, cameraState.position + cameraState.front, cameraState.up);
 
 	// define the current projection matrix
-	projection = glm::perspective(glm::radians(g_pCamera->Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+	projection = glm::perspective(glm::radians(cameraState.zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+
+	// keep the matrices for the culling of the scene objects
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
 
 	// if the shader manager object is valid
 	if (NULL != m_pShaderManager)
@@ -264,9 +416,207 @@ void ViewManager::PrepareSceneView()
 		// set the view matrix into the shader for proper rendering
 		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
 		// set the view position of the camera into the shader for proper rendering
-		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
-		m_pShaderManager->setVec3Value("pointLight.position", g_pCamera->Position);
-		m_pShaderManager->setVec3Value("pointLight.direction", g_pCamera->Front);
+		m_pShaderManager->setVec3Value("viewPosition", cameraState.position);
+		m_pShaderManager->setVec3Value("pointLight.position", cameraState.position);
+		m_pShaderManager->setVec3Value("pointLight.direction", cameraState.front);
+
+	}
+}
+
+/***********************************************************
+ *  UpdateCamera()
+ *
+ *  This method is used for moving the camera by the passed
+ *  in amount of time - from the keyboard, the replayed input
+ *  or the camera path.  It must be called on the thread that
+ *  polls the GLFW events.
+ ***********************************************************/
+void ViewManager::UpdateCamera(float deltaTime)
+{
+	gDeltaTime = deltaTime;
+
+	// a scripted camera steps by the fixed timestep so every
+	// run sees exactly the same sequence of views
+	if (((NULL != g_pInputRecorder) && (g_pInputRecorder->IsReplaying())) ||
+		(NULL != g_pCameraPath))
+	{
+		gDeltaTime = gFixedTimeStep;
+		AdvanceScriptedCamera();
+	}
+
+	// process any keyboard events that may be waiting in the 
+	// event queue
+	ProcessKeyboardEvents();
+}
+
+/***********************************************************
+ *  GetCameraState()
+ *
+ *  This method is used for taking a snapshot of the camera
+ *  values needed to render a view.
+ ***********************************************************/
+ViewManager::CAMERA_STATE ViewManager::GetCameraState() const
+{
+	CAMERA_STATE cameraState;
+
+	cameraState.position = g_pCamera->Position;
+	cameraState.front = g_pCamera->Front;
+	cameraState.up = g_pCamera->Up;
+	cameraState.zoom = g_pCamera->Zoom;
+
+	return(cameraState);
+}
+
+/***********************************************************
+ *  InterpolateCameraState()
+ *
+ *  This method is used for blending between two camera
+ *  snapshots, so that frames rendered between two camera
+ *  updates move smoothly.
+ ***********************************************************/
+ViewManager::CAMERA_STATE ViewManager::InterpolateCameraState(
+	const CAMERA_STATE& previousState,
+	const CAMERA_STATE& currentState,
+	float alpha)
+{
+	CAMERA_STATE cameraState;
+
+	cameraState.position = glm::mix(previousState.position, currentState.position, alpha);
+	cameraState.front = glm::normalize(glm::mix(previousState.front, currentState.front, alpha));
+	cameraState.up = glm::normalize(glm::mix(previousState.up, currentState.up, alpha));
+	cameraState.zoom = glm::mix(previousState.zoom, currentState.zoom, alpha);
+
+	return(cameraState);
+}
+
+/***********************************************************
+ *  AdvanceScriptedCamera()
+ *
+ *  This method is used for stepping the replayed input or
+ *  the camera path forward by one fixed timestep, and for
+ *  closing the window once the script has ended.
+ ***********************************************************/
+void ViewManager::AdvanceScriptedCamera()
+{
+	// the script time is derived from the frame count rather
+	// than summed so that it never drifts between runs
+	double scriptTime = gScriptedFrames * (double)gFixedTimeStep;
+	bool bFinished = false;
+
+	if ((NULL != g_pInputRecorder) && (g_pInputRecorder->IsReplaying()))
+	{
+		std::vector<InputRecorder::INPUT_EVENT> dueEvents;
+		g_pInputRecorder->ReplayEvents(scriptTime, dueEvents);
+
+		for (size_t i = 0; i < dueEvents.size(); i++)
+		{
+			if (dueEvents[i].type == InputRecorder::EVENT_MOUSE_MOVE)
+			{
+				ProcessMouseMovement(dueEvents[i].x, dueEvents[i].y);
+			}
+			else if (dueEvents[i].type == InputRecorder::EVENT_MOUSE_SCROLL)
+			{
+				g_pCamera->ProcessMouseScroll(dueEvents[i].y);
+			}
+		}
+
+		bFinished = g_pInputRecorder->IsReplayFinished(scriptTime);
+	}
+	else if (NULL != g_pCameraPath)
+	{
+		g_pCameraPath->Evaluate(scriptTime, g_pCamera->Position, g_pCamera->Front);
+		bFinished = (scriptTime > g_pCameraPath->GetDuration());
+	}
+
+	if (bFinished == true)
+	{
+		std::cout << "INFO: Scripted camera finished after " << gScriptedFrames << " frames" << std::endl;
+		glfwSetWindowShouldClose(m_pWindow, true);
+	}
+
+	gScriptedFrames++;
+}
 
+/***********************************************************
+ *  StartInputRecording()
+ *
+ *  This method is used for recording the live input of this
+ *  session into the passed in log file.
+ ***********************************************************/
+bool ViewManager::StartInputRecording(const char* filename)
+{
+	if (NULL == g_pInputRecorder)
+	{
+		g_pInputRecorder = new InputRecorder();
+	}
+	return(g_pInputRecorder->StartRecording(filename, glfwGetTime()));
+}
+
+/***********************************************************
+ *  StopInputRecording()
+ *
+ *  This method is used for ending the recording, which
+ *  writes the recorded events into the log file.
+ ***********************************************************/
+void ViewManager::StopInputRecording()
+{
+	if ((NULL != g_pInputRecorder) && (g_pInputRecorder->IsRecording()))
+	{
+		g_pInputRecorder->StopRecording(glfwGetTime());
+	}
+}
+
+/***********************************************************
+ *  StartInputReplay()
+ *
+ *  This method is used for driving the camera from a
+ *  previously recorded input log file.
+ ***********************************************************/
+bool ViewManager::StartInputReplay(const char* filename)
+{
+	if (NULL == g_pInputRecorder)
+	{
+		g_pInputRecorder = new InputRecorder();
+	}
+	gScriptedFrames = 0;
+	return(g_pInputRecorder->LoadReplay(filename));
+}
+
+/***********************************************************
+ *  StartCameraPath()
+ *
+ *  This method is used for driving the camera along the
+ *  spline of the passed in camera path file.
+ ***********************************************************/
+bool ViewManager::StartCameraPath(const char* filename)
+{
+	CameraPath* pCameraPath = new CameraPath();
+	if (pCameraPath->LoadPath(filename) == false)
+	{
+		delete pCameraPath;
+		return(false);
+	}
+
+	if (NULL != g_pCameraPath)
+	{
+		delete g_pCameraPath;
+	}
+	g_pCameraPath = pCameraPath;
+	gScriptedFrames = 0;
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetFixedTimeStep()
+ *
+ *  This method is used for setting the timestep the camera
+ *  advances by every frame while it is scripted.
+ ***********************************************************/
+void ViewManager::SetFixedTimeStep(float seconds)
+{
+	if (seconds > 0.0f)
+	{
+		gFixedTimeStep = seconds;
 	}
 }
\ No newline at end of file
@@ -10,6 +10,8 @@
 #pragma once
 
 #include "ShaderManager.h"
+#include "InputRecorder.h"
+#include "CameraPath.h"
 #include "camera.h"
 
 // GLFW library
@@ -24,19 +26,43 @@ public:
 	// destructor
 	~ViewManager();
 
+	// the camera values needed to render a view
+	struct CAMERA_STATE
+	{
+		glm::vec3 position;
+		glm::vec3 front;
+		glm::vec3 up;
+		float zoom;
+	};
+
 	// mouse position callback for mouse interaction with the 3D scene
 	static void Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos);
 
 	static void Mouse_Scroll_Callback(GLFWwindow* window, double xoffset, double yoffset);
 
+	// keyboard callback used for recording key presses and releases
+	static void Key_Callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
 	// active OpenGL display window
 	GLFWwindow* m_pWindow;
+	// matrices of the last prepared view
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
 
 	// process keyboard events for interaction with the 3D scene
 	void ProcessKeyboardEvents();
+	// check whether a camera key is held, live or replayed
+	bool IsKeyPressed(int key);
+	// advance the replayed input or camera path by one fixed timestep
+	void AdvanceScriptedCamera();
+
+	// move the 3D camera for a new mouse position
+	static void ProcessMouseMovement(double xMousePos, double yMousePos);
+	// keep the time of the oldest live input not yet taken
+	static void MarkInputTime();
 
 public:
 	// create the initial OpenGL display window
@@ -44,4 +70,34 @@ public:
 	
 	// prepare the conversion from 3D object display to 2D scene display
 	void PrepareSceneView();
+	// set the view of the passed in camera state into the shader
+	void PrepareSceneView(const CAMERA_STATE& cameraState);
+
+	// get the matrices of the last prepared view
+	const glm::mat4& GetViewMatrix() const { return(m_viewMatrix); }
+	const glm::mat4& GetProjectionMatrix() const { return(m_projectionMatrix); }
+
+	// move the camera by the passed in amount of time
+	void UpdateCamera(float deltaTime);
+	// take a snapshot of the current camera values
+	CAMERA_STATE GetCameraState() const;
+	// blend between two camera snapshots
+	static CAMERA_STATE InterpolateCameraState(
+		const CAMERA_STATE& previousState,
+		const CAMERA_STATE& currentState,
+		float alpha);
+
+	// record the live input of this session into a log file
+	bool StartInputRecording(const char* filename);
+	void StopInputRecording();
+	// drive the camera from a recorded input log
+	bool StartInputReplay(const char* filename);
+	// drive the camera along a spline camera path
+	bool StartCameraPath(const char* filename);
+	// set the timestep used while the camera is scripted
+	void SetFixedTimeStep(float seconds);
+
+	// take the time of the oldest live input event since the
+	// last call, negative if there was none
+	static double TakeInputTime();
 };
\ No newline at end of file
@@ -0,0 +1,108 @@
+#version 430 core
+layout (local_size_x = 64) in;
+
+// culling values of one scene object - must match DRAW_RECORD
+// in GpuCuller
+struct DrawRecord
+{
+    // box around the stored positions of the mesh
+    vec4 boundsMin;
+    vec4 boundsMax;
+    // index count, first index, bucket and first command of
+    // the bucket, for the triangles and for the lines
+    uvec4 triangles;
+    uvec4 lines;
+    // base vertex of the mesh in x
+    ivec4 baseVertex;
+};
+
+// the same as in the vertex shader, only the model is read
+struct ObjectData
+{
+    mat4 model;
+    vec4 objectColor;
+    vec3 diffuseColor;
+    float padding0;
+    vec3 specularColor;
+    float shininess;
+    int bUseTexture;
+    int padding1;
+    int padding2;
+    int padding3;
+};
+
+// as read by glMultiDrawElementsIndirectCount()
+struct DrawCommand
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout (std430, binding = 0) readonly buffer RecordBuffer
+{
+    DrawRecord records[];
+};
+layout (std430, binding = 1) readonly buffer ObjectBuffer
+{
+    ObjectData objects[];
+};
+layout (std430, binding = 2) writeonly buffer CommandBuffer
+{
+    DrawCommand commands[];
+};
+// commands written into each bucket, cleared every frame
+layout (std430, binding = 3) buffer CountBuffer
+{
+    uint counts[];
+};
+
+uniform vec4 frustumPlanes[6];
+uniform int numObjects;
+
+const uint NO_BUCKET = 0xFFFFFFFFu;
+
+// add a draw of the object to the end of its bucket
+void WriteCommand(uvec4 range, int baseVertex, uint objectIndex)
+{
+    uint slot = atomicAdd(counts[range.z], 1u);
+    commands[range.w + slot] = DrawCommand(range.x, 1u, range.y, baseVertex, objectIndex);
+}
+
+void main()
+{
+    uint objectIndex = gl_GlobalInvocationID.x;
+    if (objectIndex >= uint(numObjects))
+    {
+        return;
+    }
+
+    DrawRecord record = records[objectIndex];
+    mat4 model = objects[objectIndex].model;
+
+    // world box around the mesh, the same as ComputeWorldBounds()
+    vec3 localCenter = (record.boundsMin.xyz + record.boundsMax.xyz) * 0.5;
+    vec3 localExtents = (record.boundsMax.xyz - record.boundsMin.xyz) * 0.5;
+    vec3 center = vec3(model * vec4(localCenter, 1.0));
+    vec3 extents = abs(model[0].xyz) * localExtents.x +
+        abs(model[1].xyz) * localExtents.y +
+        abs(model[2].xyz) * localExtents.z;
+
+    for (int i = 0; i < 6; i++)
+    {
+        // distance of the box corner furthest along the normal
+        vec4 plane = frustumPlanes[i];
+        if (dot(plane.xyz, center) + dot(abs(plane.xyz), extents) + plane.w < 0.0)
+        {
+            return;
+        }
+    }
+
+    WriteCommand(record.triangles, record.baseVertex.x, objectIndex);
+    if (record.lines.z != NO_BUCKET)
+    {
+        WriteCommand(record.lines, record.baseVertex.x, objectIndex);
+    }
+}
\ No newline at end of file
@@ -50,14 +50,24 @@ struct SpotLight {
 
 #define TOTAL_POINT_LIGHTS 5
 
-uniform bool bUseTexture=false;
+// per-object values, passed on unchanged from the vertex
+// shader, which reads them from the object block or buffer
+flat in vec4 fragmentObjectColor;
+flat in vec3 fragmentDiffuseColor;
+// shininess in the fourth component
+flat in vec4 fragmentSpecularColor;
+flat in int fragmentUseTexture;
+
+// per-object values as the lighting functions read them
+vec4 objectColor;
+Material material;
+bool bUseTexture;
+
 uniform bool bUseLighting=false;
-uniform vec4 objectColor = vec4(1.0f);
 uniform vec3 viewPosition;
 uniform DirectionalLight directionalLight;
 uniform PointLight pointLights[TOTAL_POINT_LIGHTS];
 uniform SpotLight spotLight;
-uniform Material material;
 uniform sampler2D objectTexture;
 uniform vec2 UVscale = vec2(1.0f, 1.0f);
 
@@ -68,6 +78,10 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 
 void main()
 {    
+    objectColor = fragmentObjectColor;
+    material = Material(fragmentDiffuseColor, fragmentSpecularColor.rgb, fragmentSpecularColor.a);
+    bUseTexture = (fragmentUseTexture != 0);
+
     if(bUseLighting == true)
     {
         vec3 phongResult = vec3(0.0f);
@@ -0,0 +1,70 @@
+#version 460 core
+layout (location = 0) in vec3 inVertexPosition;
+// three float components, or two octahedral ones when packed
+layout (location = 1) in vec3 inVertexNormal;
+layout (location = 2) in vec2 inTextureCoordinate;
+
+out vec3 fragmentPosition;
+out vec3 fragmentVertexNormal;
+out vec2 fragmentTextureCoordinate;
+flat out vec4 fragmentObjectColor;
+flat out vec3 fragmentDiffuseColor;
+flat out vec4 fragmentSpecularColor;
+flat out int fragmentUseTexture;
+
+// per-object values of every scene object, as laid out by
+// OBJECT_BLOCK in SceneManager - the culling compute shader
+// puts the object index into the base instance of each draw
+struct ObjectData
+{
+    mat4 model;
+    vec4 objectColor;
+    vec3 diffuseColor;
+    float padding0;
+    vec3 specularColor;
+    float shininess;
+    int bUseTexture;
+    int padding1;
+    int padding2;
+    int padding3;
+};
+layout (std430, binding = 1) readonly buffer ObjectBuffer
+{
+    ObjectData objects[];
+};
+
+uniform mat4 view;
+uniform mat4 projection;
+// set when the vertices are packed - the positions need no
+// decoding here, as the model matrix already maps them back
+uniform bool bOctahedralNormals;
+
+// fold the octahedron back out into a unit vector
+vec3 DecodeOctahedralNormal(vec2 encoded)
+{
+   vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+   if (normal.z < 0.0)
+   {
+      vec2 signs = vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+      normal.xy = (1.0 - abs(normal.yx)) * signs;
+   }
+   return normalize(normal);
+}
+
+void main()
+{
+   ObjectData object = objects[gl_BaseInstance];
+
+   fragmentPosition = vec3(object.model * vec4(inVertexPosition, 1.0));
+   gl_Position = projection * view * object.model * vec4(inVertexPosition, 1.0f);
+   if (bOctahedralNormals)
+      fragmentVertexNormal = DecodeOctahedralNormal(inVertexNormal.xy);
+   else
+      fragmentVertexNormal = inVertexNormal;
+   fragmentTextureCoordinate = inTextureCoordinate;
+
+   fragmentObjectColor = object.objectColor;
+   fragmentDiffuseColor = object.diffuseColor;
+   fragmentSpecularColor = vec4(object.specularColor, object.shininess);
+   fragmentUseTexture = object.bUseTexture;
+}
\ No newline at end of file
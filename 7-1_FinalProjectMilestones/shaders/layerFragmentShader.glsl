@@ -0,0 +1,15 @@
+#version 330 core
+out vec4 fragmentColor;
+
+// static layer drawn at the size of the viewport, which starts
+// at the corner of the framebuffer, so the texels line up with
+// the pixels
+uniform sampler2D layerColor;
+uniform sampler2D layerDepth;
+
+void main()
+{
+   ivec2 texel = ivec2(gl_FragCoord.xy);
+   fragmentColor = vec4(texelFetch(layerColor, texel, 0).rgb, 1.0);
+   gl_FragDepth = texelFetch(layerDepth, texel, 0).r;
+}
\ No newline at end of file
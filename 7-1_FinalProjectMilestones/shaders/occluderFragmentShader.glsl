@@ -0,0 +1,6 @@
+#version 330 core
+
+// the occlusion buffer has no color, only the depth is written
+void main()
+{
+}
\ No newline at end of file
@@ -0,0 +1,11 @@
+#version 330 core
+layout (location = 0) in vec3 inVertexPosition;
+
+// depth only pass of the occluders, the whole transform of the
+// occluder - with the packed position decode - in one matrix
+uniform mat4 modelViewProjection;
+
+void main()
+{
+   gl_Position = modelViewProjection * vec4(inVertexPosition, 1.0);
+}
\ No newline at end of file
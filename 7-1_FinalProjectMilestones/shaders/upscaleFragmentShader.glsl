@@ -0,0 +1,41 @@
+#version 330 core
+out vec4 fragmentColor;
+
+in vec2 fragmentTextureCoordinate;
+
+// scene drawn at the render scale into the lower left corner
+uniform sampler2D sceneTexture;
+uniform vec2 renderScale;
+uniform vec2 texelSize;
+// zero is plain bilinear, up to one sharpens the upscaled image
+uniform float sharpness;
+
+// read the scene texture without bleeding in the texels past
+// the drawn corner
+vec3 SampleScene(vec2 coordinate)
+{
+   coordinate = clamp(coordinate, 0.5 * texelSize, renderScale - 0.5 * texelSize);
+   return texture(sceneTexture, coordinate).rgb;
+}
+
+void main()
+{
+   vec3 color = SampleScene(fragmentTextureCoordinate);
+
+   if (sharpness > 0.0)
+   {
+      // unsharp mask over the four neighbours a scene texel away,
+      // limited to their range so the edges don't ring
+      vec3 north = SampleScene(fragmentTextureCoordinate + vec2(0.0, texelSize.y));
+      vec3 south = SampleScene(fragmentTextureCoordinate - vec2(0.0, texelSize.y));
+      vec3 east = SampleScene(fragmentTextureCoordinate + vec2(texelSize.x, 0.0));
+      vec3 west = SampleScene(fragmentTextureCoordinate - vec2(texelSize.x, 0.0));
+
+      vec3 minColor = min(color, min(min(north, south), min(east, west)));
+      vec3 maxColor = max(color, max(max(north, south), max(east, west)));
+      vec3 blurred = (north + south + east + west) * 0.25;
+      color = clamp(color + sharpness * (color - blurred), minColor, maxColor);
+   }
+
+   fragmentColor = vec4(color, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#version 330 core
+
+// one triangle over the whole window, made from the vertex ID
+// so no vertex buffer is needed
+out vec2 fragmentTextureCoordinate;
+
+// fraction of the scene texture the scene was drawn into
+uniform vec2 renderScale;
+
+void main()
+{
+   vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+   fragmentTextureCoordinate = corner * renderScale;
+   gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
\ No newline at end of file
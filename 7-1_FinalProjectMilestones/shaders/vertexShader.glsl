@@ -1,20 +1,65 @@
 #version 330 core
 layout (location = 0) in vec3 inVertexPosition;
+// three float components, or two octahedral ones when packed
 layout (location = 1) in vec3 inVertexNormal;
 layout (location = 2) in vec2 inTextureCoordinate;
 
 out vec3 fragmentPosition;
 out vec3 fragmentVertexNormal;
 out vec2 fragmentTextureCoordinate;
+flat out vec4 fragmentObjectColor;
+flat out vec3 fragmentDiffuseColor;
+flat out vec4 fragmentSpecularColor;
+flat out int fragmentUseTexture;
+
+struct Material {
+    vec3 diffuseColor;
+    vec3 specularColor;
+    float shininess;
+};
+
+// per-object values, read from the range of the frame's
+// object buffer bound for each draw - must match OBJECT_BLOCK
+// in SceneManager
+layout (std140) uniform ObjectBlock
+{
+    mat4 model;
+    vec4 objectColor;
+    Material material;
+    bool bUseTexture;
+};
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+// set when the vertices are packed - the positions need no
+// decoding here, as the model matrix already maps them back
+uniform bool bOctahedralNormals;
+
+// fold the octahedron back out into a unit vector
+vec3 DecodeOctahedralNormal(vec2 encoded)
+{
+   vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+   if (normal.z < 0.0)
+   {
+      vec2 signs = vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+      normal.xy = (1.0 - abs(normal.yx)) * signs;
+   }
+   return normalize(normal);
+}
 
 void main()
 {
    fragmentPosition = vec3(model * vec4(inVertexPosition, 1.0));
    gl_Position = projection * view * model * vec4(inVertexPosition, 1.0f);
-   fragmentVertexNormal = inVertexNormal;
+   if (bOctahedralNormals)
+      fragmentVertexNormal = DecodeOctahedralNormal(inVertexNormal.xy);
+   else
+      fragmentVertexNormal = inVertexNormal;
    fragmentTextureCoordinate = inTextureCoordinate;
+
+   // the same for every vertex, so passed on without blending
+   fragmentObjectColor = objectColor;
+   fragmentDiffuseColor = material.diffuseColor;
+   fragmentSpecularColor = vec4(material.specularColor, material.shininess);
+   fragmentUseTexture = bUseTexture ? 1 : 0;
 }
\ No newline at end of file